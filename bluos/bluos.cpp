@@ -42,7 +42,24 @@ BluOS::BluOS(NetworkAccessManager *networkmanager,  QHostAddress hostAddress, in
     m_port(port),
     m_networkManager(networkmanager)
 {
+    m_statusRetryTimer = new QTimer(this);
+    m_statusRetryTimer->setSingleShot(true);
+    connect(m_statusRetryTimer, &QTimer::timeout, this, &BluOS::sendStatusPoll);
+
+    // The player holds the request for up to the poll timeout, give up if it takes much longer
+    m_statusTimeoutTimer = new QTimer(this);
+    m_statusTimeoutTimer->setSingleShot(true);
+    connect(m_statusTimeoutTimer, &QTimer::timeout, this, [this] {
+        if (m_statusReply) {
+            qCDebug(dcBluOS()) << "Status poll timed out" << m_hostAddress.toString();
+            m_statusReply->abort();
+        }
+    });
+}
 
+BluOS::~BluOS()
+{
+    stopStatusPolling();
 }
 
 int BluOS::port()
@@ -82,6 +99,80 @@ void BluOS::getStatus()
     return;
 }
 
+void BluOS::startStatusPolling()
+{
+    if (m_statusPolling)
+        return;
+
+    m_statusPolling = true;
+    m_statusRetryCount = 0;
+    sendStatusPoll();
+}
+
+void BluOS::stopStatusPolling()
+{
+    m_statusPolling = false;
+    m_statusRetryTimer->stop();
+    m_statusTimeoutTimer->stop();
+    if (m_statusReply) {
+        m_statusReply->disconnect(this);
+        m_statusReply->abort();
+        m_statusReply.clear();
+    }
+}
+
+void BluOS::sendStatusPoll()
+{
+    if (!m_statusPolling || m_statusReply)
+        return;
+
+    QUrlQuery query;
+    // Without an etag the player answers immediately
+    if (!m_statusEtag.isEmpty()) {
+        query.addQueryItem("timeout", QString::number(m_statusPollTimeout));
+        query.addQueryItem("etag", m_statusEtag);
+    }
+
+    QUrl url;
+    url.setScheme("http");
+    url.setHost(m_hostAddress.toString());
+    url.setPort(m_port);
+    url.setPath("/Status");
+    url.setQuery(query);
+    QNetworkReply *reply = m_networkManager->get(QNetworkRequest(url));
+    m_statusReply = reply;
+    m_statusTimeoutTimer->start((m_statusPollTimeout + 15) * 1000);
+    connect(reply, &QNetworkReply::finished, reply, &QNetworkReply::deleteLater);
+    connect(reply, &QNetworkReply::finished, this, [reply, this] {
+        m_statusReply.clear();
+        m_statusTimeoutTimer->stop();
+        if (!m_statusPolling)
+            return;
+
+        int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (status != 200 || reply->error() != QNetworkReply::NoError) {
+            emit connectionChanged(false);
+            // Jittered exponential backoff, 1 s up to 60 s
+            int backoff = qMin(60000, 1000 << qMin(m_statusRetryCount, 6));
+            int delay = backoff / 2 + qrand() % (backoff / 2 + 1);
+            m_statusRetryCount++;
+            m_statusEtag.clear();
+            qCWarning(dcBluOS()) << "Status poll error:" << status << reply->errorString() << "retrying in" << delay << "ms";
+            m_statusRetryTimer->start(delay);
+            return;
+        }
+        m_statusRetryCount = 0;
+        emit connectionChanged(true);
+        parseState(reply->readAll());
+        if (m_statusEtag.isEmpty()) {
+            // Without an etag the next request would be answered immediately again
+            m_statusRetryTimer->start(m_statusPollInterval);
+            return;
+        }
+        sendStatusPoll();
+    });
+}
+
 QUuid BluOS::setVolume(uint volume)
 {
     QUuid requestId = QUuid::createUuid();
@@ -649,6 +740,12 @@ bool BluOS::parseState(const QByteArray &state)
     StatusResponse statusResponse;
     if (xml.readNextStartElement()) {
         if (xml.name() == "status") {
+            // The etag only changes together with the status, a long-poll timeout returns the same one
+            QString etag = xml.attributes().value("etag").toString();
+            if (!etag.isEmpty() && etag == m_statusEtag)
+                return true;
+            m_statusEtag = etag;
+
             while(xml.readNextStartElement()){
                 if(xml.name() == "artist"){
                     statusResponse.Artist = xml.readElementText();
@@ -35,6 +35,8 @@
 #include <QTimer>
 #include <QHostAddress>
 #include <QUuid>
+#include <QPointer>
+#include <QNetworkReply>
 
 #include "network/networkaccessmanager.h"
 #include "integrations/thing.h"
@@ -98,11 +100,14 @@ public:
     };
 
     explicit BluOS(NetworkAccessManager *networkManager, QHostAddress hostAddress, int port, QObject *parent = nullptr);
+    ~BluOS();
     int port();
     QHostAddress hostAddress();
     
     // Status Queries
     void getStatus();
+    void startStatusPolling();  // Long-polls /Status, the player answers as soon as the status etag changes
+    void stopStatusPolling();
     
     // Volume Control
     QUuid setVolume(uint volume);
@@ -134,9 +139,23 @@ private:
     int m_port;
     NetworkAccessManager *m_networkManager = nullptr;
 
+    // Status long-polling
+    bool m_statusPolling = false;
+    QString m_statusEtag;
+    QPointer<QNetworkReply> m_statusReply;
+    QTimer *m_statusRetryTimer = nullptr;
+    QTimer *m_statusTimeoutTimer = nullptr;
+    int m_statusPollTimeout = 100;
+    // Plain polling interval in ms for players which don't send an etag
+    int m_statusPollInterval = 10000;
+    int m_statusRetryCount = 0;
+
     QUuid playBackControl(PlaybackCommand command);
     bool parseState(const QByteArray &state);
 
+private slots:
+    void sendStatusPoll();
+
 signals:
     void connectionChanged(bool connected);
     void actionExecuted(QUuid actionId, bool success);
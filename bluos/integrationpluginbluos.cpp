@@ -113,15 +113,12 @@ void IntegrationPluginBluOS::setupThing(ThingSetupInfo *info)
 
 void IntegrationPluginBluOS::postSetupThing(Thing *thing)
 {
-    Q_UNUSED(thing)
-
-    if (!m_pluginTimer) {
-        m_pluginTimer = hardwareManager()->pluginTimerManager()->registerTimer(10);
-        connect(m_pluginTimer, &PluginTimer::timeout, [this] {
-            foreach(BluOS *bluos, m_bluos) {
-                bluos->getStatus();
-            }
-        });
+    if (thing->thingClassId() == bluosPlayerThingClassId) {
+        BluOS *bluos = m_bluos.value(thing->id());
+        if (bluos) {
+            // Status changes are delivered by the long-poll, no periodic refresh needed
+            bluos->startStatusPolling();
+        }
     }
 }
 
@@ -414,7 +411,6 @@ void IntegrationPluginBluOS::onActionExecuted(QUuid requestId, bool success)
         } else {
             info->finish(Thing::ThingErrorHardwareFailure);
         }
-        m_pluginTimer->timeout(); // get a status update
     }
 }
 
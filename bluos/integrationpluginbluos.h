@@ -36,13 +36,10 @@
 #include "integrations/integrationplugin.h"
 #include "platform/platformzeroconfcontroller.h"
 #include "network/zeroconf/zeroconfservicebrowser.h"
-#include "plugintimer.h"
 
 #include <QUdpSocket>
 #include <QNetworkAccessManager>
 
-class PluginTimer;
-
 class IntegrationPluginBluOS: public IntegrationPlugin
 {
     Q_OBJECT
@@ -65,7 +62,6 @@ public:
     void executeBrowserItem(BrowserActionInfo *info) override;
 
 private:
-    PluginTimer *m_pluginTimer = nullptr;
     ZeroConfServiceBrowser *m_serviceBrowser = nullptr;
 
     QHash<ThingId, BluOS *> m_bluos;
@@ -84,6 +84,7 @@ void IntegrationPluginBose::setupThing(ThingSetupInfo *info)
         info->thing()->setParamValue(soundtouchThingIpParamTypeId,ipAddress);
         SoundTouch *soundTouch = new SoundTouch(hardwareManager()->networkManager(), ipAddress, this);
         connect(soundTouch, &SoundTouch::connectionChanged, this, &IntegrationPluginBose::onConnectionChanged);
+        connect(soundTouch, &SoundTouch::notificationsConnectedChanged, this, &IntegrationPluginBose::onNotificationsConnectedChanged);
         connect(soundTouch, &SoundTouch::infoReceived, this, &IntegrationPluginBose::onInfoObjectReceived);
         connect(soundTouch, &SoundTouch::nowPlayingReceived, this, &IntegrationPluginBose::onNowPlayingObjectReceived);
         connect(soundTouch, &SoundTouch::volumeReceived, this, &IntegrationPluginBose::onVolumeObjectReceived);
@@ -116,7 +117,7 @@ void IntegrationPluginBose::postSetupThing(Thing *thing)
     }
 
     if (!m_pluginTimer) {
-        m_pluginTimer = hardwareManager()->pluginTimerManager()->registerTimer(2);
+        m_pluginTimer = hardwareManager()->pluginTimerManager()->registerTimer(10);
         connect(m_pluginTimer, &PluginTimer::timeout, this, &IntegrationPluginBose::onPluginTimer);
     }
 }
@@ -425,7 +426,12 @@ void IntegrationPluginBose::updateConsumerKey()
 
 void IntegrationPluginBose::onPluginTimer()
 {
+    // Speakers with a notification channel push their changes, poll them only once a minute
+    bool refreshAll = (m_pollCount++ % 6 == 0);
     foreach(SoundTouch *soundTouch, m_soundTouch.values()) {
+        if (soundTouch->notificationsConnected() && !refreshAll)
+            continue;
+
         soundTouch->getInfo();
         soundTouch->getNowPlaying();
         soundTouch->getVolume();
@@ -441,6 +447,19 @@ void IntegrationPluginBose::onConnectionChanged(bool connected)
     thing->setStateValue(soundtouchConnectedStateTypeId, connected);
 }
 
+void IntegrationPluginBose::onNotificationsConnectedChanged(bool connected)
+{
+    SoundTouch *soundtouch = static_cast<SoundTouch *>(sender());
+    Thing *thing = m_soundTouch.key(soundtouch);
+    qCDebug(dcBose()) << thing->name() << (connected ? "receives change notifications" : "lost change notifications, polling");
+    if (connected) {
+        // Changes while the channel was down are not repeated
+        soundtouch->getNowPlaying();
+        soundtouch->getVolume();
+        soundtouch->getBass();
+    }
+}
+
 void IntegrationPluginBose::onDeviceNameChanged()
 {
     Thing *thing = static_cast<Thing*>(sender());
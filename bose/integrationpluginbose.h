@@ -66,6 +66,7 @@ private:
     QString m_consumerKey;
     ZeroConfServiceBrowser *m_serviceBrowser = nullptr;
     PluginTimer *m_pluginTimer = nullptr;
+    int m_pollCount = 0;
 
     QHash<Thing *, SoundTouch *> m_soundTouch;
     QHash<QUuid, ThingActionInfo *> m_pendingActions;
@@ -77,6 +78,7 @@ private:
 private slots:
     void onPluginTimer();
     void onConnectionChanged(bool connected);
+    void onNotificationsConnectedChanged(bool connected);
     void onDeviceNameChanged();
     void onRequestExecuted(QUuid requestId, bool success);
 
@@ -38,19 +38,22 @@ SoundTouch::SoundTouch(NetworkAccessManager *networkAccessManager, QString ipAdd
     m_networkAccessManager(networkAccessManager),
     m_ipAddress(ipAddress)
 {
-    //THIS CODE IS LEFT INTENTIONALLY
-    //m_websocket = new QWebSocket();
-    //connect(m_websocket, &QWebSocket::connected, this, &SoundTouch::onWebsocketConnected);
-    //connect(m_websocket, &QWebSocket::disconnected, this, &SoundTouch::onWebsocketDisconnected);
-    //connect(m_websocket, &QWebSocket::textMessageReceived, this, &SoundTouch::onWebsocketMessageReceived);
-    //QUrl url;
-    //url.setHost(m_ipAddress);
-    //url.setScheme("ws");
-    //url.setPort(8080);
-    //qDebug(dcBose) << "Connecting websocket to" << url;
-    //TODO missing websocket subprotocol "gabbo"
-    //QWebsockets doesn't support subprotocols
-    //m_websocket->open(url);
+    // Change notifications are pushed on port 8080 using the "gabbo" sub-protocol
+    m_websocket = new QWebSocket(QString(), QWebSocketProtocol::VersionLatest, this);
+    connect(m_websocket, &QWebSocket::connected, this, &SoundTouch::onWebsocketConnected);
+    connect(m_websocket, &QWebSocket::disconnected, this, &SoundTouch::onWebsocketDisconnected);
+    connect(m_websocket, &QWebSocket::textMessageReceived, this, &SoundTouch::onWebsocketMessageReceived);
+    connect(m_websocket, static_cast<void(QWebSocket::*)(QAbstractSocket::SocketError)>(&QWebSocket::error), this, &SoundTouch::onWebsocketError);
+
+    m_websocketReconnectTimer = new QTimer(this);
+    m_websocketReconnectTimer->setSingleShot(true);
+    connect(m_websocketReconnectTimer, &QTimer::timeout, this, &SoundTouch::connectWebsocket);
+    connectWebsocket();
+}
+
+bool SoundTouch::notificationsConnected() const
+{
+    return m_websocketConnected;
 }
 
 QUuid SoundTouch::getInfo()
@@ -496,29 +499,89 @@ QUuid SoundTouch::setSpeaker(PlayInfoObject playInfo)
     return requestId;
 }
 
+void SoundTouch::connectWebsocket()
+{
+    QUrl url;
+    url.setHost(m_ipAddress);
+    url.setScheme("ws");
+    url.setPort(m_websocketPort);
+    QNetworkRequest request(url);
+    request.setRawHeader("Sec-WebSocket-Protocol", "gabbo");
+    qCDebug(dcBose()) << "Connecting websocket to" << url;
+    m_websocket->open(request);
+}
+
 void SoundTouch::onWebsocketConnected()
 {
-    qDebug(dcBose) << "Bose websocket connected";
+    qCDebug(dcBose()) << "Bose websocket connected" << m_ipAddress;
+    m_websocketConnected = true;
+    m_websocketReconnectInterval = 5;
     emit connectionChanged(true);
+    emit notificationsConnectedChanged(true);
 }
 
 void SoundTouch::onWebsocketDisconnected()
 {
-    qDebug(dcBose) << "Bose websocket disconnected";
-    emit connectionChanged(false);
-    QTimer::singleShot(5000, this, [this](){
-        QUrl url;
-        url.setHost(m_ipAddress);
-        url.setScheme("ws");
-        url.setPort(8080);
-        m_websocket->open(url);
-    });
+    // The REST API may still be reachable, the connected state is left to the HTTP requests
+    qCDebug(dcBose()) << "Bose websocket disconnected" << m_ipAddress << m_websocket->closeReason();
+    if (m_websocketConnected) {
+        m_websocketConnected = false;
+        emit notificationsConnectedChanged(false);
+    }
+    scheduleWebsocketReconnect();
+}
+
+void SoundTouch::onWebsocketError(QAbstractSocket::SocketError error)
+{
+    // Older firmwares don't offer the notification channel, polling continues in that case
+    qCDebug(dcBose()) << "Bose websocket error" << m_ipAddress << error << m_websocket->errorString();
+    if (m_websocket->state() == QAbstractSocket::UnconnectedState) {
+        scheduleWebsocketReconnect();
+    }
+}
+
+void SoundTouch::scheduleWebsocketReconnect()
+{
+    if (m_websocketReconnectTimer->isActive())
+        return;
+
+    m_websocketReconnectTimer->start(m_websocketReconnectInterval * 1000);
+    m_websocketReconnectInterval = qMin(m_websocketReconnectInterval * 2, 300);
 }
 
 void SoundTouch::onWebsocketMessageReceived(QString message)
 {
-    qDebug(dcBose) << "Websocket message received:" << message;
-    //TODO as soon as QWebSocket supports sub-protocols
+    qCDebug(dcBose()) << "Websocket message received:" << message;
+    QXmlStreamReader xml(message);
+    if (!xml.readNextStartElement())
+        return;
+
+    if (xml.name() != "updates") {
+        // e.g. the SoundTouchSdkInfo greeting after connecting
+        return;
+    }
+
+    while (xml.readNextStartElement()) {
+        if (xml.name() == "nowPlayingUpdated" || xml.name() == "volumeUpdated" ||
+                xml.name() == "presetsUpdated" || xml.name() == "zoneUpdated" || xml.name() == "bassUpdated") {
+            // The update wraps the same element the REST API returns
+            if (xml.readNextStartElement()) {
+                parseElement(QUuid(), xml);
+                xml.skipCurrentElement();
+            }
+        } else if (xml.name() == "infoUpdated" || xml.name() == "nameUpdated") {
+            getInfo();
+            xml.skipCurrentElement();
+        } else if (xml.name() == "sourcesUpdated") {
+            getSources();
+            xml.skipCurrentElement();
+        } else {
+            xml.skipCurrentElement();
+        }
+    }
+    if (xml.hasError()) {
+        qCWarning(dcBose()) << "Invalid websocket update" << xml.errorString();
+    }
 }
 
 QUuid SoundTouch::sendGetRequest(QString path)
@@ -620,355 +683,360 @@ void SoundTouch::parseData(QUuid requestId, const QByteArray &data)
     xml.addData(data);
 
     if (xml.readNextStartElement()) {
-        if (xml.name() == "info") {
-            InfoObject info;
-            if(xml.attributes().hasAttribute("deviceID")) {
-                //qDebug(dcBose) << "Device ID" << xml.attributes().value("deviceID").toString();
-                info.deviceID = xml.attributes().value("deviceID").toString();
-            }
-            while(xml.readNextStartElement()){
-                if(xml.name() == "name"){
-                    //qDebug(dcBose) << "name" << xml.readElementText();
-                    info.name =  xml.readElementText();
-                } else if(xml.name() == "type"){
-                    //qDebug(dcBose) << "type" << xml.readElementText();
-                    info.type =  xml.readElementText();
-                } else if(xml.name() == "components"){
-                    //qDebug(dcBose) << "components element";
-                    while(xml.readNextStartElement()){
-                        if(xml.name() == "component"){
-                            ComponentObject component;
-                            while(xml.readNextStartElement()){
-                                if(xml.name() == "softwareVersion"){
-                                    //qDebug(dcBose) << "Software version" << xml.readElementText();
-                                    component.softwareVersion = xml.readElementText();
-                                } else if(xml.name() == "serialNumber") {
-                                    //qDebug(dcBose) << "Serialnumber" << xml.readElementText();
-                                    component.serialNumber = xml.readElementText();
-                                } else {
-                                    xml.skipCurrentElement();
-                                }
+        parseElement(requestId, xml);
+    }
+}
+
+void SoundTouch::parseElement(QUuid requestId, QXmlStreamReader &xml)
+{
+    if (xml.name() == "info") {
+        InfoObject info;
+        if(xml.attributes().hasAttribute("deviceID")) {
+            //qDebug(dcBose) << "Device ID" << xml.attributes().value("deviceID").toString();
+            info.deviceID = xml.attributes().value("deviceID").toString();
+        }
+        while(xml.readNextStartElement()){
+            if(xml.name() == "name"){
+                //qDebug(dcBose) << "name" << xml.readElementText();
+                info.name =  xml.readElementText();
+            } else if(xml.name() == "type"){
+                //qDebug(dcBose) << "type" << xml.readElementText();
+                info.type =  xml.readElementText();
+            } else if(xml.name() == "components"){
+                //qDebug(dcBose) << "components element";
+                while(xml.readNextStartElement()){
+                    if(xml.name() == "component"){
+                        ComponentObject component;
+                        while(xml.readNextStartElement()){
+                            if(xml.name() == "softwareVersion"){
+                                //qDebug(dcBose) << "Software version" << xml.readElementText();
+                                component.softwareVersion = xml.readElementText();
+                            } else if(xml.name() == "serialNumber") {
+                                //qDebug(dcBose) << "Serialnumber" << xml.readElementText();
+                                component.serialNumber = xml.readElementText();
+                            } else {
+                                xml.skipCurrentElement();
                             }
-                            info.components.append(component);
-                        } else {
-                            xml.skipCurrentElement();
-                        }
-                    }
-                } else if(xml.name() == "networkInfo"){
-                    while (xml.readNextStartElement()) {
-                        if (xml.name() == "macAddress") {
-                            info.networkInfo.macAddress = xml.readElementText();
-                        } else if(xml.name() == "ipAddress") {
-                            info.networkInfo.ipAddress = xml.readElementText();
-                        } else {
-                            xml.skipCurrentElement();
                         }
+                        info.components.append(component);
+                    } else {
+                        xml.skipCurrentElement();
                     }
-                }  else {
-                    xml.skipCurrentElement();
                 }
-            }
-            emit infoReceived(requestId, info);
-        } else if (xml.name() == "nowPlaying") {
-            NowPlayingObject nowPlaying;
-            if(xml.attributes().hasAttribute("deviceID")) {
-                //qDebug(dcBose) << "Device ID" << xml.attributes().value("deviceID").toString();
-                nowPlaying.deviceID = xml.attributes().value("deviceID").toString();
-            }
-            if(xml.attributes().hasAttribute("source")) {
-                //qDebug(dcBose) << "Source" << xml.attributes().value("source").toString();
-                nowPlaying.source = xml.attributes().value("source").toString();
-            }
-            if(xml.attributes().hasAttribute("sourceAccount")) {
-                //qDebug(dcBose) << "Source Account" << xml.attributes().value("sourceAccount").toString();
-                nowPlaying.sourceAccount = xml.attributes().value("sourceAccount").toString();
-            }
-            while(xml.readNextStartElement()){
-                if (xml.name() == "track") {
-                    //qDebug(dcBose) << "track" << xml.readElementText();
-                    nowPlaying.track = xml.readElementText();
-                } else if(xml.name() == "artist") {
-                    //qDebug(dcBose) << "artist" << xml.readElementText();
-                    nowPlaying.artist = xml.readElementText();
-                } else if(xml.name() == "album") {
-                    //qDebug(dcBose) << "album" << xml.readElementText();
-                    nowPlaying.album = xml.readElementText();
-                } else if(xml.name() == "genre") {
-                    //qDebug(dcBose) << "genre" << xml.readElementText();
-                    nowPlaying.genre = xml.readElementText();
-                } else if(xml.name() == "rating") {
-                    //qDebug(dcBose) << "rating" << xml.readElementText();
-                    nowPlaying.rating = xml.readElementText();
-                } else if(xml.name() == "stationName") {
-                    //qDebug(dcBose) << "Station name" << xml.readElementText();
-                    nowPlaying.stationName = xml.readElementText();
-                } else if(xml.name() == "art") {
-                    ArtObject art;
-                    if(xml.attributes().hasAttribute("artImageStatus")) {
-                        QString artStatus = xml.attributes().value("artImageStatus").toString().toUpper();
-                        //ART_STATUS: INVALID, SHOW_DEFAULT_IMAGE, DOWNLOADING, IMAGE_PRESENT
-                        //qDebug(dcBose) << "Art Image status" << artStatus;
-                        if (artStatus == "INVALID") {
-                            art.artStatus = ART_STATUS_INVALID;
-                        } else if (artStatus == "SHOW_DEFAULT_IMAGE") {
-                            art.artStatus = ART_STATUS_SHOW_DEFAULT_IMAGE;
-                        }  else if (artStatus == "DOWNLOADING") {
-                            art.artStatus = ART_STATUS_DOWNLOADING;
-                        }  else if (artStatus == "IMAGE_PRESENT") {
-                            art.artStatus = ART_STATUS_IMAGE_PRESENT;
-                        }
-                    }
-                    nowPlaying.art.url = xml.readElementText();
-                }else if(xml.name() == "playStatus") {
-                    QString playStatus = xml.readElementText();
-                    //qDebug(dcBose) << "Play Status" << playStatus;
-                    //Modes: PLAY_STATE, PAUSE_STATE, STOP_STATE, BUFFERING_STATE
-                    if (playStatus == "PLAY_STATE") {
-                        nowPlaying.playStatus = PLAY_STATUS_PLAY_STATE;
-                    } else if (playStatus == "PAUSE_STATE") {
-                        nowPlaying.playStatus = PLAY_STATUS_PAUSE_STATE;
-                    } else if (playStatus == "STOP_STATE") {
-                        nowPlaying.playStatus = PLAY_STATUS_STOP_STATE;
-                    } else if (playStatus == "BUFFERING_STATE") {
-                        nowPlaying.playStatus = PLAY_STATUS_BUFFERING_STATE;
-                    }
-                } else if(xml.name() == "shuffleSetting") {
-                    QString shuffle = xml.readElementText().toUpper();
-                    //qDebug(dcBose) << "Shuffle Setting" << shuffle;
-                    if (shuffle == "SHUFFLE_ON") {
-                        nowPlaying.shuffleSetting = SHUFFLE_STATUS_SHUFFLE_ON;
+            } else if(xml.name() == "networkInfo"){
+                while (xml.readNextStartElement()) {
+                    if (xml.name() == "macAddress") {
+                        info.networkInfo.macAddress = xml.readElementText();
+                    } else if(xml.name() == "ipAddress") {
+                        info.networkInfo.ipAddress = xml.readElementText();
                     } else {
-                        nowPlaying.shuffleSetting = SHUFFLE_STATUS_SHUFFLE_OFF;
+                        xml.skipCurrentElement();
                     }
-                }else if(xml.name() == "repeatSetting") {
-                    QString repeat = xml.readElementText().toUpper();
-                    //qDebug(dcBose) << "Repeat Setting" << repeat;
-                    //Modes: REPEAT_OFF, REPEAT_ALL, REPEAT_ONE
-                    if (repeat == "REPEAT_OFF") {
-                        nowPlaying.repeatSettings = REPEAT_STATUS_REPEAT_OFF;
-                    } else if (repeat == "REPEAT_ONE") {
-                        nowPlaying.repeatSettings = REPEAT_STATUS_REPEAT_ONE;
-                    } else if (repeat == "REPEAT_ALL") {
-                        nowPlaying.repeatSettings = REPEAT_STATUS_REPEAT_ALL;
+                }
+            }  else {
+                xml.skipCurrentElement();
+            }
+        }
+        emit infoReceived(requestId, info);
+    } else if (xml.name() == "nowPlaying") {
+        NowPlayingObject nowPlaying;
+        if(xml.attributes().hasAttribute("deviceID")) {
+            //qDebug(dcBose) << "Device ID" << xml.attributes().value("deviceID").toString();
+            nowPlaying.deviceID = xml.attributes().value("deviceID").toString();
+        }
+        if(xml.attributes().hasAttribute("source")) {
+            //qDebug(dcBose) << "Source" << xml.attributes().value("source").toString();
+            nowPlaying.source = xml.attributes().value("source").toString();
+        }
+        if(xml.attributes().hasAttribute("sourceAccount")) {
+            //qDebug(dcBose) << "Source Account" << xml.attributes().value("sourceAccount").toString();
+            nowPlaying.sourceAccount = xml.attributes().value("sourceAccount").toString();
+        }
+        while(xml.readNextStartElement()){
+            if (xml.name() == "track") {
+                //qDebug(dcBose) << "track" << xml.readElementText();
+                nowPlaying.track = xml.readElementText();
+            } else if(xml.name() == "artist") {
+                //qDebug(dcBose) << "artist" << xml.readElementText();
+                nowPlaying.artist = xml.readElementText();
+            } else if(xml.name() == "album") {
+                //qDebug(dcBose) << "album" << xml.readElementText();
+                nowPlaying.album = xml.readElementText();
+            } else if(xml.name() == "genre") {
+                //qDebug(dcBose) << "genre" << xml.readElementText();
+                nowPlaying.genre = xml.readElementText();
+            } else if(xml.name() == "rating") {
+                //qDebug(dcBose) << "rating" << xml.readElementText();
+                nowPlaying.rating = xml.readElementText();
+            } else if(xml.name() == "stationName") {
+                //qDebug(dcBose) << "Station name" << xml.readElementText();
+                nowPlaying.stationName = xml.readElementText();
+            } else if(xml.name() == "art") {
+                ArtObject art;
+                if(xml.attributes().hasAttribute("artImageStatus")) {
+                    QString artStatus = xml.attributes().value("artImageStatus").toString().toUpper();
+                    //ART_STATUS: INVALID, SHOW_DEFAULT_IMAGE, DOWNLOADING, IMAGE_PRESENT
+                    //qDebug(dcBose) << "Art Image status" << artStatus;
+                    if (artStatus == "INVALID") {
+                        art.artStatus = ART_STATUS_INVALID;
+                    } else if (artStatus == "SHOW_DEFAULT_IMAGE") {
+                        art.artStatus = ART_STATUS_SHOW_DEFAULT_IMAGE;
+                    }  else if (artStatus == "DOWNLOADING") {
+                        art.artStatus = ART_STATUS_DOWNLOADING;
+                    }  else if (artStatus == "IMAGE_PRESENT") {
+                        art.artStatus = ART_STATUS_IMAGE_PRESENT;
                     }
-                } else if(xml.name() == "streamType") {
-                    QString streamType = xml.readElementText().toUpper();
-                    //qDebug(dcBose) << "Stream Type" << streamType;
-                    //Types: TRACK_ONDEMAND, RADIO_STREAMING, RADIO_TRACKS, NO_TRANSPORT_CONTROLS
-                    if (streamType == "RADIO_TRACKS") {
-                        nowPlaying.streamType = STREAM_STATUS_RADIO_TRACKS;
-                    } else if (streamType == "TRACK_ONDEMAND") {
-                        nowPlaying.streamType = STREAM_STATUS_TRACK_ONDEMAND;
-                    } else if (streamType == "RADIO_STREAMING") {
-                        nowPlaying.streamType = STREAM_STATUS_RADIO_STREAMING;
-                    } else if (streamType == "NO_TRANSPORT_CONTROLS") {
-                        nowPlaying.streamType = STREAM_STATUS_NO_TRANSPORT_CONTROLS;
-                    };
-                } else if(xml.name() == "stationLocation") {
-                    nowPlaying.stationLocation = xml.readElementText();
+                }
+                nowPlaying.art.url = xml.readElementText();
+            }else if(xml.name() == "playStatus") {
+                QString playStatus = xml.readElementText();
+                //qDebug(dcBose) << "Play Status" << playStatus;
+                //Modes: PLAY_STATE, PAUSE_STATE, STOP_STATE, BUFFERING_STATE
+                if (playStatus == "PLAY_STATE") {
+                    nowPlaying.playStatus = PLAY_STATUS_PLAY_STATE;
+                } else if (playStatus == "PAUSE_STATE") {
+                    nowPlaying.playStatus = PLAY_STATUS_PAUSE_STATE;
+                } else if (playStatus == "STOP_STATE") {
+                    nowPlaying.playStatus = PLAY_STATUS_STOP_STATE;
+                } else if (playStatus == "BUFFERING_STATE") {
+                    nowPlaying.playStatus = PLAY_STATUS_BUFFERING_STATE;
+                }
+            } else if(xml.name() == "shuffleSetting") {
+                QString shuffle = xml.readElementText().toUpper();
+                //qDebug(dcBose) << "Shuffle Setting" << shuffle;
+                if (shuffle == "SHUFFLE_ON") {
+                    nowPlaying.shuffleSetting = SHUFFLE_STATUS_SHUFFLE_ON;
                 } else {
-                    xml.skipCurrentElement();
+                    nowPlaying.shuffleSetting = SHUFFLE_STATUS_SHUFFLE_OFF;
                 }
-            }
-            emit nowPlayingReceived(requestId, nowPlaying);
-        } else if (xml.name() == "volume") {
-            VolumeObject volumeObject;
-            if(xml.attributes().hasAttribute("deviceID")) {
-                //qDebug(dcBose) << "Device ID" << xml.attributes().value("deviceID").toString();
-                volumeObject.deviceID = xml.attributes().value("deviceID").toString();
-            }
-            while(xml.readNextStartElement()){
-                if(xml.name() == "targetvolume"){
-                    //qDebug(dcBose) << "Target volume" << xml.readElementText();
-                    volumeObject.targetVolume = xml.readElementText().toInt();
-                }else if(xml.name() == "actualvolume"){
-                    //qDebug(dcBose) << "Actual volume" << xml.readElementText();
-                    volumeObject.actualVolume = xml.readElementText().toInt();
-                }else if(xml.name() == "muteenabled"){
-                    //qDebug(dcBose) << "Mute enabled" << xml.readElementText();
-                    volumeObject.muteEnabled = ( xml.readElementText().toUpper() == "TRUE" ); //TODO convert from "false" to bool
-                }else {
-                    xml.skipCurrentElement();
+            }else if(xml.name() == "repeatSetting") {
+                QString repeat = xml.readElementText().toUpper();
+                //qDebug(dcBose) << "Repeat Setting" << repeat;
+                //Modes: REPEAT_OFF, REPEAT_ALL, REPEAT_ONE
+                if (repeat == "REPEAT_OFF") {
+                    nowPlaying.repeatSettings = REPEAT_STATUS_REPEAT_OFF;
+                } else if (repeat == "REPEAT_ONE") {
+                    nowPlaying.repeatSettings = REPEAT_STATUS_REPEAT_ONE;
+                } else if (repeat == "REPEAT_ALL") {
+                    nowPlaying.repeatSettings = REPEAT_STATUS_REPEAT_ALL;
                 }
+            } else if(xml.name() == "streamType") {
+                QString streamType = xml.readElementText().toUpper();
+                //qDebug(dcBose) << "Stream Type" << streamType;
+                //Types: TRACK_ONDEMAND, RADIO_STREAMING, RADIO_TRACKS, NO_TRANSPORT_CONTROLS
+                if (streamType == "RADIO_TRACKS") {
+                    nowPlaying.streamType = STREAM_STATUS_RADIO_TRACKS;
+                } else if (streamType == "TRACK_ONDEMAND") {
+                    nowPlaying.streamType = STREAM_STATUS_TRACK_ONDEMAND;
+                } else if (streamType == "RADIO_STREAMING") {
+                    nowPlaying.streamType = STREAM_STATUS_RADIO_STREAMING;
+                } else if (streamType == "NO_TRANSPORT_CONTROLS") {
+                    nowPlaying.streamType = STREAM_STATUS_NO_TRANSPORT_CONTROLS;
+                };
+            } else if(xml.name() == "stationLocation") {
+                nowPlaying.stationLocation = xml.readElementText();
+            } else {
+                xml.skipCurrentElement();
             }
-            emit volumeReceived(requestId, volumeObject);
-        } else if (xml.name() == "sources") {
-            SourcesObject sourcesObject;
-            if(xml.attributes().hasAttribute("deviceID")) {
-                //qDebug(dcBose) << "Device ID" << xml.attributes().value("deviceID").toString();
-                sourcesObject.deviceId = xml.attributes().value("deviceID").toString();
+        }
+        emit nowPlayingReceived(requestId, nowPlaying);
+    } else if (xml.name() == "volume") {
+        VolumeObject volumeObject;
+        if(xml.attributes().hasAttribute("deviceID")) {
+            //qDebug(dcBose) << "Device ID" << xml.attributes().value("deviceID").toString();
+            volumeObject.deviceID = xml.attributes().value("deviceID").toString();
+        }
+        while(xml.readNextStartElement()){
+            if(xml.name() == "targetvolume"){
+                //qDebug(dcBose) << "Target volume" << xml.readElementText();
+                volumeObject.targetVolume = xml.readElementText().toInt();
+            }else if(xml.name() == "actualvolume"){
+                //qDebug(dcBose) << "Actual volume" << xml.readElementText();
+                volumeObject.actualVolume = xml.readElementText().toInt();
+            }else if(xml.name() == "muteenabled"){
+                //qDebug(dcBose) << "Mute enabled" << xml.readElementText();
+                volumeObject.muteEnabled = ( xml.readElementText().toUpper() == "TRUE" ); //TODO convert from "false" to bool
+            }else {
+                xml.skipCurrentElement();
             }
-            while(xml.readNextStartElement()){
-                if(xml.name() == "sourceItem"){
-                    SourceItemObject sourceItem;
-                    if(xml.attributes().hasAttribute("source")) {
-                        //qDebug(dcBose) << "Source" << xml.attributes().value("source").toString();
-                        sourceItem.source = xml.attributes().value("source").toString();
-                    }
-                    if(xml.attributes().hasAttribute("sourceAccount")) {
-                        //qDebug(dcBose) << "Source Account" << xml.attributes().value("sourceAccount").toString();
-                        sourceItem.sourceAccount = xml.attributes().value("sourceAccount").toString();
-                    }
-                    if(xml.attributes().hasAttribute("status")) {
-                        QString status = xml.attributes().value("status").toString().toUpper(); //UNAVAILABLE, READY
-                        //qDebug(dcBose) << "status" << status;
-                        if (status == "READY") {
-                            sourceItem.status = SOURCE_STATUS_READY;
-                        } else {
-                            sourceItem.status = SOURCE_STATUS_UNAVAILABLE;
-                        }
-                    }
-                    if(xml.attributes().hasAttribute("isLocal")) {
-                        //qDebug(dcBose) << "is Local" << xml.attributes().value("isLocal").toString();
-                        sourceItem.isLocal = ( xml.attributes().value("isLocal").toString().toUpper() == "TRUE" );
-                    }
-                    if(xml.attributes().hasAttribute("multiroomallowed")) {
-                        //qCDebug(dcBose) << "multiroom allowed" << xml.attributes().value("multiroomallowed").toString();
-                        sourceItem.multiroomallowed = ( xml.attributes().value("multiroomallowed").toString().toUpper() == "TRUE" );
+        }
+        emit volumeReceived(requestId, volumeObject);
+    } else if (xml.name() == "sources") {
+        SourcesObject sourcesObject;
+        if(xml.attributes().hasAttribute("deviceID")) {
+            //qDebug(dcBose) << "Device ID" << xml.attributes().value("deviceID").toString();
+            sourcesObject.deviceId = xml.attributes().value("deviceID").toString();
+        }
+        while(xml.readNextStartElement()){
+            if(xml.name() == "sourceItem"){
+                SourceItemObject sourceItem;
+                if(xml.attributes().hasAttribute("source")) {
+                    //qDebug(dcBose) << "Source" << xml.attributes().value("source").toString();
+                    sourceItem.source = xml.attributes().value("source").toString();
+                }
+                if(xml.attributes().hasAttribute("sourceAccount")) {
+                    //qDebug(dcBose) << "Source Account" << xml.attributes().value("sourceAccount").toString();
+                    sourceItem.sourceAccount = xml.attributes().value("sourceAccount").toString();
+                }
+                if(xml.attributes().hasAttribute("status")) {
+                    QString status = xml.attributes().value("status").toString().toUpper(); //UNAVAILABLE, READY
+                    //qDebug(dcBose) << "status" << status;
+                    if (status == "READY") {
+                        sourceItem.status = SOURCE_STATUS_READY;
+                    } else {
+                        sourceItem.status = SOURCE_STATUS_UNAVAILABLE;
                     }
-                    sourceItem.displayName = xml.readElementText();
-                    sourcesObject.sourceItems.append(sourceItem);
-                }else {
-                    xml.skipCurrentElement();
                 }
-            }
-            emit sourcesReceived(requestId, sourcesObject);
-        } else if (xml.name() == "bass") {
-            BassObject bassObject;
-            if(xml.attributes().hasAttribute("deviceID")) {
-                //qDebug(dcBose) << "Device ID" << xml.attributes().value("deviceID").toString();
-                bassObject.deviceID = xml.attributes().value("deviceID").toString();
-            }
-            while(xml.readNextStartElement()){
-                if(xml.name() == "targetbass"){
-                    //qDebug(dcBose) << "Target bas" << xml.readElementText();
-                    bassObject.targetBass = xml.readElementText().toInt();
-                } else if(xml.name() == "actualbass"){
-                    //qDebug(dcBose) << "Actual bass" << xml.readElementText();
-                    bassObject.actualBass = xml.readElementText().toInt();
-                } else {
-                    xml.skipCurrentElement();
+                if(xml.attributes().hasAttribute("isLocal")) {
+                    //qDebug(dcBose) << "is Local" << xml.attributes().value("isLocal").toString();
+                    sourceItem.isLocal = ( xml.attributes().value("isLocal").toString().toUpper() == "TRUE" );
+                }
+                if(xml.attributes().hasAttribute("multiroomallowed")) {
+                    //qCDebug(dcBose) << "multiroom allowed" << xml.attributes().value("multiroomallowed").toString();
+                    sourceItem.multiroomallowed = ( xml.attributes().value("multiroomallowed").toString().toUpper() == "TRUE" );
                 }
+                sourceItem.displayName = xml.readElementText();
+                sourcesObject.sourceItems.append(sourceItem);
+            }else {
+                xml.skipCurrentElement();
             }
-            emit bassReceived(requestId, bassObject);
-        } else if (xml.name() == "bassCapabilities") {
-            BassCapabilitiesObject bassCapabilities;
-            if(xml.attributes().hasAttribute("deviceID")) {
-                bassCapabilities.deviceID = xml.attributes().value("deviceID").toString();
+        }
+        emit sourcesReceived(requestId, sourcesObject);
+    } else if (xml.name() == "bass") {
+        BassObject bassObject;
+        if(xml.attributes().hasAttribute("deviceID")) {
+            //qDebug(dcBose) << "Device ID" << xml.attributes().value("deviceID").toString();
+            bassObject.deviceID = xml.attributes().value("deviceID").toString();
+        }
+        while(xml.readNextStartElement()){
+            if(xml.name() == "targetbass"){
+                //qDebug(dcBose) << "Target bas" << xml.readElementText();
+                bassObject.targetBass = xml.readElementText().toInt();
+            } else if(xml.name() == "actualbass"){
+                //qDebug(dcBose) << "Actual bass" << xml.readElementText();
+                bassObject.actualBass = xml.readElementText().toInt();
+            } else {
+                xml.skipCurrentElement();
             }
-            while(xml.readNextStartElement()){
-                if(xml.name() == "bassAvailable"){
-                    //qDebug(dcBose) << "BassAvailable" << xml.readElementText();
-                    bassCapabilities.bassAvailable = ( xml.readElementText().toUpper() == "TRUE" );
-                } else if(xml.name() == "bassMin"){
-                    //qDebug(dcBose) << "bass Min" << xml.readElementText();
-                    bassCapabilities.bassMin = xml.readElementText().toInt();
-                } else if(xml.name() == "bassMax"){
-                    //qDebug(dcBose) << "bass Max" << xml.readElementText();
-                    bassCapabilities.bassMax = xml.readElementText().toInt();
-                } else if(xml.name() == "bassDefault"){
-                    //qDebug(dcBose) << "bass default" << xml.readElementText();
-                    bassCapabilities.bassDefault = xml.readElementText().toInt();
-                }else {
-                    xml.skipCurrentElement();
-                }
+        }
+        emit bassReceived(requestId, bassObject);
+    } else if (xml.name() == "bassCapabilities") {
+        BassCapabilitiesObject bassCapabilities;
+        if(xml.attributes().hasAttribute("deviceID")) {
+            bassCapabilities.deviceID = xml.attributes().value("deviceID").toString();
+        }
+        while(xml.readNextStartElement()){
+            if(xml.name() == "bassAvailable"){
+                //qDebug(dcBose) << "BassAvailable" << xml.readElementText();
+                bassCapabilities.bassAvailable = ( xml.readElementText().toUpper() == "TRUE" );
+            } else if(xml.name() == "bassMin"){
+                //qDebug(dcBose) << "bass Min" << xml.readElementText();
+                bassCapabilities.bassMin = xml.readElementText().toInt();
+            } else if(xml.name() == "bassMax"){
+                //qDebug(dcBose) << "bass Max" << xml.readElementText();
+                bassCapabilities.bassMax = xml.readElementText().toInt();
+            } else if(xml.name() == "bassDefault"){
+                //qDebug(dcBose) << "bass default" << xml.readElementText();
+                bassCapabilities.bassDefault = xml.readElementText().toInt();
+            }else {
+                xml.skipCurrentElement();
             }
-            emit bassCapabilitiesReceived(requestId, bassCapabilities);
-        } else if (xml.name() == "presets") {
-            QList<PresetObject> presets;
-            qDebug(dcBose) << "Presets";
-            while(xml.readNextStartElement()){
-                if(xml.name() == "preset"){
-                    PresetObject preset;
-                    if(xml.attributes().hasAttribute("id")) {
-                        preset.presetId = xml.attributes().value("id").toInt();
-                    }
-                    if(xml.attributes().hasAttribute("createdOn")) {
-                        preset.createdOn= xml.attributes().value("createdOn").toULong();
-                    }
-                    if(xml.attributes().hasAttribute("updatedOn")) {
-                        preset.updatedOn = xml.attributes().value("updatedOn").toULong();
-                    }
-                    qDebug(dcBose) << "Preset" << preset.presetId;
-                    while(xml.readNextStartElement()){
+        }
+        emit bassCapabilitiesReceived(requestId, bassCapabilities);
+    } else if (xml.name() == "presets") {
+        QList<PresetObject> presets;
+        qDebug(dcBose) << "Presets";
+        while(xml.readNextStartElement()){
+            if(xml.name() == "preset"){
+                PresetObject preset;
+                if(xml.attributes().hasAttribute("id")) {
+                    preset.presetId = xml.attributes().value("id").toInt();
+                }
+                if(xml.attributes().hasAttribute("createdOn")) {
+                    preset.createdOn= xml.attributes().value("createdOn").toULong();
+                }
+                if(xml.attributes().hasAttribute("updatedOn")) {
+                    preset.updatedOn = xml.attributes().value("updatedOn").toULong();
+                }
+                qDebug(dcBose) << "Preset" << preset.presetId;
+                while(xml.readNextStartElement()){
 
-                        if (xml.name() == "ContentItem") {
-                            if(xml.attributes().hasAttribute("source")) {
-                                preset.ContentItem.source = xml.attributes().value("source").toString();
-                            }
-                            if(xml.attributes().hasAttribute("location")) {
-                                preset.ContentItem.location = xml.attributes().value("location").toString();
-                            }
-                            if(xml.attributes().hasAttribute("sourceAccount")) {
-                                preset.ContentItem.sourceAccount = xml.attributes().value("sourceAccount").toString();
-                            }
+                    if (xml.name() == "ContentItem") {
+                        if(xml.attributes().hasAttribute("source")) {
+                            preset.ContentItem.source = xml.attributes().value("source").toString();
+                        }
+                        if(xml.attributes().hasAttribute("location")) {
+                            preset.ContentItem.location = xml.attributes().value("location").toString();
+                        }
+                        if(xml.attributes().hasAttribute("sourceAccount")) {
+                            preset.ContentItem.sourceAccount = xml.attributes().value("sourceAccount").toString();
+                        }
 
-                            while(xml.readNextStartElement()){
-                                 if (xml.name() == "itemName") {
-                                    preset.ContentItem.itemName = xml.readElementText();
-                                 } else if (xml.name() == "containerArt"){
-                                    preset.ContentItem.containerArt = xml.readElementText();
-                                } else {
-                                     qCWarning(dcBose()) << "Presets: unhandled XML element" << xml.name();
-                                     xml.skipCurrentElement();
-                                }
+                        while(xml.readNextStartElement()){
+                             if (xml.name() == "itemName") {
+                                preset.ContentItem.itemName = xml.readElementText();
+                             } else if (xml.name() == "containerArt"){
+                                preset.ContentItem.containerArt = xml.readElementText();
+                            } else {
+                                 qCWarning(dcBose()) << "Presets: unhandled XML element" << xml.name();
+                                 xml.skipCurrentElement();
                             }
-
-                        } else {
-                            qCWarning(dcBose()) << "Presets: unhandled XML element" << xml.name();
-                            xml.skipCurrentElement();
                         }
+
+                    } else {
+                        qCWarning(dcBose()) << "Presets: unhandled XML element" << xml.name();
+                        xml.skipCurrentElement();
                     }
-                    presets.append(preset);
-                } else {
-                    qCWarning(dcBose()) << "Presets: unhandled XML element" << xml.name();
-                    xml.skipCurrentElement();
                 }
+                presets.append(preset);
+            } else {
+                qCWarning(dcBose()) << "Presets: unhandled XML element" << xml.name();
+                xml.skipCurrentElement();
             }
-            emit presetsReceived(requestId, presets);
+        }
+        emit presetsReceived(requestId, presets);
 
-        } else if (xml.name() == "group") {
-            GroupObject group;
-            if(xml.attributes().hasAttribute("deviceID")) {
-                group.id = xml.attributes().value("id").toString();
-            }
-            while(xml.readNextStartElement()){
-                if(xml.name() == "name") {
-                    group.name = xml.readElementText();
-                } else if(xml.name() == "masterDeviceId") {
-                    group.masterDeviceId = xml.readElementText();
-                } else if(xml.name() == "roles") {
-                    //group.roles = xml.readElementText().toInt();
-                } else if(xml.name() == "status"){
-                    QString groupStatus = xml.readElementText();
-                    //qDebug(dcBose) << "Group role" << groupStatus;
-                    //group.status = xml.readElementText();
-                }else {
-                    xml.skipCurrentElement();
-                }
-            }
-            emit groupReceived(requestId, group);
-        } else if (xml.name() == "zone") {
-            ZoneObject zone;
-            if(xml.attributes().hasAttribute("master")) {
-                zone.deviceID = xml.attributes().value("master").toString();
+    } else if (xml.name() == "group") {
+        GroupObject group;
+        if(xml.attributes().hasAttribute("deviceID")) {
+            group.id = xml.attributes().value("id").toString();
+        }
+        while(xml.readNextStartElement()){
+            if(xml.name() == "name") {
+                group.name = xml.readElementText();
+            } else if(xml.name() == "masterDeviceId") {
+                group.masterDeviceId = xml.readElementText();
+            } else if(xml.name() == "roles") {
+                //group.roles = xml.readElementText().toInt();
+            } else if(xml.name() == "status"){
+                QString groupStatus = xml.readElementText();
+                //qDebug(dcBose) << "Group role" << groupStatus;
+                //group.status = xml.readElementText();
+            }else {
+                xml.skipCurrentElement();
             }
-            while(xml.readNextStartElement()){
-                MemberObject member;
-                if(xml.name() == "member") {
-                    if(xml.attributes().hasAttribute("ipaddress")) {
-                        member.ipAddress = xml.attributes().value("ipaddress").toString();
-                    }
-                    member.deviceID = xml.readElementText();
-                } else {
-                    xml.skipCurrentElement();
+        }
+        emit groupReceived(requestId, group);
+    } else if (xml.name() == "zone") {
+        ZoneObject zone;
+        if(xml.attributes().hasAttribute("master")) {
+            zone.deviceID = xml.attributes().value("master").toString();
+        }
+        while(xml.readNextStartElement()){
+            MemberObject member;
+            if(xml.name() == "member") {
+                if(xml.attributes().hasAttribute("ipaddress")) {
+                    member.ipAddress = xml.attributes().value("ipaddress").toString();
                 }
-                zone.members.append(member);
+                member.deviceID = xml.readElementText();
+            } else {
+                xml.skipCurrentElement();
             }
-            emit zoneReceived(requestId, zone);
-        }
-        else {
-            xml.skipCurrentElement();
+            zone.members.append(member);
         }
+        emit zoneReceived(requestId, zone);
+    }
+    else {
+        xml.skipCurrentElement();
     }
 }
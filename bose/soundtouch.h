@@ -32,6 +32,7 @@
 #define SOUNDTOUCH_H
 
 #include <QObject>
+#include <QTimer>
 #include <QXmlStreamReader>
 #include <QtWebSockets/QtWebSockets>
 #include <QUuid>
@@ -49,6 +50,8 @@ class SoundTouch : public QObject
 public:
     explicit SoundTouch(NetworkAccessManager *networkAccessManager, QString ipAddress, QObject *parent = nullptr);
 
+    bool notificationsConnected() const; //Whether the websocket delivers change notifications
+
     QUuid getInfo();             //Get basic information about a product.
     QUuid getVolume();           //Get the current volume and mute status of a product.
     QUuid getNowPlaying();       //Get information about what's playing on a product.
@@ -82,11 +85,18 @@ private:
     QString m_ipAddress;
     int m_port = 8090;
     QWebSocket *m_websocket = nullptr;
+    QTimer *m_websocketReconnectTimer = nullptr;
+    int m_websocketPort = 8080;
+    int m_websocketReconnectInterval = 5;
+    bool m_websocketConnected = false;
     void emitRequestStatus(QUuid requestId, QNetworkReply *reply); //returns the status, -1 in case of error
     void parseData(QUuid requestId, const QByteArray &data);
+    void parseElement(QUuid requestId, QXmlStreamReader &xml);
+    void scheduleWebsocketReconnect();
 
 signals:
     void connectionChanged(bool connected);
+    void notificationsConnectedChanged(bool connected);
 
     void infoReceived(QUuid requestId, InfoObject info);
     void nowPlayingReceived(QUuid requestId, NowPlayingObject nowPlaying);
@@ -102,8 +112,10 @@ signals:
     void errorReceived(ErrorObject error);
 
 private slots:
+    void connectWebsocket();
     void onWebsocketConnected();
     void onWebsocketDisconnected();
+    void onWebsocketError(QAbstractSocket::SocketError error);
     void onWebsocketMessageReceived(QString message);
 };
 
@@ -0,0 +1,184 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "bluetoothconnectionlease.h"
+#include "bluetoothconnectionscheduler.h"
+
+#include <QMetaObject>
+
+BluetoothConnectionLease::BluetoothConnectionLease(BluetoothLowEnergyManager *bluetoothManager, BluetoothLowEnergyDevice *bluetoothDevice, QObject *parent) :
+    QObject(parent),
+    m_scheduler(BluetoothConnectionScheduler::instance(bluetoothManager)),
+    m_bluetoothDevice(bluetoothDevice)
+{
+    // Note: the scheduler might be implemented in another plugin library, use the meta object system only
+    if (!connect(m_scheduler, SIGNAL(connectionGranted(int)), this, SLOT(onConnectionGranted(int))) ||
+            !connect(m_scheduler, SIGNAL(connectionRevoked(int)), this, SLOT(onConnectionRevoked(int)))) {
+        qCWarning(dcBluetoothConnectionScheduler()) << "Could not connect to the connection scheduler signals.";
+    }
+    connect(m_bluetoothDevice, &BluetoothLowEnergyDevice::connectedChanged, this, &BluetoothConnectionLease::onConnectedChanged);
+
+    m_connectTimer.setInterval(30000);
+    m_connectTimer.setSingleShot(true);
+    connect(&m_connectTimer, &QTimer::timeout, this, [this](){
+        qCWarning(dcBluetoothConnectionScheduler()) << "Device" << m_bluetoothDevice->address().toString() << "did not connect in time. Returning the connection slot.";
+        m_bluetoothDevice->disconnectDevice();
+        release();
+    });
+}
+
+BluetoothConnectionLease::~BluetoothConnectionLease()
+{
+    release();
+}
+
+int BluetoothConnectionLease::maximumConnections(BluetoothLowEnergyManager *bluetoothManager)
+{
+    int maximumConnections = 0;
+    if (!QMetaObject::invokeMethod(BluetoothConnectionScheduler::instance(bluetoothManager), "maximumConnections", Qt::DirectConnection,
+                                   Q_RETURN_ARG(int, maximumConnections))) {
+        qCWarning(dcBluetoothConnectionScheduler()) << "Could not read the maximum connections from the connection scheduler.";
+    }
+    return maximumConnections;
+}
+
+void BluetoothConnectionLease::setMaximumConnections(BluetoothLowEnergyManager *bluetoothManager, int maximumConnections)
+{
+    if (!QMetaObject::invokeMethod(BluetoothConnectionScheduler::instance(bluetoothManager), "setMaximumConnections", Qt::DirectConnection,
+                                   Q_ARG(int, maximumConnections))) {
+        qCWarning(dcBluetoothConnectionScheduler()) << "Could not set the maximum connections of the connection scheduler.";
+    }
+}
+
+BluetoothConnectionLease::State BluetoothConnectionLease::state() const
+{
+    return m_state;
+}
+
+bool BluetoothConnectionLease::rotatable() const
+{
+    return m_rotatable;
+}
+
+void BluetoothConnectionLease::setRotatable(bool rotatable)
+{
+    m_rotatable = rotatable;
+}
+
+void BluetoothConnectionLease::request(BluetoothConnectionLease::Priority priority, int leaseTime)
+{
+    if (m_scheduler.isNull() || m_state == StateGranted)
+        return;
+
+    // Already waiting, requeue only if the new request is more important
+    if (m_state == StateQueued) {
+        if (priority <= m_priority)
+            return;
+
+        release();
+    }
+
+    int requestId = -1;
+    if (!QMetaObject::invokeMethod(m_scheduler, "requestConnection", Qt::DirectConnection,
+                                   Q_RETURN_ARG(int, requestId),
+                                   Q_ARG(QString, m_bluetoothDevice->address().toString()),
+                                   Q_ARG(int, static_cast<int>(priority)),
+                                   Q_ARG(int, leaseTime),
+                                   Q_ARG(bool, m_rotatable))) {
+        qCWarning(dcBluetoothConnectionScheduler()) << "Could not request a connection for" << m_bluetoothDevice->address().toString() << "from the connection scheduler.";
+        return;
+    }
+
+    m_requestId = requestId;
+    m_priority = priority;
+    m_leaseTime = leaseTime;
+    m_state = StateQueued;
+}
+
+void BluetoothConnectionLease::release()
+{
+    m_connectTimer.stop();
+
+    if (m_state == StateIdle)
+        return;
+
+    if (!m_scheduler.isNull() && !QMetaObject::invokeMethod(m_scheduler, "releaseConnection", Qt::DirectConnection, Q_ARG(int, m_requestId)))
+        qCWarning(dcBluetoothConnectionScheduler()) << "Could not release the connection of" << m_bluetoothDevice->address().toString();
+
+    m_requestId = -1;
+    m_state = StateIdle;
+}
+
+void BluetoothConnectionLease::onConnectionGranted(int requestId)
+{
+    if (requestId != m_requestId)
+        return;
+
+    m_state = StateGranted;
+    emit granted();
+
+    if (m_bluetoothDevice->connected())
+        return;
+
+    m_connectTimer.start();
+    m_bluetoothDevice->connectDevice();
+}
+
+void BluetoothConnectionLease::onConnectionRevoked(int requestId)
+{
+    if (requestId != m_requestId)
+        return;
+
+    // Note: the scheduler releases the slot itself
+    m_connectTimer.stop();
+    m_requestId = -1;
+    m_state = StateIdle;
+
+    emit revoked();
+    m_bluetoothDevice->disconnectDevice();
+
+    // Persistent connections only give their slot to others for a while
+    if (m_leaseTime == 0) {
+        request(qMin(m_priority, PriorityPersistent));
+    }
+}
+
+void BluetoothConnectionLease::onConnectedChanged(bool connected)
+{
+    if (connected) {
+        m_connectTimer.stop();
+        return;
+    }
+
+    // Return the slot once the device has been disconnected
+    if (m_state == StateGranted) {
+        release();
+    }
+}
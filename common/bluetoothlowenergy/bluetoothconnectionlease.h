@@ -0,0 +1,105 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef BLUETOOTHCONNECTIONLEASE_H
+#define BLUETOOTHCONNECTIONLEASE_H
+
+#include <QTimer>
+#include <QObject>
+#include <QPointer>
+
+#include "hardware/bluetoothlowenergy/bluetoothlowenergymanager.h"
+#include "hardware/bluetoothlowenergy/bluetoothlowenergydevice.h"
+
+// Note: use a lease instead of calling BluetoothLowEnergyDevice::connectDevice() directly. The device will be
+// connected once the shared BluetoothConnectionScheduler grants a connection slot and the slot will be returned
+// as soon as the device disconnects. Persistent leases (no lease time) may be taken back by the scheduler
+// when other devices are waiting, they are queued again automatically. Devices which report their state by
+// notifications would miss events while disconnected, their leases should disable the rotation.
+
+class BluetoothConnectionLease : public QObject
+{
+    Q_OBJECT
+public:
+    enum Priority {
+        PriorityPoll = 0,
+        PriorityPersistent = 1,
+        PriorityUserAction = 2
+    };
+    Q_ENUM(Priority)
+
+    enum State {
+        StateIdle,
+        StateQueued,
+        StateGranted
+    };
+    Q_ENUM(State)
+
+    explicit BluetoothConnectionLease(BluetoothLowEnergyManager *bluetoothManager, BluetoothLowEnergyDevice *bluetoothDevice, QObject *parent = nullptr);
+    ~BluetoothConnectionLease();
+
+    // Global limit of concurrent connections, shared by all plugins
+    static int maximumConnections(BluetoothLowEnergyManager *bluetoothManager);
+    static void setMaximumConnections(BluetoothLowEnergyManager *bluetoothManager, int maximumConnections);
+
+    State state() const;
+
+    // Applies to the next request, a granted persistent lease which is not rotatable is never taken back
+    bool rotatable() const;
+    void setRotatable(bool rotatable);
+
+    // Lease time in ms, 0 keeps the connection until released or disconnected
+    void request(Priority priority, int leaseTime = 0);
+    void release();
+
+signals:
+    void granted();
+    void revoked();
+
+private slots:
+    void onConnectionGranted(int requestId);
+    void onConnectionRevoked(int requestId);
+    void onConnectedChanged(bool connected);
+
+private:
+    QPointer<QObject> m_scheduler;
+    BluetoothLowEnergyDevice *m_bluetoothDevice = nullptr;
+
+    State m_state = StateIdle;
+    Priority m_priority = PriorityPoll;
+    int m_leaseTime = 0;
+    bool m_rotatable = true;
+    int m_requestId = -1;
+
+    // Return the slot if the device does not connect after it has been granted
+    QTimer m_connectTimer;
+};
+
+#endif // BLUETOOTHCONNECTIONLEASE_H
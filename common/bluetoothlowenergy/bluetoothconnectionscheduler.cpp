@@ -0,0 +1,214 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "bluetoothconnectionscheduler.h"
+#include "nymeasettings.h"
+
+#include <QSettings>
+
+Q_LOGGING_CATEGORY(dcBluetoothConnectionScheduler, "BluetoothConnectionScheduler")
+
+static const char *schedulerObjectName = "nymea-bluetooth-connection-scheduler";
+
+QObject *BluetoothConnectionScheduler::instance(BluetoothLowEnergyManager *bluetoothManager)
+{
+    // Note: the scheduler lives as child of the manager, so all plugins will find the same instance
+    QObject *scheduler = bluetoothManager->findChild<QObject *>(schedulerObjectName, Qt::FindDirectChildrenOnly);
+    if (!scheduler) {
+        scheduler = new BluetoothConnectionScheduler(bluetoothManager);
+        scheduler->setObjectName(schedulerObjectName);
+        scheduler->setProperty("interfaceVersion", interfaceVersion);
+    } else if (scheduler->property("interfaceVersion").toInt() != interfaceVersion) {
+        qCWarning(dcBluetoothConnectionScheduler()) << "The connection scheduler has been created by a plugin with interface version" << scheduler->property("interfaceVersion").toInt() << "but this plugin expects version" << interfaceVersion << "Please update all bluetooth plugins.";
+    }
+
+    return scheduler;
+}
+
+BluetoothConnectionScheduler::BluetoothConnectionScheduler(QObject *parent) :
+    QObject(parent)
+{
+    m_rotationTimer.setSingleShot(true);
+    connect(&m_rotationTimer, &QTimer::timeout, this, &BluetoothConnectionScheduler::schedule);
+
+    QSettings settings(NymeaSettings::settingsPath() + "/bluetoothconnections.conf", QSettings::IniFormat);
+    m_maximumConnections = qMax(1, settings.value("maximumConnections", m_maximumConnections).toInt());
+}
+
+int BluetoothConnectionScheduler::requestConnection(const QString &address, int priority, int leaseTime, bool rotatable)
+{
+    Request request;
+    request.id = m_nextRequestId++;
+    request.address = address;
+    request.priority = priority;
+    request.leaseTime = leaseTime;
+    request.rotatable = rotatable;
+
+    // Keep the queue sorted by priority, requests with the same priority are handled in order
+    int index = 0;
+    while (index < m_pendingRequests.count() && m_pendingRequests.at(index).priority >= priority)
+        index++;
+
+    m_pendingRequests.insert(index, request);
+    qCDebug(dcBluetoothConnectionScheduler()) << "Connection requested for" << address << "priority" << priority << "lease time" << leaseTime << "ms. Active:" << m_activeRequests.count() << "Pending:" << m_pendingRequests.count();
+
+    // Grant asynchronously, so the caller can store the request id before the granted signal arrives
+    QTimer::singleShot(0, this, &BluetoothConnectionScheduler::schedule);
+    return request.id;
+}
+
+void BluetoothConnectionScheduler::releaseConnection(int requestId)
+{
+    for (int i = 0; i < m_pendingRequests.count(); i++) {
+        if (m_pendingRequests.at(i).id == requestId) {
+            m_pendingRequests.removeAt(i);
+            return;
+        }
+    }
+
+    if (!m_activeRequests.contains(requestId))
+        return;
+
+    Request request = m_activeRequests.take(requestId);
+    QTimer *leaseTimer = m_leaseTimers.take(requestId);
+    if (leaseTimer)
+        leaseTimer->deleteLater();
+
+    qCDebug(dcBluetoothConnectionScheduler()) << "Connection released for" << request.address;
+    schedule();
+}
+
+int BluetoothConnectionScheduler::maximumConnections() const
+{
+    return m_maximumConnections;
+}
+
+void BluetoothConnectionScheduler::setMaximumConnections(int maximumConnections)
+{
+    maximumConnections = qMax(1, maximumConnections);
+    if (m_maximumConnections == maximumConnections)
+        return;
+
+    m_maximumConnections = maximumConnections;
+    qCDebug(dcBluetoothConnectionScheduler()) << "Maximum connections set to" << m_maximumConnections;
+
+    QSettings settings(NymeaSettings::settingsPath() + "/bluetoothconnections.conf", QSettings::IniFormat);
+    settings.setValue("maximumConnections", m_maximumConnections);
+
+    // Lowering the limit takes effect as connections are released
+    schedule();
+}
+
+int BluetoothConnectionScheduler::activeConnections() const
+{
+    return m_activeRequests.count();
+}
+
+int BluetoothConnectionScheduler::pendingConnections() const
+{
+    return m_pendingRequests.count();
+}
+
+void BluetoothConnectionScheduler::schedule()
+{
+    while (!m_pendingRequests.isEmpty()) {
+        if (m_activeRequests.count() >= m_maximumConnections) {
+            // All slots taken, try to get one back from a persistent lease
+            int candidate = takeBackCandidate(m_pendingRequests.first());
+            if (candidate < 0)
+                return;
+
+            revokeConnection(candidate);
+            continue;
+        }
+
+        Request request = m_pendingRequests.takeFirst();
+        request.grantTime.start();
+        m_activeRequests.insert(request.id, request);
+
+        if (request.leaseTime > 0) {
+            QTimer *leaseTimer = new QTimer(this);
+            leaseTimer->setSingleShot(true);
+            connect(leaseTimer, &QTimer::timeout, this, [this, request](){
+                qCWarning(dcBluetoothConnectionScheduler()) << "Connection lease expired for" << request.address;
+                emit connectionRevoked(request.id);
+                releaseConnection(request.id);
+            });
+            leaseTimer->start(request.leaseTime);
+            m_leaseTimers.insert(request.id, leaseTimer);
+        }
+
+        qCDebug(dcBluetoothConnectionScheduler()) << "Connection granted for" << request.address << "Active:" << m_activeRequests.count() << "Pending:" << m_pendingRequests.count();
+        emit connectionGranted(request.id);
+    }
+}
+
+int BluetoothConnectionScheduler::takeBackCandidate(const Request &waitingRequest)
+{
+    // Prefer the persistent lease which has been connected the longest
+    int candidate = -1;
+    qint64 candidateAge = -1;
+    qint64 nextRotation = -1;
+    foreach (const Request &request, m_activeRequests) {
+        if (request.leaseTime > 0 || !request.rotatable)
+            continue;
+
+        qint64 age = request.grantTime.elapsed();
+        if (waitingRequest.priority <= request.priority && age < m_rotationTime) {
+            if (nextRotation < 0 || m_rotationTime - age < nextRotation)
+                nextRotation = m_rotationTime - age;
+
+            continue;
+        }
+
+        if (age > candidateAge) {
+            candidate = request.id;
+            candidateAge = age;
+        }
+    }
+
+    // Check again once the first persistent lease may be rotated
+    if (candidate < 0 && nextRotation >= 0 && !m_rotationTimer.isActive())
+        m_rotationTimer.start(static_cast<int>(nextRotation) + 1);
+
+    return candidate;
+}
+
+void BluetoothConnectionScheduler::revokeConnection(int requestId)
+{
+    Request request = m_activeRequests.take(requestId);
+    QTimer *leaseTimer = m_leaseTimers.take(requestId);
+    if (leaseTimer)
+        leaseTimer->deleteLater();
+
+    qCDebug(dcBluetoothConnectionScheduler()) << "Taking back the connection of" << request.address << "after" << request.grantTime.elapsed() << "ms";
+    // Note: the lease queues itself again when revoked
+    emit connectionRevoked(requestId);
+}
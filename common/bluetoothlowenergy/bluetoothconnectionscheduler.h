@@ -0,0 +1,108 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef BLUETOOTHCONNECTIONSCHEDULER_H
+#define BLUETOOTHCONNECTIONSCHEDULER_H
+
+#include <QHash>
+#include <QTimer>
+#include <QObject>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+
+#include "hardware/bluetoothlowenergy/bluetoothlowenergymanager.h"
+
+Q_DECLARE_LOGGING_CATEGORY(dcBluetoothConnectionScheduler)
+
+// Note: Most bluetooth adapters can only handle a few concurrent LE links. The scheduler hands out a limited
+// number of connection slots for the adapter used by the BluetoothLowEnergyManager. There is only one scheduler
+// per process, shared by all plugins. Because each plugin library contains its own copy of this class, other
+// plugins must only access it through the meta object system (see BluetoothConnectionLease), never by casting.
+//
+// Leases without a lease time (persistent connections) don't block the adapter forever: a waiting request with
+// a higher priority takes the slot of the oldest persistent lease right away, any other waiting request once the
+// persistent lease has been held for the rotation time. The revoked lease is queued again. Leases which depend on
+// notifications of the device can opt out of the rotation.
+//
+// The limit of concurrent connections is one global setting stored next to the nymea settings, the last
+// configured value applies to all plugins.
+
+class BluetoothConnectionScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    // Increase whenever the invokable methods or signals change
+    static const int interfaceVersion = 2;
+
+    // Returns the process wide scheduler for this manager, creates it if not available yet
+    static QObject *instance(BluetoothLowEnergyManager *bluetoothManager);
+
+    explicit BluetoothConnectionScheduler(QObject *parent = nullptr);
+
+    // Priority: higher values will be granted first. Lease time in ms, 0 means until released.
+    // Persistent leases which are not rotatable keep their slot until they release it.
+    Q_INVOKABLE int requestConnection(const QString &address, int priority, int leaseTime, bool rotatable);
+    Q_INVOKABLE void releaseConnection(int requestId);
+
+    Q_INVOKABLE int maximumConnections() const;
+    Q_INVOKABLE void setMaximumConnections(int maximumConnections);
+
+    Q_INVOKABLE int activeConnections() const;
+    Q_INVOKABLE int pendingConnections() const;
+
+signals:
+    void connectionGranted(int requestId);
+    void connectionRevoked(int requestId);
+
+private:
+    struct Request {
+        int id = -1;
+        QString address;
+        int priority = 0;
+        int leaseTime = 0;
+        bool rotatable = true;
+        QElapsedTimer grantTime;
+    };
+
+    int m_maximumConnections = 4;
+    int m_nextRequestId = 1;
+    int m_rotationTime = 60000;
+    QTimer m_rotationTimer;
+
+    QList<Request> m_pendingRequests;
+    QHash<int, Request> m_activeRequests;
+    QHash<int, QTimer *> m_leaseTimers;
+
+    void schedule();
+    int takeBackCandidate(const Request &waitingRequest);
+    void revokeConnection(int requestId);
+};
+
+#endif // BLUETOOTHCONNECTIONSCHEDULER_H
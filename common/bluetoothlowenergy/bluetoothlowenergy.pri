@@ -0,0 +1,11 @@
+# Shared Bluetooth LE helpers for the bluetooth low energy plugins
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/bluetoothconnectionscheduler.h \
+    $$PWD/bluetoothconnectionlease.h
+
+SOURCES += \
+    $$PWD/bluetoothconnectionscheduler.cpp \
+    $$PWD/bluetoothconnectionlease.cpp
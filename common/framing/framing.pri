@@ -0,0 +1,9 @@
+# Shared message framing for the plugins reading byte streams
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/streamframer.h
+
+SOURCES += \
+    $$PWD/streamframer.cpp
@@ -0,0 +1,247 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "streamframer.h"
+
+StreamFramer::StreamFramer(const Settings &settings, QObject *parent) :
+    QObject(parent),
+    m_settings(settings)
+{
+    m_idleTimer = new QTimer(this);
+    m_idleTimer->setSingleShot(true);
+    // Serial lines use idle timeouts of a few milliseconds
+    m_idleTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_idleTimer, &QTimer::timeout, this, &StreamFramer::onIdleTimeout);
+}
+
+StreamFramer::Mode StreamFramer::modeFromString(const QString &mode)
+{
+    if (mode == "Delimiter") {
+        return ModeDelimiter;
+    } else if (mode == "Fixed size" || mode == "Fixed length") {
+        return ModeFixedLength;
+    } else if (mode == "Length prefixed" || mode == "Length field") {
+        return ModeLengthField;
+    }
+    return ModeIdleTimeout;
+}
+
+QByteArray StreamFramer::unescape(const QString &sequence)
+{
+    // Allows entering control characters like \r\n or \x03 in the settings
+    QByteArray input = sequence.toUtf8();
+    QByteArray output;
+    for (int i = 0; i < input.length(); i++) {
+        if (input.at(i) != '\\' || i + 1 >= input.length()) {
+            output.append(input.at(i));
+            continue;
+        }
+        char escaped = input.at(++i);
+        switch (escaped) {
+        case 'n':
+            output.append('\n');
+            break;
+        case 'r':
+            output.append('\r');
+            break;
+        case 't':
+            output.append('\t');
+            break;
+        case '0':
+            output.append('\0');
+            break;
+        case 'x': {
+            bool ok = false;
+            char value = static_cast<char>(input.mid(i + 1, 2).toInt(&ok, 16));
+            if (ok) {
+                output.append(value);
+                i += 2;
+            } else {
+                output.append("\\x");
+            }
+            break;
+        }
+        default:
+            output.append(escaped);
+        }
+    }
+    return output;
+}
+
+StreamFramer::Settings StreamFramer::settings() const
+{
+    return m_settings;
+}
+
+void StreamFramer::setSettings(const Settings &settings)
+{
+    m_settings = settings;
+    clear();
+}
+
+void StreamFramer::addData(const QByteArray &data)
+{
+    m_buffer.append(data);
+
+    if (m_settings.mode == ModeIdleTimeout) {
+        // Pass on what we have instead of growing the buffer any further
+        if (m_buffer.size() >= m_settings.maxFrameSize) {
+            onIdleTimeout();
+            return;
+        }
+        m_idleTimer->start(m_settings.idleTimeout);
+        return;
+    }
+
+    QByteArray frame;
+    while (takeFrame(frame)) {
+        emit frameReceived(frame);
+    }
+
+    // Compact once per read instead of once per frame
+    if (m_readPosition > 0) {
+        m_buffer.remove(0, m_readPosition);
+        m_scanPosition = qMax(0, m_scanPosition - m_readPosition);
+        m_readPosition = 0;
+    }
+}
+
+void StreamFramer::clear()
+{
+    m_idleTimer->stop();
+    m_buffer.clear();
+    m_readPosition = 0;
+    m_scanPosition = 0;
+}
+
+QByteArray StreamFramer::frame(const QByteArray &message) const
+{
+    switch (m_settings.mode) {
+    case ModeDelimiter:
+        if (m_settings.delimiter.isEmpty() || message.endsWith(m_settings.delimiter))
+            return message;
+        return message + m_settings.delimiter;
+    case ModeLengthField: {
+        // Only a leading length field can be generated, anything else is up to the sender
+        if (m_settings.lengthFieldOffset != 0 || !m_settings.stripLengthField)
+            return message;
+
+        QByteArray prefix;
+        quint64 length = static_cast<quint64>(message.length() - m_settings.lengthAdjustment);
+        for (int i = lengthFieldSize() - 1; i >= 0; i--) {
+            prefix.append(static_cast<char>((length >> (8 * i)) & 0xff));
+        }
+        return prefix + message;
+    }
+    default:
+        return message;
+    }
+}
+
+int StreamFramer::lengthFieldSize() const
+{
+    // The length is read into 32 bits
+    return qBound(1, m_settings.lengthFieldSize, 4);
+}
+
+bool StreamFramer::takeFrame(QByteArray &frame)
+{
+    int available = m_buffer.size() - m_readPosition;
+
+    switch (m_settings.mode) {
+    case ModeDelimiter: {
+        if (m_settings.delimiter.isEmpty())
+            return false;
+
+        int index = m_buffer.indexOf(m_settings.delimiter, qMax(m_scanPosition, m_readPosition));
+        if (index < 0) {
+            // Don't scan the same bytes again with the next read
+            m_scanPosition = qMax(m_readPosition, m_buffer.size() - m_settings.delimiter.size() + 1);
+            if (available > m_settings.maxFrameSize) {
+                clear();
+                emit framingError(QString("No delimiter within %1 bytes").arg(m_settings.maxFrameSize));
+            }
+            return false;
+        }
+        frame = m_buffer.mid(m_readPosition, index - m_readPosition);
+        m_readPosition = index + m_settings.delimiter.size();
+        m_scanPosition = m_readPosition;
+        return true;
+    }
+    case ModeFixedLength: {
+        int frameLength = qBound(1, m_settings.frameLength, m_settings.maxFrameSize);
+        if (available < frameLength)
+            return false;
+
+        frame = m_buffer.mid(m_readPosition, frameLength);
+        m_readPosition += frameLength;
+        return true;
+    }
+    case ModeLengthField: {
+        int header = m_settings.lengthFieldOffset + lengthFieldSize();
+        if (available < header)
+            return false;
+
+        quint32 length = 0;
+        for (int i = 0; i < lengthFieldSize(); i++) {
+            length = (length << 8) | static_cast<quint8>(m_buffer.at(m_readPosition + m_settings.lengthFieldOffset + i));
+        }
+        qint64 frameLength = header + static_cast<qint64>(length) + m_settings.lengthAdjustment;
+        qint64 messageLength = m_settings.stripLengthField ? frameLength - header : frameLength;
+        if (frameLength < header || messageLength > m_settings.maxFrameSize) {
+            // The stream can't be resynchronized after this
+            clear();
+            emit framingError(QString("Invalid frame length %1, the maximum is %2 bytes").arg(messageLength).arg(m_settings.maxFrameSize));
+            return false;
+        }
+        if (available < frameLength)
+            return false;
+
+        int start = m_settings.stripLengthField ? header : 0;
+        frame = m_buffer.mid(m_readPosition + start, static_cast<int>(frameLength) - start);
+        m_readPosition += static_cast<int>(frameLength);
+        return true;
+    }
+    case ModeIdleTimeout:
+        break;
+    }
+    return false;
+}
+
+void StreamFramer::onIdleTimeout()
+{
+    m_idleTimer->stop();
+    if (m_buffer.isEmpty())
+        return;
+
+    QByteArray frame = m_buffer;
+    m_buffer.clear();
+    emit frameReceived(frame);
+}
@@ -0,0 +1,94 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef STREAMFRAMER_H
+#define STREAMFRAMER_H
+
+#include <QObject>
+#include <QTimer>
+
+// Splits a byte stream, e.g. from a TCP socket or a serial port, into messages
+class StreamFramer : public QObject
+{
+    Q_OBJECT
+public:
+    enum Mode {
+        ModeIdleTimeout, // Everything received until the stream is quiet for the idle timeout
+        ModeDelimiter,   // Terminated by the delimiter, which is not part of the message
+        ModeFixedLength, // Messages of exactly frameLength bytes
+        ModeLengthField  // A big endian length field at a fixed offset gives the message size
+    };
+
+    struct Settings {
+        Mode mode = ModeIdleTimeout;
+        QByteArray delimiter = "\n";
+        int frameLength = 1;
+        int lengthFieldOffset = 0;
+        int lengthFieldSize = 1;
+        // Added to the length field value to get the bytes following the field, e.g. for a checksum
+        int lengthAdjustment = 0;
+        // Emit only the bytes following the length field
+        bool stripLengthField = false;
+        int idleTimeout = 50;
+        int maxFrameSize = 65536;
+    };
+
+    explicit StreamFramer(const Settings &settings, QObject *parent = nullptr);
+
+    static Mode modeFromString(const QString &mode);
+    static QByteArray unescape(const QString &sequence);
+
+    Settings settings() const;
+    void setSettings(const Settings &settings);
+
+    void addData(const QByteArray &data);
+    void clear();
+
+    // Wraps an outgoing message so the peer can split it the same way
+    QByteArray frame(const QByteArray &message) const;
+
+signals:
+    void frameReceived(const QByteArray &frame);
+    // The buffered data has been discarded, the stream is most likely out of sync
+    void framingError(const QString &error);
+
+private:
+    Settings m_settings;
+    QByteArray m_buffer;
+    int m_readPosition = 0;
+    int m_scanPosition = 0;
+    QTimer *m_idleTimer = nullptr;
+
+    int lengthFieldSize() const;
+    bool takeFrame(QByteArray &frame);
+    void onIdleTimeout();
+};
+
+#endif // STREAMFRAMER_H
@@ -0,0 +1,9 @@
+# Shared HTTP helpers for the plugins running a local HTTP server
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/httprequestparser.h
+
+SOURCES += \
+    $$PWD/httprequestparser.cpp
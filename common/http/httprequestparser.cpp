@@ -0,0 +1,268 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "httprequestparser.h"
+
+#include <QList>
+
+bool HttpRequestParser::Request::keepAlive() const
+{
+    QByteArray connection = headers.value("connection").toLower();
+    return version == "HTTP/1.1" ? !connection.contains("close") : connection.contains("keep-alive");
+}
+
+HttpRequestParser::HttpRequestParser(int maxHeaderSize, int maxBodySize) :
+    m_maxHeaderSize(maxHeaderSize),
+    m_maxBodySize(maxBodySize)
+{
+
+}
+
+void HttpRequestParser::addData(const QByteArray &data)
+{
+    if (m_error != ErrorNone)
+        return;
+
+    m_buffer.append(data);
+}
+
+void HttpRequestParser::clear()
+{
+    m_buffer.clear();
+    m_state = ParseStateRequestLine;
+    m_error = ErrorNone;
+    m_request = Request();
+    m_headerSize = 0;
+    m_remaining = 0;
+    m_continueRequested = false;
+}
+
+bool HttpRequestParser::takeRequest(Request *request)
+{
+    bool complete = false;
+    while (!complete && parseNext(&complete)) { }
+    if (!complete)
+        return false;
+
+    *request = m_request;
+    m_request = Request();
+    // Too late for an interim response, the final one follows right away
+    m_continueRequested = false;
+    m_state = ParseStateRequestLine;
+    return true;
+}
+
+bool HttpRequestParser::takeContinueRequest()
+{
+    bool continueRequested = m_continueRequested;
+    m_continueRequested = false;
+    return continueRequested;
+}
+
+HttpRequestParser::Error HttpRequestParser::error() const
+{
+    return m_error;
+}
+
+QByteArray HttpRequestParser::errorStatus() const
+{
+    switch (m_error) {
+    case ErrorNone:
+        break;
+    case ErrorBadRequest:
+        return "400 Bad Request";
+    case ErrorUriTooLong:
+        return "414 URI Too Long";
+    case ErrorHeaderTooLarge:
+        return "431 Request Header Fields Too Large";
+    case ErrorPayloadTooLarge:
+        return "413 Payload Too Large";
+    }
+    return QByteArray();
+}
+
+bool HttpRequestParser::readLine(QByteArray &line)
+{
+    int index = m_buffer.indexOf("\r\n");
+    if (index < 0)
+        return false;
+
+    line = m_buffer.left(index);
+    m_buffer.remove(0, index + 2);
+    return true;
+}
+
+bool HttpRequestParser::readHeaderLine(QByteArray &line)
+{
+    // The limit applies to the whole header block of a request, not to single lines
+    if (!readLine(line)) {
+        if (m_headerSize + m_buffer.size() > m_maxHeaderSize)
+            fail(ErrorHeaderTooLarge);
+        return false;
+    }
+    m_headerSize += line.size() + 2;
+    if (m_headerSize > m_maxHeaderSize)
+        return fail(ErrorHeaderTooLarge);
+
+    return true;
+}
+
+bool HttpRequestParser::parseNext(bool *complete)
+{
+    if (m_error != ErrorNone)
+        return false;
+
+    QByteArray line;
+    switch (m_state) {
+    case ParseStateRequestLine: {
+        if (!readLine(line)) {
+            if (m_buffer.size() > m_maxHeaderSize)
+                return fail(ErrorUriTooLong);
+            return false;
+        }
+        // Tolerate empty lines between keep-alive requests
+        if (line.isEmpty())
+            return true;
+
+        QList<QByteArray> tokens = line.split(' ');
+        if (tokens.count() != 3 || !tokens.at(2).startsWith("HTTP/1."))
+            return fail(ErrorBadRequest);
+
+        m_request = Request();
+        m_request.method = tokens.at(0);
+        m_request.path = tokens.at(1);
+        m_request.version = tokens.at(2);
+        m_headerSize = line.size() + 2;
+        if (m_headerSize > m_maxHeaderSize)
+            return fail(ErrorUriTooLong);
+
+        m_state = ParseStateHeaders;
+        return true;
+    }
+    case ParseStateHeaders: {
+        if (!readHeaderLine(line))
+            return false;
+
+        if (!line.isEmpty()) {
+            int separator = line.indexOf(':');
+            if (separator <= 0)
+                return fail(ErrorBadRequest);
+
+            m_request.headers.insert(line.left(separator).trimmed().toLower(), line.mid(separator + 1).trimmed());
+            return true;
+        }
+
+        // End of the header block
+        m_continueRequested = m_request.headers.value("expect").toLower() == "100-continue";
+        if (m_request.headers.value("transfer-encoding").toLower().contains("chunked")) {
+            m_state = ParseStateChunkSize;
+            return true;
+        }
+        bool ok = true;
+        m_remaining = m_request.headers.value("content-length", "0").toLongLong(&ok);
+        if (!ok || m_remaining < 0)
+            return fail(ErrorBadRequest);
+
+        if (m_remaining > m_maxBodySize)
+            return fail(ErrorPayloadTooLarge);
+
+        if (m_remaining == 0) {
+            *complete = true;
+            return true;
+        }
+        m_state = ParseStateBody;
+        return true;
+    }
+    case ParseStateBody: {
+        if (m_buffer.isEmpty())
+            return false;
+
+        int count = static_cast<int>(qMin<qint64>(m_remaining, m_buffer.size()));
+        m_request.body.append(m_buffer.left(count));
+        m_buffer.remove(0, count);
+        m_remaining -= count;
+        if (m_remaining > 0)
+            return false;
+
+        *complete = true;
+        return true;
+    }
+    case ParseStateChunkSize: {
+        if (!readLine(line)) {
+            if (m_buffer.size() > m_maxHeaderSize)
+                fail(ErrorBadRequest);
+            return false;
+        }
+        // Chunk extensions are ignored
+        bool ok;
+        m_remaining = line.split(';').first().trimmed().toLongLong(&ok, 16);
+        if (!ok || m_remaining < 0)
+            return fail(ErrorBadRequest);
+
+        if (m_request.body.size() + m_remaining > m_maxBodySize)
+            return fail(ErrorPayloadTooLarge);
+
+        m_state = m_remaining == 0 ? ParseStateChunkTrailer : ParseStateChunkData;
+        return true;
+    }
+    case ParseStateChunkData: {
+        // Chunk payload followed by CRLF
+        if (m_buffer.size() < m_remaining + 2)
+            return false;
+
+        if (m_buffer.mid(static_cast<int>(m_remaining), 2) != "\r\n")
+            return fail(ErrorBadRequest);
+
+        m_request.body.append(m_buffer.left(static_cast<int>(m_remaining)));
+        m_buffer.remove(0, static_cast<int>(m_remaining) + 2);
+        m_remaining = 0;
+        m_state = ParseStateChunkSize;
+        return true;
+    }
+    case ParseStateChunkTrailer: {
+        // Trailer fields count towards the header limit
+        if (!readHeaderLine(line))
+            return false;
+
+        if (line.isEmpty())
+            *complete = true;
+
+        return true;
+    }
+    }
+    return false;
+}
+
+bool HttpRequestParser::fail(Error error)
+{
+    m_error = error;
+    m_buffer.clear();
+    return false;
+}
@@ -0,0 +1,102 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HTTPREQUESTPARSER_H
+#define HTTPREQUESTPARSER_H
+
+#include <QByteArray>
+#include <QHash>
+
+// Incremental HTTP/1.1 request parser for one connection. Requests may be split across
+// or share segments, data is fed with addData() and complete requests are taken in order
+// with takeRequest(). Header and body sizes are bounded per request.
+class HttpRequestParser
+{
+public:
+    enum Error {
+        ErrorNone,
+        ErrorBadRequest,
+        ErrorUriTooLong,
+        ErrorHeaderTooLarge,
+        ErrorPayloadTooLarge
+    };
+
+    struct Request {
+        QByteArray method;
+        QByteArray path;
+        QByteArray version;
+        QHash<QByteArray, QByteArray> headers;
+        QByteArray body;
+
+        bool keepAlive() const;
+    };
+
+    explicit HttpRequestParser(int maxHeaderSize = 8192, int maxBodySize = 65536);
+
+    void addData(const QByteArray &data);
+    void clear();
+
+    // Returns false if more data is needed or the stream is invalid, see error()
+    bool takeRequest(Request *request);
+
+    // True once per request if the client waits for "100 Continue" before sending the body
+    bool takeContinueRequest();
+
+    Error error() const;
+    QByteArray errorStatus() const;
+
+private:
+    enum ParseState {
+        ParseStateRequestLine,
+        ParseStateHeaders,
+        ParseStateBody,
+        ParseStateChunkSize,
+        ParseStateChunkData,
+        ParseStateChunkTrailer
+    };
+
+    int m_maxHeaderSize;
+    int m_maxBodySize;
+
+    QByteArray m_buffer;
+    ParseState m_state = ParseStateRequestLine;
+    Error m_error = ErrorNone;
+    Request m_request;
+    int m_headerSize = 0;
+    qint64 m_remaining = 0;
+    bool m_continueRequested = false;
+
+    bool readLine(QByteArray &line);
+    bool readHeaderLine(QByteArray &line);
+    bool parseNext(bool *complete);
+    bool fail(Error error);
+};
+
+#endif // HTTPREQUESTPARSER_H
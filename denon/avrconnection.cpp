@@ -44,6 +44,17 @@ AvrConnection::AvrConnection(const QHostAddress &hostAddress, const int &port, Q
     // Note: error signal will be interpreted as function, not as signal in C++11
     connect(m_socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(onError(QAbstractSocket::SocketError)));
 
+    // Responses are dispatched by their command prefix, the longest matching prefix wins
+    registerResponseHandler("MV", &AvrConnection::onMasterVolumeResponse);
+    registerResponseHandler("SI", &AvrConnection::onInputSourceResponse);
+    registerResponseHandler("PW", &AvrConnection::onPowerResponse);
+    registerResponseHandler("MU", &AvrConnection::onMuteResponse);
+    registerResponseHandler("MS", &AvrConnection::onSurroundModeResponse);
+    registerResponseHandler("NSE", &AvrConnection::onNetAudioStatusResponse);
+    registerResponseHandler("PSTONE CTRL", &AvrConnection::onToneControlResponse);
+    registerResponseHandler("PSBAS", &AvrConnection::onBassLevelResponse);
+    registerResponseHandler("PSTRE", &AvrConnection::onTrebleLevelResponse);
+
    m_commandTimer = new QTimer(this);
    m_commandTimer->start(50); // 50ms is the minimum request interval specified
 
@@ -319,6 +330,7 @@ void AvrConnection::onConnected()
 void AvrConnection::onDisconnected()
 {
     qCDebug(dcDenon) << "disconnected from" << hostAddress().toString() << port();
+    m_receiveBuffer.clear();
     emit connectionStatusChanged(false);
 }
 
@@ -330,112 +342,158 @@ void AvrConnection::onError(QAbstractSocket::SocketError socketError)
 
 void AvrConnection::readData()
 {
-    QString data = QString(m_socket->readAll());
-
-    QStringList lines = data.split('\r');
-    foreach (QString line, lines) {
-        if(line.isEmpty())
-            continue;
-
-        qCDebug(dcDenon) << "Data received" << line;
-        if (line.contains("MV") && !data.contains("MAX")){
-            int index = data.indexOf("MV");
-            int volume = data.mid(index+2, 2).toInt();
-            emit volumeChanged(volume);
-
-        } else if (line.left(2).contains("SI")) {
-            QByteArray cmd;
-            if (data.contains("TUNER")) {
-                cmd = "TUNER";
-            } else if (data.contains("DVD")) {
-                cmd = "DVD";
-            } else if (data.contains("BD")) {
-                cmd = "BD";
-            } else if (data.contains("TV")) {
-                cmd = "TV";
-            } else if (data.contains("SAT/CBL")) {
-                cmd = "SAT/CBL";
-            } else if (data.contains("MPLAY")) {
-                cmd = "MPLAY";
-            } else if (data.contains("GAME")) {
-                cmd = "GAME";
-            } else if (data.contains("AUX1")) {
-                cmd = "AUX1";
-            } else if (data.contains("NET")) {
-                cmd = "NET";
-            } else if (data.contains("PANDORA")) {
-                cmd = "PANDORA";
-            } else if (data.contains("SIRIUSXM")) {
-                cmd = "SIRIUSXM";
-            } else if (data.contains("SPOTIFY")) {
-                cmd = "SPOTIFY";
-            } else if (data.contains("FLICKR")) {
-                cmd = "FLICKR";
-            } else if (data.contains("FAVORITES")) {
-                cmd = "FAVORITES";
-            } else if (data.contains("IRADIO")) {
-                cmd = "IRADIO";
-            } else if (data.contains("SERVER")) {
-                cmd = "SERVER";
-            } else if (data.contains("USB/IPOD")) {
-                cmd = "USB/IPOD";
-            } else if (data.contains("IPD")) {
-                cmd = "IPD";
-            } else if (data.contains("IRP")) {
-                cmd = "IRP";
-            } else if (data.contains("FVP")) {
-                cmd = "FVP";
-            }
-            emit channelChanged(cmd);
-        } else if (data.contains("PWON")) {
-            emit powerChanged(true);
-        } else if (data.contains("PWSTANDBY")) {
-            emit powerChanged(false);
-        } else if (data.contains("MUON")) {
-            emit muteChanged(true);
-        } else if (data.contains("MUOFF")) {
-            emit muteChanged(false);
-        } else if (data.left(2).contains("MS")) {
-            QString surroundMode = data.remove(0, 2).trimmed();
-            qCDebug(dcDenon()) << "Surround mode changed" << surroundMode;
-            emit surroundModeChanged(surroundMode);
-
-        } else if (data.left(4).contains("NSE0")) {
-            QString nowPlaying = QString(data).remove(0, 4).trimmed();
-            qCDebug(dcDenon()) << "Playbackstatus" << nowPlaying;
-            if (nowPlaying.contains("Now Playing")) {
-                emit playBackModeChanged(PlayBackMode::PlayBackModePlaying);
-            } else {
-                emit playBackModeChanged(PlayBackMode::PlayBackModeStopped);
-            }
-        } else if (data.left(4).contains("NSE1")) {
-            QString song = QString(data).remove(0, 5).trimmed();
-            qCDebug(dcDenon()) << "Song" << song;
-            emit songChanged(song);
-        } else if (data.left(4).contains("NSE2")) {
-            QString artist = QString(data).remove(0, 5).trimmed();
-            qCDebug(dcDenon()) << "Artist" << artist;
-            emit artistChanged(artist);
-        } else if (data.left(4).contains("NSE4")) {
-            QString album = QString(data).remove(0, 5).trimmed();
-            qCDebug(dcDenon()) << "Album" << album;
-            emit albumChanged(album);
-        } else if (data.contains("PSTONE CTRL ON")) {
-            qCDebug(dcDenon()) << "Tone control is on";
-            emit toneControlEnabledChanged(true);
-        } else if (data.contains("PSTONE CTRL OFF")) {
-            qCDebug(dcDenon()) << "Tone control is off";
-            emit toneControlEnabledChanged(false);
-        } else if (data.contains("PSBAS")) {
-            int index = data.indexOf("PSBAS");
-            int bass = data.mid(index+6, 2).toInt() - 50;
-            qCDebug(dcDenon()) << "Bass level" << bass;
-            emit bassLevelChanged(bass);
-        } else if (data.contains("PSTRE")) {
-            int index = data.indexOf("PSTRE");
-            int treble = data.mid(index+6, 2).toInt() - 50;
-            qCDebug(dcDenon()) << "Treble level" << treble;
-            emit trebleLevelChanged(treble);
+    m_receiveBuffer.append(m_socket->readAll());
+
+    // Every response is terminated by CR. Incomplete lines stay in the buffer until the rest arrives.
+    int start = 0;
+    int end;
+    while ((end = m_receiveBuffer.indexOf('\r', start)) != -1) {
+        QByteArray line = m_receiveBuffer.mid(start, end - start);
+        start = end + 1;
+        if (!line.isEmpty()) {
+            processLine(line);
+        }
+    }
+    m_receiveBuffer.remove(0, start);
+
+    if (m_receiveBuffer.size() > maxReceiveBufferSize) {
+        qCWarning(dcDenon()) << "Receive buffer overflow, discarding" << m_receiveBuffer.size() << "bytes";
+        m_receiveBuffer.clear();
+    }
+}
+
+void AvrConnection::processLine(const QByteArray &line)
+{
+    qCDebug(dcDenon) << "Data received" << line;
+
+    // Look up the longest matching command prefix
+    for (int length = qMin(m_maxPrefixLength, line.length()); length >= 2; length--) {
+        ResponseHandler handler = m_responseHandlers.value(line.left(length));
+        if (handler) {
+            (this->*handler)(line.mid(length));
+            return;
+        }
+    }
+
+    qCDebug(dcDenon()) << "Unhandled response" << line;
+}
+
+void AvrConnection::registerResponseHandler(const QByteArray &prefix, AvrConnection::ResponseHandler handler)
+{
+    m_responseHandlers.insert(prefix, handler);
+    m_maxPrefixLength = qMax(m_maxPrefixLength, prefix.length());
+}
+
+void AvrConnection::onMasterVolumeResponse(const QByteArray &parameter)
+{
+    // MVMAX reports the maximum volume, 3 digits are used for half steps (MV505)
+    if (parameter.startsWith("MAX"))
+        return;
+
+    emit volumeChanged(parameter.left(2).toInt());
+}
+
+void AvrConnection::onInputSourceResponse(const QByteArray &parameter)
+{
+    static const QList<QByteArray> sources = {
+        "TUNER", "DVD", "BD", "TV", "SAT/CBL", "MPLAY", "GAME", "AUX1", "NET", "PANDORA", "SIRIUSXM",
+        "SPOTIFY", "FLICKR", "FAVORITES", "IRADIO", "SERVER", "USB/IPOD", "IPD", "IRP", "FVP"
+    };
+
+    QByteArray source = parameter.trimmed();
+    if (!sources.contains(source)) {
+        qCDebug(dcDenon()) << "Unknown input source" << source;
+        return;
+    }
+    emit channelChanged(source);
+}
+
+void AvrConnection::onPowerResponse(const QByteArray &parameter)
+{
+    if (parameter == "ON") {
+        emit powerChanged(true);
+    } else if (parameter == "STANDBY") {
+        emit powerChanged(false);
+    }
+}
+
+void AvrConnection::onMuteResponse(const QByteArray &parameter)
+{
+    if (parameter == "ON") {
+        emit muteChanged(true);
+    } else if (parameter == "OFF") {
+        emit muteChanged(false);
+    }
+}
+
+void AvrConnection::onSurroundModeResponse(const QByteArray &parameter)
+{
+    QString surroundMode = parameter.trimmed();
+    qCDebug(dcDenon()) << "Surround mode changed" << surroundMode;
+    emit surroundModeChanged(surroundMode);
+}
+
+void AvrConnection::onNetAudioStatusResponse(const QByteArray &parameter)
+{
+    // NSE<line><text>, lines 1 to 8 have an additional cursor/flag byte in front of the text
+    if (parameter.isEmpty())
+        return;
+
+    switch (parameter.at(0)) {
+    case '0': {
+        QString nowPlaying = QString(parameter.mid(1)).trimmed();
+        qCDebug(dcDenon()) << "Playbackstatus" << nowPlaying;
+        if (nowPlaying.contains("Now Playing")) {
+            emit playBackModeChanged(PlayBackMode::PlayBackModePlaying);
+        } else {
+            emit playBackModeChanged(PlayBackMode::PlayBackModeStopped);
         }
+        break;
+    }
+    case '1': {
+        QString song = QString(parameter.mid(2)).trimmed();
+        qCDebug(dcDenon()) << "Song" << song;
+        emit songChanged(song);
+        break;
     }
+    case '2': {
+        QString artist = QString(parameter.mid(2)).trimmed();
+        qCDebug(dcDenon()) << "Artist" << artist;
+        emit artistChanged(artist);
+        break;
+    }
+    case '4': {
+        QString album = QString(parameter.mid(2)).trimmed();
+        qCDebug(dcDenon()) << "Album" << album;
+        emit albumChanged(album);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void AvrConnection::onToneControlResponse(const QByteArray &parameter)
+{
+    if (parameter == " ON") {
+        qCDebug(dcDenon()) << "Tone control is on";
+        emit toneControlEnabledChanged(true);
+    } else if (parameter == " OFF") {
+        qCDebug(dcDenon()) << "Tone control is off";
+        emit toneControlEnabledChanged(false);
+    }
+}
+
+void AvrConnection::onBassLevelResponse(const QByteArray &parameter)
+{
+    int bass = parameter.trimmed().left(2).toInt() - 50;
+    qCDebug(dcDenon()) << "Bass level" << bass;
+    emit bassLevelChanged(bass);
+}
+
+void AvrConnection::onTrebleLevelResponse(const QByteArray &parameter)
+{
+    int treble = parameter.trimmed().left(2).toInt() - 50;
+    qCDebug(dcDenon()) << "Treble level" << treble;
+    emit trebleLevelChanged(treble);
 }
@@ -36,6 +36,7 @@
 #include <QHostAddress>
 #include <QTimer>
 #include <QUuid>
+#include <QHash>
 
 class AvrConnection : public QObject
 {
@@ -96,14 +97,36 @@ public:
     QUuid increaseVolume();
     QUuid decreaseVolume();
 private:
+    typedef void (AvrConnection::*ResponseHandler)(const QByteArray &parameter);
+
     QTimer *m_commandTimer = nullptr;
     QTcpSocket *m_socket = nullptr;
     QHostAddress m_hostAddress;
     int m_port;
     QList<QPair<QUuid, QByteArray>> m_commandBuffer;
 
+    // Responses are CR terminated lines, a line may be split across reads
+    static const int maxReceiveBufferSize = 4096;
+    QByteArray m_receiveBuffer;
+
+    QHash<QByteArray, ResponseHandler> m_responseHandlers;
+    int m_maxPrefixLength = 0;
+
     QUuid sendCommand(const QByteArray &message);
 
+    void processLine(const QByteArray &line);
+    void registerResponseHandler(const QByteArray &prefix, ResponseHandler handler);
+
+    void onMasterVolumeResponse(const QByteArray &parameter);
+    void onInputSourceResponse(const QByteArray &parameter);
+    void onPowerResponse(const QByteArray &parameter);
+    void onMuteResponse(const QByteArray &parameter);
+    void onSurroundModeResponse(const QByteArray &parameter);
+    void onNetAudioStatusResponse(const QByteArray &parameter);
+    void onToneControlResponse(const QByteArray &parameter);
+    void onBassLevelResponse(const QByteArray &parameter);
+    void onTrebleLevelResponse(const QByteArray &parameter);
+
 private slots:
     void onConnected();
     void onDisconnected();
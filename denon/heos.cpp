@@ -34,11 +34,7 @@
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QJsonDocument>
-#include <QUrlQuery>
-
-#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
-#include <QRandomGenerator>
-#endif
+#include <QDateTime>
 
 Heos::Heos(const QHostAddress &hostAddress, QObject *parent) :
     QObject(parent),
@@ -58,6 +54,80 @@ Heos::Heos(const QHostAddress &hostAddress, QObject *parent) :
         qCDebug(dcDenon()) << "Heos: Reconnect timer timeout, trying to connect to" << m_hostAddress.toString();
         connectDevice();
     });
+
+    m_requestTimeoutTimer = new QTimer(this);
+    m_requestTimeoutTimer->setInterval(1000);
+    connect(m_requestTimeoutTimer, &QTimer::timeout, this, &Heos::onRequestTimeoutTimer);
+
+    // 4.1 System Commands
+    m_responseHandlers.insert("system/register_for_change_events", &Heos::onRegisterForChangeEventsResponse);
+    m_responseHandlers.insert("system/check_account", &Heos::onCheckAccountResponse);
+    m_responseHandlers.insert("system/sign_in", &Heos::onSignInResponse);
+    m_responseHandlers.insert("system/sign_out", &Heos::onSignOutResponse);
+    m_responseHandlers.insert("system/heart_beat", &Heos::onIgnoredResponse);
+    m_responseHandlers.insert("system/reboot", &Heos::onIgnoredResponse);
+    m_responseHandlers.insert("system/prettify_json_response", &Heos::onIgnoredResponse);
+
+    // 4.2 Player Commands
+    m_responseHandlers.insert("player/get_players", &Heos::onGetPlayersResponse);
+    m_responseHandlers.insert("player/get_player_info", &Heos::onGetPlayerInfoResponse);
+    m_responseHandlers.insert("player/get_now_playing_media", &Heos::onGetNowPlayingMediaResponse);
+    m_responseHandlers.insert("player/get_play_state", &Heos::onPlayStateResponse);
+    m_responseHandlers.insert("player/set_play_state", &Heos::onPlayStateResponse);
+    m_responseHandlers.insert("player/get_volume", &Heos::onPlayerVolumeResponse);
+    m_responseHandlers.insert("player/set_volume", &Heos::onPlayerVolumeResponse);
+    m_responseHandlers.insert("player/volume_up", &Heos::onIgnoredResponse);
+    m_responseHandlers.insert("player/volume_down", &Heos::onIgnoredResponse);
+    m_responseHandlers.insert("player/get_mute", &Heos::onPlayerMuteResponse);
+    m_responseHandlers.insert("player/set_mute", &Heos::onPlayerMuteResponse);
+    m_responseHandlers.insert("player/get_play_mode", &Heos::onPlayModeResponse);
+    m_responseHandlers.insert("player/set_play_mode", &Heos::onPlayModeResponse);
+    m_responseHandlers.insert("player/get_queue", &Heos::onIgnoredResponse);
+    m_responseHandlers.insert("player/clear_queue", &Heos::onIgnoredResponse);
+    m_responseHandlers.insert("player/move_queue_item", &Heos::onIgnoredResponse);
+    m_responseHandlers.insert("player/play_next", &Heos::onIgnoredResponse);
+    m_responseHandlers.insert("player/play_previous", &Heos::onIgnoredResponse);
+    m_responseHandlers.insert("player/check_update", &Heos::onCheckUpdateResponse);
+
+    // 4.3 Group Commands
+    m_responseHandlers.insert("group/get_groups", &Heos::onGetGroupsResponse);
+    m_responseHandlers.insert("group/get_group_info", &Heos::onGetGroupInfoResponse);
+    m_responseHandlers.insert("group/set_group", &Heos::onSetGroupResponse);
+    m_responseHandlers.insert("group/get_volume", &Heos::onGroupVolumeResponse);
+    m_responseHandlers.insert("group/set_volume", &Heos::onGroupVolumeResponse);
+    m_responseHandlers.insert("group/volume_up", &Heos::onIgnoredResponse);
+    m_responseHandlers.insert("group/volume_down", &Heos::onIgnoredResponse);
+    m_responseHandlers.insert("group/get_mute", &Heos::onGroupMuteResponse);
+    m_responseHandlers.insert("group/set_mute", &Heos::onGroupMuteResponse);
+    m_responseHandlers.insert("group/toggle_mute", &Heos::onIgnoredResponse);
+
+    // 4.4 Browse Commands
+    m_responseHandlers.insert("browse/get_music_sources", &Heos::onMusicSourcesResponse);
+    m_responseHandlers.insert("browse/get_source_info", &Heos::onMusicSourcesResponse);
+    m_responseHandlers.insert("browse/browse", &Heos::onBrowseResponse);
+    m_responseHandlers.insert("browse/get_search_criteria", &Heos::onIgnoredResponse);
+    m_responseHandlers.insert("browse/play_stream", &Heos::onIgnoredResponse);
+    m_responseHandlers.insert("browse/play_preset", &Heos::onIgnoredResponse);
+    m_responseHandlers.insert("browse/play_input", &Heos::onIgnoredResponse);
+    m_responseHandlers.insert("browse/add_to_queue", &Heos::onIgnoredResponse);
+    m_responseHandlers.insert("browse/rename_playlist", &Heos::onIgnoredResponse);
+    m_responseHandlers.insert("browse/delete_playlist", &Heos::onIgnoredResponse);
+    m_responseHandlers.insert("browse/retrieve_metadata", &Heos::onIgnoredResponse);
+
+    // 5. Change Events (Unsolicited Responses)
+    m_responseHandlers.insert("event/sources_changed", &Heos::onSourcesChangedEvent);
+    m_responseHandlers.insert("event/players_changed", &Heos::onPlayersChangedEvent);
+    m_responseHandlers.insert("event/groups_changed", &Heos::onGroupsChangedEvent);
+    m_responseHandlers.insert("event/player_state_changed", &Heos::onPlayStateResponse);
+    m_responseHandlers.insert("event/player_now_playing_changed", &Heos::onPlayerNowPlayingChangedEvent);
+    m_responseHandlers.insert("event/player_now_playing_progress", &Heos::onPlayerNowPlayingProgressEvent);
+    m_responseHandlers.insert("event/player_playback_error", &Heos::onPlayerPlaybackErrorEvent);
+    m_responseHandlers.insert("event/player_queue_changed", &Heos::onPlayerQueueChangedEvent);
+    m_responseHandlers.insert("event/player_volume_changed", &Heos::onPlayerVolumeChangedEvent);
+    m_responseHandlers.insert("event/repeat_mode_changed", &Heos::onPlayModeResponse);
+    m_responseHandlers.insert("event/shuffle_mode_changed", &Heos::onPlayModeResponse);
+    m_responseHandlers.insert("event/group_volume_changed", &Heos::onGroupVolumeChangedEvent);
+    m_responseHandlers.insert("event/user_changed", &Heos::onUserChangedEvent);
 }
 
 Heos::~Heos()
@@ -83,6 +153,7 @@ void Heos::setAddress(QHostAddress address)
     qCDebug(dcDenon()) << "Heos: Set address" << address.toString();
     if (address != m_hostAddress) {
         m_hostAddress = address;
+        clearBrowseCache();
         m_socket->disconnectFromHost();
         // Reconnect after the disconnect event has been emitted
     }
@@ -101,61 +172,49 @@ void Heos::disconnectDevice()
 
 
 /********************************
- *        PLAYER COMMANDS
+ *        SYSTEM COMMANDS
  ********************************/
 void Heos::registerForChangeEvents(bool state)
 {
-    QByteArray query;
-
-    if (state) {
-        query = "?enable=on";
-    } else {
-        query = "?enable=off";
-    }
-    QByteArray cmd = "heos://system/register_for_change_events" + query + "\r\n";
-    qCDebug(dcDenon) << "Register for change events:" << cmd;
-    m_socket->write(cmd);
+    QUrlQuery query;
+    query.addQueryItem("enable", state ? "on" : "off");
+    qCDebug(dcDenon) << "Register for change events:" << state;
+    sendRequest("system/register_for_change_events", query);
 }
 
 void Heos::sendHeartbeat()
 {
-    QByteArray cmd = "heos://system/heart_beat\r\n";
-    m_socket->write(cmd);
+    sendRequest("system/heart_beat");
 }
 
 void Heos::getUserAccount()
 {
-    QByteArray cmd = "heos://system/check_account\r\n";
-    m_socket->write(cmd);
+    sendRequest("system/check_account");
 }
 
 void Heos::setUserAccount(QString userName, QString password)
 {
-    QByteArray cmd = "heos://system/sign_in?un=" + userName.toLocal8Bit() + "&pw=" + password.toLocal8Bit() + "\r\n";
-    m_socket->write(cmd);
+    QUrlQuery query;
+    query.addQueryItem("un", userName);
+    query.addQueryItem("pw", password);
+    sendRequest("system/sign_in", query);
 }
 
 void Heos::logoutUserAccount()
 {
-    QByteArray cmd = "heos://system/sign_out\r\n";
-    m_socket->write(cmd);
+    sendRequest("system/sign_out");
 }
 
 void Heos::rebootSpeaker()
 {
-    QByteArray cmd = "heos://system/reboot\r\n";
-    m_socket->write(cmd);
+    sendRequest("system/reboot");
 }
 
 void Heos::prettifyJsonResponse(bool enable)
 {
-    QByteArray cmd = "heos://system/prettify_json_response?enable=";
-    if (enable) {
-        cmd.append("on=\r\n");
-    } else {
-        cmd.append("off=\r\n");
-    }
-    m_socket->write(cmd);
+    QUrlQuery query;
+    query.addQueryItem("enable", enable ? "on" : "off");
+    sendRequest("system/prettify_json_response", query);
 }
 
 /********************************
@@ -163,167 +222,138 @@ void Heos::prettifyJsonResponse(bool enable)
  ********************************/
 void Heos::playNext(int playerId)
 {
-    QByteArray cmd = "heos://player/play_next?pid=" + QVariant(playerId).toByteArray() + "\r\n";
-    qCDebug(dcDenon) << "Play next:" << cmd;
-    m_socket->write(cmd);
+    qCDebug(dcDenon) << "Play next:" << playerId;
+    sendRequest("player/play_next", playerQuery(playerId));
 }
 
 void Heos::playPrevious(int playerId)
 {
-    QByteArray cmd = "heos://player/play_previous?pid=" + QVariant(playerId).toByteArray() + "\r\n";
-    qCDebug(dcDenon) << "Play previous:" << cmd;
-    m_socket->write(cmd);
+    qCDebug(dcDenon) << "Play previous:" << playerId;
+    sendRequest("player/play_previous", playerQuery(playerId));
 }
 
 void Heos::volumeUp(int playerId, int step)
 {
-    QByteArray cmd = "heos://player/volume_up?pid=" + QVariant(playerId).toByteArray() + "&step=" + QVariant(step).toByteArray() + "\r\n";
-    qCDebug(dcDenon) << "Volume up:" << cmd;
-    m_socket->write(cmd);
+    QUrlQuery query = playerQuery(playerId);
+    query.addQueryItem("step", QString::number(step));
+    qCDebug(dcDenon) << "Volume up:" << query.toString();
+    sendRequest("player/volume_up", query);
 }
 
 void Heos::volumeDown(int playerId, int step)
 {
-    QByteArray cmd = "heos://player/volume_down?pid=" + QVariant(playerId).toByteArray() + "&step=" + QVariant(step).toByteArray() + "\r\n";
-    qCDebug(dcDenon) << "Volume down:" << cmd;
-    m_socket->write(cmd);
+    QUrlQuery query = playerQuery(playerId);
+    query.addQueryItem("step", QString::number(step));
+    qCDebug(dcDenon) << "Volume down:" << query.toString();
+    sendRequest("player/volume_down", query);
 }
 
 void Heos::clearQueue(int playerId)
 {
-    QByteArray cmd = "heos://player/clear_queue?pid=" + QVariant(playerId).toByteArray() + "\r\n";
-    qCDebug(dcDenon) << "clear queue:" << cmd;
-    m_socket->write(cmd);
+    qCDebug(dcDenon) << "clear queue:" << playerId;
+    sendRequest("player/clear_queue", playerQuery(playerId));
 }
 
 void Heos::moveQueue(int playerId, int sourcQueueId, int destinationQueueId)
 {
-    QByteArray cmd("heos://player/move_queue_item?");
-    QUrlQuery queryParams;
-    queryParams.addQueryItem("pid", QString::number(playerId));
-    queryParams.addQueryItem("sqid", QString::number(sourcQueueId));
-    queryParams.addQueryItem("dqid", QString::number(destinationQueueId));
-    cmd.append(queryParams.toString());
-    cmd.append("\r\n");
-    qCDebug(dcDenon) << "moving queue:" << cmd;
-    m_socket->write(cmd);
+    QUrlQuery query = playerQuery(playerId);
+    query.addQueryItem("sqid", QString::number(sourcQueueId));
+    query.addQueryItem("dqid", QString::number(destinationQueueId));
+    qCDebug(dcDenon) << "moving queue:" << query.toString();
+    sendRequest("player/move_queue_item", query);
 }
 
 void Heos::checkForFirmwareUpdate(int playerId)
 {
-    QByteArray cmd = "heos://player/check_update?pid=" + QVariant(playerId).toByteArray() + "\r\n";
-    qCDebug(dcDenon) << "Check firmware update:" << cmd;
-    m_socket->write(cmd);
+    qCDebug(dcDenon) << "Check firmware update:" << playerId;
+    sendRequest("player/check_update", playerQuery(playerId));
 }
+
 void Heos::getNowPlayingMedia(int playerId)
 {
-    QByteArray cmd = "heos://player/get_now_playing_media?pid=" + QVariant(playerId).toByteArray() + "\r\n";
-    m_socket->write(cmd);
+    sendRequest("player/get_now_playing_media", playerQuery(playerId));
 }
 
 void Heos::getPlayers()
 {
-    QByteArray cmd = "heos://player/get_players\r\n";
-    m_socket->write(cmd);
+    sendRequest("player/get_players");
 }
 
 void Heos::getPlayerInfo(int playerId)
 {
-    QByteArray cmd = "heos://player/get_player_info?pid=" + QVariant(playerId).toByteArray() + "\r\n";
-    qCDebug(dcDenon) << "Get player info:" << cmd;
-    m_socket->write(cmd);
+    qCDebug(dcDenon) << "Get player info:" << playerId;
+    sendRequest("player/get_player_info", playerQuery(playerId));
 }
 
 void Heos::getVolume(int playerId)
 {
-    QByteArray cmd = "heos://player/get_volume?pid=" + QVariant(playerId).toByteArray() + "\r\n";
-    m_socket->write(cmd);
+    sendRequest("player/get_volume", playerQuery(playerId));
 }
 
 void Heos::setVolume(int playerId, int volume)
 {
-    QByteArray cmd = "heos://player/set_volume?pid=" + QVariant(playerId).toByteArray() + "&level=" + QVariant(volume).toByteArray() + "\r\n";
-    qCDebug(dcDenon) << "Set volume:" << cmd;
-    m_socket->write(cmd);
+    QUrlQuery query = playerQuery(playerId);
+    query.addQueryItem("level", QString::number(volume));
+    qCDebug(dcDenon) << "Set volume:" << query.toString();
+    sendRequest("player/set_volume", query);
 }
 
 void Heos::getMute(int playerId)
 {
-    QByteArray cmd = "heos://player/get_mute?pid=" + QVariant(playerId).toByteArray() + "\r\n";
-    m_socket->write(cmd);
+    sendRequest("player/get_mute", playerQuery(playerId));
 }
 
 void Heos::setMute(int playerId, bool state)
 {
-    QByteArray stateQuery;
-    if(state) {
-        stateQuery = "&state=on";
-    } else {
-        stateQuery = "&state=off";
-    }
-    QByteArray cmd = "heos://player/set_mute?pid=" + QVariant(playerId).toByteArray() + stateQuery + "\r\n";
-    qCDebug(dcDenon) << "Set mute:" << cmd;
-    m_socket->write(cmd);
+    QUrlQuery query = playerQuery(playerId);
+    query.addQueryItem("state", state ? "on" : "off");
+    qCDebug(dcDenon) << "Set mute:" << query.toString();
+    sendRequest("player/set_mute", query);
 }
 
 void Heos::setPlayerState(int playerId, PLAYER_STATE state)
 {
-    QByteArray playerStateQuery;
-
+    QUrlQuery query = playerQuery(playerId);
     if (state == PLAYER_STATE_PLAY){
-        playerStateQuery = "&state=play";
+        query.addQueryItem("state", "play");
     } else if (state == PLAYER_STATE_PAUSE){
-        playerStateQuery = "&state=pause";
+        query.addQueryItem("state", "pause");
     } else if (state == PLAYER_STATE_STOP){
-        playerStateQuery = "&state=stop";
+        query.addQueryItem("state", "stop");
     }
-
-    QByteArray cmd = "heos://player/set_play_state?pid=" + QVariant(playerId).toByteArray() + playerStateQuery + "\r\n";
-    qCDebug(dcDenon) << "Set play mode:" << cmd;
-    m_socket->write(cmd);
+    qCDebug(dcDenon) << "Set play state:" << query.toString();
+    sendRequest("player/set_play_state", query);
 }
 
 void Heos::getPlayerState(int playerId)
 {
-    QByteArray cmd = "heos://player/get_play_state?pid=" + QVariant(playerId).toByteArray() + "\r\n";
-    m_socket->write(cmd);
+    sendRequest("player/get_play_state", playerQuery(playerId));
 }
 
 
 void Heos::setPlayMode(int playerId, REPEAT_MODE repeatMode, bool shuffle)
 {
-    QByteArray repeatModeQuery;
-
+    QUrlQuery query = playerQuery(playerId);
     if (repeatMode == REPEAT_MODE_OFF) {
-        repeatModeQuery = "&repeat=off";
+        query.addQueryItem("repeat", "off");
     } else if (repeatMode == REPEAT_MODE_ONE) {
-        repeatModeQuery = "&repeat=on_one";
+        query.addQueryItem("repeat", "on_one");
     } else if (repeatMode == REPEAT_MODE_ALL) {
-        repeatModeQuery = "&repeat=on_all";
+        query.addQueryItem("repeat", "on_all");
     }
-
-    QByteArray shuffleQuery;
-    if (shuffle) {
-        shuffleQuery = "&shuffle=on";
-    } else {
-        shuffleQuery = "&shuffle=off";
-    }
-
-    QByteArray cmd = "heos://player/set_play_mode?pid=" + QVariant(playerId).toByteArray() + repeatModeQuery + shuffleQuery + "\r\n";
-    qCDebug(dcDenon) << "Set play mode:" << cmd;
-    m_socket->write(cmd);
+    query.addQueryItem("shuffle", shuffle ? "on" : "off");
+    qCDebug(dcDenon) << "Set play mode:" << query.toString();
+    sendRequest("player/set_play_mode", query);
 }
 
 void Heos::getPlayMode(int playerId)
 {
-    QByteArray cmd = "heos://player/get_play_mode?pid=" + QVariant(playerId).toByteArray() + "\r\n";
-    m_socket->write(cmd);
+    sendRequest("player/get_play_mode", playerQuery(playerId));
 }
 
 void Heos::getQueue(int playerId)
 {
-    QByteArray cmd = "heos://player/get_queue?pid=" + QVariant(playerId).toByteArray() + "\r\n";
-    m_socket->write(cmd);
+    sendRequest("player/get_queue", playerQuery(playerId));
 }
 
 /********************************
@@ -331,79 +361,72 @@ void Heos::getQueue(int playerId)
  ********************************/
 void Heos::getGroups()
 {
-    QByteArray cmd = "heos://group/get_groups\r\n";
-    m_socket->write(cmd);
+    sendRequest("group/get_groups");
 }
 
 void Heos::getGroupInfo(int groupId)
 {
-    QByteArray cmd = "heos://group/get_group_info?gid=" + QVariant(groupId).toByteArray() + "\r\n";
-    m_socket->write(cmd);
+    sendRequest("group/get_group_info", groupQuery(groupId));
 }
 
 void Heos::getGroupVolume(int groupId)
 {
-    QByteArray cmd = "heos://group/get_volume?gid=" + QVariant(groupId).toByteArray() + "\r\n";
-    m_socket->write(cmd);
+    sendRequest("group/get_volume", groupQuery(groupId));
 }
 
 void Heos::getGroupMute(int groupId)
 {
-    QByteArray cmd = "heos://group/get_mute?gid=" + QVariant(groupId).toByteArray() + "\r\n";
-    m_socket->write(cmd);
+    sendRequest("group/get_mute", groupQuery(groupId));
 }
 
 
 void Heos::setGroupVolume(int groupId, bool volume)
 {
-    QByteArray cmd = "heos://group/set_volume?gid=" + QVariant(groupId).toByteArray() + "&level=" + QVariant(volume).toByteArray() + "\r\n";
-    qCDebug(dcDenon) << "Volume up:" << cmd;
-    m_socket->write(cmd);
+    QUrlQuery query = groupQuery(groupId);
+    query.addQueryItem("level", QString::number(volume));
+    qCDebug(dcDenon) << "Set group volume:" << query.toString();
+    sendRequest("group/set_volume", query);
 }
 
 void Heos::setGroupMute(int groupId, bool mute)
 {
-    QByteArray cmd = "heos://group/set_mute?gid=" + QVariant(groupId).toByteArray() + "&state=";
-    if (mute) {
-        cmd.append("on\r\n");
-    } else {
-        cmd.append("off\r\n");
-    }
-    m_socket->write(cmd);
+    QUrlQuery query = groupQuery(groupId);
+    query.addQueryItem("state", mute ? "on" : "off");
+    sendRequest("group/set_mute", query);
 }
 
 void Heos::setGroup(QList<int> playerIds)
 {
-    QByteArray cmd = "heos://group/set_group?pid=";
+    QStringList playerIdList;
     foreach(int playerId, playerIds) {
-        cmd.append(QVariant(playerId).toByteArray());
-        cmd.append(',');
+        playerIdList.append(QString::number(playerId));
     }
-    cmd.resize(cmd.size()-1); //remove last ','
-    cmd.append("\r\n");
-    qCDebug(dcDenon) << "Set group:" << cmd;
-    m_socket->write(cmd);
+    QUrlQuery query;
+    query.addQueryItem("pid", playerIdList.join(','));
+    qCDebug(dcDenon) << "Set group:" << query.toString();
+    sendRequest("group/set_group", query);
 }
 
 void Heos::toggleGroupMute(int groupId)
 {
-    QByteArray cmd = "heos://group/toggle_mute?gid=" + QVariant(groupId).toByteArray() + "\r\n";
-    qCDebug(dcDenon) << "Volume up:" << cmd;
-    m_socket->write(cmd);
+    qCDebug(dcDenon) << "Toggle group mute:" << groupId;
+    sendRequest("group/toggle_mute", groupQuery(groupId));
 }
 
 void Heos::groupVolumeUp(int groupId, int step)
 {
-    QByteArray cmd = "heos://group/volume_up?pid=" + QVariant(groupId).toByteArray() + "&step=" + QVariant(step).toByteArray() + "\r\n";
-    qCDebug(dcDenon) << "Group volume up:" << cmd;
-    m_socket->write(cmd);
+    QUrlQuery query = groupQuery(groupId);
+    query.addQueryItem("step", QString::number(step));
+    qCDebug(dcDenon) << "Group volume up:" << query.toString();
+    sendRequest("group/volume_up", query);
 }
 
 void Heos::groupVolumeDown(int groupId, int step)
 {
-    QByteArray cmd = "heos://group/volume_down?pid=" + QVariant(groupId).toByteArray() + "&step=" + QVariant(step).toByteArray() + "\r\n";
-    qCDebug(dcDenon) << "Group volume up:" << cmd;
-    m_socket->write(cmd);
+    QUrlQuery query = groupQuery(groupId);
+    query.addQueryItem("step", QString::number(step));
+    qCDebug(dcDenon) << "Group volume down:" << query.toString();
+    sendRequest("group/volume_down", query);
 }
 
 
@@ -412,173 +435,289 @@ void Heos::groupVolumeDown(int groupId, int step)
  ********************************/
 quint32 Heos::getMusicSources()
 {
-    quint32 sequence = createRandomNumber();
-    QByteArray cmd = "heos://browse/get_music_sources?";
-    QUrlQuery queryParams;
-    queryParams.addQueryItem("SEQUENCE", QString::number(sequence));
-    cmd.append(queryParams.toString());
-    cmd.append("\r\n");
-    qCDebug(dcDenon) << "Get music sources:" << cmd;
-    m_socket->write(cmd);
-    return sequence;
+    qCDebug(dcDenon) << "Get music sources";
+    return sendRequest("browse/get_music_sources");
 }
 
 quint32 Heos::getSourceInfo(const QString &sourceId)
 {
-    quint32 sequence = createRandomNumber();
-    QByteArray cmd = "heos://browse/get_source_info?";
-    QUrlQuery queryParams;
-    queryParams.addQueryItem("sid", sourceId);
-    queryParams.addQueryItem("SEQUENCE", QString::number(sequence));
-    cmd.append(queryParams.toString());
-    cmd.append("\r\n");
-    qCDebug(dcDenon) << "Get source info:" << cmd;
-    m_socket->write(cmd);
-    return sequence;
+    QUrlQuery query;
+    query.addQueryItem("sid", sourceId);
+    qCDebug(dcDenon) << "Get source info:" << query.toString();
+    return sendRequest("browse/get_source_info", query);
 }
 
 quint32 Heos::getSearchCriteria(const QString &sourceId)
 {
-    quint32 sequence = createRandomNumber();;
-    QByteArray cmd = "heos://browse/get_search_criteria?";
-    QUrlQuery queryParams;
-    queryParams.addQueryItem("sid", sourceId);
-    cmd.append(queryParams.toString());
-    cmd.append("\r\n");
-    qCDebug(dcDenon) << "Get search criteria:" << cmd;
-    m_socket->write(cmd);
-    return sequence;
+    QUrlQuery query;
+    query.addQueryItem("sid", sourceId);
+    qCDebug(dcDenon) << "Get search criteria:" << query.toString();
+    return sendRequest("browse/get_search_criteria", query);
 }
 
 quint32 Heos::browseSource(const QString &sourceId)
 {
-    quint32 sequence = createRandomNumber();
-    QByteArray cmd = "heos://browse/browse?";
-    QUrlQuery queryParams;
-    queryParams.addQueryItem("sid", sourceId);
-    queryParams.addQueryItem("SEQUENCE", QString::number(sequence));
-    cmd.append(queryParams.toString());
-    cmd.append("\r\n");
-    qCDebug(dcDenon) << "Browse source:" << cmd;
-    m_socket->write(cmd);
-    return sequence;
+    return browse(sourceId, QString());
 }
 
 quint32 Heos::browseSourceContainers(const QString &sourceId, const QString &containerId)
 {
-    quint32 sequence = createRandomNumber();;
-    QByteArray cmd = "heos://browse/browse?";
-    QUrlQuery queryParams;
-    queryParams.addQueryItem("sid", sourceId);
-    queryParams.addQueryItem("cid", containerId);
-    queryParams.addQueryItem("SEQUENCE", QString::number(sequence));
-    cmd.append(queryParams.toString());
-    cmd.append("\r\n");
-    qCDebug(dcDenon) << "Browsing container:" << cmd;
-    m_socket->write(cmd);
-    return sequence;
+    return browse(sourceId, containerId);
 }
 
 quint32 Heos::playStation(int playerId, const QString &sourceId, const QString &containerId, const QString &mediaId, const QString &stationName)
 {
-    quint32 sequence = createRandomNumber();;
-    QByteArray cmd("heos://browse/play_stream?");
-    QUrlQuery queryParams;
-    queryParams.addQueryItem("pid", QString::number(playerId));
+    QUrlQuery query = playerQuery(playerId);
     if (!sourceId.isEmpty()) {
-        queryParams.addQueryItem("sid", sourceId);
+        query.addQueryItem("sid", sourceId);
     }
     if (!containerId.isEmpty()) {
-        queryParams.addQueryItem("cid", containerId);
+        query.addQueryItem("cid", containerId);
     }
     if (!mediaId.isEmpty()) {
-        queryParams.addQueryItem("mid", mediaId);
+        query.addQueryItem("mid", mediaId);
     }
     if (!stationName.isEmpty()) {
-        queryParams.addQueryItem("name", stationName);
+        query.addQueryItem("name", stationName);
     }
-    queryParams.addQueryItem("SEQUENCE", QString::number(sequence));
-    cmd.append(queryParams.toString());
-    cmd.append("\r\n");
-    qCDebug(dcDenon) << "playing station:" << cmd;
-    m_socket->write(cmd);
-    return sequence;
+    qCDebug(dcDenon) << "playing station:" << query.toString();
+    return sendRequest("browse/play_stream", query);
 }
 
 quint32 Heos::playPresetStation(int playerId, int presetNumber)
 {
-    quint32 sequence = createRandomNumber();
-    QByteArray cmd("heos://browse/play_preset?");
-    QUrlQuery queryParams;
-    queryParams.addQueryItem("pid", QString::number(playerId));
-    queryParams.addQueryItem("preset", QString::number(presetNumber));
-    queryParams.addQueryItem("SEQUENCE", QString::number(sequence));
-    cmd.append(queryParams.toString());
-    cmd.append("\r\n");
-    qCDebug(dcDenon) << "playing preset station:" << cmd;
-    m_socket->write(cmd);
-    return sequence;
+    QUrlQuery query = playerQuery(playerId);
+    query.addQueryItem("preset", QString::number(presetNumber));
+    qCDebug(dcDenon) << "playing preset station:" << query.toString();
+    return sendRequest("browse/play_preset", query);
 }
 
 quint32 Heos::playInputSource(int playerId, const QString &inputName)
 {
-    quint32 sequence = createRandomNumber();
-    QByteArray cmd("heos://browse/play_input?");
-    QUrlQuery queryParams;
-    queryParams.addQueryItem("pid", QString::number(playerId));
-    queryParams.addQueryItem("input", inputName);
-    queryParams.addQueryItem("SEQUENCE", QString::number(sequence));
-    cmd.append(queryParams.toString());
-    cmd.append("\r\n");
-    qCDebug(dcDenon) << "playing input source:" << cmd;
-    m_socket->write(cmd);
-    return sequence;
+    QUrlQuery query = playerQuery(playerId);
+    query.addQueryItem("input", inputName);
+    qCDebug(dcDenon) << "playing input source:" << query.toString();
+    return sendRequest("browse/play_input", query);
 }
 
 quint32 Heos::playUrl(int playerId, const QUrl &mediaUrl)
 {
-    quint32 sequence = createRandomNumber();
-    QByteArray cmd("heos://browse/play_stream?");
-    QUrlQuery queryParams;
-    queryParams.addQueryItem("pid", QString::number(playerId));
-    queryParams.addQueryItem("url", mediaUrl.toString());
-    queryParams.addQueryItem("SEQUENCE", QString::number(sequence));
-    cmd.append(queryParams.toString());
-    cmd.append("\r\n");
-    qCDebug(dcDenon) << "playing url:" << cmd;
-    m_socket->write(cmd);
+    QUrlQuery query = playerQuery(playerId);
+    query.addQueryItem("url", mediaUrl.toString());
+    qCDebug(dcDenon) << "playing url:" << query.toString();
+    return sendRequest("browse/play_stream", query);
+}
+
+quint32 Heos::addContainerToQueue(int playerId, const QString &sourceId, const QString &containerId, ADD_CRITERIA addCriteria)
+{
+    QUrlQuery query = playerQuery(playerId);
+    query.addQueryItem("sid", sourceId);
+    query.addQueryItem("cid", containerId);
+    query.addQueryItem("aid", QString::number(addCriteria));
+    qCDebug(dcDenon) << "Adding to queue:" << query.toString();
+    return sendRequest("browse/add_to_queue", query);
+}
+
+/********************************
+ *        REQUEST HANDLING
+ ********************************/
+QUrlQuery Heos::playerQuery(int playerId) const
+{
+    QUrlQuery query;
+    query.addQueryItem("pid", QString::number(playerId));
+    return query;
+}
+
+QUrlQuery Heos::groupQuery(int groupId) const
+{
+    QUrlQuery query;
+    query.addQueryItem("gid", QString::number(groupId));
+    return query;
+}
+
+quint32 Heos::sendRequest(const QString &command, QUrlQuery query)
+{
+    // Browse requests are tagged with a SEQUENCE number, the speaker echoes it in the response message.
+    // Other commands don't support it, their responses are matched by the command name.
+    Request request;
+    request.command = command;
+    request.sequence = m_nextSequence++;
+    if (command.startsWith("browse/")) {
+        query.addQueryItem("SEQUENCE", QString::number(request.sequence));
+    }
+    request.data = "heos://" + command.toUtf8() + "?" + query.toString().toUtf8() + "\r\n";
+
+    m_pendingRequests.append(request);
+    sendNextRequests();
+    return request.sequence;
+}
+
+void Heos::sendNextRequests()
+{
+    if (m_socket->state() != QAbstractSocket::ConnectedState) {
+        return;
+    }
+
+    while (m_requestsInFlight.count() < m_maxRequestsInFlight && !m_pendingRequests.isEmpty()) {
+        Request request = m_pendingRequests.takeFirst();
+        request.sentTime = QDateTime::currentMSecsSinceEpoch();
+        m_requestsInFlight.append(request);
+        m_socket->write(request.data);
+    }
+
+    if (!m_requestsInFlight.isEmpty() && !m_requestTimeoutTimer->isActive()) {
+        m_requestTimeoutTimer->start();
+    }
+}
+
+void Heos::finishRequest(const Response &response)
+{
+    // Command under process responses are followed by the final response with the same sequence
+    if (response.message.hasQueryItem("command under process")) {
+        return;
+    }
+
+    for (int i = 0; i < m_requestsInFlight.count(); i++) {
+        const Request &request = m_requestsInFlight.at(i);
+        if (response.hasSequence ? request.sequence == response.sequence : request.command == response.command) {
+            m_requestsInFlight.removeAt(i);
+            sendNextRequests();
+            return;
+        }
+    }
+}
+
+/********************************
+ *         BROWSE CACHE
+ ********************************/
+quint32 Heos::browse(const QString &sourceId, const QString &containerId)
+{
+    QString key = sourceId + "/" + containerId;
+    if (m_browseCache.contains(key)) {
+        const BrowseCacheEntry &entry = m_browseCache.value(key);
+        if (QDateTime::currentMSecsSinceEpoch() - entry.timestamp < m_browseCacheTimeout) {
+            quint32 sequence = m_nextSequence++;
+            QList<MusicSourceObject> musicSources = entry.musicSources;
+            QList<MediaObject> mediaItems = entry.mediaItems;
+            qCDebug(dcDenon()) << "Browse cache hit" << key << musicSources.count() + mediaItems.count() << "of" << entry.count << "items";
+            // Deliver asynchronously, callers register their pending result after this method returns
+            QTimer::singleShot(0, this, [=](){
+                emit browseRequestReceived(sequence, sourceId, containerId, musicSources, mediaItems);
+            });
+            prefetchBrowsePage(key);
+            return sequence;
+        }
+        m_browseCache.remove(key);
+    }
+
+    BrowseRequest request;
+    request.sourceId = sourceId;
+    request.containerId = containerId;
+    request.userRequest = true;
+    return requestBrowsePage(request);
+}
+
+quint32 Heos::requestBrowsePage(const BrowseRequest &request)
+{
+    QUrlQuery query;
+    query.addQueryItem("sid", request.sourceId);
+    if (request.containerId.isEmpty()) {
+        qCDebug(dcDenon) << "Browse source:" << query.toString();
+    } else {
+        // Only containers can be browsed in ranges, sources return their full (short) list
+        query.addQueryItem("cid", request.containerId);
+        query.addQueryItem("range", QString("%1,%2").arg(request.start).arg(request.start + m_browsePageSize - 1));
+        qCDebug(dcDenon) << "Browsing container:" << query.toString();
+    }
+    quint32 sequence = sendRequest("browse/browse", query);
+    m_browseRequests.insert(sequence, request);
     return sequence;
 }
 
+void Heos::prefetchBrowsePage(const QString &key)
+{
+    if (!m_browseCache.contains(key)) {
+        return;
+    }
+
+    BrowseCacheEntry &entry = m_browseCache[key];
+    int loaded = entry.musicSources.count() + entry.mediaItems.count();
+    if (entry.prefetching || entry.containerId.isEmpty() || loaded >= entry.count || loaded >= m_maxBrowseItems) {
+        return;
+    }
+
+    qCDebug(dcDenon()) << "Prefetching browse page" << key << "starting at" << loaded;
+    BrowseRequest request;
+    request.sourceId = entry.sourceId;
+    request.containerId = entry.containerId;
+    request.start = loaded;
+    entry.prefetching = true;
+    requestBrowsePage(request);
+}
+
+void Heos::clearBrowseCache()
+{
+    if (!m_browseCache.isEmpty()) {
+        qCDebug(dcDenon()) << "Clearing browse cache with" << m_browseCache.count() << "entries";
+    }
+    // Outstanding prefetch responses find no entry anymore and get dropped
+    m_browseCache.clear();
+}
+
+void Heos::dropRequest(const Heos::Request &request, const QString &reason)
+{
+    if (!m_browseRequests.contains(request.sequence)) {
+        return;
+    }
+
+    BrowseRequest browseRequest = m_browseRequests.take(request.sequence);
+    QString key = browseRequest.sourceId + "/" + browseRequest.containerId;
+    if (browseRequest.userRequest) {
+        // There is no HEOS error id for requests which never got a response
+        emit browseErrorReceived(browseRequest.sourceId, browseRequest.containerId, -1, reason);
+    } else if (m_browseCache.contains(key)) {
+        m_browseCache[key].prefetching = false;
+    }
+}
+
+void Heos::onRequestTimeoutTimer()
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (int i = m_requestsInFlight.count() - 1; i >= 0; i--) {
+        if (now - m_requestsInFlight.at(i).sentTime > m_requestTimeout) {
+            // Note: take it out first, the browse error handler might send new requests
+            Request request = m_requestsInFlight.takeAt(i);
+            qCWarning(dcDenon()) << "Heos: Request timed out" << request.command << "sequence" << request.sequence;
+            dropRequest(request, "The speaker did not respond in time.");
+        }
+    }
+
+    if (m_requestsInFlight.isEmpty()) {
+        m_requestTimeoutTimer->stop();
+    }
+    sendNextRequests();
+}
+
 void Heos::onConnected()
 {
     qCDebug(dcDenon()) << "Heos: Connected successfully to" << m_hostAddress.toString();
     m_reconnectTimer->stop();
     emit connectionStatusChanged(true);
+    sendNextRequests();
 }
 
 void Heos::onDisconnected()
 {
     m_reconnectTimer->start();
     qCDebug(dcDenon()) << "Heos: Disconnected from" << m_hostAddress.toString() << "try reconnecting in 5 seconds";
-    emit connectionStatusChanged(false);
-}
 
-quint32 Heos::addContainerToQueue(int playerId, const QString &sourceId, const QString &containerId, ADD_CRITERIA addCriteria)
-{
-    quint32 sequence = createRandomNumber();
-    QByteArray cmd("heos://browse/add_to_queue?");
-    QUrlQuery queryParams;
-    queryParams.addQueryItem("pid", QString::number(playerId));
-    queryParams.addQueryItem("sid", sourceId);
-    queryParams.addQueryItem("cid", containerId);
-    queryParams.addQueryItem("aid", QString::number(addCriteria));
-    queryParams.addQueryItem("SEQUENCE", QString::number(sequence));
-    cmd.append(queryParams.toString());
-    cmd.append("\r\n");
-    qCDebug(dcDenon) << "Adding to queue:" << cmd;
-    m_socket->write(cmd);
-    return sequence;
+    // Requests on the wire are lost, the ones not sent yet will go out after reconnecting
+    foreach (const Request &request, m_requestsInFlight) {
+        dropRequest(request, "The connection to the speaker has been lost.");
+    }
+    m_requestsInFlight.clear();
+    m_requestTimeoutTimer->stop();
+    emit connectionStatusChanged(false);
 }
 
 void Heos::onError(QAbstractSocket::SocketError socketError)
@@ -596,603 +735,509 @@ void Heos::readData()
         QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
         if (error.error != QJsonParseError::NoError) {
             qCWarning(dcDenon) << "failed to parse json :" << error.errorString();
-            return;
+            continue;
+        }
+
+        QJsonObject heosObject = jsonDoc.object().value("heos").toObject();
+        if (heosObject.isEmpty()) {
+            continue;
         }
-        QVariantMap dataMap = jsonDoc.toVariant().toMap();
-        if (dataMap.contains("heos")) {
-            QString command = dataMap.value("heos").toMap().value("command").toString();
-            QUrlQuery message(dataMap.value("heos").toMap().value("message").toString());
-            bool success = false;
-            if(dataMap.value("heos").toMap().contains("result")) {
-                //If the message doesn't contain result it is an event message
-                success = dataMap.value("heos").toMap().value("result").toString().contains("success");
-                if (!success) {
-                    qCWarning(dcDenon()) << "Command:" << command << "was not successfull. Message:" << message.toString();
-                    if (command == "system/sign_in") {
-                        emit userChanged(false, "");
-                    }
+
+        Response response;
+        response.command = heosObject.value("command").toString().trimmed();
+        response.message = QUrlQuery(heosObject.value("message").toString());
+        response.payload = jsonDoc.object().value("payload").toVariant();
+        response.hasSequence = response.message.hasQueryItem("SEQUENCE");
+        response.sequence = response.message.queryItemValue("SEQUENCE").toUInt();
+
+        // If the message doesn't contain result it is an event message
+        if (heosObject.contains("result")) {
+            response.success = heosObject.value("result").toString().contains("success");
+            if (!response.success) {
+                qCWarning(dcDenon()) << "Command:" << response.command << "was not successfull. Message:" << response.message.toString();
+                if (response.command == "system/sign_in") {
+                    emit userChanged(false, "");
                 }
             }
-            /*
-             * 4.1 System Commands
-             *  4.1.1 Register for Change Events
-             *  4.1.2 HEOS Account Check
-             *  4.1.3 HEOS Account Sign In
-             *  4.1.4 HEOS Account Sign Out
-             *  4.1.5 HEOS System Heart Beat
-             *  4.1.6 HEOS Speaker Reboot
-             *  4.1.7 Prettify JSON response
-            */
-            if (command.startsWith("system")) {
-                if (command.contains("register_for_change_events")) {
-                    QString enabled = message.queryItemValue("enabled");
-                    if (enabled.contains("off")) {
-                        qDebug(dcDenon) << "Events are disabled";
-                        m_eventRegistered = false;
-                        emit systemEventsEnabled(false);
-                    } else {
-                        qDebug(dcDenon) << "Events are enabled";
-                        m_eventRegistered = true;
-                        emit systemEventsEnabled(true);
-                    }
-
-                } else if (command.contains("check_account")) {
-
-                    qDebug(dcDenon()) << "System command check_account:" << message.toString();
-                    bool signedIn;
-                    QString username = "";
-                    if (message.hasQueryItem("signed_in")){
-                        signedIn = true;
-                        username = message.queryItemValue("un");
-                    } else {
-                        signedIn = false;
-                    }
-                    emit userChanged(signedIn, username);
-
-                } else if (command.contains("sign_in")) {
-
-                    qDebug(dcDenon()) << "System command sign_in:" << message.toString();
-
-                    if (message.hasQueryItem("signed_in")) {
-                        QString username = message.queryItemValue("un");
-                        emit userChanged(true, username);
-
-                    } // otherwise it will be command under process and we will wait for the event
-                } else if (command.contains("sign_out")) {
-
-                    qDebug(dcDenon()) << "System command sign_out:" << message.toString();
-                    emit userChanged(false, "");
+            finishRequest(response);
+        }
 
-                } else if (command.contains("heart_beat")) {
+        ResponseHandler handler = m_responseHandlers.value(response.command);
+        if (!handler) {
+            qCDebug(dcDenon) << "Unhandled Heos command" << response.command;
+            continue;
+        }
+        (this->*handler)(response);
+    }
+}
 
-                } else if (command.contains("reboot")) {
+/********************************
+ *       RESPONSE HANDLERS
+ ********************************/
+void Heos::onIgnoredResponse(const Heos::Response &response)
+{
+    Q_UNUSED(response)
+}
 
-                } else if (command.contains("prettify_json_response")) {
+void Heos::onRegisterForChangeEventsResponse(const Heos::Response &response)
+{
+    QString enabled = response.message.queryItemValue("enable");
+    if (enabled.contains("off")) {
+        qDebug(dcDenon) << "Events are disabled";
+        m_eventRegistered = false;
+        emit systemEventsEnabled(false);
+    } else {
+        qDebug(dcDenon) << "Events are enabled";
+        m_eventRegistered = true;
+        emit systemEventsEnabled(true);
+    }
+}
 
-                }  else {
-                    qDebug(dcDenon) << "Unhandled Heos system command" << command;
-                }
-                /* 4.2 Player Commands
-             *  4.2.1 Get Players
-             *  4.2.2 Get Player Info
-             *  4.2.3 Get Play State
-             *  4.2.4 Set Play State
-             *  4.2.5 Get Now Playing Media
-             *  4.2.6 Get Volume
-             *  4.2.7 Set Volume
-             *  4.2.8 Volume Up
-             *  4.2.9 Volume Down
-             *  4.2.10 Get Mute
-             *  4.2.11 Set Mute
-             *  4.2.12 Toggle Mute
-             *  4.2.13 Get Play Mode
-             *  4.2.14 Set Play Mode
-             *  4.2.15 Get Queue
-             *  4.2.16 Play Queue Item
-             *  4.2.17 Remove Item(s) from Queue
-             *  4.2.18 Save Queue as Playlist
-             *  4.2.19 Clear Queue
-             *  4.2.20 Move Queue
-             *  4.2.21 Play Next
-             *  4.2.22 Play Previous
-             *  4.2.23 Set QuickSelect [LS AVR Only]
-             *  4.2.24 Play QuickSelect [LS AVR Only]
-             *  4.2.25 Get QuickSelects [LS AVR Only]
-             *  4.2.26 Check for Firmware Update
-             */
-            } else if (command.startsWith("player")) {
-                int playerId = 0;
-                if (message.hasQueryItem("pid")) {
-                    playerId = message.queryItemValue("pid").toInt();
-                }
+void Heos::onCheckAccountResponse(const Heos::Response &response)
+{
+    qDebug(dcDenon()) << "System command check_account:" << response.message.toString();
+    bool signedIn;
+    QString username = "";
+    if (response.message.hasQueryItem("signed_in")){
+        signedIn = true;
+        username = response.message.queryItemValue("un");
+    } else {
+        signedIn = false;
+    }
+    emit userChanged(signedIn, username);
+}
 
-                if (command.contains("get_players")) {
-                    QVariantList payloadVariantList = jsonDoc.toVariant().toMap().value("payload").toList();
-                    QList<HeosPlayer *> players;
-                    foreach (const QVariant &payloadEntryVariant, payloadVariantList) {
-                        HeosPlayer *player = new HeosPlayer(payloadEntryVariant.toMap().value("pid").toInt());
-                        player->setSerialNumber(payloadEntryVariant.toMap().value("serial").toString());
-                        player->setName(payloadEntryVariant.toMap().value("name").toString());
-                        getPlayerInfo(player->playerId());
-                        players.append(player);
-                    }
-                    emit playersRecieved(players);
-
-                } else if (command.contains("get_player_info")) {
-                    //update heos player info
-                    int pid = dataMap.value("payload").toMap().value("pid").toInt();
-                    HeosPlayer *player = new HeosPlayer(pid);
-                    player->setName(dataMap.value("payload").toMap().value("name").toString());
-                    if (dataMap.value("payload").toMap().contains("gid")) {
-                        player->setGroupId(dataMap.value("payload").toMap().value("gid").toInt());
-                    } else {
-                        player->setGroupId(-1); //no group assigned
-                    }
-                    player->setPlayerModel(dataMap.value("payload").toMap().value("model").toString());
-                    player->setPlayerVersion(dataMap.value("payload").toMap().value("version").toString());
-                    player->setLineOut(dataMap.value("payload").toMap().value("lineout").toString());
-                    player->setControl(dataMap.value("payload").toMap().value("control").toString());
-                    player->setSerialNumber(dataMap.value("payload").toMap().value("serial").toString());
-                    player->setNetwork(dataMap.value("payload").toMap().value("network").toString());
-                    emit playerInfoRecieved(player);
-
-                } else if (command.contains("get_now_playing_media")) {
-
-                    QString artist = dataMap.value("payload").toMap().value("artist").toString();
-                    QString song = dataMap.value("payload").toMap().value("song").toString();
-                    QString artwork = dataMap.value("payload").toMap().value("image_url").toString();
-                    QString album = dataMap.value("payload").toMap().value("album").toString();
-                    QString sourceId = dataMap.value("payload").toMap().value("sid").toString();
-                    qDebug(dcDenon) << "Now playing" << playerId << sourceId << artist << album << song;
-                    emit nowPlayingMediaStatusReceived(playerId, sourceId, artist, album, song, artwork);
-
-                } else if (command.contains("get_play_state") || command.contains("set_play_state")) {
-                    if (message.hasQueryItem("state")) {
-                        PLAYER_STATE playState =  PLAYER_STATE_STOP;
-                        if (message.queryItemValue("state").contains("play")) {
-                            playState =  PLAYER_STATE_PLAY;
-                        } else if (message.queryItemValue("state").contains("pause")) {
-                            playState = PLAYER_STATE_PAUSE;
-                        } else if (message.queryItemValue("state").contains("stop")) {
-                            playState =  PLAYER_STATE_STOP;
-                        }
-                        emit playerPlayStateReceived(playerId, playState);
-                    }
-                } else if (command.contains("get_volume") || command.contains("set_volume")) {
-                    if (message.hasQueryItem("level")) {
-                        int volume = message.queryItemValue("level").toInt();
-                        emit playerVolumeReceived(playerId, volume);
-                    }
-                } else if (command.contains("get_mute") || command.contains("set_mute")) {
-                    if (message.hasQueryItem("state")) {
-                        QString state = message.queryItemValue("state");
-                        if (state.contains("on")) {
-                            emit playerMuteStatusReceived(playerId, true);
-                        } else {
-                            emit playerMuteStatusReceived(playerId, false);
-                        }
-                    }
-                } else if (command.contains("get_play_mode") || command.contains("set_play_mode")) {
-                    if (message.hasQueryItem("shuffle") && message.hasQueryItem("repeat")) {
-                        bool shuffle;
-                        if (message.queryItemValue("shuffle").contains("on")){
-                            shuffle = true;
-                        } else {
-                            shuffle = false;
-                        }
-                        emit playerShuffleModeReceived(playerId, shuffle);
-
-                        REPEAT_MODE repeatMode = REPEAT_MODE_OFF;
-                        if (message.queryItemValue("repeat").contains("on_all")){
-                            repeatMode = REPEAT_MODE_ALL;
-                        } else if (message.queryItemValue("repeat").contains("on_one")){
-                            repeatMode = REPEAT_MODE_ONE;
-                        } else  if (message.queryItemValue("repeat").contains("off")){
-                            repeatMode = REPEAT_MODE_OFF;
-                        }
-                        emit playerRepeatModeReceived(playerId, repeatMode);
-                    }
-                } else if (command.contains("check_update")) {
-                    QVariantMap payloadVariantMap = jsonDoc.toVariant().toMap().value("payload").toMap();
-                    bool updateExist = payloadVariantMap.value("update").toString().contains("exist");
-                    emit playerUpdateAvailable(playerId, updateExist);
-                } else {
-                    qDebug(dcDenon) << "Unhandled Heos group command" << command;
-                }
-                /*
-             * 4.3 Group Commands
-             *  4.3.1 Get Groups
-             *  4.3.2 Get Group Info
-             *  4.3.3 Set Group
-             *  4.3.4 Get Group Volume
-             *  4.3.5 Set Group Volume
-             *  4.2.6 Group Volume Up
-             *  4.2.7 Group Volume Down
-             *  4.3.8 Get Group Mute
-             *  4.3.9 Set Group Mute
-             *  4.3.10 Toggle Group Mute
-             */
-            } else if (command.startsWith("group")) {
-                int groupId = 0;
-                if (message.hasQueryItem("gid")) {
-                    qDebug(dcDenon) << "Group id" << message.queryItemValue("gid");
-                    groupId = message.queryItemValue("gid").toInt();
-                }
-                if (command.contains("get_groups")) {
-                    QVariantList payloadVariantList = jsonDoc.toVariant().toMap().value("payload").toList();
-                    QList<GroupObject> groups;
-                    foreach (const QVariant &payloadEntryVariant, payloadVariantList) {
-                        GroupObject group;
-                        group.groupId = payloadEntryVariant.toMap().value("gid").toInt();
-                        group.name = payloadEntryVariant.toMap().value("name").toString();
-                        if (!payloadEntryVariant.toMap().value("players").toList().isEmpty()) {
-                            QVariantList playerlist = payloadEntryVariant.toMap().value("players").toList();
-                            foreach (const QVariant &playerVariant, playerlist) {
-                                PlayerObject player;
-                                player.name = playerVariant.toMap().value("name").toString();
-                                player.playerId = playerVariant.toMap().value("pid").toInt();
-                                group.players.append(player);
-                            }
-                        }
-                        groups.append(group);
-                    }
-                    emit groupsReceived(groups);
-                } else if (command.contains("get_group_info")) {
-                    QVariantMap payloadVariantMap = jsonDoc.toVariant().toMap().value("payload").toMap();
-                    GroupObject group;
-                    group.groupId = payloadVariantMap.value("gid").toInt();
-                    group.name = payloadVariantMap.value("name").toString();
-                    if (!payloadVariantMap.value("players").toList().isEmpty()) {
-                        QVariantList playerlist = payloadVariantMap.value("players").toList();
-                        foreach (const QVariant &playerVariant, playerlist) {
-                            PlayerObject player;
-                            player.name = playerVariant.toMap().value("name").toString();
-                            player.playerId = playerVariant.toMap().value("pid").toInt();
-                            group.players.append(player);
-                        }
-                    }
-                    emit groupInfoReceived(group);
-
-                } else if (command.contains("set_group")) {
-                    if (message.hasQueryItem("gid")) {
-
-                        int groupId = message.queryItemValue("gid").toInt();
-                        QString groupName = message.queryItemValue("name");
-                        emit setGroupReceived(groupId, groupName);
-                    } else {
-                        //No group Id so it must have been an ungoup request
-                        int playerId = message.queryItemValue("pid").toInt();
-                        emit deleteGroupReceived(playerId);
-                    }
-
-                } else if (command.contains("get_volume") || command.contains("set_volume")) {
-
-                    if (message.hasQueryItem("level")) {
-                        int volume = message.queryItemValue("level").toInt();
-                        emit groupVolumeReceived(groupId, volume);
-                    }
-
-                } else if (command.contains("volume_up") || command.contains("volume_down")) {
-
-                } else if (command.contains("get_mute") || command.contains("set_mute")) {
-
-                    if (message.hasQueryItem("state")) {
-                        QString state = message.queryItemValue("state");
-                        if (state.contains("on")) {
-                            emit playerMuteStatusReceived(groupId, true);
-                        } else {
-                            emit playerMuteStatusReceived(groupId, false);
-                        }
-                    }
-                } else if (command.contains("toggle_mute")) {
-
-                } else {
-                    qDebug(dcDenon) << "Unhandled Heos group command" << command;
-                }
+void Heos::onSignInResponse(const Heos::Response &response)
+{
+    qDebug(dcDenon()) << "System command sign_in:" << response.message.toString();
 
+    if (response.message.hasQueryItem("signed_in")) {
+        QString username = response.message.queryItemValue("un");
+        emit userChanged(true, username);
+    } // otherwise it will be command under process and we will wait for the event
+}
 
-                /* 4.4 Browse Commands
-                                                  *  4.4.1 Get Music Sources                         - "command": "browse/get_music_sources"
-                                                  *  4.4.2 Get Source Info                           - "command": "browse/get_source_info"
-                                                  *  4.4.3 Browse Source                             - "command": "browse/browse",
-                                                  *  4.4.4 Browse Source Containers                  - "command": "browse/browse",
-                                                  *  4.4.5 Get Source Search Criteria                - "command": "browse/get_search_criteria"
-                                                  *  4.4.6 Search                                    - "command": "browse/search"
-                                                  *  4.4.7 Play Station                              - "command": "browse/play_stream"
-                                                  *  4.4.8 Play Preset Station                       - "command": "browse/play_preset"
-                                                  *  4.4.9 Play Input source                         - "command": "browse/play_input"
-                                                  *  4.4.10 Play URL                                 - "command": "browse/play_stream "
-                                                  *  4.4.11 Add Container to Queue with Options      - "command": "browse/add_to_queue"
-                                                  *  4.4.12 Add Track to Queue with Options          - "command": "browse/add_to_queue"
-                                                  *  4.4.14 Rename HEOS Playlist                     - "command": "browse/rename_playlist"
-                                                  *  4.4.15 Delete HEOS Playlist                     - "command": "browse/delete_playlist "
-                                                  *  4.4.17 Retrieve Album Metadata                  - "command": "browse/retrieve_metadata",
-                                                 */
-            } else if (command.startsWith("browse") || command.startsWith(" browse")) {
-
-                quint32 sequenceNumber = 0;
-                if (message.hasQueryItem("SEQUENCE")) {
-                    qDebug(dcDenon) << "Sequence number" << message.queryItemValue("SEQUENCE");
-                    sequenceNumber = message.queryItemValue("SEQUENCE").toUInt();
-                }
+void Heos::onSignOutResponse(const Heos::Response &response)
+{
+    qDebug(dcDenon()) << "System command sign_out:" << response.message.toString();
+    emit userChanged(false, "");
+}
 
-                if (command.contains("get_music_sources") || command.contains("get_source_info")) {
-                    qDebug(dcDenon()) << "Get music source request response received" << command;
-                    QVariantList payloadVariantList = jsonDoc.toVariant().toMap().value("payload").toList();
-                    QList<MusicSourceObject> musicSources;
-                    if (success) {
-                        foreach (const QVariant &payloadEntryVariant, payloadVariantList) {
-                            MusicSourceObject source;
-                            source.name = payloadEntryVariant.toMap().value("name").toString();
-                            source.image_url = payloadEntryVariant.toMap().value("image_url").toString();
-                            source.type = payloadEntryVariant.toMap().value("type").toString();
-                            source.sourceId = payloadEntryVariant.toMap().value("sid").toInt();
-                            source.available = payloadEntryVariant.toMap().value("available").toString().contains("true");
-                            source.serviceUsername = payloadEntryVariant.toMap().value("service_username").toString();
-                            musicSources.append(source);
-                        }
-                        emit musicSourcesReceived(sequenceNumber, musicSources);
-                    }
-
-                } else if (command.contains("browse/browse")) {
-                    qDebug(dcDenon()) << "Browse response:"  << jsonDoc.toVariant().toMap().value("payload");
-                    QVariantList payloadVariantList = jsonDoc.toVariant().toMap().value("payload").toList();
-                    QString sourceId;
-                    QString containerId;
-                    if (message.hasQueryItem("sid")) {
-                        sourceId = message.queryItemValue("sid");
-                    }
-                    if (message.hasQueryItem("cid")) {
-                        containerId = message.queryItemValue("cid");
-                    }
-
-                    if (message.toString().contains("command under process")){
-                        qDebug(dcDenon()) << "Browse command is beeing processed";
-                        return;
-                    }
-                    if (success) {
-                        QList<MusicSourceObject> musicSources;
-                        QList<MediaObject> mediaItems;
-                        foreach (const QVariant &payloadEntryVariant, payloadVariantList) {
-                            QString type = payloadEntryVariant.toMap().value("type").toString();
-                            if (type == "source") {
-                                MusicSourceObject source;
-                                source.name = payloadEntryVariant.toMap().value("name").toString();
-                                source.image_url = payloadEntryVariant.toMap().value("image_url").toString();
-                                source.type = payloadEntryVariant.toMap().value("type").toString();
-                                source.sourceId = payloadEntryVariant.toMap().value("sid").toInt();
-                                qDebug(dcDenon()) << "Source" << source.name << source.type << source.sourceId << payloadEntryVariant.toMap().value("sid");
-                                //source.available = payloadEntryVariant.toMap().value("available").toString().contains("true");
-                                //source.serviceUsername = payloadEntryVariant.toMap().value("service_username").toString();
-                                musicSources.append(source);
-                            } else {
-                                MediaObject media;
-                                qDebug(dcDenon()) << "Media Item" << payloadEntryVariant.toMap().value("mid").toString() << payloadEntryVariant.toMap().value("cid").toString();
-                                media.name = payloadEntryVariant.toMap().value("name").toString();
-                                if (payloadEntryVariant.toMap().contains("cid")) {
-                                    media.containerId = payloadEntryVariant.toMap().value("cid").toString();
-                                } else {
-                                    media.containerId = message.queryItemValue("cid");
-                                }
-                                media.mediaId = payloadEntryVariant.toMap().value("mid").toString();
-                                media.imageUrl = payloadEntryVariant.toMap().value("image_url").toString();
-                                media.isPlayable = payloadEntryVariant.toMap().value("playable").toString().contains("yes");
-                                media.isContainer = payloadEntryVariant.toMap().value("container").toString().contains("yes");
-                                media.sourceId = sourceId;
-                                if (type == "artist") {
-                                    media.mediaType = MEDIA_TYPE_ARTIST;
-                                } else if (type == "song") {
-                                    media.mediaType = MEDIA_TYPE_SONG;
-                                } else if (type == "genre") {
-                                    media.mediaType = MEDIA_TYPE_GENRE;
-                                } else if (type == "station") {
-                                    media.mediaType = MEDIA_TYPE_STATION;
-                                } else if (type == "album") {
-                                    media.mediaType = MEDIA_TYPE_ALBUM;
-                                } else if (type == "container") {
-                                    media.mediaType = MEDIA_TYPE_CONTAINER;
-                                }
-                                mediaItems.append(media);
-                            }
-                        }
-                        emit browseRequestReceived(sequenceNumber, sourceId, containerId, musicSources, mediaItems);
-                    }
-                    else {
-                        int errorId = message.queryItemValue("eid").toInt();
-                        QString text = message.queryItemValue("text");
-                        emit browseErrorReceived(sourceId, containerId, errorId, text);
-                    }
-                } else if (command.contains("play_preset")) {
-
-                } else if (command.contains("play_input")) {
-                    qCDebug(dcDenon()) << "Command play input";
-
-                } else if (command.contains("add_to_queue")) {
-
-                } else if (command.contains("rename_playlist")) {
-
-                } else if (command.contains("delete_playlist")) {
-
-                } else if (command.contains("retrieve_metadata")) {
-
-                } else {
-                    qDebug(dcDenon) << "Unhandled Heos browse command" << command;
-                }
+void Heos::onGetPlayersResponse(const Heos::Response &response)
+{
+    QList<HeosPlayer *> players;
+    foreach (const QVariant &payloadEntryVariant, response.payload.toList()) {
+        HeosPlayer *player = new HeosPlayer(payloadEntryVariant.toMap().value("pid").toInt());
+        player->setSerialNumber(payloadEntryVariant.toMap().value("serial").toString());
+        player->setName(payloadEntryVariant.toMap().value("name").toString());
+        getPlayerInfo(player->playerId());
+        players.append(player);
+    }
+    emit playersRecieved(players);
+}
+
+void Heos::onGetPlayerInfoResponse(const Heos::Response &response)
+{
+    QVariantMap payloadMap = response.payload.toMap();
+    int pid = payloadMap.value("pid").toInt();
+    HeosPlayer *player = new HeosPlayer(pid);
+    player->setName(payloadMap.value("name").toString());
+    if (payloadMap.contains("gid")) {
+        player->setGroupId(payloadMap.value("gid").toInt());
+    } else {
+        player->setGroupId(-1); //no group assigned
+    }
+    player->setPlayerModel(payloadMap.value("model").toString());
+    player->setPlayerVersion(payloadMap.value("version").toString());
+    player->setLineOut(payloadMap.value("lineout").toString());
+    player->setControl(payloadMap.value("control").toString());
+    player->setSerialNumber(payloadMap.value("serial").toString());
+    player->setNetwork(payloadMap.value("network").toString());
+    emit playerInfoRecieved(player);
+}
 
+void Heos::onGetNowPlayingMediaResponse(const Heos::Response &response)
+{
+    int playerId = response.message.queryItemValue("pid").toInt();
+    QVariantMap payloadMap = response.payload.toMap();
+    QString artist = payloadMap.value("artist").toString();
+    QString song = payloadMap.value("song").toString();
+    QString artwork = payloadMap.value("image_url").toString();
+    QString album = payloadMap.value("album").toString();
+    QString sourceId = payloadMap.value("sid").toString();
+    qDebug(dcDenon) << "Now playing" << playerId << sourceId << artist << album << song;
+    emit nowPlayingMediaStatusReceived(playerId, sourceId, artist, album, song, artwork);
+}
 
-                /*
-             * 5. Change Events (Unsolicited Responses) 5.1 Sources Changed
-             * 5.2 Players Changed
-             * 5.3 Group Changed
-             * 5.4 Player State Changed
-             * 5.5 Player Now Playing Changed
-             * 5.6 Player Now Playing Progress
-             * 5.7 Player Playback Error
-             * 5.8 Player Queue Changed
-             * 5.9 Player Volume Changed
-             * 5.10 Player Repeat Mode Changed
-             * 5.11 Player Shuffle Mode Changed
-             * 5.12 Group Volume Changed
-             * 5.13 User Changed
-             */
-            } else if (command.startsWith("event")) {
-                if (command.contains("sources_changed")) {
-                    emit sourcesChanged();
-
-                } else if (command.contains("players_changed")) {
-                    emit playersChanged();
-
-                } else if (command.contains("groups_changed")) {
-                    emit groupsChanged();
-
-                } else if (command.contains("player_state_changed")) {
-                    qDebug(dcDenon()) << "Player state changed";
-                    if (message.hasQueryItem("pid")) {
-                        int playerId = message.queryItemValue("pid").toInt();
-                        if (message.hasQueryItem("state")) {
-                            PLAYER_STATE playState = PLAYER_STATE_STOP;
-                            if (message.queryItemValue("state").contains("play")) {
-                                playState = PLAYER_STATE_PLAY;
-                            } else if (message.queryItemValue("state").contains("pause")) {
-                                playState = PLAYER_STATE_PAUSE;
-                            } else if (message.queryItemValue("state").contains("stop")) {
-                                playState = PLAYER_STATE_STOP;
-                            }
-                            emit playerPlayStateReceived(playerId, playState);
-                        }
-                    }
-                } else if (command.contains("player_now_playing_changed")) {
-                    qDebug(dcDenon()) << "Player now playing changed, player id:" << message.queryItemValue("pid").toInt();
-                    if (message.hasQueryItem("pid")) {
-                        int playerId = message.queryItemValue("pid").toInt();
-                        emit playerNowPlayingChanged(playerId);
-                    }
-                } else if (command.contains("player_now_playing_progress")) {
-                    //qDebug(dcDenon()) << "Player now playing progress";
-                    if (message.hasQueryItem("pid")) {
-                        int playerId = message.queryItemValue("pid").toInt();
-                        int currentPossition = message.queryItemValue("cur_pos").toInt();
-                        int duration = message.queryItemValue("duration").toInt();
-                        emit playerNowPlayingProgressReceived(playerId, currentPossition, duration);
-                    }
-                } else if (command.contains("player_playback_error")) {
-                    qDebug(dcDenon) << "Player playback error";
-                    int playerId = 0;
-                    if (message.hasQueryItem("pid")) {
-                        playerId = message.queryItemValue("pid").toInt();
-                        QString errorMessage = message.queryItemValue("error");
-                        emit playerPlaybackErrorReceived(playerId, errorMessage);
-                    }
-                } else if (command.contains("player_queue_changed")) {
-                    qDebug(dcDenon()) << "Player queue Changed";
-                    int playerId = 0;
-                    if (message.hasQueryItem("pid")) {
-                        playerId = message.queryItemValue("pid").toInt();
-                        emit playerQueueChanged(playerId);
-                    }
-                } else if (command.contains("player_volume_changed")) {
-                    qDebug(dcDenon()) << "Event player volume Changed";
-                    int playerId = 0;
-                    if (message.hasQueryItem("pid")) {
-                        playerId = message.queryItemValue("pid").toInt();
-
-                        if (message.hasQueryItem("level")) {
-                            int volume = message.queryItemValue("level").toInt();
-                            emit playerVolumeReceived(playerId, volume);
-                        }
-                        if (message.hasQueryItem("mute")) {
-                            bool mute;
-                            if (message.queryItemValue("mute").contains("on")) {
-                                mute = true;
-                            } else {
-                                mute = false;
-                            }
-                            emit playerMuteStatusReceived(playerId, mute);
-                        }
-                    }
-                } else if (command.contains("repeat_mode_changed")) {
-                    qDebug(dcDenon()) << "Repeat mode Changed";
-                    int playerId = 0;
-                    if (message.hasQueryItem("pid")) {
-                        playerId = message.queryItemValue("pid").toInt();
-
-                        if (message.hasQueryItem("repeat")) {
-                            REPEAT_MODE repeatMode = REPEAT_MODE_OFF;
-                            if (message.queryItemValue("repeat").contains("on_all")){
-                                repeatMode = REPEAT_MODE_ALL;
-                            } else if (message.queryItemValue("repeat").contains("on_one")){
-                                repeatMode = REPEAT_MODE_ONE;
-                            } else  if (message.queryItemValue("repeat").contains("off")){
-                                repeatMode = REPEAT_MODE_OFF;
-                            }
-                            emit playerRepeatModeReceived(playerId, repeatMode);
-                        }
-                    }
-                } else if (command.contains("shuffle_mode_changed")) {
-                    qDebug(dcDenon()) << "Shuffle mode Changed";
-                    int playerId = 0;
-                    if (message.hasQueryItem("pid")) {
-                        playerId = message.queryItemValue("pid").toInt();
-
-                        if (message.hasQueryItem("shuffle")) {
-                            bool shuffle;
-                            if (message.queryItemValue("shuffle").contains("on")){
-                                shuffle = true;
-                            } else {
-                                shuffle = false;
-                            }
-                            emit playerShuffleModeReceived(playerId, shuffle);
-                        }
-                    }
-                } else if (command.contains("group_volume_changed")) {
-                    qDebug(dcDenon()) << "Event group volume Changed";
-                    int playerId = 0;
-                    if (message.hasQueryItem("gid")) {
-                        playerId = message.queryItemValue("gid").toInt();
-
-                        if (message.hasQueryItem("level")) {
-                            int volume = message.queryItemValue("level").toInt();
-                            emit groupVolumeReceived(playerId, volume);
-                        }
-                        if (message.hasQueryItem("mute")) {
-                            bool mute;
-                            if (message.queryItemValue("mute").contains("on")) {
-                                mute = true;
-                            } else {
-                                mute = false;
-                            }
-                            emit groupMuteStatusReceived(playerId, mute);
-                        }
-                    }
-                } else if (command.contains("user_changed")) {
-
-                    qDebug(dcDenon()) << "Event user changed" << message.toString();
-                    bool signedIn;
-                    QString username;
-                    if (message.hasQueryItem("signed_out")){
-                        signedIn = false;
-                    } else {
-                        signedIn = true;
-                        username = message.queryItemValue("un");
-                    }
-                    emit userChanged(signedIn, username);
-                } else {
-                    qDebug(dcDenon) << "Unhandled Heos event";
-                }
+void Heos::onPlayStateResponse(const Heos::Response &response)
+{
+    if (!response.message.hasQueryItem("pid") || !response.message.hasQueryItem("state"))
+        return;
+
+    int playerId = response.message.queryItemValue("pid").toInt();
+    QString state = response.message.queryItemValue("state");
+    PLAYER_STATE playState = PLAYER_STATE_STOP;
+    if (state.contains("play")) {
+        playState = PLAYER_STATE_PLAY;
+    } else if (state.contains("pause")) {
+        playState = PLAYER_STATE_PAUSE;
+    } else if (state.contains("stop")) {
+        playState = PLAYER_STATE_STOP;
+    }
+    emit playerPlayStateReceived(playerId, playState);
+}
+
+void Heos::onPlayerVolumeResponse(const Heos::Response &response)
+{
+    if (response.message.hasQueryItem("level")) {
+        int playerId = response.message.queryItemValue("pid").toInt();
+        int volume = response.message.queryItemValue("level").toInt();
+        emit playerVolumeReceived(playerId, volume);
+    }
+}
+
+void Heos::onPlayerMuteResponse(const Heos::Response &response)
+{
+    if (response.message.hasQueryItem("state")) {
+        int playerId = response.message.queryItemValue("pid").toInt();
+        emit playerMuteStatusReceived(playerId, response.message.queryItemValue("state").contains("on"));
+    }
+}
+
+void Heos::onPlayModeResponse(const Heos::Response &response)
+{
+    // Used for get/set_play_mode as well as for the repeat and shuffle mode changed events
+    if (!response.message.hasQueryItem("pid"))
+        return;
+
+    int playerId = response.message.queryItemValue("pid").toInt();
+    if (response.message.hasQueryItem("shuffle")) {
+        bool shuffle = response.message.queryItemValue("shuffle").contains("on");
+        emit playerShuffleModeReceived(playerId, shuffle);
+    }
+
+    if (response.message.hasQueryItem("repeat")) {
+        QString repeat = response.message.queryItemValue("repeat");
+        REPEAT_MODE repeatMode = REPEAT_MODE_OFF;
+        if (repeat.contains("on_all")){
+            repeatMode = REPEAT_MODE_ALL;
+        } else if (repeat.contains("on_one")){
+            repeatMode = REPEAT_MODE_ONE;
+        } else if (repeat.contains("off")){
+            repeatMode = REPEAT_MODE_OFF;
+        }
+        emit playerRepeatModeReceived(playerId, repeatMode);
+    }
+}
+
+void Heos::onCheckUpdateResponse(const Heos::Response &response)
+{
+    int playerId = response.message.queryItemValue("pid").toInt();
+    bool updateExist = response.payload.toMap().value("update").toString().contains("exist");
+    emit playerUpdateAvailable(playerId, updateExist);
+}
+
+GroupObject Heos::parseGroup(const QVariantMap &groupMap) const
+{
+    GroupObject group;
+    group.groupId = groupMap.value("gid").toInt();
+    group.name = groupMap.value("name").toString();
+    foreach (const QVariant &playerVariant, groupMap.value("players").toList()) {
+        PlayerObject player;
+        player.name = playerVariant.toMap().value("name").toString();
+        player.playerId = playerVariant.toMap().value("pid").toInt();
+        group.players.append(player);
+    }
+    return group;
+}
+
+void Heos::onGetGroupsResponse(const Heos::Response &response)
+{
+    QList<GroupObject> groups;
+    foreach (const QVariant &payloadEntryVariant, response.payload.toList()) {
+        groups.append(parseGroup(payloadEntryVariant.toMap()));
+    }
+    emit groupsReceived(groups);
+}
+
+void Heos::onGetGroupInfoResponse(const Heos::Response &response)
+{
+    emit groupInfoReceived(parseGroup(response.payload.toMap()));
+}
+
+void Heos::onSetGroupResponse(const Heos::Response &response)
+{
+    if (response.message.hasQueryItem("gid")) {
+        int groupId = response.message.queryItemValue("gid").toInt();
+        QString groupName = response.message.queryItemValue("name");
+        emit setGroupReceived(groupId, groupName);
+    } else {
+        //No group Id so it must have been an ungoup request
+        int playerId = response.message.queryItemValue("pid").toInt();
+        emit deleteGroupReceived(playerId);
+    }
+}
+
+void Heos::onGroupVolumeResponse(const Heos::Response &response)
+{
+    if (response.message.hasQueryItem("level")) {
+        int groupId = response.message.queryItemValue("gid").toInt();
+        int volume = response.message.queryItemValue("level").toInt();
+        emit groupVolumeReceived(groupId, volume);
+    }
+}
+
+void Heos::onGroupMuteResponse(const Heos::Response &response)
+{
+    if (response.message.hasQueryItem("state")) {
+        int groupId = response.message.queryItemValue("gid").toInt();
+        emit playerMuteStatusReceived(groupId, response.message.queryItemValue("state").contains("on"));
+    }
+}
+
+void Heos::onMusicSourcesResponse(const Heos::Response &response)
+{
+    qDebug(dcDenon()) << "Get music source request response received" << response.command;
+    if (!response.success) {
+        return;
+    }
+
+    QList<MusicSourceObject> musicSources;
+    foreach (const QVariant &payloadEntryVariant, response.payload.toList()) {
+        MusicSourceObject source;
+        source.name = payloadEntryVariant.toMap().value("name").toString();
+        source.image_url = payloadEntryVariant.toMap().value("image_url").toString();
+        source.type = payloadEntryVariant.toMap().value("type").toString();
+        source.sourceId = payloadEntryVariant.toMap().value("sid").toInt();
+        source.available = payloadEntryVariant.toMap().value("available").toString().contains("true");
+        source.serviceUsername = payloadEntryVariant.toMap().value("service_username").toString();
+        musicSources.append(source);
+    }
+    emit musicSourcesReceived(response.sequence, musicSources);
+}
+
+void Heos::onBrowseResponse(const Heos::Response &response)
+{
+    if (response.message.toString().contains("command under process")){
+        qDebug(dcDenon()) << "Browse command is beeing processed";
+        return;
+    }
+
+    // Responses we did not request through browse() are passed through uncached
+    bool cached = response.hasSequence && m_browseRequests.contains(response.sequence);
+    BrowseRequest request;
+    if (cached) {
+        request = m_browseRequests.take(response.sequence);
+    } else {
+        request.sourceId = response.message.queryItemValue("sid");
+        request.containerId = response.message.queryItemValue("cid");
+        request.userRequest = true;
+    }
+    QString key = request.sourceId + "/" + request.containerId;
+
+    if (!response.success) {
+        int errorId = response.message.queryItemValue("eid").toInt();
+        QString text = response.message.queryItemValue("text");
+        m_browseCache.remove(key);
+        if (request.userRequest) {
+            emit browseErrorReceived(request.sourceId, request.containerId, errorId, text);
+        } else {
+            qCWarning(dcDenon()) << "Browse prefetch failed" << key << errorId << text;
+        }
+        return;
+    }
+
+    QList<MusicSourceObject> musicSources;
+    QList<MediaObject> mediaItems;
+    foreach (const QVariant &payloadEntryVariant, response.payload.toList()) {
+        QVariantMap entryMap = payloadEntryVariant.toMap();
+        QString type = entryMap.value("type").toString();
+        if (type == "source") {
+            MusicSourceObject source;
+            source.name = entryMap.value("name").toString();
+            source.image_url = entryMap.value("image_url").toString();
+            source.type = entryMap.value("type").toString();
+            source.sourceId = entryMap.value("sid").toInt();
+            qDebug(dcDenon()) << "Source" << source.name << source.type << source.sourceId;
+            musicSources.append(source);
+        } else {
+            MediaObject media;
+            media.name = entryMap.value("name").toString();
+            if (entryMap.contains("cid")) {
+                media.containerId = entryMap.value("cid").toString();
             } else {
-                qDebug(dcDenon) << "Unhandled Heos category" << command;
+                media.containerId = request.containerId;
             }
+            media.mediaId = entryMap.value("mid").toString();
+            media.imageUrl = entryMap.value("image_url").toString();
+            media.isPlayable = entryMap.value("playable").toString().contains("yes");
+            media.isContainer = entryMap.value("container").toString().contains("yes");
+            media.sourceId = request.sourceId;
+            if (type == "artist") {
+                media.mediaType = MEDIA_TYPE_ARTIST;
+            } else if (type == "song") {
+                media.mediaType = MEDIA_TYPE_SONG;
+            } else if (type == "genre") {
+                media.mediaType = MEDIA_TYPE_GENRE;
+            } else if (type == "station") {
+                media.mediaType = MEDIA_TYPE_STATION;
+            } else if (type == "album") {
+                media.mediaType = MEDIA_TYPE_ALBUM;
+            } else if (type == "container") {
+                media.mediaType = MEDIA_TYPE_CONTAINER;
+            }
+            qDebug(dcDenon()) << "Media Item" << media.name << media.mediaId << media.containerId;
+            mediaItems.append(media);
         }
     }
+
+    if (!cached) {
+        emit browseRequestReceived(response.sequence, request.sourceId, request.containerId, musicSources, mediaItems);
+        return;
+    }
+
+    if (request.start == 0) {
+        if (!m_browseCache.contains(key) && m_browseCache.count() >= m_maxBrowseCacheEntries) {
+            // Evict the oldest entry
+            QString oldestKey;
+            qint64 oldestTimestamp = 0;
+            foreach (const QString &cacheKey, m_browseCache.keys()) {
+                if (oldestKey.isEmpty() || m_browseCache.value(cacheKey).timestamp < oldestTimestamp) {
+                    oldestKey = cacheKey;
+                    oldestTimestamp = m_browseCache.value(cacheKey).timestamp;
+                }
+            }
+            m_browseCache.remove(oldestKey);
+        }
+        BrowseCacheEntry entry;
+        entry.sourceId = request.sourceId;
+        entry.containerId = request.containerId;
+        entry.timestamp = QDateTime::currentMSecsSinceEpoch();
+        m_browseCache.insert(key, entry);
+    } else if (!m_browseCache.contains(key) || !m_browseCache.value(key).prefetching
+               || m_browseCache.value(key).musicSources.count() + m_browseCache.value(key).mediaItems.count() != request.start) {
+        // The entry has been invalidated or refetched meanwhile
+        return;
+    }
+
+    BrowseCacheEntry &entry = m_browseCache[key];
+    entry.prefetching = false;
+    entry.musicSources.append(musicSources);
+    entry.mediaItems.append(mediaItems);
+    int loaded = entry.musicSources.count() + entry.mediaItems.count();
+    if (response.message.hasQueryItem("count")) {
+        entry.count = response.message.queryItemValue("count").toInt();
+    } else {
+        entry.count = loaded;
+    }
+    // An empty page means the container is shorter than announced, don't ask again
+    if (musicSources.isEmpty() && mediaItems.isEmpty()) {
+        entry.count = loaded;
+    }
+
+    if (request.userRequest) {
+        emit browseRequestReceived(response.sequence, request.sourceId, request.containerId, entry.musicSources, entry.mediaItems);
+    }
+    prefetchBrowsePage(key);
+}
+
+void Heos::onSourcesChangedEvent(const Heos::Response &response)
+{
+    Q_UNUSED(response)
+    clearBrowseCache();
+    emit sourcesChanged();
 }
 
-quint32 Heos::createRandomNumber()
+void Heos::onPlayersChangedEvent(const Heos::Response &response)
 {
-#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
-    return QRandomGenerator::global()->generate();
-#else
-    return qrand();
-#endif
+    Q_UNUSED(response)
+    emit playersChanged();
 }
 
+void Heos::onGroupsChangedEvent(const Heos::Response &response)
+{
+    Q_UNUSED(response)
+    emit groupsChanged();
+}
 
+void Heos::onPlayerNowPlayingChangedEvent(const Heos::Response &response)
+{
+    qDebug(dcDenon()) << "Player now playing changed, player id:" << response.message.queryItemValue("pid").toInt();
+    if (response.message.hasQueryItem("pid")) {
+        emit playerNowPlayingChanged(response.message.queryItemValue("pid").toInt());
+    }
+}
+
+void Heos::onPlayerNowPlayingProgressEvent(const Heos::Response &response)
+{
+    if (response.message.hasQueryItem("pid")) {
+        int playerId = response.message.queryItemValue("pid").toInt();
+        int currentPossition = response.message.queryItemValue("cur_pos").toInt();
+        int duration = response.message.queryItemValue("duration").toInt();
+        emit playerNowPlayingProgressReceived(playerId, currentPossition, duration);
+    }
+}
+
+void Heos::onPlayerPlaybackErrorEvent(const Heos::Response &response)
+{
+    qDebug(dcDenon) << "Player playback error";
+    if (response.message.hasQueryItem("pid")) {
+        int playerId = response.message.queryItemValue("pid").toInt();
+        QString errorMessage = response.message.queryItemValue("error");
+        emit playerPlaybackErrorReceived(playerId, errorMessage);
+    }
+}
+
+void Heos::onPlayerQueueChangedEvent(const Heos::Response &response)
+{
+    qDebug(dcDenon()) << "Player queue Changed";
+    if (response.message.hasQueryItem("pid")) {
+        emit playerQueueChanged(response.message.queryItemValue("pid").toInt());
+    }
+}
+
+void Heos::onPlayerVolumeChangedEvent(const Heos::Response &response)
+{
+    qDebug(dcDenon()) << "Event player volume Changed";
+    if (!response.message.hasQueryItem("pid"))
+        return;
+
+    int playerId = response.message.queryItemValue("pid").toInt();
+    if (response.message.hasQueryItem("level")) {
+        emit playerVolumeReceived(playerId, response.message.queryItemValue("level").toInt());
+    }
+    if (response.message.hasQueryItem("mute")) {
+        emit playerMuteStatusReceived(playerId, response.message.queryItemValue("mute").contains("on"));
+    }
+}
+
+void Heos::onGroupVolumeChangedEvent(const Heos::Response &response)
+{
+    qDebug(dcDenon()) << "Event group volume Changed";
+    if (!response.message.hasQueryItem("gid"))
+        return;
+
+    int groupId = response.message.queryItemValue("gid").toInt();
+    if (response.message.hasQueryItem("level")) {
+        emit groupVolumeReceived(groupId, response.message.queryItemValue("level").toInt());
+    }
+    if (response.message.hasQueryItem("mute")) {
+        emit groupMuteStatusReceived(groupId, response.message.queryItemValue("mute").contains("on"));
+    }
+}
+
+void Heos::onUserChangedEvent(const Heos::Response &response)
+{
+    qDebug(dcDenon()) << "Event user changed" << response.message.toString();
+    bool signedIn;
+    QString username;
+    if (response.message.hasQueryItem("signed_out")){
+        signedIn = false;
+    } else {
+        signedIn = true;
+        username = response.message.queryItemValue("un");
+    }
+    // Favorites, history and playlists depend on the signed in account
+    clearBrowseCache();
+    emit userChanged(signedIn, username);
+}
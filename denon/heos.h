@@ -35,6 +35,8 @@
 #include <QHostAddress>
 #include <QTcpSocket>
 #include <QTimer>
+#include <QUrlQuery>
+#include <QHash>
 
 #include "heosplayer.h"
 #include "heostypes.h"
@@ -113,7 +115,8 @@ public:
     quint32 browseSource(const QString &sourceId);
     quint32 browseSourceContainers(const QString &sourceId, const QString &containerId);
     quint32 addContainerToQueue(int playerId, const QString &sourceId, const QString &containerId, ADD_CRITERIA addCriteria);
-    // Controllers can add custom argument SEQUENCE=<number> in browse commands to associate command and response.
+    // Browse commands carry a SEQUENCE=<number> argument, the returned number identifies the response.
+    // Browse requests which time out or get lost with the connection are reported by browseErrorReceived().
 
     //Play commands
     quint32 playStation(int playerId, const QString &sourceId, const QString &containerId, const QString &mediaId, const QString &stationName);
@@ -122,12 +125,109 @@ public:
     quint32 playUrl(int playerId, const QUrl &url);
 
 private:
+    struct Request {
+        QString command;
+        quint32 sequence = 0;
+        QByteArray data;
+        qint64 sentTime = 0;
+    };
+
+    struct Response {
+        QString command;
+        bool success = false;
+        QUrlQuery message;
+        QVariant payload;
+        bool hasSequence = false;
+        quint32 sequence = 0;
+    };
+
+    struct BrowseRequest {
+        QString sourceId;
+        QString containerId;
+        int start = 0;
+        bool userRequest = false;
+    };
+
+    struct BrowseCacheEntry {
+        QString sourceId;
+        QString containerId;
+        QList<MusicSourceObject> musicSources;
+        QList<MediaObject> mediaItems;
+        int count = 0;
+        qint64 timestamp = 0;
+        bool prefetching = false;
+    };
+
+    typedef void (Heos::*ResponseHandler)(const Response &response);
+
     bool m_eventRegistered = false;
     QHostAddress m_hostAddress;
     QTcpSocket *m_socket = nullptr;
     QTimer *m_reconnectTimer = nullptr;
     void setConnected(const bool &connected);
 
+    // Note: the CLI processes commands one after another, keep a few requests in flight
+    // to hide the round trip but not so many that events get stuck behind a long queue.
+    int m_maxRequestsInFlight = 8;
+    int m_requestTimeout = 10000;
+    quint32 m_nextSequence = 1;
+    QList<Request> m_pendingRequests;
+    QList<Request> m_requestsInFlight;
+    QTimer *m_requestTimeoutTimer = nullptr;
+    QHash<QString, ResponseHandler> m_responseHandlers;
+
+    // Browse results per "sid/cid", filled page by page in the background
+    int m_browsePageSize = 50;
+    int m_browseCacheTimeout = 300000;
+    int m_maxBrowseCacheEntries = 64;
+    int m_maxBrowseItems = 1000;
+    QHash<quint32, BrowseRequest> m_browseRequests;
+    QHash<QString, BrowseCacheEntry> m_browseCache;
+
+    QUrlQuery playerQuery(int playerId) const;
+    QUrlQuery groupQuery(int groupId) const;
+    quint32 sendRequest(const QString &command, QUrlQuery query = QUrlQuery());
+    void sendNextRequests();
+    void finishRequest(const Response &response);
+    GroupObject parseGroup(const QVariantMap &groupMap) const;
+    void dropRequest(const Request &request, const QString &reason);
+
+    quint32 browse(const QString &sourceId, const QString &containerId);
+    quint32 requestBrowsePage(const BrowseRequest &request);
+    void prefetchBrowsePage(const QString &key);
+    void clearBrowseCache();
+
+    void onIgnoredResponse(const Response &response);
+    void onRegisterForChangeEventsResponse(const Response &response);
+    void onCheckAccountResponse(const Response &response);
+    void onSignInResponse(const Response &response);
+    void onSignOutResponse(const Response &response);
+    void onGetPlayersResponse(const Response &response);
+    void onGetPlayerInfoResponse(const Response &response);
+    void onGetNowPlayingMediaResponse(const Response &response);
+    void onPlayStateResponse(const Response &response);
+    void onPlayerVolumeResponse(const Response &response);
+    void onPlayerMuteResponse(const Response &response);
+    void onPlayModeResponse(const Response &response);
+    void onCheckUpdateResponse(const Response &response);
+    void onGetGroupsResponse(const Response &response);
+    void onGetGroupInfoResponse(const Response &response);
+    void onSetGroupResponse(const Response &response);
+    void onGroupVolumeResponse(const Response &response);
+    void onGroupMuteResponse(const Response &response);
+    void onMusicSourcesResponse(const Response &response);
+    void onBrowseResponse(const Response &response);
+    void onSourcesChangedEvent(const Response &response);
+    void onPlayersChangedEvent(const Response &response);
+    void onGroupsChangedEvent(const Response &response);
+    void onPlayerNowPlayingChangedEvent(const Response &response);
+    void onPlayerNowPlayingProgressEvent(const Response &response);
+    void onPlayerPlaybackErrorEvent(const Response &response);
+    void onPlayerQueueChangedEvent(const Response &response);
+    void onPlayerVolumeChangedEvent(const Response &response);
+    void onGroupVolumeChangedEvent(const Response &response);
+    void onUserChangedEvent(const Response &response);
+
 signals:
     void connectionStatusChanged(bool status);
     void systemEventsEnabled(bool status);
@@ -168,8 +268,7 @@ private slots:
     void onDisconnected();
     void onError(QAbstractSocket::SocketError socketError);
     void readData();
-
-    quint32 createRandomNumber();
+    void onRequestTimeoutTimer();
 };
 
 
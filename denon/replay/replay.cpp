@@ -0,0 +1,160 @@
+#include <QCoreApplication>
+
+#include <QFile>
+#include <QDebug>
+#include <QTimer>
+#include <QEventLoop>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include "avrconnection.h"
+
+// Replays recorded AVR byte streams through the AvrConnection line framing and checks the parsed events.
+// The streams are served by a local TCP server in chunks, so lines arrive split across reads like on
+// a real network connection.
+// Usage: replay              runs the built in recordings and exits with an error if a check fails
+//        replay <file> [n]   replays a raw capture of the telnet port in chunks of n bytes and prints the events
+
+Q_LOGGING_CATEGORY(dcDenon, "Denon")
+
+struct Recording {
+    QString name;
+    QList<QByteArray> chunks;
+    QStringList expectedEvents;
+};
+
+static void wait(int milliseconds)
+{
+    QEventLoop loop;
+    QTimer::singleShot(milliseconds, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+static QStringList replay(QTcpServer *server, const QList<QByteArray> &chunks)
+{
+    QStringList events;
+    AvrConnection connection(QHostAddress::LocalHost, server->serverPort());
+    QObject::connect(&connection, &AvrConnection::powerChanged, [&events](bool power){ events.append(QString("power:%1").arg(power ? "on" : "off")); });
+    QObject::connect(&connection, &AvrConnection::volumeChanged, [&events](int volume){ events.append(QString("volume:%1").arg(volume)); });
+    QObject::connect(&connection, &AvrConnection::muteChanged, [&events](bool mute){ events.append(QString("mute:%1").arg(mute ? "on" : "off")); });
+    QObject::connect(&connection, &AvrConnection::channelChanged, [&events](const QString &channel){ events.append("channel:" + channel); });
+    QObject::connect(&connection, &AvrConnection::surroundModeChanged, [&events](const QString &mode){ events.append("surround:" + mode); });
+    QObject::connect(&connection, &AvrConnection::songChanged, [&events](const QString &song){ events.append("song:" + song); });
+    QObject::connect(&connection, &AvrConnection::artistChanged, [&events](const QString &artist){ events.append("artist:" + artist); });
+    QObject::connect(&connection, &AvrConnection::albumChanged, [&events](const QString &album){ events.append("album:" + album); });
+    QObject::connect(&connection, &AvrConnection::playBackModeChanged, [&events](AvrConnection::PlayBackMode mode){
+        events.append(QString("playback:%1").arg(mode == AvrConnection::PlayBackModePlaying ? "playing" : "stopped"));
+    });
+    QObject::connect(&connection, &AvrConnection::toneControlEnabledChanged, [&events](bool enabled){ events.append(QString("tone:%1").arg(enabled ? "on" : "off")); });
+    QObject::connect(&connection, &AvrConnection::bassLevelChanged, [&events](int level){ events.append(QString("bass:%1").arg(level)); });
+    QObject::connect(&connection, &AvrConnection::trebleLevelChanged, [&events](int level){ events.append(QString("treble:%1").arg(level)); });
+
+    QTcpSocket *peer = nullptr;
+    QEventLoop loop;
+    QObject::connect(server, &QTcpServer::newConnection, &loop, [&peer, &loop, server](){
+        peer = server->nextPendingConnection();
+        loop.quit();
+    });
+    QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+    connection.connectDevice();
+    loop.exec();
+
+    if (!peer) {
+        qWarning() << "The AVR connection did not connect to the replay server";
+        return QStringList() << "no connection";
+    }
+
+    // Give every chunk its own read on the other side
+    foreach (const QByteArray &chunk, chunks) {
+        peer->write(chunk);
+        peer->flush();
+        wait(5);
+    }
+    wait(100);
+
+    peer->close();
+    delete peer;
+    return events;
+}
+
+static QList<Recording> recordings()
+{
+    QList<Recording> recordings;
+
+    recordings.append({"Complete lines in one read",
+                       {"PWON\rMV50\rSIDVD\rMUOFF\r"},
+                       {"power:on", "volume:50", "channel:DVD", "mute:off"}});
+
+    recordings.append({"Lines split across reads",
+                       {"PWST", "ANDBY\rMV4", "55\rMVMAX 98\r", "SISAT/", "CBL\r"},
+                       {"power:off", "volume:45", "channel:SAT/CBL"}});
+
+    QList<QByteArray> bytes;
+    foreach (char byte, QByteArray("MSSTEREO\rPSTONE CTRL ON\rPSBAS 53\rPSTRE 48\r")) {
+        bytes.append(QByteArray(1, byte));
+    }
+    recordings.append({"One byte per read",
+                       bytes,
+                       {"surround:STEREO", "tone:on", "bass:3", "treble:-2"}});
+
+    recordings.append({"Net audio status",
+                       {"NSE0Now Playing\rNSE1\x01Song title\rNSE2\x01", "Artist\rNSE4\x01" "Album\r"},
+                       {"playback:playing", "song:Song title", "artist:Artist", "album:Album"}});
+
+    recordings.append({"Empty, unknown and unsupported lines",
+                       {"\r\rZMON\rSIFOO\rPSTONE CTRL OFF", "\rMUON\r"},
+                       {"tone:off", "mute:on"}});
+
+    recordings.append({"Receive buffer overflow",
+                       {QByteArray(5000, 'x'), "\rPWON\r"},
+                       {"power:on"}});
+
+    return recordings;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+    QLoggingCategory::setFilterRules("Denon.debug=false");
+
+    QTcpServer server;
+    if (!server.listen(QHostAddress::LocalHost)) {
+        qWarning() << "Could not start the replay server:" << server.errorString();
+        return 1;
+    }
+
+    QStringList arguments = application.arguments();
+    if (arguments.count() > 1) {
+        QFile file(arguments.at(1));
+        if (!file.open(QIODevice::ReadOnly)) {
+            qWarning() << "Could not open" << file.fileName() << file.errorString();
+            return 1;
+        }
+
+        int chunkSize = arguments.count() > 2 ? qMax(1, arguments.at(2).toInt()) : 64;
+        QByteArray data = file.readAll();
+        QList<QByteArray> chunks;
+        for (int i = 0; i < data.size(); i += chunkSize) {
+            chunks.append(data.mid(i, chunkSize));
+        }
+
+        foreach (const QString &event, replay(&server, chunks)) {
+            qInfo().noquote() << event;
+        }
+        return 0;
+    }
+
+    int failures = 0;
+    foreach (const Recording &recording, recordings()) {
+        QStringList events = replay(&server, recording.chunks);
+        if (events == recording.expectedEvents) {
+            qInfo().noquote() << "OK    " << recording.name;
+        } else {
+            qWarning().noquote() << "FAILED" << recording.name << "expected" << recording.expectedEvents.join(", ") << "got" << events.join(", ");
+            failures++;
+        }
+    }
+
+    qInfo() << failures << "of" << recordings().count() << "recordings failed";
+    return failures > 0 ? 1 : 0;
+}
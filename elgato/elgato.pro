@@ -1,4 +1,5 @@
 include(../plugins.pri)
+include(../common/bluetoothlowenergy/bluetoothlowenergy.pri)
 
 QT += bluetooth
 
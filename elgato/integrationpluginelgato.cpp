@@ -401,6 +401,14 @@ void IntegrationPluginElgato::init()
 {
     m_pluginTimer = hardwareManager()->pluginTimerManager()->registerTimer(10);
     connect(m_pluginTimer, &PluginTimer::timeout, this, &IntegrationPluginElgato::onPluginTimer);
+
+    // Note: the connection limit is shared by all bluetooth plugins, show the current global value
+    setConfigValue(elgatoPluginMaxConnectionsParamTypeId, BluetoothConnectionLease::maximumConnections(hardwareManager()->bluetoothLowEnergyManager()));
+    connect(this, &IntegrationPluginElgato::configValueChanged, this, [this](const ParamTypeId &paramTypeId, const QVariant &value){
+        if (paramTypeId == elgatoPluginMaxConnectionsParamTypeId) {
+            BluetoothConnectionLease::setMaximumConnections(hardwareManager()->bluetoothLowEnergyManager(), value.toInt());
+        }
+    });
 }
 
 void IntegrationPluginElgato::discoverThings(ThingDiscoveryInfo *info)
@@ -464,6 +472,10 @@ void IntegrationPluginElgato::setupThing(ThingSetupInfo *info)
 
         AveaBulb *bulb = new AveaBulb(thing, bluetoothDevice, this);
         m_bulbs.insert(thing, bulb);
+        // State changes are reported by notifications, keep the Avea connected
+        BluetoothConnectionLease *connectionLease = new BluetoothConnectionLease(hardwareManager()->bluetoothLowEnergyManager(), bluetoothDevice, bulb);
+        connectionLease->setRotatable(false);
+        m_connectionLeases.insert(thing, connectionLease);
 
         return info->finish(Thing::ThingErrorNoError);
     }
@@ -481,7 +493,7 @@ void IntegrationPluginElgato::postSetupThing(Thing *thing)
     bulb->setGreen(thing->stateValue(aveaGreenStateTypeId).toInt());
     bulb->setBlue(thing->stateValue(aveaBlueStateTypeId).toInt());
 
-    bulb->bluetoothDevice()->connectDevice();
+    m_connectionLeases.value(thing)->request(BluetoothConnectionLease::PriorityPersistent);
 }
 
 void IntegrationPluginElgato::executeAction(ThingActionInfo *info)
@@ -577,6 +589,7 @@ void IntegrationPluginElgato::thingRemoved(Thing *thing)
 
     AveaBulb *bulb = m_bulbs.value(thing);
     m_bulbs.remove(thing);
+    m_connectionLeases.take(thing)->release();
     hardwareManager()->bluetoothLowEnergyManager()->unregisterDevice(bulb->bluetoothDevice());
     bulb->deleteLater();
 }
@@ -593,9 +606,9 @@ bool IntegrationPluginElgato::verifyExistingDevices(const QBluetoothDeviceInfo &
 
 void IntegrationPluginElgato::onPluginTimer()
 {
-    foreach (AveaBulb *bulb, m_bulbs.values()) {
-        if (!bulb->bluetoothDevice()->connected()) {
-            bulb->bluetoothDevice()->connectDevice();
+    foreach (Thing *thing, m_bulbs.keys()) {
+        if (!m_bulbs.value(thing)->bluetoothDevice()->connected()) {
+            m_connectionLeases.value(thing)->request(BluetoothConnectionLease::PriorityPersistent);
         }
     }
 }
@@ -32,6 +32,7 @@
 #define INTEGRATIONPLUGINELGATO_H
 
 #include "aveabulb.h"
+#include "bluetoothconnectionlease.h"
 #include "plugintimer.h"
 #include "integrations/integrationplugin.h"
 #include "hardware/bluetoothlowenergy/bluetoothlowenergydevice.h"
@@ -57,6 +58,7 @@ public:
 private:
     PluginTimer *m_pluginTimer = nullptr;
     QHash<Thing *, AveaBulb *> m_bulbs;
+    QHash<Thing *, BluetoothConnectionLease *> m_connectionLeases;
 
     bool verifyExistingDevices(const QBluetoothDeviceInfo &deviceInfo);
 
@@ -115,7 +115,12 @@ EqivaBluetooth::EqivaBluetooth(BluetoothLowEnergyManager *bluetoothManager, cons
     QBluetoothDeviceInfo deviceInfo = QBluetoothDeviceInfo(hostAddress, QString(), 0);
     m_bluetoothDevice = m_bluetoothManager->registerDevice(deviceInfo, QLowEnergyController::PublicAddress);
     connect(m_bluetoothDevice, &BluetoothLowEnergyDevice::stateChanged, this, &EqivaBluetooth::controllerStateChanged);
-    m_bluetoothDevice->connectDevice();
+
+    // The connection will be established once the scheduler grants a connection slot
+    // The thermostat reports its status by notifications, keep it connected
+    m_connectionLease = new BluetoothConnectionLease(m_bluetoothManager, m_bluetoothDevice, this);
+    m_connectionLease->setRotatable(false);
+    m_connectionLease->request(BluetoothConnectionLease::PriorityPersistent);
 
     m_refreshTimer.setInterval(5000);
     m_refreshTimer.setSingleShot(true);
@@ -125,7 +130,18 @@ EqivaBluetooth::EqivaBluetooth(BluetoothLowEnergyManager *bluetoothManager, cons
     connect(&m_reconnectTimer, &QTimer::timeout, this, [this](){
         qCDebug(dcEQ3()) << m_name << "Trying to reconnect";
         m_reconnectAttempt++;
-        m_bluetoothDevice->connectDevice();
+        requestConnection();
+    });
+
+    m_idleTimer.setInterval(30000);
+    m_idleTimer.setSingleShot(true);
+    connect(&m_idleTimer, &QTimer::timeout, this, &EqivaBluetooth::onIdleTimeout);
+
+    m_pollTimer.setInterval(600000);
+    m_pollTimer.setSingleShot(true);
+    connect(&m_pollTimer, &QTimer::timeout, this, [this](){
+        qCDebug(dcEQ3()) << m_name << "Connecting to refresh the status";
+        requestConnection();
     });
 
     m_commandTimeout.setInterval(3000);
@@ -133,7 +149,19 @@ EqivaBluetooth::EqivaBluetooth(BluetoothLowEnergyManager *bluetoothManager, cons
     connect(&m_commandTimeout, &QTimer::timeout, this, [this](){
         // Put current command back to the queue as it didn't succeed
         qCWarning(dcEQ3()) << m_name << "Command timed out:" << m_currentCommand.id << m_currentCommand.name << "Putting command back to queue";
-        m_commandQueue.prepend(m_currentCommand);
+        bool superseded = false;
+        for (int i = 0; i < m_commandQueue.count(); i++) {
+            if (m_commandQueue.at(i).type == m_currentCommand.type) {
+                // A newer command of the same type is waiting already, let that one finish this one too
+                m_commandQueue[i].supersededIds.append(m_currentCommand.supersededIds);
+                m_commandQueue[i].supersededIds.append(m_currentCommand.id);
+                superseded = true;
+                break;
+            }
+        }
+        if (!superseded) {
+            m_commandQueue.prepend(m_currentCommand);
+        }
         m_currentCommand = Command();
 
         // and reset the connection
@@ -145,6 +173,7 @@ EqivaBluetooth::EqivaBluetooth(BluetoothLowEnergyManager *bluetoothManager, cons
 
 EqivaBluetooth::~EqivaBluetooth()
 {
+    m_connectionLease->release();
     m_bluetoothManager->unregisterDevice(m_bluetoothDevice);
 }
 
@@ -158,6 +187,39 @@ bool EqivaBluetooth::available() const
     return m_available;
 }
 
+void EqivaBluetooth::setConnectionPolicy(EqivaBluetooth::ConnectionPolicy policy, int idleTimeout, int pollInterval)
+{
+    m_idleTimer.setInterval(idleTimeout * 1000);
+    m_pollTimer.setInterval(pollInterval * 60000);
+
+    if (m_connectionPolicy == policy) {
+        return;
+    }
+
+    qCDebug(dcEQ3()) << m_name << "Connection policy changed to" << (policy == ConnectionPolicyKeepAlive ? "keep alive" : "on demand");
+    m_connectionPolicy = policy;
+
+    if (m_connectionPolicy == ConnectionPolicyKeepAlive) {
+        m_idleTimer.stop();
+        m_pollTimer.stop();
+        if (m_linkReady) {
+            m_refreshTimer.start();
+        } else {
+            requestConnection();
+        }
+    } else {
+        m_refreshTimer.stop();
+        if (m_linkReady) {
+            m_idleTimer.start();
+        }
+    }
+}
+
+int EqivaBluetooth::commandLatency() const
+{
+    return m_commandLatency;
+}
+
 bool EqivaBluetooth::locked() const
 {
     return m_locked;
@@ -169,7 +231,7 @@ int EqivaBluetooth::setLocked(bool locked)
     QDataStream stream(&data, QIODevice::WriteOnly);
     stream << commandLock;
     stream << (locked ? valueOn : valueOff);
-    return enqueue("SetLocked", data);
+    return enqueue(CommandTypeLock, "SetLocked", data);
 }
 
 bool EqivaBluetooth::boostEnabled() const
@@ -183,7 +245,7 @@ int EqivaBluetooth::setBoostEnabled(bool enabled)
     QDataStream stream(&data, QIODevice::WriteOnly);
     stream << commandBoost;
     stream << (enabled ? valueOn : valueOff);
-    return enqueue("SetBoostEnabled", data);
+    return enqueue(CommandTypeBoost, "SetBoostEnabled", data);
 }
 
 qreal EqivaBluetooth::targetTemperature() const
@@ -201,7 +263,7 @@ int EqivaBluetooth::setTargetTemperature(qreal targetTemperature)
     } else {
         stream << static_cast<quint8>(targetTemperature * 2); // Temperature *2 (thing only supports .5 precision)
     }
-    return enqueue("SetTargetTemperature", data);
+    return enqueue(CommandTypeTargetTemperature, "SetTargetTemperature", data);
 }
 
 EqivaBluetooth::Mode EqivaBluetooth::mode() const
@@ -231,7 +293,7 @@ int EqivaBluetooth::setMode(EqivaBluetooth::Mode mode)
         break;
     }
     qCDebug(dcEQ3()) << m_name << "Setting mode to" << data.toHex();
-    return enqueue("SetMode", data);
+    return enqueue(CommandTypeMode, "SetMode", data);
 }
 
 bool EqivaBluetooth::windowOpen() const
@@ -258,11 +320,32 @@ void EqivaBluetooth::controllerStateChanged(const QLowEnergyController::Controll
     }
 
     if (state == QLowEnergyController::UnconnectedState) {
-        int delay = qMin(m_reconnectAttempt, 30);
-        qWarning(dcEQ3()) << m_name << "Eqiva thing disconnected. Reconnecting in" << delay << "sec";
+        m_linkReady = false;
+        m_idleTimer.stop();
+
+        if (m_idleDisconnect) {
+            m_idleDisconnect = false;
+            if (!m_commandQueue.isEmpty()) {
+                // Commands came in while disconnecting
+                m_reconnectTimer.start(0);
+                return;
+            }
+            qCDebug(dcEQ3()) << m_name << "Disconnected while idle. Refreshing status in" << m_pollTimer.interval() / 60000 << "min";
+            m_pollTimer.start();
+            return;
+        }
+
         m_available = false;
         emit availableChanged();
 
+        if (m_connectionPolicy == ConnectionPolicyOnDemand && m_commandQueue.isEmpty()) {
+            qWarning(dcEQ3()) << m_name << "Eqiva thing disconnected. Trying again in" << m_pollTimer.interval() / 60000 << "min";
+            m_pollTimer.start();
+            return;
+        }
+
+        int delay = qMin(m_reconnectAttempt, 30);
+        qWarning(dcEQ3()) << m_name << "Eqiva thing disconnected. Reconnecting in" << delay << "sec";
         m_reconnectTimer.start(delay * 1000);
     }
 
@@ -333,8 +416,20 @@ void EqivaBluetooth::controllerStateChanged(const QLowEnergyController::Controll
         Q_UNUSED(value)
         qCDebug(dcEQ3()) << m_name << "Command sent:" << m_currentCommand.id << m_currentCommand.name;
         m_commandTimeout.stop();
+
+        // The date is sent periodically and not requested by the user
+        if (m_currentCommand.type != CommandTypeDate) {
+            m_commandLatency = static_cast<int>(QDateTime::currentMSecsSinceEpoch() - m_currentCommand.enqueueTime);
+            qCDebug(dcEQ3()) << m_name << "Command latency:" << m_commandLatency << "ms";
+            emit commandLatencyChanged();
+        }
+
+        foreach (qint32 supersededId, m_currentCommand.supersededIds) {
+            emit commandResult(supersededId, true);
+        }
         emit commandResult(m_currentCommand.id, true);
         m_currentCommand.id = -1;
+        resetActivityTimers();
         processCommandQueue();
 //        m_eqivaService->readCharacteristic(notificationCharacteristicUuid);
     });
@@ -363,9 +458,14 @@ void EqivaBluetooth::serviceStateChanged(QLowEnergyService::ServiceState newStat
 //        }
 //    }
 
-    m_available = true;
+    m_linkReady = true;
     m_reconnectAttempt = 0;
-    emit availableChanged();
+    m_pollTimer.stop();
+    if (!m_available) {
+        m_available = true;
+        emit availableChanged();
+    }
+    resetActivityTimers();
 
     sendDate();
 
@@ -381,7 +481,7 @@ void EqivaBluetooth::characteristicChanged(const QLowEnergyCharacteristic &info,
         qCWarning(dcEQ3()) << m_name << "Received a notification from a characteristic we did't expect:" << info.uuid() << value.toHex();
         return;
     }
-    m_refreshTimer.start();
+    resetActivityTimers();
 
     QByteArray data(value);
     QDataStream stream(&data, QIODevice::ReadOnly);
@@ -443,8 +543,6 @@ void EqivaBluetooth::characteristicChanged(const QLowEnergyCharacteristic &info,
             emit targetTemperatureChanged();
             emit valveOpenChanged();
             emit batteryCriticalChanged();
-
-            m_refreshTimer.start();
         } else if (notificationType == notifyProfile) {
             // Profile updates not implemented
         } else {
@@ -480,15 +578,32 @@ void EqivaBluetooth::sendDate()
     stream << static_cast<quint8>(now.time().second());
 
     // Example: 03130117172315 -> 03YYMMDDHHMMSS
-    enqueue("SetDate", data);
+    enqueue(CommandTypeDate, "SetDate", data);
 }
 
-int EqivaBluetooth::enqueue(const QString &name, const QByteArray &data)
+int EqivaBluetooth::enqueue(CommandType type, const QString &name, const QByteArray &data)
 {
     Command cmd;
+    cmd.type = type;
     cmd.name = name;
     cmd.id = m_nextCommandId++;
     cmd.data = data;
+    cmd.enqueueTime = QDateTime::currentMSecsSinceEpoch();
+
+    // Each command sets an absolute value, so a newer one replaces a pending one of the same type.
+    // This keeps e.g. dragging a temperature slider from queuing up every intermediate setpoint.
+    // The new command goes to the end of the queue, so it is still sent after commands enqueued before it.
+    for (int i = 0; i < m_commandQueue.count(); i++) {
+        if (m_commandQueue.at(i).type != type) {
+            continue;
+        }
+        Command pending = m_commandQueue.takeAt(i);
+        qCDebug(dcEQ3()) << m_name << "Command" << cmd.id << name << "supersedes pending command" << pending.id;
+        cmd.supersededIds = pending.supersededIds;
+        cmd.supersededIds.append(pending.id);
+        break;
+    }
+
     m_commandQueue.append(cmd);
     processCommandQueue();
     return cmd.id;
@@ -505,9 +620,11 @@ void EqivaBluetooth::processCommandQueue()
         return;
     }
 
-    if (!m_available) {
-        qCWarning(dcEQ3()) << m_name << "Not connected. Trying to reconnect before sending commands...";
-        m_bluetoothDevice->connectDevice();
+    if (!m_linkReady) {
+        qCDebug(dcEQ3()) << m_name << "Not connected. Connecting before sending commands...";
+        m_reconnectTimer.stop();
+        m_pollTimer.stop();
+        requestConnection();
         return;
     }
 
@@ -517,6 +634,44 @@ void EqivaBluetooth::processCommandQueue()
     writeCharacteristic(commandCharacteristicUuid, m_currentCommand.data);
 }
 
+void EqivaBluetooth::requestConnection()
+{
+    if (!m_commandQueue.isEmpty() || m_currentCommand.id != -1) {
+        m_connectionLease->request(BluetoothConnectionLease::PriorityUserAction);
+    } else if (m_connectionPolicy == ConnectionPolicyKeepAlive) {
+        m_connectionLease->request(BluetoothConnectionLease::PriorityPersistent);
+    } else {
+        // Status refresh only, this should not block the adapter for long
+        m_connectionLease->request(BluetoothConnectionLease::PriorityPoll, 120000);
+    }
+}
+
+void EqivaBluetooth::resetActivityTimers()
+{
+    if (m_connectionPolicy == ConnectionPolicyKeepAlive) {
+        m_refreshTimer.start();
+    } else {
+        m_idleTimer.start();
+    }
+}
+
+void EqivaBluetooth::onIdleTimeout()
+{
+    if (m_connectionPolicy != ConnectionPolicyOnDemand || !m_linkReady) {
+        return;
+    }
+
+    if (m_currentCommand.id != -1 || !m_commandQueue.isEmpty()) {
+        m_idleTimer.start();
+        return;
+    }
+
+    qCDebug(dcEQ3()) << m_name << "Idle. Disconnecting until the next command or status refresh";
+    m_idleDisconnect = true;
+    m_linkReady = false;
+    m_bluetoothDevice->disconnectDevice();
+}
+
 
 EqivaBluetoothDiscovery::EqivaBluetoothDiscovery(BluetoothLowEnergyManager *bluetoothManager, QObject *parent):
     QObject(parent),
@@ -34,6 +34,7 @@
 #include <QObject>
 
 #include "hardware/bluetoothlowenergy/bluetoothlowenergymanager.h"
+#include "bluetoothconnectionlease.h"
 
 
 class EqivaBluetooth : public QObject
@@ -45,12 +46,22 @@ public:
         ModeManual,
         ModeHoliday
     };
+    enum ConnectionPolicy {
+        ConnectionPolicyKeepAlive,
+        ConnectionPolicyOnDemand
+    };
     explicit EqivaBluetooth(BluetoothLowEnergyManager *bluetoothManager, const QBluetoothAddress &hostAddress, const QString &name, QObject *parent = nullptr);
     ~EqivaBluetooth();
     void setName(const QString &name);
 
     bool available() const;
 
+    // On demand: disconnect after idleTimeout seconds without commands, refresh the status every pollInterval minutes
+    void setConnectionPolicy(ConnectionPolicy policy, int idleTimeout, int pollInterval);
+
+    // Time in ms between the last user command being enqueued and its acknowledgement
+    int commandLatency() const;
+
     bool enabled() const;
     int setEnabled(bool enabled);
 
@@ -81,6 +92,7 @@ signals:
     void targetTemperatureChanged();
     void valveOpenChanged();
     void batteryCriticalChanged();
+    void commandLatencyChanged();
 
     void commandResult(int id, bool result);
 
@@ -93,19 +105,35 @@ private slots:
 
     void sendDate();
 
+    void onIdleTimeout();
+
+private:
+    enum CommandType {
+        CommandTypeDate,
+        CommandTypeLock,
+        CommandTypeBoost,
+        CommandTypeTargetTemperature,
+        CommandTypeMode
+    };
+
     // Name parameter used for debugging purposes
-    int enqueue(const QString &name, const QByteArray &data);
+    int enqueue(CommandType type, const QString &name, const QByteArray &data);
     void processCommandQueue();
 
-private:
+    void requestConnection();
+    void resetActivityTimers();
+
     BluetoothLowEnergyManager* m_bluetoothManager = nullptr;
     BluetoothLowEnergyDevice* m_bluetoothDevice = nullptr;
+    BluetoothConnectionLease *m_connectionLease = nullptr;
     QLowEnergyService *m_eqivaService = nullptr;
     QTimer m_refreshTimer;
 
     QString m_name;
 
+    // Available stays true while disconnected on purpose, the link is only up while connected
     bool m_available = false;
+    bool m_linkReady = false;
     bool m_locked = false;
     bool m_boostEnabled = false;
     qreal m_targetTemp = 0;
@@ -117,10 +145,21 @@ private:
     QTimer m_reconnectTimer;
     int m_reconnectAttempt = 0;
 
+    ConnectionPolicy m_connectionPolicy = ConnectionPolicyKeepAlive;
+    QTimer m_idleTimer;
+    QTimer m_pollTimer;
+    bool m_idleDisconnect = false;
+
+    int m_commandLatency = 0;
+
     struct Command {
+        CommandType type = CommandTypeDate;
         QString name; // For debug prints
         QByteArray data;
         qint32 id = -1;
+        // Commands of the same type this one replaced before they have been sent. Finished together with this one.
+        QList<qint32> supersededIds;
+        qint64 enqueueTime = 0;
     };
     QList<Command> m_commandQueue;
     Command m_currentCommand;
@@ -54,6 +54,14 @@ void IntegrationPluginEQ3::init()
 
     m_pluginTimer = hardwareManager()->pluginTimerManager()->registerTimer(10);
     connect(m_pluginTimer, &PluginTimer::timeout, this, &IntegrationPluginEQ3::onPluginTimer);
+
+    // Note: the connection limit is shared by all bluetooth plugins, show the current global value
+    setConfigValue(eQ3PluginMaxConnectionsParamTypeId, BluetoothConnectionLease::maximumConnections(hardwareManager()->bluetoothLowEnergyManager()));
+    connect(this, &IntegrationPluginEQ3::configValueChanged, this, [this](const ParamTypeId &paramTypeId, const QVariant &value){
+        if (paramTypeId == eQ3PluginMaxConnectionsParamTypeId) {
+            BluetoothConnectionLease::setMaximumConnections(hardwareManager()->bluetoothLowEnergyManager(), value.toInt());
+        }
+    });
 }
 
 void IntegrationPluginEQ3::discoverThings(ThingDiscoveryInfo *info)
@@ -169,6 +177,12 @@ void IntegrationPluginEQ3::setupThing(ThingSetupInfo *info)
             eqivaDevice->setName(thing->name());
         });
 
+        // Connection policy
+        applyConnectionPolicy(thing, eqivaDevice);
+        connect(thing, &Thing::settingChanged, eqivaDevice, [this, thing, eqivaDevice](){
+            applyConnectionPolicy(thing, eqivaDevice);
+        });
+
         // Connected state
         thing->setStateValue(eqivaBluetoothConnectedStateTypeId, eqivaDevice->available());
         connect(eqivaDevice, &EqivaBluetooth::availableChanged, thing, [thing, eqivaDevice](){
@@ -214,6 +228,10 @@ void IntegrationPluginEQ3::setupThing(ThingSetupInfo *info)
         connect(eqivaDevice, &EqivaBluetooth::batteryCriticalChanged, thing, [thing, eqivaDevice](){
             thing->setStateValue(eqivaBluetoothBatteryCriticalStateTypeId, eqivaDevice->batteryCritical());
         });
+        // Command latency state
+        connect(eqivaDevice, &EqivaBluetooth::commandLatencyChanged, thing, [thing, eqivaDevice](){
+            thing->setStateValue(eqivaBluetoothCommandLatencyStateTypeId, eqivaDevice->commandLatency());
+        });
     }
 
     info->finish(Thing::ThingErrorNoError);
@@ -236,6 +254,14 @@ void IntegrationPluginEQ3::thingRemoved(Thing *thing)
 
 }
 
+void IntegrationPluginEQ3::applyConnectionPolicy(Thing *thing, EqivaBluetooth *eqivaDevice)
+{
+    EqivaBluetooth::ConnectionPolicy policy = stringToConnectionPolicy(thing->setting(eqivaBluetoothSettingsConnectionPolicyParamTypeId).toString());
+    eqivaDevice->setConnectionPolicy(policy,
+                                     thing->setting(eqivaBluetoothSettingsIdleTimeoutParamTypeId).toInt(),
+                                     thing->setting(eqivaBluetoothSettingsPollIntervalParamTypeId).toInt());
+}
+
 QString IntegrationPluginEQ3::modeToString(EqivaBluetooth::Mode mode)
 {
     switch (mode) {
@@ -265,6 +291,18 @@ EqivaBluetooth::Mode IntegrationPluginEQ3::stringToMode(const QString &string)
     return  EqivaBluetooth::ModeAuto;
 }
 
+EqivaBluetooth::ConnectionPolicy IntegrationPluginEQ3::stringToConnectionPolicy(const QString &string)
+{
+    if (string == "On demand") {
+        return EqivaBluetooth::ConnectionPolicyOnDemand;
+    }
+    if (string == "Keep alive") {
+        return EqivaBluetooth::ConnectionPolicyKeepAlive;
+    }
+    qCWarning(dcEQ3()) << "Unhandled connection policy" << string << "Keeping the connection alive.";
+    return EqivaBluetooth::ConnectionPolicyKeepAlive;
+}
+
 void IntegrationPluginEQ3::executeAction(ThingActionInfo *info)
 {
     Action action = info->action();
@@ -60,8 +60,10 @@ public:
     void executeAction(ThingActionInfo *info) override;
 
 private:
+    void applyConnectionPolicy(Thing *thing, EqivaBluetooth *eqivaDevice);
     QString modeToString(EqivaBluetooth::Mode mode);
     EqivaBluetooth::Mode stringToMode(const QString &string);
+    EqivaBluetooth::ConnectionPolicy stringToConnectionPolicy(const QString &string);
 
     PluginTimer *m_pluginTimer = nullptr;
     QList<Param> m_config;
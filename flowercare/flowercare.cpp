@@ -33,19 +33,32 @@
 #include "extern-plugininfo.h"
 
 #include <QDataStream>
+#include <QtEndian>
 
-FlowerCare::FlowerCare(BluetoothLowEnergyDevice *thing, QObject *parent):
+FlowerCare::FlowerCare(BluetoothLowEnergyManager *bluetoothManager, BluetoothLowEnergyDevice *thing, QObject *parent):
     QObject(parent),
-    m_bluetoothDevice(thing)
+    m_bluetoothDevice(thing),
+    m_connectionLease(new BluetoothConnectionLease(bluetoothManager, thing, this))
 {
     connect(m_bluetoothDevice, &BluetoothLowEnergyDevice::connectedChanged, this, &FlowerCare::onConnectedChanged);
     connect(m_bluetoothDevice, &BluetoothLowEnergyDevice::servicesDiscoveryFinished, this, &FlowerCare::onServiceDiscoveryFinished);
 }
 
-void FlowerCare::refreshData()
+void FlowerCare::refreshData(BluetoothConnectionLease::Priority priority)
 {
-    qCDebug(dcFlowerCare()) << "Connecting to device";
-    m_bluetoothDevice->connectDevice();
+    QueuedOperation operation;
+    operation.operation = OperationLiveData;
+    operation.priority = priority;
+    enqueueOperation(operation);
+}
+
+void FlowerCare::syncHistory(const QDateTime &since, int startIndex)
+{
+    QueuedOperation operation;
+    operation.operation = OperationHistory;
+    operation.historySince = since;
+    operation.historyStart = startIndex;
+    enqueueOperation(operation);
 }
 
 BluetoothLowEnergyDevice *FlowerCare::btDevice() const
@@ -53,13 +66,96 @@ BluetoothLowEnergyDevice *FlowerCare::btDevice() const
     return m_bluetoothDevice;
 }
 
+void FlowerCare::enqueueOperation(const QueuedOperation &operation)
+{
+    // The lease gave up connecting the device, the current operation will not finish any more
+    if (m_operation != OperationNone && !m_bluetoothDevice->connected() && m_connectionLease->state() == BluetoothConnectionLease::StateIdle) {
+        qCWarning(dcFlowerCare()) << "Could not connect to the device.";
+        failOperation();
+    }
+
+    // Still waiting for the connection of the same operation, only raise the priority
+    if (operation.operation == m_operation && operation.operation == OperationLiveData && !m_bluetoothDevice->connected()) {
+        m_connectionLease->request(operation.priority, 60000);
+        return;
+    }
+
+    for (int i = 0; i < m_operationQueue.count(); i++) {
+        if (m_operationQueue.at(i).operation == operation.operation) {
+            qCDebug(dcFlowerCare()) << "Operation already queued, updating it.";
+            QueuedOperation &queued = m_operationQueue[i];
+            queued.priority = qMax(queued.priority, operation.priority);
+            queued.historySince = operation.historySince;
+            queued.historyStart = operation.historyStart;
+            return;
+        }
+    }
+
+    m_operationQueue.append(operation);
+    startNextOperation();
+}
+
+void FlowerCare::startNextOperation()
+{
+    // Note: the next operation starts once the device has been disconnected and the lease is free again
+    if (m_operation != OperationNone || m_bluetoothDevice->connected() || m_operationQueue.isEmpty())
+        return;
+
+    QueuedOperation operation = m_operationQueue.takeFirst();
+    m_operation = operation.operation;
+
+    // Note: the lease connects the device once a connection slot is available and limits the connection time
+    if (m_operation == OperationHistory) {
+        qCDebug(dcFlowerCare()) << "Requesting connection to device for history download from record" << operation.historyStart << "since" << operation.historySince.toString(Qt::ISODate);
+        m_historySince = operation.historySince;
+        m_historyStart = operation.historyStart;
+        m_historyCount = -1;
+        m_historyIndex = 0;
+        m_historyRecords.clear();
+
+        // Reading the history takes one round trip per record, allow some more time than for live data
+        m_connectionLease->request(operation.priority, 300000);
+        return;
+    }
+
+    qCDebug(dcFlowerCare()) << "Requesting connection to device";
+    m_connectionLease->request(operation.priority, 60000);
+}
+
+void FlowerCare::failOperation()
+{
+    m_historyRecords.clear();
+    m_operation = OperationNone;
+    m_bluetoothDevice->disconnectDevice();
+    emit failed();
+}
+
 void FlowerCare::onConnectedChanged(bool connected)
 {
     qCDebug(dcFlowerCare()) << "Connection changed:" << connected;
-    if (!connected) {
+    if (connected)
+        return;
+
+    if (m_sensorService) {
         m_sensorService->deleteLater();
         m_sensorService = nullptr;
     }
+
+    if (m_historyService) {
+        m_historyService->deleteLater();
+        m_historyService = nullptr;
+    }
+
+    if (m_operation == OperationHistory) {
+        qCWarning(dcFlowerCare()) << "Connection lost during history download. Received" << m_historyIndex << "of" << m_historyCount << "records.";
+        failOperation();
+    } else if (m_operation == OperationLiveData) {
+        qCWarning(dcFlowerCare()) << "Connection lost before receiving the sensor data.";
+        failOperation();
+    }
+
+    // Note: the lease has been connected to the device first and returned its slot already
+    startNextOperation();
 }
 
 void FlowerCare::onServiceDiscoveryFinished()
@@ -84,7 +180,7 @@ void FlowerCare::onSensorServiceStateChanged(const QLowEnergyService::ServiceSta
     QLowEnergyCharacteristic batteryFirmwareCharacteristic = m_sensorService->characteristic(batteryFirmwareCharacteristicUuid);
     if (!batteryFirmwareCharacteristic.isValid()) {
         qCWarning(dcFlowerCare()) << "Invalid battery/firmware characteristic.";
-        emit failed();
+        failOperation();
         return;
     }
 
@@ -98,6 +194,21 @@ void FlowerCare::onSensorServiceStateChanged(const QLowEnergyService::ServiceSta
 
     qCDebug(dcFlowerCare()) << "Firmware version:" << firmwareVersionString;
 
+    if (m_operation == OperationHistory) {
+        m_historyService = m_bluetoothDevice->controller()->createServiceObject(historyServiceUuid, this);
+        if (!m_historyService) {
+            qCWarning(dcFlowerCare()) << "History service not available on this device.";
+            failOperation();
+            return;
+        }
+        connect(m_historyService, &QLowEnergyService::stateChanged, this, &FlowerCare::onHistoryServiceStateChanged);
+        connect(m_historyService, &QLowEnergyService::characteristicRead, this, &FlowerCare::onHistoryServiceCharacteristicRead);
+        connect(m_historyService, &QLowEnergyService::characteristicWritten, this, &FlowerCare::onHistoryServiceCharacteristicWritten);
+        connect(m_historyService, static_cast<void(QLowEnergyService::*)(QLowEnergyService::ServiceError)>(&QLowEnergyService::error), this, &FlowerCare::onHistoryServiceError);
+        m_historyService->discoverDetails();
+        return;
+    }
+
     if (firmwareVersionString >= "2.6.6") {
         QLowEnergyCharacteristic sensorControlCharacteristic = m_sensorService->characteristic(sensorControlCharacteristicUuid);
         m_sensorService->writeCharacteristic(sensorControlCharacteristic, QByteArray::fromHex("A01F"));
@@ -139,6 +250,96 @@ void FlowerCare::onSensorServiceCharacteristicChanged(const QLowEnergyCharacteri
 }
 
 
+void FlowerCare::onHistoryServiceStateChanged(const QLowEnergyService::ServiceState &state)
+{
+    if (state != QLowEnergyService::ServiceDiscovered) {
+        return;
+    }
+
+    if (!m_historyService->characteristic(historyControlCharacteristicUuid).isValid() ||
+            !m_historyService->characteristic(historyDataCharacteristicUuid).isValid() ||
+            !m_historyService->characteristic(deviceTimeCharacteristicUuid).isValid()) {
+        qCWarning(dcFlowerCare()) << "Invalid history characteristics.";
+        failOperation();
+        return;
+    }
+
+    // The record timestamps are relative to the device start, fetch the device time first
+    m_historyService->readCharacteristic(m_historyService->characteristic(deviceTimeCharacteristicUuid));
+}
+
+void FlowerCare::onHistoryServiceCharacteristicRead(const QLowEnergyCharacteristic &characteristic, const QByteArray &value)
+{
+    if (characteristic.uuid() == deviceTimeCharacteristicUuid) {
+        if (value.size() < 4) {
+            qCWarning(dcFlowerCare()) << "Invalid device time" << value.toHex();
+            failOperation();
+            return;
+        }
+        quint32 deviceSeconds = qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(value.constData()));
+        m_deviceStartTime = QDateTime::currentDateTimeUtc().addSecs(-static_cast<qint64>(deviceSeconds));
+        qCDebug(dcFlowerCare()) << "Device running since" << m_deviceStartTime.toString(Qt::ISODate);
+
+        m_historyService->writeCharacteristic(m_historyService->characteristic(historyControlCharacteristicUuid), QByteArray::fromHex("A00000"));
+        return;
+    }
+
+    if (characteristic.uuid() != historyDataCharacteristicUuid) {
+        return;
+    }
+
+    // First read after entering the history mode contains the number of records
+    if (m_historyCount < 0) {
+        if (value.size() < 2) {
+            qCWarning(dcFlowerCare()) << "Invalid history record count" << value.toHex();
+            failOperation();
+            return;
+        }
+        m_historyCount = qFromLittleEndian<quint16>(reinterpret_cast<const uchar *>(value.constData()));
+        qCDebug(dcFlowerCare()) << "Device holds" << m_historyCount << "history records";
+
+        // Fewer records than last time, the history has been cleared on the device
+        if (m_historyStart > m_historyCount) {
+            qCDebug(dcFlowerCare()) << "History has been reset on the device. Reading all records.";
+            m_historyStart = 0;
+        }
+
+        m_historyIndex = m_historyStart;
+        if (m_historyIndex >= m_historyCount) {
+            finishHistory();
+            return;
+        }
+        requestHistoryRecord();
+        return;
+    }
+
+    processHistoryRecord(value);
+
+    m_historyIndex++;
+    if (m_historyIndex < m_historyCount) {
+        requestHistoryRecord();
+    } else {
+        finishHistory();
+    }
+}
+
+void FlowerCare::onHistoryServiceCharacteristicWritten(const QLowEnergyCharacteristic &characteristic, const QByteArray &value)
+{
+    Q_UNUSED(value)
+    if (characteristic.uuid() != historyControlCharacteristicUuid) {
+        return;
+    }
+
+    // The data characteristic holds the count or the selected record now
+    m_historyService->readCharacteristic(m_historyService->characteristic(historyDataCharacteristicUuid));
+}
+
+void FlowerCare::onHistoryServiceError(QLowEnergyService::ServiceError error)
+{
+    qCWarning(dcFlowerCare()) << "History service error:" << error;
+    failOperation();
+}
+
 void FlowerCare::printServiceDetails(QLowEnergyService *service) const
 {
     foreach (const QLowEnergyCharacteristic &characteristic, service->characteristics()) {
@@ -167,6 +368,65 @@ void FlowerCare::processSensorData(const QByteArray &data)
 
     qCDebug(dcFlowerCare()) << "Temperature:" << temp << "Lux:" << lux << "moisture:" << moisture << "fertility" << fertility;
 
+    m_operation = OperationNone;
     m_bluetoothDevice->disconnectDevice();
     emit finished(m_batteryLevel, 1.0 * temp / 10, lux, moisture, fertility);
 }
+
+void FlowerCare::requestHistoryRecord()
+{
+    QByteArray command(3, 0);
+    command[0] = static_cast<char>(0xA1);
+    qToLittleEndian<quint16>(static_cast<quint16>(m_historyIndex), reinterpret_cast<uchar *>(command.data() + 1));
+    m_historyService->writeCharacteristic(m_historyService->characteristic(historyControlCharacteristicUuid), command);
+}
+
+void FlowerCare::processHistoryRecord(const QByteArray &data)
+{
+    if (data.size() < 16) {
+        qCWarning(dcFlowerCare()) << "Invalid history record" << m_historyIndex << data.toHex();
+        return;
+    }
+
+    QByteArray copy = data;
+    QDataStream stream(&copy, QIODevice::ReadOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    quint32 timestamp;
+    stream >> timestamp;
+    qint16 temp;
+    stream >> temp;
+    qint8 skip;
+    stream >> skip;
+    quint32 lux;
+    stream >> lux;
+    quint8 moisture;
+    stream >> moisture;
+    quint16 fertility;
+    stream >> fertility;
+
+    HistoryRecord record;
+    record.timestamp = m_deviceStartTime.addSecs(timestamp);
+    if (m_historySince.isValid() && record.timestamp <= m_historySince) {
+        return;
+    }
+
+    record.degreeCelsius = 1.0 * temp / 10;
+    record.lux = lux;
+    record.moisture = moisture;
+    record.fertility = fertility;
+    m_historyRecords.append(record);
+}
+
+void FlowerCare::finishHistory()
+{
+    qCDebug(dcFlowerCare()) << "History download finished." << m_historyRecords.count() << "new records";
+    std::sort(m_historyRecords.begin(), m_historyRecords.end(), [](const HistoryRecord &a, const HistoryRecord &b) {
+        return a.timestamp < b.timestamp;
+    });
+
+    QList<HistoryRecord> records = m_historyRecords;
+    m_historyRecords.clear();
+    m_operation = OperationNone;
+    m_bluetoothDevice->disconnectDevice();
+    emit historyFinished(m_batteryLevel, records, qMax(m_historyCount, 0));
+}
@@ -32,8 +32,10 @@
 #define FLOWERCARE_H
 
 #include <QObject>
+#include <QDateTime>
 
 #include "hardware/bluetoothlowenergy/bluetoothlowenergydevice.h"
+#include "bluetoothconnectionlease.h"
 
 static QBluetoothUuid sensorServiceUuid                      = QBluetoothUuid(QUuid("00001204-0000-1000-8000-00805f9b34fb"));
 
@@ -46,19 +48,43 @@ static QBluetoothUuid sensorControlCharacteristicUuid        = QBluetoothUuid(QU
 // contains sensor data
 static QBluetoothUuid sensorDataCharacteristicUuid           = QBluetoothUuid(QUuid("00001a01-0000-1000-8000-00805f9b34fb"));
 
+static QBluetoothUuid historyServiceUuid                     = QBluetoothUuid(QUuid("00001206-0000-1000-8000-00805f9b34fb"));
+
+// Write 0xA00000 to enter history mode, 0xA1 + index (uint16 LE) to select a record
+static QBluetoothUuid historyControlCharacteristicUuid       = QBluetoothUuid(QUuid("00001a10-0000-1000-8000-00805f9b34fb"));
+
+// Contains the record count after entering history mode, the selected record afterwards
+static QBluetoothUuid historyDataCharacteristicUuid          = QBluetoothUuid(QUuid("00001a11-0000-1000-8000-00805f9b34fb"));
+
+// Seconds since the device has been started, the history timestamps are relative to that
+static QBluetoothUuid deviceTimeCharacteristicUuid           = QBluetoothUuid(QUuid("00001a12-0000-1000-8000-00805f9b34fb"));
+
 
 class FlowerCare : public QObject
 {
     Q_OBJECT
 public:
-    explicit FlowerCare(BluetoothLowEnergyDevice* thing, QObject *parent = nullptr);
+    struct HistoryRecord {
+        QDateTime timestamp;
+        double degreeCelsius = 0;
+        double lux = 0;
+        double moisture = 0;
+        double fertility = 0;
+    };
+
+    explicit FlowerCare(BluetoothLowEnergyManager *bluetoothManager, BluetoothLowEnergyDevice* thing, QObject *parent = nullptr);
 
-    void refreshData();
+    void refreshData(BluetoothConnectionLease::Priority priority = BluetoothConnectionLease::PriorityPoll);
+
+    // Downloads the history records stored on the device starting at the given index, which are newer than
+    // the given timestamp. The device appends new records, pass the record count of the last download.
+    void syncHistory(const QDateTime &since, int startIndex = 0);
 
     BluetoothLowEnergyDevice* btDevice() const;
 
 signals:
     void finished(quint8 batteryLevel, double degreeCelsius, double lux, double moisture, double fertility);
+    void historyFinished(quint8 batteryLevel, const QList<FlowerCare::HistoryRecord> &records, int recordCount);
     void failed();
 
 private slots:
@@ -69,16 +95,56 @@ private slots:
     void onSensorServiceCharacteristicRead(const QLowEnergyCharacteristic &characteristic, const QByteArray &value);
     void onSensorServiceCharacteristicChanged(const QLowEnergyCharacteristic &characteristic, const QByteArray &value);
 
+    void onHistoryServiceStateChanged(const QLowEnergyService::ServiceState &state);
+    void onHistoryServiceCharacteristicRead(const QLowEnergyCharacteristic &characteristic, const QByteArray &value);
+    void onHistoryServiceCharacteristicWritten(const QLowEnergyCharacteristic &characteristic, const QByteArray &value);
+    void onHistoryServiceError(QLowEnergyService::ServiceError error);
+
 private:
+    enum Operation {
+        OperationNone,
+        OperationLiveData,
+        OperationHistory
+    };
+
+    struct QueuedOperation {
+        Operation operation = OperationNone;
+        BluetoothConnectionLease::Priority priority = BluetoothConnectionLease::PriorityPoll;
+        QDateTime historySince;
+        int historyStart = 0;
+    };
+
+    void enqueueOperation(const QueuedOperation &operation);
+    void startNextOperation();
+    void failOperation();
+
     void printServiceDetails(QLowEnergyService* service) const;
 
     void processSensorData(const QByteArray &data);
 
+    void requestHistoryRecord();
+    void processHistoryRecord(const QByteArray &data);
+    void finishHistory();
+
     BluetoothLowEnergyDevice *m_bluetoothDevice;
+    BluetoothConnectionLease *m_connectionLease = nullptr;
+
+    // Each operation needs its own connection, the others wait until the device has been disconnected
+    Operation m_operation = OperationNone;
+    QList<QueuedOperation> m_operationQueue;
 
     // Services
     QLowEnergyService *m_sensorService = nullptr;
     QLowEnergyCharacteristic m_sensorDataCharacteristic;
+    QLowEnergyService *m_historyService = nullptr;
+
+    // History download
+    QDateTime m_historySince;
+    QDateTime m_deviceStartTime;
+    int m_historyStart = 0;
+    int m_historyCount = -1;
+    int m_historyIndex = 0;
+    QList<HistoryRecord> m_historyRecords;
 
     // cache
     quint8 m_batteryLevel = 0;
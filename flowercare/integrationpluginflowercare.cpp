@@ -56,6 +56,13 @@ IntegrationPluginFlowercare::~IntegrationPluginFlowercare()
 
 void IntegrationPluginFlowercare::init()
 {
+    // Note: the connection limit is shared by all bluetooth plugins, show the current global value
+    setConfigValue(flowerCarePluginMaxConnectionsParamTypeId, BluetoothConnectionLease::maximumConnections(hardwareManager()->bluetoothLowEnergyManager()));
+    connect(this, &IntegrationPluginFlowercare::configValueChanged, this, [this](const ParamTypeId &paramTypeId, const QVariant &value){
+        if (paramTypeId == flowerCarePluginMaxConnectionsParamTypeId) {
+            BluetoothConnectionLease::setMaximumConnections(hardwareManager()->bluetoothLowEnergyManager(), value.toInt());
+        }
+    });
 }
 
 void IntegrationPluginFlowercare::discoverThings(ThingDiscoveryInfo *info)
@@ -111,8 +118,10 @@ void IntegrationPluginFlowercare::setupThing(ThingSetupInfo *info)
     QBluetoothDeviceInfo deviceInfo = QBluetoothDeviceInfo(address, thing->name(), 0);
 
     BluetoothLowEnergyDevice *bluetoothDevice = hardwareManager()->bluetoothLowEnergyManager()->registerDevice(deviceInfo, QLowEnergyController::PublicAddress);
-    FlowerCare *flowerCare = new FlowerCare(bluetoothDevice, this);
+    FlowerCare *flowerCare = new FlowerCare(hardwareManager()->bluetoothLowEnergyManager(), bluetoothDevice, this);
     connect(flowerCare, &FlowerCare::finished, this, &IntegrationPluginFlowercare::onSensorDataReceived);
+    connect(flowerCare, &FlowerCare::historyFinished, this, &IntegrationPluginFlowercare::onHistoryReceived);
+    connect(flowerCare, &FlowerCare::failed, this, &IntegrationPluginFlowercare::onFailed);
     m_list.insert(thing, flowerCare);
 
     m_refreshMinutes[flowerCare] = 0;
@@ -122,10 +131,10 @@ void IntegrationPluginFlowercare::setupThing(ThingSetupInfo *info)
         connect(m_reconnectTimer, &PluginTimer::timeout, this, &IntegrationPluginFlowercare::onPluginTimer);
     }
 
-    // Update refresh schedule when the refresh rate setting is changed
+    // Update refresh schedule when the refresh rate or history settings are changed
     connect(thing, &Thing::settingChanged, flowerCare, [this, thing] {
         FlowerCare *flowerCare = m_list.value(thing);
-        int refreshInterval = thing->setting(flowerCareSettingsRefreshRateParamTypeId).toInt();
+        int refreshInterval = refreshMinutes(thing);
         if (m_refreshMinutes[flowerCare] > refreshInterval) {
             m_refreshMinutes[flowerCare] = refreshInterval;
         }
@@ -136,8 +145,21 @@ void IntegrationPluginFlowercare::setupThing(ThingSetupInfo *info)
 
 void IntegrationPluginFlowercare::postSetupThing(Thing *thing)
 {
+    refresh(thing);
+}
+
+void IntegrationPluginFlowercare::executeAction(ThingActionInfo *info)
+{
+    Thing *thing = info->thing();
     FlowerCare *flowerCare = m_list.value(thing);
-    flowerCare->refreshData();
+
+    if (info->action().actionTypeId() == flowerCareRefreshActionTypeId) {
+        // Live data on demand, also when the history is synchronized periodically
+        flowerCare->refreshData(BluetoothConnectionLease::PriorityUserAction);
+        return info->finish(Thing::ThingErrorNoError);
+    }
+
+    info->finish(Thing::ThingErrorActionTypeNotFound);
 }
 
 void IntegrationPluginFlowercare::thingRemoved(Thing *thing)
@@ -149,6 +171,9 @@ void IntegrationPluginFlowercare::thingRemoved(Thing *thing)
 
     hardwareManager()->bluetoothLowEnergyManager()->unregisterDevice(flowerCare->btDevice());
     flowerCare->deleteLater();
+    m_refreshMinutes.remove(flowerCare);
+
+    pluginStorage()->remove(thing->id().toString());
 
     if (m_list.isEmpty() && m_reconnectTimer) {
         hardwareManager()->pluginTimerManager()->unregisterTimer(m_reconnectTimer);
@@ -162,7 +187,7 @@ void IntegrationPluginFlowercare::onPluginTimer()
     foreach (FlowerCare *flowerCare, m_list) {
         if (--m_refreshMinutes[flowerCare] <= 0) {
             qCDebug(dcFlowerCare()) << "Refreshing" << flowerCare->btDevice()->address();
-            flowerCare->refreshData();
+            refresh(m_list.key(flowerCare));
         } else {
             qCDebug(dcFlowerCare()) << "Not refreshing" << flowerCare->btDevice()->address() << " Next refresh in" << m_refreshMinutes[flowerCare] << "minutes";
         }
@@ -187,5 +212,81 @@ void IntegrationPluginFlowercare::onSensorDataReceived(quint8 batteryLevel, doub
     thing->setStateValue(flowerCareMoistureStateTypeId, moisture);
     thing->setStateValue(flowerCareConductivityStateTypeId, fertility);
 
-    m_refreshMinutes[flowerCare] = thing->setting(flowerCareSettingsRefreshRateParamTypeId).toInt();
+    // Note: live data requested on demand does not move the history schedule
+    if (!thing->setting(flowerCareSettingsHistorySyncParamTypeId).toBool()) {
+        m_refreshMinutes[flowerCare] = refreshMinutes(thing);
+    }
+}
+
+void IntegrationPluginFlowercare::onHistoryReceived(quint8 batteryLevel, const QList<FlowerCare::HistoryRecord> &records, int recordCount)
+{
+    FlowerCare *flowerCare = static_cast<FlowerCare*>(sender());
+    Thing *thing = m_list.key(flowerCare);
+    thing->setStateValue(flowerCareConnectedStateTypeId, true);
+    thing->setStateValue(flowerCareBatteryLevelStateTypeId, batteryLevel);
+    thing->setStateValue(flowerCareBatteryCriticalStateTypeId, batteryLevel <= 10);
+
+    // Records are sorted by time. Each one is logged as event carrying its own timestamp
+    foreach (const FlowerCare::HistoryRecord &record, records) {
+        ParamList params;
+        params << Param(flowerCareHistoryRecordEventTimestampParamTypeId, record.timestamp.toSecsSinceEpoch());
+        params << Param(flowerCareHistoryRecordEventTemperatureParamTypeId, record.degreeCelsius);
+        params << Param(flowerCareHistoryRecordEventLightIntensityParamTypeId, record.lux);
+        params << Param(flowerCareHistoryRecordEventMoistureParamTypeId, record.moisture);
+        params << Param(flowerCareHistoryRecordEventConductivityParamTypeId, record.fertility);
+        emit emitEvent(Event(flowerCareHistoryRecordEventTypeId, thing->id(), params));
+    }
+
+    pluginStorage()->beginGroup(thing->id().toString());
+    pluginStorage()->setValue("historyRecordCount", recordCount);
+    if (!records.isEmpty()) {
+        const FlowerCare::HistoryRecord &latest = records.last();
+        thing->setStateValue(flowerCareTemperatureStateTypeId, latest.degreeCelsius);
+        thing->setStateValue(flowerCareLightIntensityStateTypeId, latest.lux);
+        thing->setStateValue(flowerCareMoistureStateTypeId, latest.moisture);
+        thing->setStateValue(flowerCareConductivityStateTypeId, latest.fertility);
+
+        pluginStorage()->setValue("lastHistoryRecord", latest.timestamp);
+    }
+    pluginStorage()->endGroup();
+
+    m_refreshMinutes[flowerCare] = refreshMinutes(thing);
+}
+
+void IntegrationPluginFlowercare::onFailed()
+{
+    FlowerCare *flowerCare = static_cast<FlowerCare*>(sender());
+    Thing *thing = m_list.key(flowerCare);
+    if (!thing) {
+        return;
+    }
+
+    // Note: the refresh counter stays expired, so the plugin timer retries on the next tick
+    qCDebug(dcFlowerCare()) << "Failed to read data from" << thing->name();
+    thing->setStateValue(flowerCareConnectedStateTypeId, false);
+}
+
+int IntegrationPluginFlowercare::refreshMinutes(Thing *thing) const
+{
+    if (thing->setting(flowerCareSettingsHistorySyncParamTypeId).toBool()) {
+        return thing->setting(flowerCareSettingsHistorySyncIntervalParamTypeId).toInt() * 60;
+    }
+    return thing->setting(flowerCareSettingsRefreshRateParamTypeId).toInt();
+}
+
+void IntegrationPluginFlowercare::refresh(Thing *thing)
+{
+    FlowerCare *flowerCare = m_list.value(thing);
+    if (!thing->setting(flowerCareSettingsHistorySyncParamTypeId).toBool()) {
+        flowerCare->refreshData();
+        return;
+    }
+
+    // Only the records added since the last download are read
+    pluginStorage()->beginGroup(thing->id().toString());
+    QDateTime lastRecord = pluginStorage()->value("lastHistoryRecord").toDateTime();
+    int recordCount = pluginStorage()->value("historyRecordCount", 0).toInt();
+    pluginStorage()->endGroup();
+
+    flowerCare->syncHistory(lastRecord, recordCount);
 }
@@ -37,8 +37,7 @@
 #include "integrations/integrationplugin.h"
 #include "plugintimer.h"
 #include "hardware/bluetoothlowenergy/bluetoothlowenergydevice.h"
-
-class FlowerCare;
+#include "flowercare.h"
 
 class IntegrationPluginFlowercare : public IntegrationPlugin
 {
@@ -54,9 +53,13 @@ public:
     void discoverThings(ThingDiscoveryInfo *info) override;
     void setupThing(ThingSetupInfo *info) override;
     void postSetupThing(Thing *thing) override;
+    void executeAction(ThingActionInfo *info) override;
     void thingRemoved(Thing *thing) override;
 
 private:
+    int refreshMinutes(Thing *thing) const;
+    void refresh(Thing *thing);
+
     PluginTimer *m_reconnectTimer = nullptr;
     QHash<Thing*, FlowerCare*> m_list;
     QHash<FlowerCare*, int> m_refreshMinutes;
@@ -64,6 +67,8 @@ private:
 private slots:
     void onPluginTimer();
     void onSensorDataReceived(quint8 batteryLevel, double degreeCelsius, double lux, double moisture, double fertility);
+    void onHistoryReceived(quint8 batteryLevel, const QList<FlowerCare::HistoryRecord> &records, int recordCount);
+    void onFailed();
 
 };
 
@@ -0,0 +1,203 @@
+#include <QCoreApplication>
+
+#include <QDebug>
+#include <QQueue>
+#include <QTcpSocket>
+#include <QElapsedTimer>
+
+// Load test client for the HTTP server of the HTTP commander
+// Usage: benchmark [host] [port] [connections] [requests] [pipeline]
+// Every connection is kept alive and keeps [pipeline] POST requests in flight until
+// [requests] requests have been answered in total. Connections closed by the server,
+// e.g. after its request limit per connection, are reopened.
+
+#define HOST "127.0.0.1"
+#define PORT 8080
+
+// State of one keep-alive connection, owned by the benchmark
+struct Connection {
+    QTcpSocket socket;
+    QByteArray buffer;
+    QQueue<qint64> sendTimes;
+    bool connected = false;
+    bool closing = false;
+    int answered = 0;
+};
+
+class Benchmark
+{
+public:
+    Benchmark(const QString &host, quint16 port, int connections, int requests, int pipeline) :
+        m_host(host),
+        m_port(port),
+        m_requests(requests),
+        m_pipeline(pipeline),
+        m_open(connections)
+    {
+        QByteArray body = "{\"benchmark\":true}";
+        m_request = "POST /benchmark HTTP/1.1\r\n"
+                    "Host: " + host.toLatin1() + "\r\n"
+                    "Content-Type: application/json\r\n"
+                    "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                    "\r\n" + body;
+
+        for (int i = 0; i < connections; i++) {
+            m_connections.append(new Connection());
+        }
+    }
+
+    ~Benchmark()
+    {
+        // Closing the sockets must not reconnect them
+        foreach (Connection *connection, m_connections) {
+            connection->socket.disconnect();
+        }
+        qDeleteAll(m_connections);
+    }
+
+    void start()
+    {
+        m_clock.start();
+        foreach (Connection *connection, m_connections) {
+            QTcpSocket *socket = &connection->socket;
+            QObject::connect(socket, &QTcpSocket::connected, socket, [this, connection]() { onConnected(connection); });
+            QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, connection]() { onReadyRead(connection); });
+            QObject::connect(socket, &QTcpSocket::disconnected, socket, [this, connection]() { onDisconnected(connection); });
+            QObject::connect(socket, static_cast<void (QTcpSocket::*)(QAbstractSocket::SocketError)>(&QTcpSocket::error), socket, [this, connection]() {
+                onError(connection);
+            });
+            socket->connectToHost(m_host, m_port);
+        }
+    }
+
+private:
+    QString m_host;
+    quint16 m_port;
+    int m_requests;
+    int m_pipeline;
+    QByteArray m_request;
+    QList<Connection *> m_connections;
+
+    QElapsedTimer m_clock;
+    int m_sent = 0;
+    int m_answered = 0;
+    int m_failed = 0;
+    qint64 m_latencySum = 0;
+    qint64 m_latencyMax = 0;
+    int m_open;
+    int m_reconnects = 0;
+
+    // Keeps the pipeline of the connection filled while requests are left
+    void fill(Connection *connection)
+    {
+        while (!connection->closing && connection->sendTimes.count() < m_pipeline && m_sent < m_requests) {
+            m_sent++;
+            connection->sendTimes.enqueue(m_clock.nsecsElapsed());
+            connection->socket.write(m_request);
+        }
+    }
+
+    void onConnected(Connection *connection)
+    {
+        connection->connected = true;
+        connection->closing = false;
+        connection->answered = 0;
+        fill(connection);
+    }
+
+    void onReadyRead(Connection *connection)
+    {
+        connection->buffer.append(connection->socket.readAll());
+        // The server answers with empty bodies, every header block is one response
+        int index;
+        while ((index = connection->buffer.indexOf("\r\n\r\n")) >= 0) {
+            QByteArray header = connection->buffer.left(index).toLower();
+            QByteArray status = connection->buffer.left(connection->buffer.indexOf("\r\n"));
+            connection->buffer.remove(0, index + 4);
+            if (status.startsWith("HTTP/1.1 100"))
+                continue;
+
+            if (connection->sendTimes.isEmpty()) {
+                qWarning() << "Unexpected response" << status;
+                continue;
+            }
+            qint64 latency = (m_clock.nsecsElapsed() - connection->sendTimes.dequeue()) / 1000;
+            m_latencySum += latency;
+            m_latencyMax = qMax(m_latencyMax, latency);
+            m_answered++;
+            connection->answered++;
+            // Requests pipelined behind this one will not be answered anymore
+            if (header.contains("\r\nconnection: close"))
+                connection->closing = true;
+
+            if (!status.startsWith("HTTP/1.1 200")) {
+                qWarning() << "Request failed:" << status;
+                m_failed++;
+            }
+        }
+        fill(connection);
+        if (connection->sendTimes.isEmpty() && m_sent >= m_requests) {
+            connection->socket.disconnectFromHost();
+        }
+    }
+
+    void onDisconnected(Connection *connection)
+    {
+        connection->connected = false;
+        connection->buffer.clear();
+        // Requests still in flight were not answered, send them again on a new connection
+        m_sent -= connection->sendTimes.count();
+        connection->sendTimes.clear();
+        if (m_sent < m_requests && connection->answered > 0) {
+            m_reconnects++;
+            connection->socket.connectToHost(m_host, m_port);
+            return;
+        }
+        closeConnection();
+    }
+
+    void onError(Connection *connection)
+    {
+        qWarning() << "Connection error:" << connection->socket.errorString();
+        // Established connections are handled once disconnected
+        if (!connection->connected) {
+            closeConnection();
+        }
+    }
+
+    void closeConnection()
+    {
+        m_open--;
+        if (m_open > 0)
+            return;
+
+        qint64 elapsed = qMax<qint64>(m_clock.elapsed(), 1);
+        qDebug() << "Answered" << m_answered << "requests in" << elapsed << "ms," << m_failed << "failed," << m_reconnects << "reconnects";
+        qDebug() << "Throughput" << (m_answered * 1000.0 / elapsed) << "requests/s";
+        if (m_answered > 0) {
+            qDebug() << "Latency average" << (m_latencySum / 1000.0 / m_answered) << "ms, max" << (m_latencyMax / 1000.0) << "ms";
+        }
+        QCoreApplication::exit(m_failed > 0 || m_answered < m_requests ? 1 : 0);
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QString host = argc > 1 ? QString(argv[1]) : QString(HOST);
+    quint16 port = argc > 2 ? static_cast<quint16>(QString(argv[2]).toUInt()) : PORT;
+    int connections = argc > 3 ? QString(argv[3]).toInt() : 8;
+    int requests = argc > 4 ? QString(argv[4]).toInt() : 10000;
+    int pipeline = argc > 5 ? QString(argv[5]).toInt() : 4;
+    if (connections <= 0 || requests <= 0 || pipeline <= 0) {
+        qWarning() << "Usage: benchmark [host] [port] [connections] [requests] [pipeline]";
+        return 1;
+    }
+
+    qDebug() << "Sending" << requests << "requests to" << host << port << "over" << connections << "connections, pipeline depth" << pipeline;
+
+    Benchmark benchmark(host, port, connections, requests, pipeline);
+    benchmark.start();
+    return app.exec();
+}
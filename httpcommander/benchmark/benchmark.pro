@@ -0,0 +1,5 @@
+CONFIG += c++11
+
+QT += network
+
+SOURCES += benchmark.cpp
@@ -37,12 +37,16 @@
 #include <QDebug>
 #include <QDateTime>
 #include <QUrlQuery>
-#include <QRegExp>
-#include <QStringList>
+#include <QLocale>
 
 HttpSimpleServer::HttpSimpleServer(quint16 port, QObject *parent):
     QTcpServer(parent)
 {
+    m_idleTimer = new QTimer(this);
+    m_idleTimer->setInterval(10000);
+    connect(m_idleTimer, &QTimer::timeout, this, &HttpSimpleServer::onIdleTimeout);
+    m_idleTimer->start();
+
     listen(QHostAddress::Any, port);
 }
 
@@ -54,58 +58,122 @@ HttpSimpleServer::~HttpSimpleServer()
 void HttpSimpleServer::incomingConnection(qintptr socket)
 {
     // When a new client connects, the server constructs a QTcpSocket and all
-    // communication with the client is done over this QTcpSocket. QTcpSocket
-    // works asynchronously, this means that all the communication is done
-    // in the two slots readClient() and discardClient().
+    // communication with the client is done over this QTcpSocket. The
+    // connection stays open for further requests until the client closes it
+    // or it is idle for longer than the keep-alive timeout.
     QTcpSocket* tcpSocket = new QTcpSocket(this);
-    connect(tcpSocket, SIGNAL(readyRead()), this, SLOT(readClient()));
-    connect(tcpSocket, SIGNAL(disconnected()), this, SLOT(discardClient()));
+    connect(tcpSocket, &QTcpSocket::readyRead, this, &HttpSimpleServer::readClient);
+    // Queued, the parser may still hold the client state when a response closes the socket
+    connect(tcpSocket, &QTcpSocket::disconnected, this, &HttpSimpleServer::discardClient, Qt::QueuedConnection);
     tcpSocket->setSocketDescriptor(socket);
 
+    Client client;
+    client.parser = HttpRequestParser(m_maxHeaderSize, m_maxBodySize);
+    client.lastActivity = QDateTime::currentDateTimeUtc();
+    m_clients.insert(tcpSocket, client);
 }
 
 void HttpSimpleServer::readClient()
 {
-    // This slot is called when the client sent data to the server. The
-    // server looks if it was a get request and sends a very simple HTML
-    // document back.
     QTcpSocket* tcpSocket = static_cast<QTcpSocket*>(sender());
-    if (tcpSocket->canReadLine()) {
+    if (!m_clients.contains(tcpSocket))
+        return;
 
-        QByteArray data = tcpSocket->readAll();
-        QStringList tokens = QString(data).split(QRegExp("[ \r\n][ \r\n]*"));
-        qCDebug(dcHttpCommander()) << "Http Request, type" << tokens[0] << "path" << tokens[1] << "body" << tokens.last();
+    Client &client = m_clients[tcpSocket];
+    if (client.closing) {
+        tcpSocket->readAll();
+        return;
+    }
 
-        if ((tokens[0] == "GET")      ||
-                (tokens[0] == "PUT")  ||
-                (tokens[0] == "POST") ||
-                (tokens[0] == "DELETE")) {
+    // Drop clients which keep pipelining without reading their responses
+    if (tcpSocket->bytesToWrite() > m_maxPendingOutput) {
+        qCWarning(dcHttpCommander()) << "Closing connection from" << tcpSocket->peerAddress().toString() << "which doesn't read its responses";
+        client.closing = true;
+        tcpSocket->abort();
+        return;
+    }
 
-            QTextStream os(tcpSocket);
-            os.setAutoDetectUnicode(true);
-            os << generateHeader();
-            tcpSocket->close();
+    client.parser.addData(tcpSocket->readAll());
+    client.lastActivity = QDateTime::currentDateTimeUtc();
 
-            if (tcpSocket->state() == QTcpSocket::UnconnectedState)
-                delete tcpSocket;
+    // A segment may contain a partial request or several pipelined ones
+    HttpRequestParser::Request request;
+    while (!client.closing && client.parser.takeRequest(&request)) {
+        finishRequest(tcpSocket, client, request);
+    }
+    if (client.closing)
+        return;
 
-            emit requestReceived(tokens[0], tokens[1], tokens.last());
-        }
+    if (client.parser.error() != HttpRequestParser::ErrorNone) {
+        rejectRequest(tcpSocket, client, client.parser.errorStatus());
+        return;
+    }
+
+    // Clients like curl wait for this before sending larger bodies
+    if (client.parser.takeContinueRequest()) {
+        tcpSocket->write("HTTP/1.1 100 Continue\r\n\r\n");
     }
 }
 
 void HttpSimpleServer::discardClient()
 {
     QTcpSocket* socket = static_cast<QTcpSocket*>(sender());
+    m_clients.remove(socket);
     socket->deleteLater();
 }
 
-QString HttpSimpleServer::generateHeader()
+void HttpSimpleServer::onIdleTimeout()
+{
+    QDateTime now = QDateTime::currentDateTimeUtc();
+    foreach (QTcpSocket *socket, m_clients.keys()) {
+        if (m_clients.value(socket).lastActivity.secsTo(now) > m_idleTimeout) {
+            socket->disconnectFromHost();
+        }
+    }
+}
+
+void HttpSimpleServer::finishRequest(QTcpSocket *socket, Client &client, const HttpRequestParser::Request &request)
+{
+    bool keepAlive = request.keepAlive();
+    client.requestCount++;
+    if (client.requestCount >= m_maxRequestsPerConnection)
+        keepAlive = false;
+
+    qCDebug(dcHttpCommander()) << "Http Request, type" << request.method << "path" << request.path << "body" << request.body;
+    if (request.method != "GET" && request.method != "PUT" && request.method != "POST" && request.method != "DELETE") {
+        sendResponse(socket, client, "405 Method Not Allowed", keepAlive);
+        return;
+    }
+
+    // Responses are written in request order, which keeps pipelined requests in sync
+    sendResponse(socket, client, "200 OK", keepAlive);
+    emit requestReceived(QString::fromUtf8(request.method), QString::fromUtf8(request.path), QString::fromUtf8(request.body));
+}
+
+void HttpSimpleServer::sendResponse(QTcpSocket *socket, Client &client, const QByteArray &status, bool keepAlive)
+{
+    QByteArray response = "HTTP/1.1 " + status + "\r\n";
+    response.append("Content-Type: text/html; charset=\"utf-8\"\r\n");
+    response.append("Content-Length: 0\r\n");
+    response.append("Date: " + QLocale::c().toString(QDateTime::currentDateTimeUtc(), "ddd, dd MMM yyyy hh:mm:ss").toLatin1() + " GMT\r\n");
+    if (keepAlive) {
+        response.append("Connection: keep-alive\r\n");
+        response.append("Keep-Alive: timeout=" + QByteArray::number(m_idleTimeout) + "\r\n");
+    } else {
+        response.append("Connection: close\r\n");
+    }
+    response.append("\r\n");
+    socket->write(response);
+
+    if (!keepAlive) {
+        client.closing = true;
+        client.parser.clear();
+        socket->disconnectFromHost();
+    }
+}
+
+void HttpSimpleServer::rejectRequest(QTcpSocket *socket, Client &client, const QByteArray &status)
 {
-    QString contentHeader(
-                "HTTP/1.0 200 Ok\r\n"
-                "Content-Type: text/html; charset=\"utf-8\"\r\n"
-                "\r\n"
-                );
-    return contentHeader;
+    qCWarning(dcHttpCommander()) << "Rejecting request:" << status;
+    sendResponse(socket, client, status, false);
 }
@@ -32,11 +32,15 @@
 #define HTTPSIMPLESERVER1_H
 
 #include "typeutils.h"
+#include "httprequestparser.h"
 
 #include <QTcpServer>
+#include <QTcpSocket>
 #include <QUuid>
 #include <QDateTime>
 #include <QUrl>
+#include <QHash>
+#include <QTimer>
 
 class Device;
 class DevicePlugin;
@@ -60,9 +64,29 @@ signals:
 private slots:
     void readClient();
     void discardClient();
+    void onIdleTimeout();
 
 private:
-    QString generateHeader();
+    // Request parser and keep-alive state of one connection, requests are handled in order
+    struct Client {
+        HttpRequestParser parser;
+        QDateTime lastActivity;
+        int requestCount = 0;
+        bool closing = false;
+    };
+
+    QHash<QTcpSocket *, Client> m_clients;
+    QTimer *m_idleTimer = nullptr;
+
+    int m_idleTimeout = 30;
+    int m_maxRequestsPerConnection = 1000;
+    int m_maxHeaderSize = 16384;
+    int m_maxBodySize = 1048576;
+    int m_maxPendingOutput = 262144;
+
+    void finishRequest(QTcpSocket *socket, Client &client, const HttpRequestParser::Request &request);
+    void sendResponse(QTcpSocket *socket, Client &client, const QByteArray &status, bool keepAlive);
+    void rejectRequest(QTcpSocket *socket, Client &client, const QByteArray &status);
 
 };
 
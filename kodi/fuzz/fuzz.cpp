@@ -0,0 +1,281 @@
+#include <QCoreApplication>
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+
+#include <random>
+
+#include "kodijsonframer.h"
+
+// Fuzzes the JSON framer of the Kodi connection and benchmarks it against parsing the whole
+// receive buffer on every read, which the connection did before.
+// Usage: fuzz [iterations] [seed]
+
+static std::mt19937 generator;
+static int failures = 0;
+
+static int randomInt(int min, int max)
+{
+    return std::uniform_int_distribution<int>(min, max)(generator);
+}
+
+static void check(bool condition, const QString &what)
+{
+    if (!condition) {
+        qWarning() << "FAILED:" << what;
+        failures++;
+    }
+}
+
+static QString randomString()
+{
+    // Characters which confuse a naive framer, the serializer escapes quotes, backslashes and control characters
+    static const QString characters = QString::fromUtf8("ab{}[]\"\\:,/ \n\t\u00e4\u20ac");
+    QString string;
+    int length = randomInt(0, 12);
+    for (int i = 0; i < length; i++) {
+        string.append(characters.at(randomInt(0, characters.length() - 1)));
+    }
+    return string;
+}
+
+static QVariant randomValue(int depth)
+{
+    int type = randomInt(0, depth > 4 ? 3 : 5);
+    switch (type) {
+    case 0:
+        return randomString();
+    case 1:
+        return randomInt(-100000, 100000);
+    case 2:
+        return randomInt(0, 1) == 1;
+    case 3:
+        return QVariant();
+    case 4: {
+        QVariantList list;
+        int count = randomInt(0, 4);
+        for (int i = 0; i < count; i++) {
+            list.append(randomValue(depth + 1));
+        }
+        return list;
+    }
+    default: {
+        QVariantMap map;
+        int count = randomInt(0, 4);
+        for (int i = 0; i < count; i++) {
+            map.insert(randomString(), randomValue(depth + 1));
+        }
+        return map;
+    }
+    }
+}
+
+static QByteArray randomDocument()
+{
+    QVariant value = randomValue(0);
+    if (value.type() != QVariant::Map && value.type() != QVariant::List) {
+        value = QVariantList() << value;
+    }
+
+    QJsonDocument document = QJsonDocument::fromVariant(value);
+    return document.toJson(randomInt(0, 1) == 1 ? QJsonDocument::Compact : QJsonDocument::Indented).trimmed();
+}
+
+static QList<QByteArray> randomChunks(const QByteArray &stream)
+{
+    QList<QByteArray> chunks;
+    int position = 0;
+    while (position < stream.size()) {
+        int size = randomInt(0, 3) == 0 ? 1 : randomInt(1, 64);
+        chunks.append(stream.mid(position, size));
+        position += size;
+    }
+    return chunks;
+}
+
+// Frames the complete stream at once, without carrying any state across reads
+static QList<QByteArray> referenceFrames(const QByteArray &stream)
+{
+    QList<QByteArray> frames;
+    int depth = 0;
+    bool inString = false;
+    bool escaped = false;
+    int start = -1;
+    for (int i = 0; i < stream.size(); i++) {
+        char c = stream.at(i);
+        if (depth == 0) {
+            if (c == '{' || c == '[') {
+                depth = 1;
+                start = i;
+            }
+        } else if (inString) {
+            if (escaped) {
+                escaped = false;
+            } else if (c == '\\') {
+                escaped = true;
+            } else if (c == '"') {
+                inString = false;
+            }
+        } else if (c == '"') {
+            inString = true;
+        } else if (c == '{' || c == '[') {
+            depth++;
+        } else if ((c == '}' || c == ']') && --depth == 0) {
+            frames.append(stream.mid(start, i + 1 - start));
+        }
+    }
+    return frames;
+}
+
+static QList<QByteArray> feed(KodiJsonFramer *framer, const QList<QByteArray> &chunks)
+{
+    QList<QByteArray> frames;
+    foreach (const QByteArray &chunk, chunks) {
+        frames.append(framer->addData(chunk));
+    }
+    return frames;
+}
+
+static void fuzzDocuments(int iterations)
+{
+    // Valid messages with noise in between must come out unchanged, no matter how the stream is split
+    static const QList<QByteArray> separators = {"", "\n", "\r\n", " ", "noise without brackets"};
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        QList<QByteArray> documents;
+        QByteArray stream;
+        int count = randomInt(1, 5);
+        for (int i = 0; i < count; i++) {
+            documents.append(randomDocument());
+            stream.append(documents.last());
+            stream.append(separators.at(randomInt(0, separators.count() - 1)));
+        }
+
+        KodiJsonFramer framer;
+        QList<QByteArray> frames = feed(&framer, randomChunks(stream));
+        check(frames == documents, QString("documents %1: got %2 frames for %3 documents").arg(iteration).arg(frames.count()).arg(documents.count()));
+        check(framer.bufferSize() == 0, QString("documents %1: %2 bytes left in the buffer").arg(iteration).arg(framer.bufferSize()));
+        foreach (const QByteArray &frame, frames) {
+            QJsonParseError error;
+            QJsonDocument::fromJson(frame, &error);
+            check(error.error == QJsonParseError::NoError, QString("documents %1: frame does not parse: %2").arg(iteration).arg(error.errorString()));
+        }
+    }
+}
+
+static void fuzzBytes(int iterations)
+{
+    // Arbitrary input must frame exactly like the one shot reference, regardless of the split
+    static const QByteArray alphabet = "{}[]\"\\ a:,";
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        QByteArray stream;
+        int length = randomInt(0, 512);
+        for (int i = 0; i < length; i++) {
+            stream.append(randomInt(0, 3) == 0 ? static_cast<char>(randomInt(0, 255)) : alphabet.at(randomInt(0, alphabet.size() - 1)));
+        }
+
+        KodiJsonFramer framer;
+        QList<QByteArray> frames = feed(&framer, randomChunks(stream));
+        check(frames == referenceFrames(stream), QString("bytes %1: frames differ from the reference").arg(iteration));
+
+        int framedSize = 0;
+        foreach (const QByteArray &frame, frames) {
+            framedSize += frame.size();
+        }
+        check(framer.bufferSize() <= stream.size() - framedSize, QString("bytes %1: buffer holds more than the unframed data").arg(iteration));
+    }
+}
+
+// The connection appended every read and tried to parse the whole buffer once it ended with a brace
+static int benchmarkParseAttempts(const QList<QByteArray> &chunks)
+{
+    int messages = 0;
+    QByteArray buffer;
+    foreach (const QByteArray &chunk, chunks) {
+        buffer.append(chunk);
+        if (!buffer.endsWith('}')) {
+            continue;
+        }
+        QJsonParseError error;
+        QJsonDocument::fromJson(buffer, &error);
+        if (error.error == QJsonParseError::NoError) {
+            buffer.clear();
+            messages++;
+        }
+    }
+    return messages;
+}
+
+static int benchmarkFramer(const QList<QByteArray> &chunks)
+{
+    int messages = 0;
+    KodiJsonFramer framer;
+    foreach (const QByteArray &chunk, chunks) {
+        messages += framer.addData(chunk).count();
+    }
+    return messages;
+}
+
+static void benchmark()
+{
+    // A large library listing like VideoLibrary.GetMovies returns, received in TCP segments
+    QVariantList movies;
+    for (int i = 0; i < 5000; i++) {
+        QVariantMap movie;
+        movie.insert("movieid", i);
+        movie.insert("label", QString("Movie {%1} \"title\"").arg(i));
+        movie.insert("thumbnail", QString("image://movies/%1.jpg/").arg(i));
+        movies.append(movie);
+    }
+    QVariantMap result;
+    result.insert("movies", movies);
+    QVariantMap message;
+    message.insert("id", 1);
+    message.insert("jsonrpc", "2.0");
+    message.insert("result", result);
+    QByteArray stream = QJsonDocument::fromVariant(message).toJson(QJsonDocument::Compact);
+
+    QList<QByteArray> chunks;
+    for (int i = 0; i < stream.size(); i += 1460) {
+        chunks.append(stream.mid(i, 1460));
+    }
+    qInfo() << "Message size" << stream.size() << "bytes in" << chunks.count() << "reads";
+
+    QElapsedTimer timer;
+    timer.start();
+    int messages = benchmarkParseAttempts(chunks);
+    qint64 parseTime = timer.nsecsElapsed();
+    check(messages == 1, "parse attempts did not find the message");
+    qInfo() << "Parse attempts on every read:" << parseTime / 1000 << "us";
+
+    const int rounds = 100;
+    timer.restart();
+    for (int i = 0; i < rounds; i++) {
+        messages = benchmarkFramer(chunks);
+    }
+    qint64 framerTime = timer.nsecsElapsed() / rounds;
+    check(messages == 1, "framer did not find the message");
+    qInfo() << "Framer:" << framerTime / 1000 << "us," << (stream.size() * 1000.0 / qMax<qint64>(framerTime, 1)) << "MB/s";
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+
+    int iterations = argc > 1 ? qMax(1, QByteArray(argv[1]).toInt()) : 10000;
+    unsigned int seed = argc > 2 ? QByteArray(argv[2]).toUInt() : std::random_device()();
+    generator.seed(seed);
+    qInfo() << "Fuzzing with" << iterations << "iterations, seed" << seed;
+
+    fuzzDocuments(iterations);
+    fuzzBytes(iterations);
+    benchmark();
+
+    if (failures > 0) {
+        qWarning() << failures << "checks failed";
+        return 1;
+    }
+
+    qInfo() << "All checks passed";
+    return 0;
+}
@@ -0,0 +1,8 @@
+CONFIG += c++11
+
+INCLUDEPATH += ..
+
+SOURCES += fuzz.cpp \
+    ../kodijsonframer.cpp
+
+HEADERS += ../kodijsonframer.h
@@ -47,6 +47,17 @@ Kodi::Kodi(const QHostAddress &hostAddress, int port, int httpPort, QObject *par
     connect(m_jsonHandler, &KodiJsonHandler::notificationReceived, this, &Kodi::processNotification);
     connect(m_jsonHandler, &KodiJsonHandler::replyReceived, this, &Kodi::processResponse);
 
+    m_refreshTimeout.setInterval(10000);
+    m_refreshTimeout.setSingleShot(true);
+    connect(&m_refreshTimeout, &QTimer::timeout, this, [this](){
+        qCWarning(dcKodi()) << "Refresh timed out, missing replies:" << m_refreshRequestIds;
+        m_refreshRequestIds.clear();
+        m_refreshInProgress = false;
+        if (m_refreshQueued) {
+            m_refreshQueued = false;
+            update();
+        }
+    });
 
     // Init FS
     m_virtualFs = new VirtualFsNode(BrowserItem());
@@ -285,6 +296,13 @@ int Kodi::systemCommand(const QString &command)
 
 void Kodi::update()
 {
+    // Notifications often arrive in bursts, run one more refresh after the current one instead of many
+    if (m_refreshInProgress) {
+        m_refreshQueued = true;
+        return;
+    }
+    m_refreshInProgress = true;
+
     QVariantMap params;
     QVariantList properties;
     properties.append("volume");
@@ -293,10 +311,11 @@ void Kodi::update()
     properties.append("version");
     params.insert("properties", properties);
 
-    m_jsonHandler->sendData("Application.GetProperties", params);
-
-    params.clear();
-    m_jsonHandler->sendData("Player.GetActivePlayers", params);
+    QList<KodiReply> requests;
+    requests.append(KodiReply("Application.GetProperties", params));
+    requests.append(KodiReply("Player.GetActivePlayers", QVariantMap()));
+    m_refreshRequestIds.append(m_jsonHandler->sendBatch(requests));
+    m_refreshTimeout.start();
 }
 
 void Kodi::checkVersion()
@@ -547,6 +566,11 @@ int Kodi::executeBrowserItemAction(const QString &itemId, const ActionTypeId &ac
 
 void Kodi::onConnectionStatusChanged()
 {
+    m_refreshInProgress = false;
+    m_refreshQueued = false;
+    m_refreshRequestIds.clear();
+    m_refreshTimeout.stop();
+
     if (m_connection->connected()) {
         checkVersion();
     } else {
@@ -587,7 +611,7 @@ void Kodi::activePlayersChanged(const QVariantList &data)
     qCDebug(dcKodi) << "Active Player changed:" << m_activePlayer << data.first().toMap().value("type").toString();
     emit activePlayerChanged(data.first().toMap().value("type").toString());
 
-    updateMetadata();
+    updatePlayerProperties();
 }
 
 void Kodi::playerPropertiesReceived(const QVariantMap &properties)
@@ -643,9 +667,8 @@ void Kodi::mediaMetaDataReceived(const QVariantMap &data)
 
 void Kodi::onPlaybackStatusChanged(const QString &playbackState)
 {
-    if (playbackState != "Stopped") {
-        updateMetadata();
-    } else {
+    // The metadata of a running player is fetched together with the player properties
+    if (playbackState == "Stopped") {
         emit mediaMetadataChanged(QString(), QString(), QString(), QString());
     }
     emit playbackStatusChanged(playbackState);
@@ -671,6 +694,23 @@ void Kodi::processNotification(const QString &method, const QVariantMap &params)
 }
 
 void Kodi::processResponse(int id, const QString &method, const QVariantMap &response)
+{
+    bool refreshReply = m_refreshRequestIds.removeOne(id);
+
+    handleResponse(id, method, response);
+
+    // Follow up requests of the refresh have been added to the list by now
+    if (refreshReply && m_refreshRequestIds.isEmpty()) {
+        m_refreshTimeout.stop();
+        m_refreshInProgress = false;
+        if (m_refreshQueued) {
+            m_refreshQueued = false;
+            update();
+        }
+    }
+}
+
+void Kodi::handleResponse(int id, const QString &method, const QVariantMap &response)
 {
 
     qCDebug(dcKodi) << "response received:" << method << response;
@@ -708,14 +748,12 @@ void Kodi::processResponse(int id, const QString &method, const QVariantMap &res
     if (method == "Player.GetActivePlayers") {
         qCDebug(dcKodi) << "Active players changed" << response;
         activePlayersChanged(response.value("result").toList());
-        updatePlayerProperties();
         return;
     }
 
     if (method == "Player.GetProperties") {
         qCDebug(dcKodi) << "Player properties received" << response;
         playerPropertiesReceived(response.value("result").toMap());
-        updateMetadata();
         return;
     }
 
@@ -1012,17 +1050,23 @@ void Kodi::updatePlayerProperties()
     QVariantList properties;
     properties << "speed" << "shuffled" << "repeat";
     params.insert("properties", properties);
-    m_jsonHandler->sendData("Player.GetProperties", params);
-}
 
-void Kodi::updateMetadata()
-{
-    QVariantMap params;
-    params.insert("playerid", m_activePlayer);
+    QVariantMap itemParams;
+    itemParams.insert("playerid", m_activePlayer);
     QVariantList fields;
     fields << "title" << "artist" << "album" << "director" << "thumbnail" << "showtitle" << "fanart" << "channel" << "year";
-    params.insert("properties", fields);
-    m_jsonHandler->sendData("Player.GetItem", params);
+    itemParams.insert("properties", fields);
+
+    QList<KodiReply> requests;
+    requests.append(KodiReply("Player.GetProperties", params));
+    requests.append(KodiReply("Player.GetItem", itemParams));
+    QList<int> ids = m_jsonHandler->sendBatch(requests);
+
+    // Part of the second round trip if a refresh is running
+    if (m_refreshInProgress) {
+        m_refreshRequestIds.append(ids);
+        m_refreshTimeout.start();
+    }
 }
 
 QString Kodi::prepareThumbnail(const QString &thumbnail)
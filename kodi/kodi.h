@@ -32,6 +32,7 @@
 #define KODI_H
 
 #include <QObject>
+#include <QTimer>
 #include <QHostAddress>
 
 #include "kodiconnection.h"
@@ -108,10 +109,10 @@ private slots:
     void processResponse(int id, const QString &method, const QVariantMap &response);
 
     void updatePlayerProperties();
-    void updateMetadata();
 
 private:
     QString prepareThumbnail(const QString &thumbnail);
+    void handleResponse(int id, const QString &method, const QVariantMap &response);
 
 private:
     KodiConnection *m_connection;
@@ -122,6 +123,14 @@ private:
     int m_activePlayerCount = 0; // if it's > 0, there is something playing (either music or video or slideshow)
     int m_activePlayer = -1;
 
+    // A refresh is Application.GetProperties + Player.GetActivePlayers, followed by
+    // Player.GetProperties + Player.GetItem if a player is active, two batches at most.
+    bool m_refreshInProgress = false;
+    bool m_refreshQueued = false;
+    QList<int> m_refreshRequestIds;
+    // A lost reply must not block all following refreshes
+    QTimer m_refreshTimeout;
+
     class VirtualFsNode {
     public:
         VirtualFsNode(const BrowserItem &item):item(item) {}
@@ -7,6 +7,7 @@ TARGET = $$qtLibraryTarget(nymea_integrationpluginkodi)
 SOURCES += \
     integrationpluginkodi.cpp \
     kodiconnection.cpp \
+    kodijsonframer.cpp \
     kodijsonhandler.cpp \
     kodi.cpp \
     kodireply.cpp
@@ -14,6 +15,7 @@ SOURCES += \
 HEADERS += \
     integrationpluginkodi.h \
     kodiconnection.h \
+    kodijsonframer.h \
     kodijsonhandler.h \
     kodi.h \
     kodireply.h
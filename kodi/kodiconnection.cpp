@@ -87,6 +87,7 @@ void KodiConnection::onDisconnected()
 {
     qCDebug(dcKodi) << "disconnected from" << hostAddress().toString() << port();
     m_connected = false;
+    m_framer.clear();
     emit connectionStatusChanged();
 }
 
@@ -99,21 +100,15 @@ void KodiConnection::onError(QAbstractSocket::SocketError socketError)
 
 void KodiConnection::readData()
 {
-    QByteArray data = m_socket->readAll();
-
-    QStringList commandList = QString(data).split("}{");
-    for(int i = 0; i < commandList.count(); ++i) {
-        QString command = commandList.at(i);
-        if(command.isEmpty()) {
-            continue;
-        }
-        if(i < commandList.count() - 1) {
-            command.append("}");
-        }
-        if(i > 0) {
-            command.prepend("{");
-        }
-        emit dataReady(command.toUtf8());
+    QList<QByteArray> frames = m_framer.addData(m_socket->readAll());
+
+    if (m_framer.bufferSize() > m_maxReceiveBufferSize) {
+        qCWarning(dcKodi) << "receive buffer exceeded" << m_maxReceiveBufferSize << "bytes without a complete message, discarding data";
+        m_framer.clear();
+    }
+
+    foreach (const QByteArray &frame, frames) {
+        emit dataReady(frame);
     }
 }
 
@@ -36,6 +36,8 @@
 #include <QHostAddress>
 #include <QJsonDocument>
 
+#include "kodijsonframer.h"
+
 class KodiConnection : public QObject
 {
     Q_OBJECT
@@ -58,6 +60,9 @@ private:
     int m_port;
     bool m_connected;
 
+    KodiJsonFramer m_framer;
+    int m_maxReceiveBufferSize = 16 * 1024 * 1024;
+
 private slots:
     void onConnected();
     void onDisconnected();
@@ -0,0 +1,95 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "kodijsonframer.h"
+
+QList<QByteArray> KodiJsonFramer::addData(const QByteArray &data)
+{
+    m_buffer.append(data);
+
+    // Scan only the bytes added since the last call
+    QList<QByteArray> frames;
+    const char *buffer = m_buffer.constData();
+    int size = m_buffer.size();
+    int consumed = 0;
+    for (int i = m_scanPosition; i < size; i++) {
+        char c = buffer[i];
+        if (m_depth == 0) {
+            // Outside of a frame, skip anything that doesn't open an object or a batch array
+            if (c == '{' || c == '[') {
+                m_depth = 1;
+            } else {
+                consumed = i + 1;
+            }
+            continue;
+        }
+
+        if (m_inString) {
+            if (m_escaped) {
+                m_escaped = false;
+            } else if (c == '\\') {
+                m_escaped = true;
+            } else if (c == '"') {
+                m_inString = false;
+            }
+            continue;
+        }
+
+        if (c == '"') {
+            m_inString = true;
+        } else if (c == '{' || c == '[') {
+            m_depth++;
+        } else if (c == '}' || c == ']') {
+            m_depth--;
+            if (m_depth == 0) {
+                frames.append(QByteArray(buffer + consumed, i + 1 - consumed));
+                consumed = i + 1;
+            }
+        }
+    }
+
+    m_buffer.remove(0, consumed);
+    m_scanPosition = m_buffer.size();
+    return frames;
+}
+
+void KodiJsonFramer::clear()
+{
+    m_buffer.clear();
+    m_scanPosition = 0;
+    m_depth = 0;
+    m_inString = false;
+    m_escaped = false;
+}
+
+int KodiJsonFramer::bufferSize() const
+{
+    return m_buffer.size();
+}
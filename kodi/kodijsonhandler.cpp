@@ -39,9 +39,42 @@ KodiJsonHandler::KodiJsonHandler(KodiConnection *connection, QObject *parent) :
     m_id(0)
 {
     connect(m_connection, &KodiConnection::dataReady, this, &KodiJsonHandler::processResponse);
+
+    // Batches sent before a disconnect will never be answered
+    connect(m_connection, &KodiConnection::connectionStatusChanged, this, [this](){
+        if (!m_connection->connected()) {
+            m_pendingBatches.clear();
+        }
+    });
 }
 
 int KodiJsonHandler::sendData(const QString &method, const QVariantMap &params)
+{
+    QJsonDocument jsonDoc = QJsonDocument::fromVariant(createPackage(method, params));
+    m_connection->sendData(jsonDoc.toJson());
+    //qCDebug(dcKodi) << "sending data" << jsonDoc.toJson();
+    return m_id;
+}
+
+QList<int> KodiJsonHandler::sendBatch(const QList<KodiReply> &requests)
+{
+    // JSON-RPC 2.0 batch: Kodi answers with an array, every element carries the id of its request
+    QList<int> ids;
+    QVariantList batch;
+    foreach (const KodiReply &request, requests) {
+        batch.append(createPackage(request.method(), request.params()));
+        ids.append(m_id);
+    }
+
+    m_pendingBatches.append(ids);
+
+    QJsonDocument jsonDoc = QJsonDocument::fromVariant(batch);
+    m_connection->sendData(jsonDoc.toJson(QJsonDocument::Compact));
+    //qCDebug(dcKodi) << "sending batch" << jsonDoc.toJson();
+    return ids;
+}
+
+QVariantMap KodiJsonHandler::createPackage(const QString &method, const QVariantMap &params)
 {
     m_id++;
 
@@ -52,45 +85,88 @@ int KodiJsonHandler::sendData(const QString &method, const QVariantMap &params)
     package.insert("jsonrpc", "2.0");
 
     m_replys.insert(m_id, KodiReply(method, params));
-
-    QJsonDocument jsonDoc = QJsonDocument::fromVariant(package);
-    m_connection->sendData(jsonDoc.toJson());
-    //qCDebug(dcKodi) << "sending data" << jsonDoc.toJson();
-    return m_id;
+    return package;
 }
 
 void KodiJsonHandler::processResponse(const QByteArray &data)
 {
-    m_dataBuffer.append(data);
-
-    QByteArray packet = m_dataBuffer;
-    int pos = packet.indexOf("}{");
-    if (pos > 0) {
-        packet = m_dataBuffer.left(pos + 1);
-    }
-
-    if (!packet.endsWith("}")) {
-        return; // Won't parse for sure, likely not enough data yet
-    }
-
+    // The connection hands out complete JSON texts only
     QJsonParseError error;
-    QJsonDocument jsonDoc = QJsonDocument::fromJson(packet, &error);
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
 
     if(error.error != QJsonParseError::NoError) {
         qCWarning(dcKodi) << "failed to parse JSON data:" << data << ":" << error.errorString();
         return;
     }
 
-    // Ok, we managed to parse a complete packet, remove it from the input buffer
-    m_dataBuffer.remove(0, packet.length());
-
     //qCDebug(dcKodi) << "data received:" << jsonDoc.toJson();
 
+    if (jsonDoc.isArray()) {
+        processBatchResponse(jsonDoc.toVariant().toList());
+        return;
+    }
+
     QVariantMap message = jsonDoc.toVariant().toMap();
+    if (hasNullId(message)) {
+        // Kodi could not read a request at all. Our single requests are always valid, so this
+        // is the error for a whole batch. Batches are answered in order, it belongs to the oldest one.
+        if (m_pendingBatches.isEmpty()) {
+            qCWarning(dcKodi) << "error response without request id:" << message;
+            return;
+        }
+        qCWarning(dcKodi) << "batch request failed:" << message.value("error").toMap().value("message").toString();
+        failRequests(m_pendingBatches.takeFirst(), message);
+        return;
+    }
+
+    processMessage(message);
+}
+
+void KodiJsonHandler::processBatchResponse(const QVariantList &messages)
+{
+    QList<int> answeredIds;
+    QVariantMap errorMessage;
+    foreach (const QVariant &messageVariant, messages) {
+        QVariantMap message = messageVariant.toMap();
+        if (hasNullId(message)) {
+            errorMessage = message;
+            continue;
+        }
+        if (message.contains("id")) {
+            answeredIds.append(message.value("id").toInt());
+        }
+        processMessage(message);
+    }
+
+    if (m_pendingBatches.isEmpty()) {
+        return;
+    }
+
+    // Find the batch by the answered ids, if none has been answered it is the oldest one
+    int batchIndex = 0;
+    for (int i = 0; i < m_pendingBatches.count() && !answeredIds.isEmpty(); i++) {
+        if (m_pendingBatches.at(i).contains(answeredIds.first())) {
+            batchIndex = i;
+            break;
+        }
+    }
+    QList<int> batch = m_pendingBatches.takeAt(batchIndex);
 
+    // Requests with an error but without id can't be told apart, fail all which didn't get an answer
+    if (!errorMessage.isEmpty()) {
+        qCWarning(dcKodi) << "batch response contains errors without request id:" << errorMessage.value("error").toMap().value("message").toString();
+        foreach (int id, answeredIds) {
+            batch.removeAll(id);
+        }
+        failRequests(batch, errorMessage);
+    }
+}
+
+void KodiJsonHandler::processMessage(const QVariantMap &message)
+{
     // check jsonrpc value
     if (!message.contains("jsonrpc") || message.value("jsonrpc").toString() != "2.0") {
-        qCWarning(dcKodi) << "jsonrpc 2.0 value missing in message" << data;
+        qCWarning(dcKodi) << "jsonrpc 2.0 value missing in message" << message;
     }
 
     // check id (if there is no id, it's an notification from kodi)
@@ -98,7 +174,7 @@ void KodiJsonHandler::processResponse(const QByteArray &data)
 
         // check method
         if (!message.contains("method")) {
-            qCWarning(dcKodi) << "method missing in message" << data;
+            qCWarning(dcKodi) << "method missing in message" << message;
         }
 
         emit notificationReceived(message.value("method").toString(), message.value("params").toMap());
@@ -110,3 +186,20 @@ void KodiJsonHandler::processResponse(const QByteArray &data)
 
     emit replyReceived(id, reply.method(), message);
 }
+
+void KodiJsonHandler::failRequests(const QList<int> &ids, const QVariantMap &errorMessage)
+{
+    foreach (int id, ids) {
+        if (!m_replys.contains(id)) {
+            continue;
+        }
+        KodiReply reply = m_replys.take(id);
+        emit replyReceived(id, reply.method(), errorMessage);
+    }
+}
+
+bool KodiJsonHandler::hasNullId(const QVariantMap &message) const
+{
+    // JSON null is converted to an invalid QVariant, toInt() would turn it into the id 0
+    return message.contains("id") && message.value("id").isNull();
+}
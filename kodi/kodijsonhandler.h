@@ -46,6 +46,7 @@ public:
     explicit KodiJsonHandler(KodiConnection *connection, QObject *parent = nullptr);
 
     int sendData(const QString &method, const QVariantMap &params);
+    QList<int> sendBatch(const QList<KodiReply> &requests);
 
 signals:
     void notificationReceived(const QString &method, const QVariantMap &params);
@@ -58,7 +59,14 @@ private:
     KodiConnection *m_connection;
     int m_id;
     QHash<int, KodiReply> m_replys;
-    QByteArray m_dataBuffer;
+    // Request ids of the batches waiting for a response, in the order they have been sent
+    QList<QList<int> > m_pendingBatches;
+
+    QVariantMap createPackage(const QString &method, const QVariantMap &params);
+    void processBatchResponse(const QVariantList &messages);
+    void processMessage(const QVariantMap &message);
+    void failRequests(const QList<int> &ids, const QVariantMap &errorMessage);
+    bool hasNullId(const QVariantMap &message) const;
 
 };
 
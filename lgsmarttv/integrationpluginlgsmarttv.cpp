@@ -355,9 +355,14 @@ void IntegrationPluginLgSmartTv::refreshTv(Thing *thing)
 
 void IntegrationPluginLgSmartTv::onPluginTimer()
 {
+    // TVs which push their events are only checked for consistency every minute
+    bool consistencyCheck = (m_pollCount++ % 12 == 0);
     foreach (Thing *thing, m_tvList.values()) {
         TvDevice *tv = m_tvList.key(thing);
         if (tv->paired()) {
+            if (tv->eventsConfirmed() && !consistencyCheck)
+                continue;
+
             refreshTv(thing);
         } else {
             pairTvDevice(thing);
@@ -62,6 +62,7 @@ public:
 
 private:
     PluginTimer *m_pluginTimer = nullptr;
+    int m_pollCount = 0;
     QHash<TvDevice *, Thing *> m_tvList;
     QHash<QString, QString> m_tvKeys;
 
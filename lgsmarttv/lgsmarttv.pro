@@ -1,4 +1,5 @@
 include(../plugins.pri)
+include(../common/http/http.pri)
 
 TARGET = $$qtLibraryTarget(nymea_integrationpluginlgsmarttv)
 
@@ -91,6 +91,7 @@ void TvDevice::setPaired(const bool &paired)
 {
     if (m_paired != paired) {
         m_paired = paired;
+        m_eventsConfirmed = false;
         stateChanged();
     }
 }
@@ -105,6 +106,8 @@ void TvDevice::setReachable(const bool &reachable)
     if (m_reachable != reachable) {
         qCDebug(dcLgSmartTv()) << "TV Event handler" << (reachable ? "reachable" : "not reachable any more");
         m_reachable = reachable;
+        if (!reachable)
+            m_eventsConfirmed = false;
         emit stateChanged();
     }
 }
@@ -114,6 +117,11 @@ bool TvDevice::reachable() const
     return m_reachable;
 }
 
+bool TvDevice::eventsConfirmed() const
+{
+    return m_eventsConfirmed;
+}
+
 bool TvDevice::is3DMode() const
 {
     return m_is3DMode;
@@ -327,6 +335,10 @@ QString TvDevice::printXmlData(const QByteArray &data)
 void TvDevice::eventOccured(const QByteArray &data)
 {
     qCDebug(dcLgSmartTv()) << "Event handler data received" << printXmlData(data);
+    if (!m_eventsConfirmed && m_paired) {
+        qCDebug(dcLgSmartTv()) << "Receiving events from" << m_hostAddress.toString() << "polling less frequently";
+        m_eventsConfirmed = true;
+    }
 
     // if we got a channel changed event...
     if(data.contains("ChannelChanged")) {
@@ -141,6 +141,9 @@ public:
     void setReachable(const bool &reachable);
     bool reachable() const;
 
+    // True once the TV pushed an event since it has been paired
+    bool eventsConfirmed() const;
+
     bool is3DMode() const;
     int volumeLevel() const;
     bool mute() const;
@@ -176,6 +179,7 @@ private:
     // States
     bool m_paired;
     bool m_reachable;
+    bool m_eventsConfirmed = false;
     bool m_is3DMode;
     bool m_mute;
     int m_volumeLevel;
@@ -31,12 +31,18 @@
 #include "tveventhandler.h"
 #include "extern-plugininfo.h"
 
+#include <QLocale>
+
 TvEventHandler::TvEventHandler(const QHostAddress &host, const int &port, QObject *parent) :
     QTcpServer(parent),
     m_host(host),
-    m_port(port),
-    m_expectingData(false)
+    m_port(port)
 {
+    m_idleTimer = new QTimer(this);
+    m_idleTimer->setInterval(30000);
+    connect(m_idleTimer, &QTimer::timeout, this, &TvEventHandler::onIdleTimeout);
+    m_idleTimer->start();
+
     listen(QHostAddress::AnyIPv4, m_port);
 }
 
@@ -44,57 +50,100 @@ void TvEventHandler::incomingConnection(qintptr socket)
 {
     QTcpSocket* tcpSocket = new QTcpSocket(this);
     tcpSocket->setSocketDescriptor(socket);
+
+    // reject everything, except the tv
+    if (tcpSocket->peerAddress() != m_host) {
+        qCWarning(dcLgSmartTv()) << "Event handler -> rejecting connection from " << tcpSocket->peerAddress().toString();
+        tcpSocket->abort();
+        tcpSocket->deleteLater();
+        return;
+    }
+
     qCDebug(dcLgSmartTv()) << "Event handler -> incoming connection" << tcpSocket->peerAddress().toString() << tcpSocket->peerName();
+    Client client;
+    client.parser = HttpRequestParser(m_maxHeaderSize, m_maxBodySize);
+    client.lastActivity = QDateTime::currentDateTimeUtc();
+    m_clients.insert(tcpSocket, client);
     connect(tcpSocket, &QTcpSocket::readyRead, this, &TvEventHandler::readClient);
-    connect(tcpSocket, &QTcpSocket::disconnected, this, &TvEventHandler::onDisconnected);
+    // Queued, the parser still holds a reference to the client when a response closes the socket
+    connect(tcpSocket, &QTcpSocket::disconnected, this, &TvEventHandler::onDisconnected, Qt::QueuedConnection);
 }
 
 void TvEventHandler::readClient()
 {
-    QTcpSocket* socket = (QTcpSocket*)sender();
+    QTcpSocket* socket = static_cast<QTcpSocket *>(sender());
+    if (!m_clients.contains(socket))
+        return;
 
-    // reject everything, except the tv
-    if(socket->peerAddress() != m_host){
-        socket->close();
-        socket->deleteLater();
-        qCWarning(dcLgSmartTv()) << "Event handler -> rejecting connection from " << socket->peerAddress().toString();
+    Client &client = m_clients[socket];
+    if (client.closing) {
+        socket->readAll();
         return;
     }
+    client.parser.addData(socket->readAll());
+    client.lastActivity = QDateTime::currentDateTimeUtc();
 
+    // Requests may be split across or share segments, handle all complete ones
+    HttpRequestParser::Request request;
+    while (!client.closing && client.parser.takeRequest(&request)) {
+        finishRequest(socket, request);
+    }
+    if (!client.closing && client.parser.error() != HttpRequestParser::ErrorNone) {
+        rejectRequest(socket, client.parser.errorStatus());
+    }
+}
 
-    // the tv sends first the header (POST /udap/api/.... HTTP/1.1)
-    // in the scond package the tv sends the information (xml format)
-    while(!socket->atEnd()){
-        QByteArray data = socket->readAll();
-
-        // check if we got information
-        if(data.startsWith("<?xml") && m_expectingData){
-            m_expectingData = false;
+void TvEventHandler::finishRequest(QTcpSocket *socket, const HttpRequestParser::Request &request)
+{
+    if (request.method != "POST") {
+        sendResponse(socket, "405 Method Not Allowed", request.keepAlive());
+        return;
+    }
 
-            // Answere with OK
-            QTextStream textStream(socket);
-            textStream.setAutoDetectUnicode(true);
-            textStream << "HTTP/1.0 200 OK\r\n"
-                          "Content-Type: text/html; charset=\"utf-8\"\r\n"
-                          "User-Agent: UDAP/2.0 nymea\r\n"
-                       << "Date: " << QDateTime::currentDateTime().toString() << "\n";
+    qCDebug(dcLgSmartTv()) << "Event handler -> event occured" << "http://" + m_host.toString() + ":" + QString::number(m_port) + request.path;
+    sendResponse(socket, "200 OK", request.keepAlive());
+    emit eventOccured(request.body);
+}
 
-            emit eventOccured(data);
-        }
+void TvEventHandler::sendResponse(QTcpSocket *socket, const QByteArray &status, bool keepAlive)
+{
+    QByteArray response = "HTTP/1.1 " + status + "\r\n";
+    response.append("Content-Type: text/html; charset=\"utf-8\"\r\n");
+    response.append("Content-Length: 0\r\n");
+    response.append("Server: UDAP/2.0 nymea\r\n");
+    response.append("Date: " + QLocale::c().toString(QDateTime::currentDateTimeUtc(), "ddd, dd MMM yyyy hh:mm:ss").toLatin1() + " GMT\r\n");
+    response.append(keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
+    response.append("\r\n");
+    socket->write(response);
 
-        // check if we got header
-        if (data.startsWith("POST") && !m_expectingData) {
-            m_expectingData = true;
-            QStringList tokens = QString(data).split(QRegExp("[ \r\n][ \r\n]*"));
-            qCDebug(dcLgSmartTv()) << "event handler -> event occured" << "http://" << m_host.toString() << ":" << m_port << tokens[1];
-        }
+    if (!keepAlive) {
+        m_clients[socket].closing = true;
+        m_clients[socket].parser.clear();
+        socket->disconnectFromHost();
     }
 }
 
+void TvEventHandler::rejectRequest(QTcpSocket *socket, const QByteArray &status)
+{
+    qCWarning(dcLgSmartTv()) << "Event handler -> rejecting request:" << status;
+    sendResponse(socket, status, false);
+}
+
 void TvEventHandler::onDisconnected()
 {
-    QTcpSocket* socket = (QTcpSocket*)sender();
+    QTcpSocket* socket = static_cast<QTcpSocket *>(sender());
     qCDebug(dcLgSmartTv()) << "event handler -> client disconnected" << socket->peerAddress();
+    m_clients.remove(socket);
     socket->deleteLater();
 }
 
+void TvEventHandler::onIdleTimeout()
+{
+    QDateTime now = QDateTime::currentDateTimeUtc();
+    foreach (QTcpSocket *socket, m_clients.keys()) {
+        if (m_clients.value(socket).lastActivity.secsTo(now) > m_idleTimeout) {
+            qCDebug(dcLgSmartTv()) << "event handler -> closing idle connection" << socket->peerAddress();
+            socket->disconnectFromHost();
+        }
+    }
+}
@@ -31,15 +31,14 @@
 #ifndef TVEVENTHANDLER_H
 #define TVEVENTHANDLER_H
 
+#include "httprequestparser.h"
+
 #include <QTcpServer>
 #include <QTcpSocket>
 #include <QDebug>
 #include <QDateTime>
-#include <QTextStream>
-#include <QRegExp>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QNetworkRequest>
+#include <QHash>
+#include <QTimer>
 
 class TvEventHandler : public QTcpServer
 {
@@ -51,9 +50,25 @@ protected:
     void incomingConnection(qintptr socket) override;
 
 private:
+    // Request parser and keep-alive state of one TV connection
+    struct Client {
+        HttpRequestParser parser;
+        QDateTime lastActivity;
+        bool closing = false;
+    };
+
     QHostAddress m_host;
     int m_port;
-    bool m_expectingData;
+
+    QHash<QTcpSocket *, Client> m_clients;
+    QTimer *m_idleTimer = nullptr;
+    int m_idleTimeout = 120;
+    int m_maxHeaderSize = 8192;
+    int m_maxBodySize = 65536;
+
+    void finishRequest(QTcpSocket *socket, const HttpRequestParser::Request &request);
+    void sendResponse(QTcpSocket *socket, const QByteArray &status, bool keepAlive);
+    void rejectRequest(QTcpSocket *socket, const QByteArray &status);
 
 signals:
     void eventOccured(const QByteArray &path);
@@ -61,6 +76,7 @@ signals:
 private slots:
     void readClient();
     void onDisconnected();
+    void onIdleTimeout();
 
 };
 
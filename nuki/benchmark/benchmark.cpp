@@ -0,0 +1,175 @@
+#include <QCoreApplication>
+
+#include <QDebug>
+#include <QDataStream>
+#include <QElapsedTimer>
+
+extern "C" {
+#include "sodium.h"
+}
+
+#include "nukiutils.h"
+
+// Checks and benchmarks the CRC and message code of the Nuki plugin and the libsodium
+// calls of the authenticator.
+// Usage: benchmark [iterations]
+
+Q_LOGGING_CATEGORY(dcNuki, "Nuki")
+
+static int failures = 0;
+
+static void check(bool condition, const QString &what)
+{
+    if (!condition) {
+        qWarning() << "FAILED:" << what;
+        failures++;
+    }
+}
+
+// The bitwise CRC-CCITT the lookup table replaced
+static quint16 referenceCrc(const QByteArray &data)
+{
+    quint16 crcValue = 0xffff;
+    for (int byte = 0; byte < data.length(); ++byte) {
+        crcValue ^= (static_cast<quint8>(data.at(byte)) << 8);
+        for (quint8 bit = 8; bit > 0; --bit) {
+            if (crcValue & 0x8000) {
+                crcValue = static_cast<quint16>((crcValue << 1) ^ 0x1021);
+            } else {
+                crcValue = static_cast<quint16>(crcValue << 1);
+            }
+        }
+    }
+    return crcValue;
+}
+
+// The stream based message builder the in place one replaced
+static QByteArray referenceMessage(quint32 authenticationId, quint16 command, const QByteArray &payload)
+{
+    QByteArray message;
+    QDataStream stream(&message, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream << authenticationId;
+    stream << command;
+    for (int i = 0; i < payload.length(); i++) {
+        stream << static_cast<quint8>(payload.at(i));
+    }
+    stream << referenceCrc(message);
+    return message;
+}
+
+static QByteArray randomData(int length)
+{
+    QByteArray data(length, 0);
+    randombytes_buf(data.data(), static_cast<size_t>(length));
+    return data;
+}
+
+static void report(const char *name, int iterations, qint64 nsecs)
+{
+    qDebug().nospace() << name << ": " << (nsecs / iterations) << " ns per call";
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    int iterations = argc > 1 ? QString(argv[1]).toInt() : 100000;
+    if (iterations <= 0 || sodium_init() < 0) {
+        qWarning() << "Usage: benchmark [iterations]";
+        return 1;
+    }
+
+    // CRC-CCITT/FALSE check value
+    check(NukiUtils::calculateCrc(QByteArray("123456789")) == 0x29b1, "CRC check value");
+    for (int length = 0; length < 300; length++) {
+        QByteArray data = randomData(length);
+        check(NukiUtils::calculateCrc(data) == referenceCrc(data), QString("CRC of %1 random bytes").arg(length));
+    }
+
+    // Messages for the keyturner
+    for (int length = 0; length < 64; length++) {
+        QByteArray payload = randomData(length);
+        QByteArray message = NukiUtils::createRequestMessageForUnencryptedForEncryption(0x12345678, NukiUtils::CommandRequestData, payload);
+        check(message == referenceMessage(0x12345678, NukiUtils::CommandRequestData, payload), QString("Message with %1 payload bytes").arg(length));
+        check(NukiUtils::validateMessageCrc(message), QString("CRC validation of a message with %1 payload bytes").arg(length));
+        message[message.length() / 2] = static_cast<char>(message.at(message.length() / 2) ^ 0x01);
+        check(!NukiUtils::validateMessageCrc(message), QString("CRC validation of a corrupted message with %1 payload bytes").arg(length));
+    }
+
+    // The precalculated shared key must give the same cipher text as crypto_box_easy
+    unsigned char publicKey[crypto_box_PUBLICKEYBYTES], secretKey[crypto_box_SECRETKEYBYTES];
+    unsigned char publicKeyNuki[crypto_box_PUBLICKEYBYTES], secretKeyNuki[crypto_box_SECRETKEYBYTES];
+    crypto_box_keypair(publicKey, secretKey);
+    crypto_box_keypair(publicKeyNuki, secretKeyNuki);
+    unsigned char sharedKey[crypto_box_BEFORENMBYTES];
+    check(crypto_box_beforenm(sharedKey, publicKeyNuki, secretKey) == 0, "Shared key");
+
+    QByteArray plain = NukiUtils::createRequestMessageForUnencryptedForEncryption(0x12345678, NukiUtils::CommandLockAction, randomData(30));
+    QByteArray nonce = randomData(crypto_box_NONCEBYTES);
+    const unsigned char *plainData = reinterpret_cast<const unsigned char *>(plain.constData());
+    const unsigned char *nonceData = reinterpret_cast<const unsigned char *>(nonce.constData());
+    QByteArray cipherFull(plain.length() + static_cast<int>(crypto_box_MACBYTES), 0);
+    QByteArray cipherShared(cipherFull.length(), 0);
+    crypto_box_easy(reinterpret_cast<unsigned char *>(cipherFull.data()), plainData, static_cast<unsigned long long>(plain.length()), nonceData, publicKeyNuki, secretKey);
+    crypto_box_easy_afternm(reinterpret_cast<unsigned char *>(cipherShared.data()), plainData, static_cast<unsigned long long>(plain.length()), nonceData, sharedKey);
+    check(cipherFull == cipherShared, "Cipher text with the precalculated key");
+
+    // The lock decrypts with its own key pair
+    QByteArray decrypted(plain.length(), 0);
+    check(crypto_box_open_easy(reinterpret_cast<unsigned char *>(decrypted.data()), reinterpret_cast<const unsigned char *>(cipherShared.constData()),
+                               static_cast<unsigned long long>(cipherShared.length()), nonceData, publicKey, secretKeyNuki) == 0 && decrypted == plain, "Decryption by the peer");
+    cipherShared[0] = static_cast<char>(cipherShared.at(0) ^ 0x01);
+    check(crypto_box_open_easy_afternm(reinterpret_cast<unsigned char *>(decrypted.data()), reinterpret_cast<const unsigned char *>(cipherShared.constData()),
+                                       static_cast<unsigned long long>(cipherShared.length()), nonceData, sharedKey) != 0, "Rejecting a corrupted cipher text");
+
+    // Benchmarks
+    QElapsedTimer timer;
+    volatile quint16 sink = 0;
+    QByteArray data = randomData(64);
+
+    timer.start();
+    for (int i = 0; i < iterations; i++)
+        sink = sink ^ referenceCrc(data);
+    report("Bitwise CRC, 64 bytes", iterations, timer.nsecsElapsed());
+
+    timer.start();
+    for (int i = 0; i < iterations; i++)
+        sink = sink ^ NukiUtils::calculateCrc(data);
+    report("Table CRC, 64 bytes", iterations, timer.nsecsElapsed());
+
+    timer.start();
+    for (int i = 0; i < iterations; i++)
+        sink = sink ^ static_cast<quint16>(referenceMessage(0x12345678, NukiUtils::CommandLockAction, data).length());
+    report("Stream message builder", iterations, timer.nsecsElapsed());
+
+    timer.start();
+    for (int i = 0; i < iterations; i++)
+        sink = sink ^ static_cast<quint16>(NukiUtils::createRequestMessageForUnencryptedForEncryption(0x12345678, NukiUtils::CommandLockAction, data).length());
+    report("In place message builder", iterations, timer.nsecsElapsed());
+
+    int cryptoIterations = qMax(1, iterations / 10);
+    timer.start();
+    for (int i = 0; i < cryptoIterations; i++) {
+        QByteArray cipher(plain.length() + static_cast<int>(crypto_box_MACBYTES), Qt::Uninitialized);
+        crypto_box_easy(reinterpret_cast<unsigned char *>(cipher.data()), plainData, static_cast<unsigned long long>(plain.length()), nonceData, publicKeyNuki, secretKey);
+    }
+    report("crypto_box_easy with a new buffer", cryptoIterations, timer.nsecsElapsed());
+
+    // Like the authenticator: shared key once per session, one scratch buffer for all messages
+    QByteArray scratch;
+    scratch.reserve(512);
+    timer.start();
+    for (int i = 0; i < cryptoIterations; i++) {
+        scratch.resize(plain.length() + static_cast<int>(crypto_box_MACBYTES));
+        crypto_box_easy_afternm(reinterpret_cast<unsigned char *>(scratch.data()), plainData, static_cast<unsigned long long>(plain.length()), nonceData, sharedKey);
+    }
+    report("crypto_box_easy_afternm with a scratch buffer", cryptoIterations, timer.nsecsElapsed());
+
+    Q_UNUSED(sink)
+    if (failures > 0) {
+        qWarning() << failures << "checks failed";
+        return 1;
+    }
+    qDebug() << "All checks passed";
+    return 0;
+}
@@ -0,0 +1,12 @@
+CONFIG += c++11
+
+# Picks up the logging category stub in this directory before the generated plugin info
+INCLUDEPATH += . ..
+
+LIBS += -lsodium
+
+SOURCES += benchmark.cpp \
+    ../nukiutils.cpp
+
+HEADERS += extern-plugininfo.h \
+    ../nukiutils.h
@@ -45,10 +45,7 @@ QString BluetoothAdapter::alias() const
 
 bool BluetoothAdapter::setAlias(const QString &alias)
 {
-    if (!m_adapterInterface->isValid())
-        return false;
-
-    return m_adapterInterface->setProperty("Alias", QVariant(alias));
+    return setPropertyInternally("Alias", QVariant(alias));
 }
 
 QString BluetoothAdapter::address() const
@@ -73,10 +70,7 @@ bool BluetoothAdapter::discoverable() const
 
 bool BluetoothAdapter::setDiscoverable(const bool &discoverable)
 {
-    if (!m_adapterInterface->isValid())
-        return false;
-
-    return m_adapterInterface->setProperty("Discoverable", QVariant(discoverable));
+    return setPropertyInternally("Discoverable", QVariant(discoverable));
 }
 
 uint BluetoothAdapter::discoverableTimeout() const
@@ -86,10 +80,7 @@ uint BluetoothAdapter::discoverableTimeout() const
 
 bool BluetoothAdapter::setDiscoverableTimeout(const uint &seconds)
 {
-    if (!m_adapterInterface->isValid())
-        return false;
-
-    return m_adapterInterface->setProperty("DiscoverableTimeout", QVariant(seconds));
+    return setPropertyInternally("DiscoverableTimeout", QVariant(seconds));
 }
 
 bool BluetoothAdapter::pairable() const
@@ -99,10 +90,7 @@ bool BluetoothAdapter::pairable() const
 
 bool BluetoothAdapter::setPairable(const bool &pairable)
 {
-    if (!m_adapterInterface->isValid())
-        return false;
-
-    return m_adapterInterface->setProperty("Pairable", QVariant(pairable));
+    return setPropertyInternally("Pairable", QVariant(pairable));
 }
 
 uint BluetoothAdapter::pairableTimeout() const
@@ -112,10 +100,7 @@ uint BluetoothAdapter::pairableTimeout() const
 
 bool BluetoothAdapter::setPairableTimeout(const uint &seconds)
 {
-    if (!m_adapterInterface->isValid())
-        return false;
-
-    return m_adapterInterface->setProperty("PairableTimeout", QVariant(seconds));
+    return setPropertyInternally("PairableTimeout", QVariant(seconds));
 }
 
 uint BluetoothAdapter::adapterClass() const
@@ -141,10 +126,7 @@ bool BluetoothAdapter::powered() const
 
 bool BluetoothAdapter::setPower(const bool &power)
 {
-    if (!m_adapterInterface->isValid())
-        return false;
-
-    return m_adapterInterface->setProperty("Powered", QVariant(power));
+    return setPropertyInternally("Powered", QVariant(power));
 }
 
 QStringList BluetoothAdapter::uuids() const
@@ -204,7 +186,8 @@ BluetoothAdapter::BluetoothAdapter(const QDBusObjectPath &path, const QVariantMa
     m_pairable(false),
     m_pairableTimeout(0),
     m_adapterClass(0),
-    m_powered(false)
+    m_powered(false),
+    m_discoveryWatcher(nullptr)
 {
     // Check DBus connection
     if (!QDBusConnection::systemBus().isConnected()) {
@@ -212,13 +195,13 @@ BluetoothAdapter::BluetoothAdapter(const QDBusObjectPath &path, const QVariantMa
         return;
     }
 
-    m_adapterInterface = new QDBusInterface(orgBluez, m_path.path(), orgBluezAdapter1, QDBusConnection::systemBus(), this);
+    m_adapterInterface = new BluezInterface(m_path.path(), orgBluezAdapter1, this);
     if (!m_adapterInterface->isValid()) {
         qCWarning(dcBluez()) << "Invalid DBus adapter interface for" << m_path.path();
         return;
     }
 
-    QDBusConnection::systemBus().connect(orgBluez, m_path.path(), "org.freedesktop.DBus.Properties", "PropertiesChanged", this, SLOT(onPropertiesChanged(QString,QVariantMap,QStringList)));
+    QDBusConnection::systemBus().connect(orgBluez, m_path.path(), orgFreedesktopDBusProperties, "PropertiesChanged", this, SLOT(onPropertiesChanged(QString,QVariantMap,QStringList)));
 
     processProperties(properties);
 }
@@ -308,6 +291,28 @@ bool BluetoothAdapter::removeDevice(const QDBusObjectPath &path)
     return true;
 }
 
+bool BluetoothAdapter::setPropertyInternally(const QString &propertyName, const QVariant &value)
+{
+    if (!m_adapterInterface->isValid()) {
+        qCWarning(dcBluez()) << "Invalid DBus adapter interface for" << m_path.path();
+        return false;
+    }
+
+    // Note: the new value will be applied once bluez emits the PropertiesChanged signal
+    QDBusPendingCall setPropertyCall = m_adapterInterface->setPropertyAsync(propertyName, value);
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(setPropertyCall, this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, watcher, propertyName](){
+        QDBusPendingReply<void> reply = *watcher;
+        if (reply.isError()) {
+            qCWarning(dcBluez()) << "Could not set adapter property" << propertyName << m_address << reply.error().name() << reply.error().message();
+            emit errorOccurred(Bluez::errorFromDBusError(reply.error()));
+        }
+
+        watcher->deleteLater();
+    });
+    return true;
+}
+
 void BluetoothAdapter::setAliasInternally(const QString &alias)
 {
     if (m_alias != alias) {
@@ -376,8 +381,33 @@ void BluetoothAdapter::onPropertiesChanged(const QString &interface, const QVari
 void BluetoothAdapter::onRemoveDeviceFinished(QDBusPendingCallWatcher *call)
 {
     QDBusPendingReply<void> reply = *call;
-    if (reply.isError())
+    if (reply.isError()) {
         qCWarning(dcBluez()) << "Could not remove device" << m_address << reply.error().name() << reply.error().message();
+        emit errorOccurred(Bluez::errorFromDBusError(reply.error()));
+    }
+
+    call->deleteLater();
+}
+
+void BluetoothAdapter::onStartDiscoveryFinished(QDBusPendingCallWatcher *call)
+{
+    QDBusPendingReply<void> reply = *call;
+    if (reply.isError()) {
+        qCWarning(dcBluez()) << "Could not start discovery" << m_name << ":" << reply.error().name() << reply.error().message();
+        emit errorOccurred(Bluez::errorFromDBusError(reply.error()));
+    }
+
+    call->deleteLater();
+    m_discoveryWatcher = nullptr;
+}
+
+void BluetoothAdapter::onStopDiscoveryFinished(QDBusPendingCallWatcher *call)
+{
+    QDBusPendingReply<void> reply = *call;
+    if (reply.isError()) {
+        qCWarning(dcBluez()) << "Could not stop discovery" << m_name << ":" << reply.error().name() << reply.error().message();
+        emit errorOccurred(Bluez::errorFromDBusError(reply.error()));
+    }
 
     call->deleteLater();
 }
@@ -389,14 +419,12 @@ void BluetoothAdapter::startDiscovering()
         return;
     }
 
-    if (discovering())
+    if (discovering() || m_discoveryWatcher)
         return;
 
-    QDBusMessage query = m_adapterInterface->call("StartDiscovery");
-    if(query.type() != QDBusMessage::ReplyMessage) {
-        qCWarning(dcBluez()) << "Could not start discovery" << m_name << ":" << query.errorName() << query.errorMessage();
-        return;
-    }
+    QDBusPendingCall startDiscoveryCall = m_adapterInterface->asyncCall("StartDiscovery");
+    m_discoveryWatcher = new QDBusPendingCallWatcher(startDiscoveryCall, this);
+    connect(m_discoveryWatcher, &QDBusPendingCallWatcher::finished, this, &BluetoothAdapter::onStartDiscoveryFinished);
 }
 
 void BluetoothAdapter::stopDiscovering()
@@ -406,11 +434,10 @@ void BluetoothAdapter::stopDiscovering()
         return;
     }
 
-    QDBusMessage query = m_adapterInterface->call("StopDiscovery");
-    if(query.type() != QDBusMessage::ReplyMessage) {
-        qCWarning(dcBluez()) << "Could not start discovery" << m_name << ":" << query.errorName() << query.errorMessage();
-        return;
-    }
+    // Note: calls are processed in order by bluez, so a pending StartDiscovery will be stopped as well
+    QDBusPendingCall stopDiscoveryCall = m_adapterInterface->asyncCall("StopDiscovery");
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(stopDiscoveryCall, this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, &BluetoothAdapter::onStopDiscoveryFinished);
 }
 
 QDebug operator<<(QDebug debug, BluetoothAdapter *adapter)
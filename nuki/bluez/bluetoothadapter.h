@@ -33,10 +33,12 @@
 
 #include <QObject>
 #include <QDebug>
-#include <QDBusInterface>
 #include <QDBusConnection>
 #include <QDBusObjectPath>
+#include <QDBusPendingCallWatcher>
 
+#include "blueztypes.h"
+#include "bluezinterface.h"
 #include "bluetoothdevice.h"
 
 // Note: DBus documentation https://git.kernel.org/pub/scm/bluetooth/bluez.git/tree/doc/adapter-api.txt
@@ -93,7 +95,7 @@ private:
     ~BluetoothAdapter();
 
     QDBusObjectPath m_path;
-    QDBusInterface *m_adapterInterface;
+    BluezInterface *m_adapterInterface;
 
     QString m_name;
     QString m_address;
@@ -111,6 +113,8 @@ private:
 
     QList<BluetoothDevice *> m_devices;
 
+    QDBusPendingCallWatcher *m_discoveryWatcher;
+
     void processProperties(const QVariantMap &properties);
 
     // Methods called from BluetoothManager
@@ -122,7 +126,7 @@ private:
 
     // DBus methods
     bool removeDevice(const QDBusObjectPath &path);
-
+    bool setPropertyInternally(const QString &propertyName, const QVariant &value);
 
     void setAliasInternally(const QString &alias);
     void setDiscoveringInternally(const bool &discovering);
@@ -135,6 +139,8 @@ private:
 private slots:
     void onPropertiesChanged(const QString &interface, const QVariantMap &changedProperties, const QStringList &invalidatedProperties);
     void onRemoveDeviceFinished(QDBusPendingCallWatcher *call);
+    void onStartDiscoveryFinished(QDBusPendingCallWatcher *call);
+    void onStopDiscoveryFinished(QDBusPendingCallWatcher *call);
 
 signals:
     void aliasChanged(const QString &alias);
@@ -148,6 +154,8 @@ signals:
     void deviceAdded(BluetoothDevice *thing);
     void deviceRemoved(BluetoothDevice *thing);
 
+    void errorOccurred(const Bluez::Error &error);
+
 public slots:
     void startDiscovering();
     void stopDiscovering();
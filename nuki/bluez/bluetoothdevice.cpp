@@ -64,10 +64,7 @@ QString BluetoothDevice::alias() const
 
 bool BluetoothDevice::setAlias(const QString &alias)
 {
-    if (!m_deviceInterface->isValid())
-        return false;
-
-    return m_deviceInterface->setProperty("Alias", QVariant(alias));
+    return setPropertyInternally("Alias", QVariant(alias));
 }
 
 QString BluetoothDevice::modalias() const
@@ -117,10 +114,7 @@ bool BluetoothDevice::trusted() const
 
 bool BluetoothDevice::setTrusted(const bool &trusted)
 {
-    if (!m_deviceInterface->isValid())
-        return false;
-
-    return m_deviceInterface->setProperty("Trusted", QVariant(trusted));
+    return setPropertyInternally("Trusted", QVariant(trusted));
 }
 
 bool BluetoothDevice::blocked() const
@@ -130,10 +124,7 @@ bool BluetoothDevice::blocked() const
 
 bool BluetoothDevice::setBlocked(const bool &blocked)
 {
-    if (!m_deviceInterface->isValid())
-        return false;
-
-    return m_deviceInterface->setProperty("Blocked", QVariant(blocked));
+    return setPropertyInternally("Blocked", QVariant(blocked));
 }
 
 bool BluetoothDevice::legacyPairing() const
@@ -197,13 +188,13 @@ BluetoothDevice::BluetoothDevice(const QDBusObjectPath &path, const QVariantMap
         return;
     }
 
-    m_deviceInterface = new QDBusInterface(orgBluez, m_path.path(), orgBluezDevice1, QDBusConnection::systemBus(), this);
+    m_deviceInterface = new BluezInterface(m_path.path(), orgBluezDevice1, this);
     if (!m_deviceInterface->isValid()) {
         qCWarning(dcBluez()) << "Invalid DBus thing interface for" << m_path.path();
         return;
     }
 
-    QDBusConnection::systemBus().connect(orgBluez, m_path.path(), "org.freedesktop.DBus.Properties", "PropertiesChanged", this, SLOT(onPropertiesChanged(QString,QVariantMap,QStringList)));
+    QDBusConnection::systemBus().connect(orgBluez, m_path.path(), orgFreedesktopDBusProperties, "PropertiesChanged", this, SLOT(onPropertiesChanged(QString,QVariantMap,QStringList)));
 
     processProperties(properties);
 
@@ -304,6 +295,39 @@ BluetoothGattService *BluetoothDevice::getService(const QDBusObjectPath &path)
     return nullptr;
 }
 
+void BluetoothDevice::removeServiceInternally(const QDBusObjectPath &path)
+{
+    BluetoothGattService *service = getService(path);
+    if (!service)
+        return;
+
+    m_services.removeOne(service);
+    qCDebug(dcBluez()) << "[-]" << service;
+    service->deleteLater();
+}
+
+bool BluetoothDevice::setPropertyInternally(const QString &propertyName, const QVariant &value)
+{
+    if (!m_deviceInterface->isValid()) {
+        qCWarning(dcBluez()) << "Invalid DBus thing interface for" << m_path.path();
+        return false;
+    }
+
+    // Note: the new value will be applied once bluez emits the PropertiesChanged signal
+    QDBusPendingCall setPropertyCall = m_deviceInterface->setPropertyAsync(propertyName, value);
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(setPropertyCall, this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, watcher, propertyName](){
+        QDBusPendingReply<void> reply = *watcher;
+        if (reply.isError()) {
+            qCWarning(dcBluez()) << "Could not set device property" << propertyName << m_address.toString() << reply.error().name() << reply.error().message();
+            emit errorOccurred(Bluez::errorFromDBusError(reply.error()));
+        }
+
+        watcher->deleteLater();
+    });
+    return true;
+}
+
 void BluetoothDevice::setStateInternally(const BluetoothDevice::State &state)
 {
     if (m_state != state) {
@@ -413,6 +437,7 @@ void BluetoothDevice::onConnectDeviceFinished(QDBusPendingCallWatcher *call)
     if (reply.isError()) {
         setStateInternally(Disconnected);
         qCWarning(dcBluez()) << "Could not connect device" << m_address.toString() << reply.error().name() << reply.error().message();
+        emit errorOccurred(Bluez::errorFromDBusError(reply.error()));
     }
 
     call->deleteLater();
@@ -422,8 +447,10 @@ void BluetoothDevice::onConnectDeviceFinished(QDBusPendingCallWatcher *call)
 void BluetoothDevice::onDisconnectDeviceFinished(QDBusPendingCallWatcher *call)
 {
     QDBusPendingReply<void> reply = *call;
-    if (reply.isError())
+    if (reply.isError()) {
         qCWarning(dcBluez()) << "Could not disconnect device" << m_address.toString() << reply.error().name() << reply.error().message();
+        emit errorOccurred(Bluez::errorFromDBusError(reply.error()));
+    }
 
     evaluateCurrentState();
 
@@ -434,8 +461,10 @@ void BluetoothDevice::onDisconnectDeviceFinished(QDBusPendingCallWatcher *call)
 void BluetoothDevice::onPairingFinished(QDBusPendingCallWatcher *call)
 {
     QDBusPendingReply<void> reply = *call;
-    if (reply.isError())
+    if (reply.isError()) {
         qCWarning(dcBluez()) << "Could not pair device" << m_address.toString() << reply.error().name() << reply.error().message();
+        emit errorOccurred(Bluez::errorFromDBusError(reply.error()));
+    }
 
     evaluateCurrentState();
 
@@ -446,8 +475,10 @@ void BluetoothDevice::onPairingFinished(QDBusPendingCallWatcher *call)
 void BluetoothDevice::onCancelPairingFinished(QDBusPendingCallWatcher *call)
 {
     QDBusPendingReply<void> reply = *call;
-    if (reply.isError())
+    if (reply.isError()) {
         qCWarning(dcBluez()) << "Could not cancel pairing" << m_address.toString() << reply.error().name() << reply.error().message();
+        emit errorOccurred(Bluez::errorFromDBusError(reply.error()));
+    }
 
     evaluateCurrentState();
 
@@ -490,27 +521,6 @@ bool BluetoothDevice::disconnectDevice()
     return true;
 }
 
-bool BluetoothDevice::disconnectDeviceBlocking()
-{
-    if (!m_deviceInterface->isValid()) {
-        qCWarning(dcBluez()) << "Invalid DBus thing interface for" << m_path.path();
-        return false;
-    }
-
-    if (!connected() || state() == Disconnecting)
-        return true;
-
-    qCWarning(dcBluez()) << "Disconnecting blocking" << this;
-    QDBusPendingReply<void> reply = m_deviceInterface->call("Disconnect");
-    reply.waitForFinished();
-    if(reply.isError()) {
-        qCWarning(dcBluez()) << reply.error();
-        return false;
-    }
-
-    return true;
-}
-
 bool BluetoothDevice::requestPairing()
 {
     if (!m_deviceInterface->isValid()) {
@@ -543,7 +553,7 @@ bool BluetoothDevice::cancelPairingRequest()
 
     QDBusPendingCall cancelPairingCall = m_deviceInterface->asyncCall("CancelPairing");
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(cancelPairingCall, this);
-    connect(watcher, &QDBusPendingCallWatcher::finished, this, &BluetoothDevice::onPairingFinished);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, &BluetoothDevice::onCancelPairingFinished);
     return true;
 }
 
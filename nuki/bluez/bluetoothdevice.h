@@ -32,13 +32,13 @@
 #define BLUETOOTHDEVICE_H
 
 #include <QObject>
-#include <QDBusInterface>
 #include <QDBusPendingCall>
 #include <QBluetoothAddress>
 #include <QBluetoothHostInfo>
 #include <QDBusPendingCallWatcher>
 
 #include "blueztypes.h"
+#include "bluezinterface.h"
 #include "bluetoothgattservice.h"
 
 // Note: DBus documentation https://git.kernel.org/pub/scm/bluetooth/bluez.git/tree/doc/thing-api.txt
@@ -105,7 +105,7 @@ private:
     ~BluetoothDevice();
 
     QDBusObjectPath m_path;
-    QDBusInterface *m_deviceInterface;
+    BluezInterface *m_deviceInterface;
 
     QList<BluetoothGattService *> m_services;
 
@@ -147,6 +147,9 @@ private:
     void addServiceInternally(const QDBusObjectPath &path, const QVariantMap &properties);
     bool hasService(const QDBusObjectPath &path);
     BluetoothGattService *getService(const QDBusObjectPath &path);
+    void removeServiceInternally(const QDBusObjectPath &path);
+
+    bool setPropertyInternally(const QString &propertyName, const QVariant &value);
 
     void setStateInternally(const State &state);
 
@@ -171,6 +174,8 @@ signals:
     void blockedChanged(const bool &blocked);
     void servicesResolvedChanged(const bool &servicesResolved);
 
+    void errorOccurred(const Bluez::Error &error);
+
 private slots:
     void onPropertiesChanged(const QString &interface, const QVariantMap &changedProperties, const QStringList &invalidatedProperties);
 
@@ -182,7 +187,6 @@ private slots:
 public slots:
     bool connectDevice();
     bool disconnectDevice();
-    bool disconnectDeviceBlocking();
     bool requestPairing();
     bool cancelPairingRequest();
 };
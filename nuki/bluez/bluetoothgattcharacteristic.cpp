@@ -30,7 +30,7 @@
 
 #include "bluetoothgattcharacteristic.h"
 
-#include <QDBusReply>
+#include <QDBusPendingReply>
 
 QString BluetoothGattCharacteristic::chararcteristicName() const
 {
@@ -88,13 +88,13 @@ BluetoothGattCharacteristic::BluetoothGattCharacteristic(const QDBusObjectPath &
     m_path(path),
     m_notifying(false)
 {
-    m_characteristicInterface = new QDBusInterface(orgBluez, m_path.path(), orgBluezGattCharacteristic1, QDBusConnection::systemBus(), this);
+    m_characteristicInterface = new BluezInterface(m_path.path(), orgBluezGattCharacteristic1, this);
     if (!m_characteristicInterface->isValid()) {
         qCWarning(dcBluez()) << "Invalid DBus characteristic interface for" << m_path.path();
         return;
     }
 
-    QDBusConnection::systemBus().connect(orgBluez, m_path.path(), "org.freedesktop.DBus.Properties", "PropertiesChanged", this, SLOT(onPropertiesChanged(QString,QVariantMap,QStringList)));
+    QDBusConnection::systemBus().connect(orgBluez, m_path.path(), orgFreedesktopDBusProperties, "PropertiesChanged", this, SLOT(onPropertiesChanged(QString,QVariantMap,QStringList)));
 
     processProperties(properties);
 }
@@ -220,6 +220,7 @@ void BluetoothGattCharacteristic::onReadingFinished(QDBusPendingCallWatcher *cal
     QDBusPendingReply<QByteArray> reply = *call;
     if (reply.isError()) {
         qCWarning(dcBluez()) << "Could not read characteristic" << m_uuid.toString() << reply.error().name() << reply.error().message();
+        emit errorOccurred(Bluez::errorFromDBusError(reply.error()));
     } else {
         QByteArray value = reply.argumentAt<0>();
         qCDebug(dcBluez()) << "Async reading finished for" << m_uuid.toString() << value;
@@ -235,6 +236,8 @@ void BluetoothGattCharacteristic::onWritingFinished(QDBusPendingCallWatcher *cal
     QDBusPendingReply<void> reply = *call;
     if (reply.isError()) {
         qCWarning(dcBluez()) << "Could not write characteristic" << m_uuid.toString() << reply.error().name() << reply.error().message();
+        emit errorOccurred(Bluez::errorFromDBusError(reply.error()));
+        m_asyncWrites.remove(call);
     } else {
         QByteArray value = m_asyncWrites.take(call);
         qCDebug(dcBluez()) << "Async characteristic writing finished for" << m_uuid.toString() << value;
@@ -247,8 +250,10 @@ void BluetoothGattCharacteristic::onWritingFinished(QDBusPendingCallWatcher *cal
 void BluetoothGattCharacteristic::onStartNotificationFinished(QDBusPendingCallWatcher *call)
 {
     QDBusPendingReply<void> reply = *call;
-    if (reply.isError())
+    if (reply.isError()) {
         qCWarning(dcBluez()) << "Could not start notifications on characteristic" << m_uuid.toString() << reply.error().name() << reply.error().message();
+        emit errorOccurred(Bluez::errorFromDBusError(reply.error()));
+    }
 
     call->deleteLater();
 }
@@ -256,8 +261,10 @@ void BluetoothGattCharacteristic::onStartNotificationFinished(QDBusPendingCallWa
 void BluetoothGattCharacteristic::onStopNotificationFinished(QDBusPendingCallWatcher *call)
 {
     QDBusPendingReply<void> reply = *call;
-    if (reply.isError())
+    if (reply.isError()) {
         qCWarning(dcBluez()) << "Could not stop notifications on characteristic" << m_uuid.toString() << reply.error().name() << reply.error().message();
+        emit errorOccurred(Bluez::errorFromDBusError(reply.error()));
+    }
 
     call->deleteLater();
 }
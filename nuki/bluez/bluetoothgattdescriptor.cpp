@@ -66,21 +66,16 @@ BluetoothGattDescriptor::BluetoothGattDescriptor(const QDBusObjectPath &path, co
     QObject(parent),
     m_path(path)
 {
-    m_descriptorInterface = new QDBusInterface(orgBluez, m_path.path(), orgBluezGattDescriptor1, QDBusConnection::systemBus(), this);
+    m_descriptorInterface = new BluezInterface(m_path.path(), orgBluezGattDescriptor1, this);
     if (!m_descriptorInterface->isValid()) {
         qCWarning(dcBluez()) << "Invalid DBus descriptor interface for" << m_path.path();
         return;
     }
 
-    QDBusConnection::systemBus().connect(orgBluez, m_path.path(), "org.freedesktop.DBus.Properties", "PropertiesChanged", this, SLOT(onPropertiesChanged(QString,QVariantMap,QStringList)));
+    QDBusConnection::systemBus().connect(orgBluez, m_path.path(), orgFreedesktopDBusProperties, "PropertiesChanged", this, SLOT(onPropertiesChanged(QString,QVariantMap,QStringList)));
 
+    // Note: the properties are taken from the ObjectManager snapshot, no need to query them again
     processProperties(properties);
-
-    QDBusPendingCall readingCall = m_descriptorInterface->asyncCall("GetAll", QVariantMap());
-    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(readingCall, this);
-    connect(watcher, &QDBusPendingCallWatcher::finished, this, [=](){
-        qCDebug(dcBluez()) << "Get descriptor properties finished";
-    });
 }
 
 void BluetoothGattDescriptor::processProperties(const QVariantMap &properties)
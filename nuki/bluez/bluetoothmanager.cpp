@@ -33,9 +33,11 @@
 #include <QDBusObjectPath>
 #include <QDBusArgument>
 #include <QDBusMetaType>
+#include <QDBusPendingReply>
 
 BluetoothManager::BluetoothManager(QObject *parent) :
     QObject(parent),
+    m_initWatcher(nullptr),
     m_available(false)
 {
     qDBusRegisterMetaType<InterfaceList>();
@@ -52,7 +54,7 @@ BluetoothManager::BluetoothManager(QObject *parent) :
     connect(m_serviceWatcher, &QDBusServiceWatcher::serviceRegistered, this, &BluetoothManager::serviceRegistered);
     connect(m_serviceWatcher, &QDBusServiceWatcher::serviceUnregistered, this, &BluetoothManager::serviceUnregistered);
 
-    m_objectManagerInterface = new QDBusInterface(orgBluez, "/", orgFreedesktopDBusObjectManager, QDBusConnection::systemBus(), this);
+    m_objectManagerInterface = new BluezInterface("/", orgFreedesktopDBusObjectManager, this);
     if (!m_objectManagerInterface->isValid()) {
         qCWarning(dcBluez()) << "Invalid DBus ObjectManager interface.";
         return;
@@ -74,23 +76,20 @@ bool BluetoothManager::isAvailable() const
     return m_available;
 }
 
+bool BluetoothManager::isInitializing() const
+{
+    return m_initWatcher != nullptr;
+}
+
 void BluetoothManager::init()
 {
-    // Get current object from org.bluez
-    QDBusMessage query = m_objectManagerInterface->call("GetManagedObjects");
-    if(query.type() != QDBusMessage::ReplyMessage) {
-        qCWarning(dcBluez()) << "Could not initialize BluetoothManager:" << query.errorName() << query.errorMessage();
+    if (m_initWatcher)
         return;
-    }
-
-    const QDBusArgument &argument = query.arguments().at(0).value<QDBusArgument>();
-    ManagedObjectList objectList = qdbus_cast<ManagedObjectList>(argument);
-    processObjectList(objectList);
-
-    if (!m_adapters.isEmpty())
-        setAvailable(true);
 
-    qCDebug(dcBluez()) << "BluetoothManager initialized successfully.";
+    // Get current object tree from org.bluez, further changes will arrive using InterfacesAdded/InterfacesRemoved
+    QDBusPendingCall getManagedObjectsCall = m_objectManagerInterface->asyncCall("GetManagedObjects");
+    m_initWatcher = new QDBusPendingCallWatcher(getManagedObjectsCall, this);
+    connect(m_initWatcher, &QDBusPendingCallWatcher::finished, this, &BluetoothManager::onGetManagedObjectsFinished);
 }
 
 void BluetoothManager::clean()
@@ -313,4 +312,34 @@ void BluetoothManager::onInterfaceRemoved(const QDBusObjectPath &objectPath, con
         }
     }
 
+    // GATT Service removed, characteristics and descriptors will be removed through parent relation
+    if (interfaces.contains(orgBluezGattService1)) {
+        BluetoothGattService *service = findService(objectPath);
+        if (service) {
+            BluetoothDevice *thing = static_cast<BluetoothDevice *>(service->parent());
+            thing->removeServiceInternally(objectPath);
+        }
+    }
+}
+
+void BluetoothManager::onGetManagedObjectsFinished(QDBusPendingCallWatcher *call)
+{
+    QDBusPendingReply<ManagedObjectList> reply = *call;
+    call->deleteLater();
+    m_initWatcher = nullptr;
+
+    if (reply.isError()) {
+        qCWarning(dcBluez()) << "Could not initialize BluetoothManager:" << reply.error().name() << reply.error().message();
+        emit initializationFinished();
+        return;
+    }
+
+    // Note: the object paths are sorted, so parent objects will always be created before their children
+    processObjectList(reply.value());
+
+    if (!m_adapters.isEmpty())
+        setAvailable(true);
+
+    qCDebug(dcBluez()) << "BluetoothManager initialized successfully.";
+    emit initializationFinished();
 }
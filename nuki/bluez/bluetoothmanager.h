@@ -33,10 +33,11 @@
 
 #include <QObject>
 #include <QDBusConnection>
-#include <QDBusInterface>
 #include <QDBusServiceWatcher>
+#include <QDBusPendingCallWatcher>
 
 #include "blueztypes.h"
+#include "bluezinterface.h"
 #include "bluetoothadapter.h"
 
 class BluetoothManager : public QObject
@@ -48,9 +49,11 @@ public:
     QList<BluetoothAdapter *> adapters() const;
 
     bool isAvailable() const;
+    bool isInitializing() const;
 
 private:
-    QDBusInterface *m_objectManagerInterface;
+    BluezInterface *m_objectManagerInterface;
+    QDBusPendingCallWatcher *m_initWatcher;
     QDBusServiceWatcher *m_serviceWatcher;
 
     QList<BluetoothAdapter *> m_adapters;
@@ -75,6 +78,7 @@ private:
 
 signals:
     void availableChanged(const bool &available);
+    void initializationFinished();
 
     void adapterAdded(BluetoothAdapter *adapter);
     void adapterRemoved(BluetoothAdapter *adapter);
@@ -85,6 +89,7 @@ private slots:
 
     void onInterfaceAdded(const QDBusObjectPath &objectPath, const InterfaceList &interfaceList);
     void onInterfaceRemoved(const QDBusObjectPath &objectPath, const QStringList &interfaces);
+    void onGetManagedObjectsFinished(QDBusPendingCallWatcher *call);
 
 public slots:
 
@@ -37,4 +37,56 @@ Bluez::Bluez()
 
 }
 
+Bluez::Error Bluez::errorFromDBusError(const QDBusError &error)
+{
+    if (!error.isValid())
+        return NoError;
+
+    // Note: bluez errors are reported as org.bluez.Error.<Name>
+    const QString errorName = error.name();
+    if (!errorName.startsWith("org.bluez.Error."))
+        return DBusError;
 
+    const QString name = errorName.mid(QString("org.bluez.Error.").length());
+    if (name == "NotReady") {
+        return NotReady;
+    } else if (name == "Failed") {
+        return Failed;
+    } else if (name == "Rejected") {
+        return Rejected;
+    } else if (name == "Canceled") {
+        return Canceled;
+    } else if (name == "InvalidArguments") {
+        return InvalidArguments;
+    } else if (name == "AlreadyExists") {
+        return AlreadyExists;
+    } else if (name == "DoesNotExist") {
+        return DoesNotExist;
+    } else if (name == "InProgress") {
+        return InProgress;
+    } else if (name == "NotInProgress") {
+        return NotInProgress;
+    } else if (name == "AlreadyConnected") {
+        return AlreadyConnected;
+    } else if (name == "ConnectFailed") {
+        return ConnectFailed;
+    } else if (name == "NotConnected") {
+        return NotConnected;
+    } else if (name == "NotSupported") {
+        return NotSupported;
+    } else if (name == "NotAuthorized") {
+        return NotAuthorized;
+    } else if (name == "AuthenticationCanceled") {
+        return AuthenticationCanceled;
+    } else if (name == "AuthenticationFailed") {
+        return AuthenticationFailed;
+    } else if (name == "AuthenticationRejected") {
+        return AuthenticationRejected;
+    } else if (name == "AuthenticationTimeout") {
+        return AuthenticationTimeout;
+    } else if (name == "ConnectionAttemptFailed") {
+        return ConnectionAttemptFailed;
+    }
+
+    return UnknownError;
+}
@@ -33,6 +33,7 @@
 
 #include <QDebug>
 #include <QString>
+#include <QDBusError>
 #include <QDBusArgument>
 #include <QDBusObjectPath>
 #include <QLoggingCategory>
@@ -40,6 +41,7 @@
 // Interfaces DBus
 static const QString orgFreedesktopDBus = QStringLiteral("org.freedesktop.DBus");
 static const QString orgFreedesktopDBusObjectManager = QStringLiteral("org.freedesktop.DBus.ObjectManager");
+static const QString orgFreedesktopDBusProperties = QStringLiteral("org.freedesktop.DBus.Properties");
 
 // Interfaces Bluez
 static const QString orgBluez = QStringLiteral("org.bluez");
@@ -106,6 +108,8 @@ public:
     Q_ENUM(Error)
 
     Bluez();
+
+    static Error errorFromDBusError(const QDBusError &error);
 };
 
 #endif // BLUEZTYPES_H
@@ -53,10 +53,25 @@ void IntegrationPluginNuki::init()
     m_refreshTimer = hardwareManager()->pluginTimerManager()->registerTimer(3600);
     connect(m_refreshTimer, &PluginTimer::timeout, this, &IntegrationPluginNuki::onRefreshTimeout);
 
-    // Bluetooth manager for BTLE bluez handling
+    if (sodium_init() < 0) {
+        qCCritical(dcNuki()) << "Could not initialize encryption library sodium";
+        m_encrytionLibraryInitialized = false;
+        return;
+    }
+
+    m_encrytionLibraryInitialized = true;
+    qCDebug(dcNuki()) << "Encryption library initialized successfully: libsodium" << sodium_version_string();
+
+    // Bluetooth manager for BTLE bluez handling, the object tree will be loaded asynchronously
     m_bluetoothManager = new BluetoothManager(this);
-    if (!m_bluetoothManager->isAvailable()) {
+    connect(m_bluetoothManager, &BluetoothManager::availableChanged, this, &IntegrationPluginNuki::onBluetoothManagerAvailableChanged);
+}
+
+void IntegrationPluginNuki::onBluetoothManagerAvailableChanged(bool available)
+{
+    if (!available) {
         qCWarning(dcNuki()) << "Bluetooth not available";
+        m_bluetoothAdapter = nullptr;
         return;
     }
 
@@ -71,15 +86,6 @@ void IntegrationPluginNuki::init()
     m_bluetoothAdapter->setPairable(true);
 
     qCDebug(dcNuki()) << "Using bluetooth adapter" << m_bluetoothAdapter;
-
-    if (sodium_init() < 0) {
-        qCCritical(dcNuki()) << "Could not initialize encryption library sodium";
-        m_encrytionLibraryInitialized = false;
-        return;
-    }
-
-    m_encrytionLibraryInitialized = true;
-    qCDebug(dcNuki()) << "Encryption library initialized successfully: libsodium" << sodium_version_string();
 }
 
 void IntegrationPluginNuki::setupThing(ThingSetupInfo *info)
@@ -93,6 +99,14 @@ void IntegrationPluginNuki::setupThing(ThingSetupInfo *info)
         return info->finish(Thing::ThingErrorThingInUse, QT_TR_NOOP("Device is already in use."));
     }
 
+    if (!m_bluetoothAdapter && m_bluetoothManager && m_bluetoothManager->isInitializing()) {
+        qCDebug(dcNuki()) << "Bluetooth manager not initialized yet. Continue setup once the bluez objects are loaded.";
+        connect(m_bluetoothManager, &BluetoothManager::initializationFinished, info, [this, info](){
+            setupThing(info);
+        });
+        return;
+    }
+
     if (!m_bluetoothAdapter){
         qCWarning(dcNuki()) << "No bluetooth adapter available";
         return info->finish(Thing::ThingErrorHardwareNotAvailable, QT_TR_NOOP("Bluetooth is not available on this system."));
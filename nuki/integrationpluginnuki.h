@@ -74,6 +74,7 @@ private:
 private slots:
     void onRefreshTimeout();
     void onBluetoothEnabledChanged(const bool &enabled);
+    void onBluetoothManagerAvailableChanged(bool available);
     void onBluetoothDiscoveryFinished(ThingDiscoveryInfo *info);
 
 };
@@ -11,6 +11,7 @@ HEADERS += \
     integrationpluginnuki.h \
     nuki.h \
     bluez/blueztypes.h \
+    bluez/bluezinterface.h \
     bluez/bluetoothmanager.h \
     bluez/bluetoothadapter.h \
     bluez/bluetoothdevice.h \
@@ -25,6 +26,7 @@ SOURCES += \
     integrationpluginnuki.cpp \
     nuki.cpp \
     bluez/blueztypes.cpp \
+    bluez/bluezinterface.cpp \
     bluez/bluetoothmanager.cpp \
     bluez/bluetoothadapter.cpp \
     bluez/bluetoothdevice.cpp \
@@ -44,11 +44,17 @@ extern "C" {
 #include <QSettings>
 #include <QDataStream>
 
+// Size of the encryption scratch buffers, they only grow for larger messages
+static const int scratchBufferSize = 512;
+
 NukiAuthenticator::NukiAuthenticator(const QBluetoothHostInfo &hostInfo, BluetoothGattCharacteristic *pairingCharacteristic, QObject *parent) :
     QObject(parent),
     m_hostInfo(hostInfo),
     m_pairingCharacteristic(pairingCharacteristic)
 {
+    // Note: the reserved capacity is kept when the buffers shrink, so messages are processed without allocations
+    m_encryptBuffer.reserve(scratchBufferSize);
+    m_decryptBuffer.reserve(scratchBufferSize);
 
 #ifdef QT_DEBUG
     // Enable full debug messages containing sensible data for debug builds
@@ -67,6 +73,11 @@ NukiAuthenticator::NukiAuthenticator(const QBluetoothHostInfo &hostInfo, Bluetoo
     connect(m_pairingCharacteristic, &BluetoothGattCharacteristic::valueChanged, this, &NukiAuthenticator::onPairingDataCharacteristicChanged);
 }
 
+NukiAuthenticator::~NukiAuthenticator()
+{
+    clearSharedKey();
+}
+
 NukiUtils::ErrorCode NukiAuthenticator::error() const
 {
     return m_error;
@@ -112,89 +123,95 @@ QByteArray NukiAuthenticator::authorizationIdRawData() const
     return m_authorizationIdRawData;
 }
 
-QByteArray NukiAuthenticator::encryptData(const QByteArray &data, const QByteArray &nonce)
+const QByteArray &NukiAuthenticator::encryptData(const QByteArray &data, const QByteArray &nonce)
 {
-    // Calculate shared key
     qCDebug(dcNuki()) << "Authenticator: Encrypt data";
     Q_ASSERT_X(nonce.length() == crypto_box_NONCEBYTES, "data length", "The nonce does not have the correct length.");
 
+    // The shared key will be calculated once per session, not for each message
+    m_encryptBuffer.resize(0);
+    if (m_sharedKey.isEmpty() && !calculateSharedKey())
+        return m_encryptBuffer;
+
     /* Note: https://download.libsodium.org/doc/public-key_cryptography/authenticated_encryption.html
      *      unsigned char *c         The encrypted message (length of the data + crypto_box_MACBYTES)
      *      const unsigned char *m   The message to encrypt
      *      unsigned long long mlen  The length of the message to encrypt
      *      const unsigned char *n   The nonce (must also sent unencrypted)
-     *      const unsigned char *pk  The public key of the Nuki
-     *      const unsigned char *sk  The private key of nymea for this Nuki
+     *      const unsigned char *k   The precalculated shared key (crypto_box_beforenm)
      */
 
-    unsigned char encrypted[crypto_box_MACBYTES + data.length()];
-    int result = crypto_box_easy(encrypted,
-                                 reinterpret_cast<const unsigned char *>(data.data()),
-                                 static_cast<unsigned long long>(data.length()),
-                                 reinterpret_cast<const unsigned char *>(nonce.data()),
-                                 reinterpret_cast<const unsigned char *>(m_publicKeyNuki.data()),
-                                 reinterpret_cast<const unsigned char *>(m_privateKey.data()));
+    m_encryptBuffer.resize(static_cast<int>(crypto_box_MACBYTES) + data.length());
+    int result = crypto_box_easy_afternm(reinterpret_cast<unsigned char *>(m_encryptBuffer.data()),
+                                         reinterpret_cast<const unsigned char *>(data.constData()),
+                                         static_cast<unsigned long long>(data.length()),
+                                         reinterpret_cast<const unsigned char *>(nonce.constData()),
+                                         reinterpret_cast<const unsigned char *>(m_sharedKey.constData()));
 
     if (result < 0) {
         qCWarning(dcNuki()) << "Could not encrypt data. Something went wrong";
-        return QByteArray();
+        m_encryptBuffer.resize(0);
+        return m_encryptBuffer;
     }
 
-    QByteArray encryptedData = QByteArray(reinterpret_cast<const char*>(encrypted), crypto_box_MACBYTES + data.length());
-
     if (m_debug) qCDebug(dcNuki()) << "    Private key     :" << NukiUtils::convertByteArrayToHexStringCompact(m_privateKey);
     if (m_debug) qCDebug(dcNuki()) << "    Public key      :" << NukiUtils::convertByteArrayToHexStringCompact(m_publicKey);
     if (m_debug) qCDebug(dcNuki()) << "    Nuki public key :" << NukiUtils::convertByteArrayToHexStringCompact(m_publicKeyNuki);
     if (m_debug) qCDebug(dcNuki()) << "    Unencrypted data:" << NukiUtils::convertByteArrayToHexStringCompact(data);
-    if (m_debug) qCDebug(dcNuki()) << "    Encrypted data  :" << NukiUtils::convertByteArrayToHexStringCompact(encryptedData);
+    if (m_debug) qCDebug(dcNuki()) << "    Encrypted data  :" << NukiUtils::convertByteArrayToHexStringCompact(m_encryptBuffer);
 
-    return encryptedData;
+    return m_encryptBuffer;
 }
 
-QByteArray NukiAuthenticator::decryptData(const QByteArray &data, const QByteArray &nonce)
+const QByteArray &NukiAuthenticator::decryptData(const QByteArray &data, const QByteArray &nonce)
 {
     qCDebug(dcNuki()) << "Authenticator: Decrypt data";
     Q_ASSERT_X(nonce.length() == crypto_box_NONCEBYTES, "data length", "The nonce does not have the correct length.");
-    Q_ASSERT_X(static_cast<uint>(data.length()) >= crypto_box_MACBYTES, "data length", "The encrypted data is to short.");
+
+    m_decryptBuffer.resize(0);
+    if (static_cast<uint>(data.length()) < crypto_box_MACBYTES) {
+        qCWarning(dcNuki()) << "Could not decrypt data. The encrypted data is to short.";
+        return m_decryptBuffer;
+    }
+
+    if (m_sharedKey.isEmpty() && !calculateSharedKey())
+        return m_decryptBuffer;
 
     /* Note: https://download.libsodium.org/doc/public-key_cryptography/authenticated_encryption.html
      *      unsigned char *m         The decrypted message result
      *      const unsigned char *c   The message to decrypt / cyphertext (length of the encrypted data + crypto_box_MACBYTES)
      *      unsigned long long clen  The length of the message to decrypt
      *      const unsigned char *n   The nonce used while encryption (received in the unencrypted ADATA)
-     *      const unsigned char *pk  The public key of the Nuki
-     *      const unsigned char *sk  The private key of nymea for this Nuki
+     *      const unsigned char *k   The precalculated shared key (crypto_box_beforenm)
      */
 
-    unsigned char decrypted[data.length() - crypto_box_MACBYTES];
-    int result = crypto_box_open_easy(decrypted,
-                                      reinterpret_cast<const unsigned char *>(data.data()),
-                                      static_cast<unsigned long long>(data.length()),
-                                      reinterpret_cast<const unsigned char *>(nonce.data()),
-                                      reinterpret_cast<const unsigned char *>(m_publicKeyNuki.data()),
-                                      reinterpret_cast<const unsigned char *>(m_privateKey.data()));
+    m_decryptBuffer.resize(data.length() - static_cast<int>(crypto_box_MACBYTES));
+    int result = crypto_box_open_easy_afternm(reinterpret_cast<unsigned char *>(m_decryptBuffer.data()),
+                                              reinterpret_cast<const unsigned char *>(data.constData()),
+                                              static_cast<unsigned long long>(data.length()),
+                                              reinterpret_cast<const unsigned char *>(nonce.constData()),
+                                              reinterpret_cast<const unsigned char *>(m_sharedKey.constData()));
 
     if (result < 0) {
         qCWarning(dcNuki()) << "Could not decrypt data. Something went wrong";
-        return QByteArray();
+        m_decryptBuffer.resize(0);
+        return m_decryptBuffer;
     }
 
-    QByteArray decryptedData = QByteArray(reinterpret_cast<const char*>(decrypted), data.length() - crypto_box_MACBYTES);
-
     if (m_debug) qCDebug(dcNuki()) << "    Private key     :" << NukiUtils::convertByteArrayToHexStringCompact(m_privateKey);
     if (m_debug) qCDebug(dcNuki()) << "    Public key      :" << NukiUtils::convertByteArrayToHexStringCompact(m_publicKey);
     if (m_debug) qCDebug(dcNuki()) << "    Nuki public key :" << NukiUtils::convertByteArrayToHexStringCompact(m_publicKeyNuki);
     if (m_debug) qCDebug(dcNuki()) << "    Encrypted data  :" << NukiUtils::convertByteArrayToHexStringCompact(data);
-    if (m_debug) qCDebug(dcNuki()) << "    Decrypted data  :" << NukiUtils::convertByteArrayToHexStringCompact(decryptedData);
+    if (m_debug) qCDebug(dcNuki()) << "    Decrypted data  :" << NukiUtils::convertByteArrayToHexStringCompact(m_decryptBuffer);
 
-    return decryptedData;
+    return m_decryptBuffer;
 }
 
 QByteArray NukiAuthenticator::generateNonce(const int &length) const
 {
-    unsigned char nounce[length];
-    randombytes_buf(nounce, length);
-    return QByteArray(reinterpret_cast<const char *>(nounce), length);
+    QByteArray nonce(length, Qt::Uninitialized);
+    randombytes_buf(nonce.data(), static_cast<size_t>(length));
+    return nonce;
 }
 
 void NukiAuthenticator::setState(NukiAuthenticator::AuthenticationState state)
@@ -258,19 +275,46 @@ void NukiAuthenticator::setState(NukiAuthenticator::AuthenticationState state)
     }
 }
 
-bool NukiAuthenticator::createAuthenticator(const QByteArray content)
+bool NukiAuthenticator::calculateSharedKey()
 {
-    // Create shared key
     qCDebug(dcNuki()) << "Authenticator: Calculate shared key";
-    unsigned char sharedKey[crypto_box_BEFORENMBYTES];
-    int result = crypto_box_beforenm(sharedKey, reinterpret_cast<const unsigned char *>(m_publicKeyNuki.data()), reinterpret_cast<const unsigned char *>(m_privateKey.data()));
+    if (m_privateKey.length() != crypto_box_SECRETKEYBYTES || m_publicKeyNuki.length() != crypto_box_PUBLICKEYBYTES) {
+        qCWarning(dcNuki()) << "Could not calculate shared key. The key pair is not available.";
+        clearSharedKey();
+        return false;
+    }
+
+    QByteArray sharedKey(crypto_box_BEFORENMBYTES, Qt::Uninitialized);
+    int result = crypto_box_beforenm(reinterpret_cast<unsigned char *>(sharedKey.data()),
+                                     reinterpret_cast<const unsigned char *>(m_publicKeyNuki.constData()),
+                                     reinterpret_cast<const unsigned char *>(m_privateKey.constData()));
     if (result < 0) {
-        qCWarning(dcNuki()) << "Could not create shared key for autorization authenticator.";
+        qCWarning(dcNuki()) << "Could not calculate shared key. Something went wrong";
+        clearSharedKey();
         return false;
     }
 
-    m_sharedKey = QByteArray(reinterpret_cast<const char*>(sharedKey), crypto_box_BEFORENMBYTES);
-    Q_ASSERT_X(m_sharedKey.length() == 32, "data length", "The shared key does not have the correct length.");
+    clearSharedKey();
+    m_sharedKey = sharedKey;
+    return true;
+}
+
+void NukiAuthenticator::clearSharedKey()
+{
+    if (m_sharedKey.isEmpty())
+        return;
+
+    sodium_memzero(m_sharedKey.data(), static_cast<size_t>(m_sharedKey.length()));
+    m_sharedKey.clear();
+}
+
+bool NukiAuthenticator::createAuthenticator(const QByteArray content)
+{
+    // Create shared key
+    if (!calculateSharedKey()) {
+        qCWarning(dcNuki()) << "Could not create shared key for autorization authenticator.";
+        return false;
+    }
 
     if (m_debug) qCDebug(dcNuki()) << "Authenticator: Calculate authenticator hash HMAC-SHA-256";
     if (m_debug) qCDebug(dcNuki()) << "    Shared key      :" << NukiUtils::convertByteArrayToHexStringCompact(m_sharedKey);
@@ -279,7 +323,7 @@ bool NukiAuthenticator::createAuthenticator(const QByteArray content)
     // Calculate authenticator hash input for HMAC-SHA-256
     qCDebug(dcNuki()) << "Authenticator: Calculate authenticator data";
     unsigned char authenticator[crypto_auth_hmacsha256_BYTES];
-    result = crypto_auth_hmacsha256(authenticator, reinterpret_cast<const unsigned char *>(content.data()), content.length(), reinterpret_cast<const unsigned char *>(m_sharedKey.data()));
+    int result = crypto_auth_hmacsha256(authenticator, reinterpret_cast<const unsigned char *>(content.data()), content.length(), reinterpret_cast<const unsigned char *>(m_sharedKey.data()));
     if (result < 0) {
         qCWarning(dcNuki()) << "Could not create authenticator hash for autorization authenticator.";
         return false;
@@ -319,6 +363,7 @@ void NukiAuthenticator::generateKeyPair()
     crypto_box_keypair(publicKey, secretKey);
     m_publicKey = QByteArray(reinterpret_cast<const char *>(publicKey), crypto_box_PUBLICKEYBYTES);
     m_privateKey = QByteArray(reinterpret_cast<const char *>(secretKey), crypto_box_SECRETKEYBYTES);
+    clearSharedKey();
 
     if (m_debug) qCDebug(dcNuki()) << "    Private key     :" << NukiUtils::convertByteArrayToHexStringCompact(m_privateKey);
     if (m_debug) qCDebug(dcNuki()) << "    Public key      :" << NukiUtils::convertByteArrayToHexStringCompact(m_publicKey);
@@ -446,6 +491,9 @@ void NukiAuthenticator::loadData()
     m_uuid = setting.value("uuid", QByteArray()).toByteArray();
     setting.endGroup();
 
+    // Keys might have changed, the shared key will be calculated on the next encryption
+    clearSharedKey();
+
     qCDebug(dcNuki()) << "Authenticator: Settings loaded from" << setting.fileName();
 }
 
@@ -485,6 +533,7 @@ void NukiAuthenticator::onPairingDataCharacteristicChanged(const QByteArray &val
 
         qCDebug(dcNuki()) << "Authenticator: Nuki public key message received" << (m_debug ? NukiUtils::convertByteArrayToHexStringCompact(m_currentReceivingData) : "");
         m_publicKeyNuki = m_currentReceivingData.mid(2, 32);
+        clearSharedKey();
         if (m_debug) qCDebug(dcNuki()) << "Authenticator: --> Nuki public key:" <<   NukiUtils::convertByteArrayToHexStringCompact(m_publicKeyNuki);
 
         setState(AuthenticationStateGenerateKeyPair);
@@ -60,6 +60,7 @@ public:
     Q_ENUM(AuthenticationState)
 
     explicit NukiAuthenticator(const QBluetoothHostInfo &hostInfo, BluetoothGattCharacteristic *pairingCharacteristic, QObject *parent = nullptr);
+    ~NukiAuthenticator();
 
     NukiUtils::ErrorCode error() const;
     AuthenticationState state() const;
@@ -73,8 +74,9 @@ public:
     quint32 authorizationId() const;
     QByteArray authorizationIdRawData() const;
 
-    QByteArray encryptData(const QByteArray &data, const QByteArray &nonce);
-    QByteArray decryptData(const QByteArray &data, const QByteArray &nonce);
+    // The returned data is kept in a buffer of the authenticator and valid until the next call
+    const QByteArray &encryptData(const QByteArray &data, const QByteArray &nonce);
+    const QByteArray &decryptData(const QByteArray &data, const QByteArray &nonce);
 
     // Generate 32 byte nonce data
     QByteArray generateNonce(const int &length = 32) const;
@@ -98,6 +100,10 @@ private:
     QByteArray m_privateKey;
     QByteArray m_publicKey;
     QByteArray m_sharedKey;
+
+    // Reused for every message, allocated once with the maximum message size
+    QByteArray m_encryptBuffer;
+    QByteArray m_decryptBuffer;
     QByteArray m_authenticator;
     QByteArray m_nonce;
     QByteArray m_uuid;
@@ -112,6 +118,8 @@ private:
     void setState(AuthenticationState state);
 
     // Helper methods
+    bool calculateSharedKey();
+    void clearSharedKey();
     bool createAuthenticator(const QByteArray content);
 
     // State action methods
@@ -282,7 +282,7 @@ void NukiController::processNukiErrorReport(const QByteArray &data)
 
 void NukiController::processUserDataNotification(const QByteArray nonce, quint32 authorizationIdentifier, const QByteArray &privateData)
 {
-    QByteArray decryptedMessage = m_nukiAuthenticator->decryptData(privateData, nonce);
+    const QByteArray &decryptedMessage = m_nukiAuthenticator->decryptData(privateData, nonce);
 
     // Process decrypted data
     if (!NukiUtils::validateMessageCrc(decryptedMessage)) {
@@ -450,7 +450,7 @@ void NukiController::sendReadLockStateRequest()
 
     // Encrypt PDATA
     QByteArray nonce = m_nukiAuthenticator->generateNonce(crypto_box_NONCEBYTES);
-    QByteArray encryptedMessage = m_nukiAuthenticator->encryptData(unencryptedMessage, nonce);
+    const QByteArray &encryptedMessage = m_nukiAuthenticator->encryptData(unencryptedMessage, nonce);
 
     // Create ADATA
     QByteArray header;
@@ -489,7 +489,7 @@ void NukiController::sendReadConfigurationRequest()
 
     // Encrypt PDATA
     QByteArray nonce = m_nukiAuthenticator->generateNonce(crypto_box_NONCEBYTES);
-    QByteArray encryptedMessage = m_nukiAuthenticator->encryptData(unencryptedMessage, nonce);
+    const QByteArray &encryptedMessage = m_nukiAuthenticator->encryptData(unencryptedMessage, nonce);
 
     // Create ADATA
     QByteArray header;
@@ -525,7 +525,7 @@ void NukiController::sendRequestChallengeRequest()
 
     // Encrypt PDATA
     QByteArray nonce = m_nukiAuthenticator->generateNonce(crypto_box_NONCEBYTES);
-    QByteArray encryptedMessage = m_nukiAuthenticator->encryptData(unencryptedMessage, nonce);
+    const QByteArray &encryptedMessage = m_nukiAuthenticator->encryptData(unencryptedMessage, nonce);
 
     // Create ADATA
     QByteArray header;
@@ -568,7 +568,7 @@ void NukiController::sendLockActionRequest(NukiUtils::LockAction lockAction, qui
     QByteArray unencryptedMessage = NukiUtils::createRequestMessageForUnencryptedForEncryption(m_nukiAuthenticator->authorizationId(), NukiUtils::CommandLockAction, payload);
 
     // Encrypt PDATA
-    QByteArray encryptedMessage = m_nukiAuthenticator->encryptData(unencryptedMessage, nonce);
+    const QByteArray &encryptedMessage = m_nukiAuthenticator->encryptData(unencryptedMessage, nonce);
 
     // Create ADATA
     QByteArray header;
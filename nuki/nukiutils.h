@@ -186,6 +186,7 @@ public:
 
     // Crc calculation
     static quint16 calculateCrc(const QByteArray &data);
+    static quint16 calculateCrc(const char *data, int length);
     static bool validateMessageCrc(const QByteArray &message);
 
     // Message helper
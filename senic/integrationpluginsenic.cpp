@@ -42,6 +42,8 @@ void IntegrationPluginSenic::init()
 {
     // Initialize plugin configurations
     m_autoSymbolMode = configValue(senicPluginAutoSymbolsParamTypeId).toBool();
+    // Note: the connection limit is shared by all bluetooth plugins, show the current global value
+    setConfigValue(senicPluginMaxConnectionsParamTypeId, BluetoothConnectionLease::maximumConnections(hardwareManager()->bluetoothLowEnergyManager()));
     connect(this, &IntegrationPluginSenic::configValueChanged, this, &IntegrationPluginSenic::onPluginConfigurationChanged);
 }
 
@@ -108,6 +110,10 @@ void IntegrationPluginSenic::setupThing(ThingSetupInfo *info)
     connect(nuimo, &Nuimo::batteryValueChanged, this, &IntegrationPluginSenic::onBatteryValueChanged);
 
     m_nuimos.insert(nuimo, thing);
+    // The buttons and the wheel are reported by notifications, keep the Nuimo connected
+    BluetoothConnectionLease *connectionLease = new BluetoothConnectionLease(hardwareManager()->bluetoothLowEnergyManager(), bluetoothDevice, nuimo);
+    connectionLease->setRotatable(false);
+    m_connectionLeases.insert(nuimo, connectionLease);
 
     connect(nuimo, &Nuimo::deviceInitializationFinished, info, [this, info, nuimo](bool success){
         Thing *thing = info->thing();
@@ -117,6 +123,7 @@ void IntegrationPluginSenic::setupThing(ThingSetupInfo *info)
                 info->finish(Thing::ThingErrorNoError);
             } else {
                 m_nuimos.take(nuimo);
+                m_connectionLeases.take(nuimo)->release();
 
                 hardwareManager()->bluetoothLowEnergyManager()->unregisterDevice(nuimo->bluetoothDevice());
                 nuimo->deleteLater();
@@ -127,8 +134,8 @@ void IntegrationPluginSenic::setupThing(ThingSetupInfo *info)
 
     });
 
-
-    nuimo->bluetoothDevice()->connectDevice();
+    // Setup waits for the connection, so this is handled like a user action
+    m_connectionLeases.value(nuimo)->request(BluetoothConnectionLease::PriorityUserAction);
 }
 
 void IntegrationPluginSenic::postSetupThing(Thing *thing)
@@ -196,6 +203,7 @@ void IntegrationPluginSenic::thingRemoved(Thing *thing)
 
     Nuimo *nuimo = m_nuimos.key(thing);
     m_nuimos.take(nuimo);
+    m_connectionLeases.take(nuimo)->release();
 
     hardwareManager()->bluetoothLowEnergyManager()->unregisterDevice(nuimo->bluetoothDevice());
     nuimo->deleteLater();
@@ -211,7 +219,7 @@ void IntegrationPluginSenic::onReconnectTimeout()
 {
     foreach (Nuimo *nuimo, m_nuimos.keys()) {
         if (!nuimo->bluetoothDevice()->connected()) {
-            nuimo->bluetoothDevice()->connectDevice();
+            m_connectionLeases.value(nuimo)->request(BluetoothConnectionLease::PriorityPersistent);
         }
     }
 }
@@ -322,6 +330,10 @@ void IntegrationPluginSenic::onPluginConfigurationChanged(const ParamTypeId &par
             nuimo->setLongPressTime(value.toInt());
         }
     }
+
+    if (paramTypeId == senicPluginMaxConnectionsParamTypeId) {
+        BluetoothConnectionLease::setMaximumConnections(hardwareManager()->bluetoothLowEnergyManager(), value.toInt());
+    }
 }
 
 void IntegrationPluginSenic::onBatteryValueChanged(const uint &percentage)
@@ -36,6 +36,7 @@
 #include "hardware/bluetoothlowenergy/bluetoothlowenergydevice.h"
 
 #include "nuimo.h"
+#include "bluetoothconnectionlease.h"
 
 class IntegrationPluginSenic : public IntegrationPlugin
 {
@@ -57,6 +58,7 @@ public:
 
 private:
     QHash<Nuimo *, Thing *> m_nuimos;
+    QHash<Nuimo *, BluetoothConnectionLease *> m_connectionLeases;
     PluginTimer *m_reconnectTimer = nullptr;
     bool m_autoSymbolMode = true;
 
@@ -31,6 +31,9 @@
 #include "integrationpluginserialportcommander.h"
 #include "plugininfo.h"
 
+#include <QRegExp>
+#include <QtMath>
+
 IntegrationPluginSerialPortCommander::IntegrationPluginSerialPortCommander()
 {
 }
@@ -117,6 +120,19 @@ void IntegrationPluginSerialPortCommander::setupThing(ThingSetupInfo *info)
         connect(serialPort, SIGNAL(stopBitsChanged(QSerialPort::StopBits)), this, SLOT(onStopBitsChanged(QSerialPort::StopBits)));
         connect(serialPort, SIGNAL(flowControlChanged(QSerialPort::FlowControl)), this, SLOT(onFlowControlChanged(QSerialPort::FlowControl)));
         m_serialPorts.insert(thing, serialPort);
+
+        StreamFramer *framer = new StreamFramer(framingSettings(thing), serialPort);
+        connect(framer, &StreamFramer::frameReceived, thing, [this, thing](const QByteArray &frame){
+            onFrameReceived(thing, frame);
+        });
+        connect(framer, &StreamFramer::framingError, thing, [](const QString &error){
+            qCWarning(dcSerialPortCommander()) << "Discarding the received data:" << error;
+        });
+        connect(thing, &Thing::settingChanged, framer, [this, thing, framer](){
+            framer->setSettings(framingSettings(thing));
+        });
+        m_framers.insert(thing, framer);
+
         thing->setStateValue(serialPortCommanderConnectedStateTypeId, true);
     }
     return info->finish(Thing::ThingErrorNoError);
@@ -131,12 +147,27 @@ void IntegrationPluginSerialPortCommander::executeAction(ThingActionInfo *info)
 
     if (action.actionTypeId() == serialPortCommanderTriggerActionTypeId) {
 
-        QSerialPort *serialPort = m_serialPorts.value(thing);
-        qint64 size = serialPort->write(action.param(serialPortCommanderTriggerActionOutputDataParamTypeId).value().toByteArray());
-        if(size != action.param(serialPortCommanderTriggerActionOutputDataParamTypeId).value().toByteArray().length()) {
-            return info->finish(Thing::ThingErrorHardwareFailure, QT_TR_NOOP("Error writing to serial port."));
+        QString outputData = action.param(serialPortCommanderTriggerActionOutputDataParamTypeId).value().toString();
+        QByteArray data;
+        if (thing->setting(serialPortCommanderSettingsDataFormatParamTypeId).toString() == "Hex") {
+            outputData.remove(QRegExp("\\s"));
+            if (outputData.length() % 2 != 0 || !QRegExp("[0-9a-fA-F]*").exactMatch(outputData)) {
+                return info->finish(Thing::ThingErrorInvalidParameter, QT_TR_NOOP("The data is not a valid hex string."));
+            }
+            data = QByteArray::fromHex(outputData.toLatin1());
+        } else {
+            data = outputData.toUtf8();
+        }
+
+        // Everything sent within one event loop run is written in one go
+        if (m_pendingWriteActions.value(thing).isEmpty()) {
+            QTimer::singleShot(0, this, [this, thing](){
+                writePendingData(thing);
+            });
         }
-        return info->finish(Thing::ThingErrorNoError);
+        m_pendingWrites[thing].append(data);
+        m_pendingWriteActions[thing].append(info);
+        return;
     }
     info->finish(Thing::ThingErrorActionTypeNotFound);
 }
@@ -147,6 +178,9 @@ void IntegrationPluginSerialPortCommander::thingRemoved(Thing *thing)
     if (thing->thingClassId() == serialPortCommanderThingClassId) {
 
         QSerialPort *serialPort = m_serialPorts.take(thing);
+        m_framers.remove(thing);
+        m_pendingWrites.remove(thing);
+        m_pendingWriteActions.remove(thing);
         if (serialPort) {
             if (serialPort->isOpen()){
                 serialPort->flush();
@@ -166,12 +200,23 @@ void IntegrationPluginSerialPortCommander::onReadyRead()
 {
     QSerialPort *serialPort =  static_cast<QSerialPort*>(sender());
     Thing *thing = m_serialPorts.key(serialPort);
+    StreamFramer *framer = m_framers.value(thing);
+    if (!framer)
+        return;
 
-    QByteArray data;
-    while (!serialPort->atEnd()) {
-        data.append(serialPort->read(100));
+    framer->addData(serialPort->readAll());
+}
+
+void IntegrationPluginSerialPortCommander::onFrameReceived(Thing *thing, const QByteArray &frame)
+{
+    qDebug(dcSerialPortCommander()) << "Message received" << frame;
+
+    QString data;
+    if (thing->setting(serialPortCommanderSettingsDataFormatParamTypeId).toString() == "Hex") {
+        data = QString::fromLatin1(frame.toHex(' '));
+    } else {
+        data = QString::fromUtf8(frame);
     }
-    qDebug(dcSerialPortCommander()) << "Message received" << data;
 
     Event event(serialPortCommanderTriggeredEventTypeId, thing->id());
     ParamList parameters;
@@ -180,6 +225,62 @@ void IntegrationPluginSerialPortCommander::onReadyRead()
     emitEvent(event);
 }
 
+void IntegrationPluginSerialPortCommander::writePendingData(Thing *thing)
+{
+    QSerialPort *serialPort = m_serialPorts.value(thing);
+    if (!serialPort)
+        return;
+
+    QByteArray data = m_pendingWrites.take(thing);
+    QList<QPointer<ThingActionInfo> > actions = m_pendingWriteActions.take(thing);
+    qint64 size = serialPort->isOpen() ? serialPort->write(data) : -1;
+    foreach (QPointer<ThingActionInfo> info, actions) {
+        if (info.isNull())
+            continue;
+
+        if (size != data.length()) {
+            info->finish(Thing::ThingErrorHardwareFailure, QT_TR_NOOP("Error writing to serial port."));
+        } else {
+            info->finish(Thing::ThingErrorNoError);
+        }
+    }
+}
+
+// 3.5 character times like Modbus RTU, in milliseconds
+static int characterTimeout(int baudRate, int dataBits, bool parity, int stopBits)
+{
+    if (baudRate <= 0)
+        return 5;
+
+    // Above 19200 baud Modbus uses a fixed 1.75 ms
+    if (baudRate > 19200)
+        return 2;
+
+    int bitsPerCharacter = 1 + dataBits + (parity ? 1 : 0) + stopBits;
+    return qMax(2, qCeil(3.5 * bitsPerCharacter * 1000.0 / baudRate));
+}
+
+StreamFramer::Settings IntegrationPluginSerialPortCommander::framingSettings(Thing *thing) const
+{
+    StreamFramer::Settings settings;
+    settings.mode = StreamFramer::modeFromString(thing->setting(serialPortCommanderSettingsFramingParamTypeId).toString());
+    settings.delimiter = StreamFramer::unescape(thing->setting(serialPortCommanderSettingsDelimiterParamTypeId).toString());
+    settings.frameLength = thing->setting(serialPortCommanderSettingsFrameLengthParamTypeId).toInt();
+    settings.lengthFieldOffset = thing->setting(serialPortCommanderSettingsLengthFieldOffsetParamTypeId).toInt();
+    settings.lengthFieldSize = thing->setting(serialPortCommanderSettingsLengthFieldSizeParamTypeId).toInt();
+    settings.lengthAdjustment = thing->setting(serialPortCommanderSettingsLengthAdjustmentParamTypeId).toInt();
+
+    settings.idleTimeout = thing->setting(serialPortCommanderSettingsTimeoutParamTypeId).toInt();
+    if (settings.idleTimeout == 0) {
+        bool parity = !thing->paramValue(serialPortCommanderThingParityParamTypeId).toString().contains("No");
+        int stopBits = thing->paramValue(serialPortCommanderThingStopBitsParamTypeId).toInt() == QSerialPort::TwoStop ? 2 : 1;
+        settings.idleTimeout = characterTimeout(thing->paramValue(serialPortCommanderThingBaudRateParamTypeId).toInt(),
+                                                thing->paramValue(serialPortCommanderThingDataBitsParamTypeId).toInt(),
+                                                parity, stopBits);
+    }
+    return settings;
+}
+
 void IntegrationPluginSerialPortCommander::onSerialError(QSerialPort::SerialPortError error)
 {
     QSerialPort *serialPort =  static_cast<QSerialPort*>(sender());
@@ -189,6 +290,7 @@ void IntegrationPluginSerialPortCommander::onSerialError(QSerialPort::SerialPort
         qCCritical(dcSerialPortCommander()) << "Serial port error:" << error << serialPort->errorString();
         m_reconnectTimer->start();
         serialPort->close();
+        m_framers.value(thing)->clear();
         thing->setStateValue(serialPortCommanderConnectedStateTypeId, false);
     }
 }
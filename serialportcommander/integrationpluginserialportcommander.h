@@ -32,10 +32,12 @@
 #define INTEGRATIONPLUGINSERIALPORTCOMMANDER_H
 
 #include "integrations/integrationplugin.h"
+#include "streamframer.h"
 
 #include <QTimer>
 #include <QSerialPort>
 #include <QSerialPortInfo>
+#include <QPointer>
 
 class IntegrationPluginSerialPortCommander : public IntegrationPlugin
 {
@@ -55,6 +57,14 @@ public:
 private:
     QTimer *m_reconnectTimer = nullptr;
     QHash<Thing *, QSerialPort *> m_serialPorts;
+    QHash<Thing *, StreamFramer *> m_framers;
+
+    QHash<Thing *, QByteArray> m_pendingWrites;
+    QHash<Thing *, QList<QPointer<ThingActionInfo> > > m_pendingWriteActions;
+
+    StreamFramer::Settings framingSettings(Thing *thing) const;
+    void onFrameReceived(Thing *thing, const QByteArray &frame);
+    void writePendingData(Thing *thing);
 
 private slots:
     void onReadyRead();
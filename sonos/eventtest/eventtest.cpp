@@ -0,0 +1,173 @@
+#include <QCoreApplication>
+
+#include <QDebug>
+#include <QTimer>
+#include <QEventLoop>
+#include <QTcpSocket>
+
+#include "sonoseventserver.h"
+
+// Stands in for a speaker sending UPnP GENA NOTIFY requests to the event server and checks the
+// responses, the delivered notifications and when connections get closed.
+// Usage: eventtest
+
+Q_LOGGING_CATEGORY(dcSonos, "Sonos")
+
+struct Exchange {
+    QList<QByteArray> statusCodes;
+    QList<QPair<QByteArray, QByteArray> > notifications;
+    bool closed = false;
+};
+
+static int failures = 0;
+
+static void check(bool condition, const QString &what)
+{
+    if (!condition) {
+        qWarning().noquote() << "FAILED:" << what;
+        failures++;
+    }
+}
+
+static void wait(int milliseconds)
+{
+    QEventLoop loop;
+    QTimer::singleShot(milliseconds, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+static QByteArray notify(const QByteArray &sid, const QByteArray &body, const QByteArray &extraHeaders = QByteArray())
+{
+    QByteArray request = "NOTIFY /RINCON_000E58A0B1C201400/MediaRenderer/AVTransport/Event HTTP/1.1\r\n";
+    request.append("HOST: 127.0.0.1\r\n");
+    request.append("CONTENT-TYPE: text/xml; charset=\"utf-8\"\r\n");
+    request.append("NT: upnp:event\r\n");
+    request.append("NTS: upnp:propchange\r\n");
+    if (!sid.isEmpty()) {
+        request.append("SID: " + sid + "\r\n");
+    }
+    request.append("SEQ: 0\r\n");
+    request.append(extraHeaders);
+    request.append("CONTENT-LENGTH: " + QByteArray::number(body.size()) + "\r\n\r\n");
+    request.append(body);
+    return request;
+}
+
+static Exchange exchange(SonosEventServer *server, const QList<QByteArray> &segments, const QHostAddress &localAddress = QHostAddress::LocalHost)
+{
+    Exchange result;
+    QMetaObject::Connection notificationConnection = QObject::connect(server, &SonosEventServer::notificationReceived, [&result](const QByteArray &sid, const QByteArray &body){
+        result.notifications.append(qMakePair(sid, body));
+    });
+
+    QTcpSocket socket;
+    socket.bind(localAddress);
+    socket.connectToHost(QHostAddress::LocalHost, server->serverPort());
+
+    QEventLoop loop;
+    QObject::connect(&socket, &QTcpSocket::connected, &loop, &QEventLoop::quit);
+    QTimer::singleShot(2000, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    foreach (const QByteArray &segment, segments) {
+        socket.write(segment);
+        socket.flush();
+        wait(5);
+    }
+    wait(200);
+
+    // All responses of the server are header only
+    QByteArray data = socket.readAll();
+    foreach (const QByteArray &response, data.split('\n')) {
+        if (response.startsWith("HTTP/1.1 ")) {
+            result.statusCodes.append(response.mid(9, 3));
+        }
+    }
+
+    result.closed = socket.state() == QAbstractSocket::UnconnectedState;
+    QObject::disconnect(notificationConnection);
+    return result;
+}
+
+static QList<QByteArray> split(const QByteArray &data, int segmentSize)
+{
+    QList<QByteArray> segments;
+    for (int i = 0; i < data.size(); i += segmentSize) {
+        segments.append(data.mid(i, segmentSize));
+    }
+    return segments;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+    QLoggingCategory::setFilterRules("Sonos.debug=false\nSonos.warning=false");
+
+    SonosEventServer server;
+    if (!server.startServer()) {
+        qWarning() << "Could not start the event server";
+        return 1;
+    }
+    server.addSpeaker(QHostAddress::LocalHost);
+
+    const QByteArray sid = "uuid:RINCON_000E58A0B1C201400_sub0000000123";
+    const QByteArray body = "<e:propertyset xmlns:e=\"urn:schemas-upnp-org:event-1-0\"><e:property><LastChange>"
+                            "&lt;Event&gt;&lt;InstanceID val=&quot;0&quot;&gt;&lt;TransportState val=&quot;PLAYING&quot;/&gt;"
+                            "&lt;/InstanceID&gt;&lt;/Event&gt;</LastChange></e:property></e:propertyset>";
+
+    Exchange result = exchange(&server, {notify(sid, body)});
+    check(result.statusCodes == QList<QByteArray>({"200"}), "single notification is accepted");
+    check(result.notifications.count() == 1 && result.notifications.first() == qMakePair(sid, body), "single notification is delivered");
+    check(!result.closed, "keep-alive connection stays open");
+
+    result = exchange(&server, split(notify(sid, body), 7));
+    check(result.statusCodes == QList<QByteArray>({"200"}), "notification split across segments is accepted");
+    check(result.notifications.count() == 1 && result.notifications.first().second == body, "split notification is delivered complete");
+
+    result = exchange(&server, {notify(sid, "first") + notify(sid, "second")});
+    check(result.statusCodes == QList<QByteArray>({"200", "200"}), "pipelined notifications are accepted");
+    check(result.notifications.count() == 2 && result.notifications.at(0).second == "first" && result.notifications.at(1).second == "second", "pipelined notifications are delivered in order");
+
+    QByteArray chunked = notify(sid, QByteArray()).replace("CONTENT-LENGTH: 0\r\n", "TRANSFER-ENCODING: chunked\r\n");
+    chunked.append("5\r\nfirst\r\n6\r\nsecond\r\n0\r\n\r\n");
+    result = exchange(&server, split(chunked, 11));
+    check(result.statusCodes == QList<QByteArray>({"200"}), "chunked notification is accepted");
+    check(result.notifications.count() == 1 && result.notifications.first().second == "firstsecond", "chunked notification is delivered complete");
+
+    QByteArray negativeLength = notify(sid, QByteArray()).replace("CONTENT-LENGTH: 0", "CONTENT-LENGTH: -5");
+    result = exchange(&server, {negativeLength + notify(sid, body)});
+    check(result.statusCodes == QList<QByteArray>({"400"}), "negative content length is rejected");
+    check(result.notifications.isEmpty() && result.closed, "connection with negative content length is closed");
+
+    result = exchange(&server, {notify(QByteArray(), body) + notify(sid, body)});
+    check(result.statusCodes == QList<QByteArray>({"412", "200"}), "notification without SID is rejected");
+    check(result.notifications.count() == 1, "notification without SID is not delivered");
+
+    QByteArray subscribe = notify(sid, body).replace("NOTIFY ", "SUBSCRIBE ");
+    result = exchange(&server, {subscribe});
+    check(result.statusCodes == QList<QByteArray>({"412"}) && result.notifications.isEmpty(), "other methods are rejected");
+
+    result = exchange(&server, {notify(sid, body, "CONNECTION: close\r\n")});
+    check(result.statusCodes == QList<QByteArray>({"200"}) && result.notifications.count() == 1, "notification with connection close is accepted");
+    check(result.closed, "connection close is honoured");
+
+    result = exchange(&server, split(notify(sid, QByteArray(600 * 1024, 'x')), 64 * 1024));
+    check(result.statusCodes == QList<QByteArray>({"413"}) && result.notifications.isEmpty(), "oversized notification is rejected");
+    check(result.closed, "connection with oversized notification is closed");
+
+    result = exchange(&server, {notify(sid, body)}, QHostAddress("127.0.0.2"));
+    check(result.statusCodes.isEmpty() && result.notifications.isEmpty(), "unknown address is not served");
+    check(result.closed, "connection from unknown address is closed");
+
+    server.removeSpeaker(QHostAddress::LocalHost);
+    result = exchange(&server, {notify(sid, body)});
+    check(result.notifications.isEmpty() && result.closed, "removed speaker is not served any more");
+
+    if (failures > 0) {
+        qWarning() << failures << "checks failed";
+        return 1;
+    }
+
+    qInfo() << "All checks passed";
+    return 0;
+}
@@ -0,0 +1,14 @@
+CONFIG += c++11
+
+QT += network
+
+include(../../common/http/http.pri)
+
+# Picks up the logging category stub in this directory before the generated plugin info
+INCLUDEPATH += . ..
+
+SOURCES += eventtest.cpp \
+    ../sonoseventserver.cpp
+
+HEADERS += extern-plugininfo.h \
+    ../sonoseventserver.h
@@ -31,6 +31,8 @@
 #include "integrationpluginsonos.h"
 #include "integrations/thing.h"
 #include "network/networkaccessmanager.h"
+#include "network/upnp/upnpdiscovery.h"
+#include "network/upnp/upnpdiscoveryreply.h"
 #include "plugininfo.h"
 #include "types/mediabrowseritem.h"
 
@@ -195,6 +197,11 @@ void IntegrationPluginSonos::postSetupThing(Thing *thing)
                     if (groupDevice->thingClassId() == sonosGroupThingClassId) {
                         //get playback status of each group
                         QString groupId = groupDevice->paramValue(sonosGroupThingGroupIdParamTypeId).toString();
+                        SonosGroupEvents *groupEvents = m_groupEvents.value(groupId);
+                        if (groupEvents && groupEvents->subscribed()) {
+                            // The speaker pushes changes, no need to ask the cloud
+                            continue;
+                        }
                         sonos->getGroupPlaybackStatus(groupId);
                         sonos->getGroupMetadataStatus(groupId);
                         sonos->getGroupVolume(groupId);
@@ -216,12 +223,23 @@ void IntegrationPluginSonos::postSetupThing(Thing *thing)
                 //get groups for each household in order to add or remove groups
                 sonos->getHouseholds();
             }
+            // Speakers may have changed their address
+            discoverSpeakers();
         });
     }
 
     if (thing->thingClassId() == sonosConnectionThingClassId) {
         Sonos *sonos = m_sonosConnections.value(thing);
         sonos->getHouseholds();
+        discoverSpeakers();
+
+        connect(thing, &Thing::settingChanged, this, [this, thing](const ParamTypeId &paramTypeId, const QVariant &value){
+            if (paramTypeId == sonosConnectionSettingsLocalEventsParamTypeId) {
+                qCDebug(dcSonos()) << "Local speaker events" << (value.toBool() ? "enabled" : "disabled") << "for" << thing->name();
+                updateGroupEvents(thing);
+                discoverSpeakers();
+            }
+        });
     }
 
     if (thing->thingClassId() == sonosGroupThingClassId) {
@@ -250,6 +268,14 @@ void IntegrationPluginSonos::startMonitoringAutoThings()
 void IntegrationPluginSonos::thingRemoved(Thing *thing)
 {
     qCDebug(dcSonos) << "Delete " << thing->name();
+    if (thing->thingClassId() == sonosGroupThingClassId) {
+        QString groupId = thing->paramValue(sonosGroupThingGroupIdParamTypeId).toString();
+        m_groupCoordinators.remove(groupId);
+        if (m_groupEvents.contains(groupId)) {
+            m_groupEvents.take(groupId)->deleteLater();
+        }
+    }
+
     if (myThings().empty()) {
         hardwareManager()->pluginTimerManager()->unregisterTimer(m_pluginTimer5sec);
         hardwareManager()->pluginTimerManager()->unregisterTimer(m_pluginTimer60sec);
@@ -584,6 +610,10 @@ void IntegrationPluginSonos::onGroupsReceived(const QString &householdId, QList<
         }
     }
 
+    foreach (const Sonos::GroupObject &groupObject, groupObjects) {
+        m_groupCoordinators.insert(groupObject.groupId, groupObject.CoordinatorId);
+    }
+    updateGroupEvents(parentDevice);
 }
 
 void IntegrationPluginSonos::onPlayBackStatusReceived(const QString &groupId, Sonos::PlayBackObject playBack)
@@ -671,3 +701,100 @@ void IntegrationPluginSonos::onActionExecuted(QUuid sonosActionId, bool success)
         }
     }
 }
+
+void IntegrationPluginSonos::onTopologyChanged(const QString &groupId)
+{
+    // Let the cloud resolve the new groups, coordinators and names
+    Thing *groupThing = myThings().findByParams(ParamList() << Param(sonosGroupThingGroupIdParamTypeId, groupId));
+    if (!groupThing)
+        return;
+
+    Sonos *sonos = m_sonosConnections.value(myThings().findById(groupThing->parentId()));
+    if (!sonos)
+        return;
+
+    qCDebug(dcSonos()) << "Zone group topology changed, refreshing groups";
+    sonos->getGroups(groupThing->paramValue(sonosGroupThingHouseholdIdParamTypeId).toString());
+}
+
+void IntegrationPluginSonos::discoverSpeakers()
+{
+    bool localEventsEnabled = false;
+    foreach (Thing *thing, myThings().filterByThingClassId(sonosConnectionThingClassId)) {
+        localEventsEnabled |= thing->setting(sonosConnectionSettingsLocalEventsParamTypeId).toBool();
+    }
+    if (!localEventsEnabled || !hardwareManager()->upnpDiscovery()->available()) {
+        return;
+    }
+
+    UpnpDiscoveryReply *reply = hardwareManager()->upnpDiscovery()->discoverDevices("urn:schemas-upnp-org:device:ZonePlayer:1");
+    connect(reply, &UpnpDiscoveryReply::finished, reply, &UpnpDiscoveryReply::deleteLater);
+    connect(reply, &UpnpDiscoveryReply::finished, this, [this, reply](){
+        if (reply->error() != UpnpDiscoveryReply::UpnpDiscoveryReplyErrorNoError) {
+            qCWarning(dcSonos()) << "Upnp discovery error" << reply->error();
+            return;
+        }
+
+        foreach (const UpnpDeviceDescriptor &upnpDevice, reply->deviceDescriptors()) {
+            // The UDN of a zone player equals its player id in the cloud API
+            QString playerId = upnpDevice.uuid();
+            playerId.remove("uuid:");
+            if (!playerId.startsWith("RINCON_")) {
+                continue;
+            }
+            if (m_playerAddresses.value(playerId) != upnpDevice.hostAddress()) {
+                qCDebug(dcSonos()) << "Found Sonos speaker" << upnpDevice.friendlyName() << playerId << upnpDevice.hostAddress().toString();
+                m_playerAddresses.insert(playerId, upnpDevice.hostAddress());
+            }
+        }
+
+        foreach (Thing *thing, myThings().filterByThingClassId(sonosConnectionThingClassId)) {
+            updateGroupEvents(thing);
+        }
+    });
+}
+
+void IntegrationPluginSonos::updateGroupEvents(Thing *connectionThing)
+{
+    bool localEvents = connectionThing->setting(sonosConnectionSettingsLocalEventsParamTypeId).toBool();
+
+    foreach (Thing *groupThing, myThings().filterByParentId(connectionThing->id())) {
+        QString groupId = groupThing->paramValue(sonosGroupThingGroupIdParamTypeId).toString();
+        QHostAddress address = m_playerAddresses.value(m_groupCoordinators.value(groupId));
+        SonosGroupEvents *groupEvents = m_groupEvents.value(groupId);
+
+        if (groupEvents && (!localEvents || groupEvents->address() != address)) {
+            m_groupEvents.remove(groupId);
+            groupEvents->deleteLater();
+            groupEvents = nullptr;
+        }
+        if (groupEvents || !localEvents || address.isNull()) {
+            continue;
+        }
+
+        if (!m_eventServer) {
+            m_eventServer = new SonosEventServer(this);
+        }
+        if (!m_eventServer->startServer()) {
+            return;
+        }
+
+        qCDebug(dcSonos()) << "Subscribing to local events of group" << groupThing->name() << "on" << address.toString();
+        groupEvents = new SonosGroupEvents(hardwareManager()->networkManager(), m_eventServer, groupId, address, this);
+        connect(groupEvents, &SonosGroupEvents::playBackStatusReceived, this, &IntegrationPluginSonos::onPlayBackStatusReceived);
+        connect(groupEvents, &SonosGroupEvents::metadataStatusReceived, this, &IntegrationPluginSonos::onMetadataStatusReceived);
+        connect(groupEvents, &SonosGroupEvents::volumeReceived, this, &IntegrationPluginSonos::onVolumeReceived);
+        connect(groupEvents, &SonosGroupEvents::topologyChanged, this, &IntegrationPluginSonos::onTopologyChanged);
+        connect(groupEvents, &SonosGroupEvents::subscribedChanged, this, [this, connectionThing](const QString &groupId, bool subscribed){
+            Sonos *sonos = m_sonosConnections.value(connectionThing);
+            if (!subscribed && sonos) {
+                // Catch up on what we may have missed, polling takes over from here
+                sonos->getGroupPlaybackStatus(groupId);
+                sonos->getGroupMetadataStatus(groupId);
+                sonos->getGroupVolume(groupId);
+            }
+        });
+        m_groupEvents.insert(groupId, groupEvents);
+        groupEvents->subscribe();
+    }
+}
@@ -34,6 +34,8 @@
 #include "integrations/integrationplugin.h"
 #include "plugintimer.h"
 #include "sonos.h"
+#include "sonoseventserver.h"
+#include "sonosgroupevents.h"
 
 #include <QHash>
 #include <QDebug>
@@ -79,6 +81,15 @@ private:
 
     const QString m_browseFavoritesPrefix = "/favorites";
 
+    // Local UPnP events, groups without an active subscription fall back to cloud polling
+    SonosEventServer *m_eventServer = nullptr;
+    QHash<QString, SonosGroupEvents *> m_groupEvents;
+    QHash<QString, QString> m_groupCoordinators;
+    QHash<QString, QHostAddress> m_playerAddresses;
+
+    void discoverSpeakers();
+    void updateGroupEvents(Thing *connectionThing);
+
 private slots:
     void onConnectionChanged(bool connected);
     void onAuthenticationStatusChanged(bool authenticated);
@@ -93,6 +104,8 @@ private slots:
     void onMetadataStatusReceived(const QString &groupId, Sonos::MetadataStatus metaDataStatus);
     void onVolumeReceived(const QString &groupId, Sonos::VolumeObject groupVolume);
     void onActionExecuted(QUuid actionId, bool success);
+
+    void onTopologyChanged(const QString &groupId);
 };
 
 #endif // INTEGRATIONPLUGINSONOS_H
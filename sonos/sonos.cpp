@@ -42,6 +42,8 @@ Sonos::Sonos(NetworkAccessManager *networkmanager,  const QByteArray &clientKey,
     m_clientSecret(clientSecret),
     m_networkManager(networkmanager)
 {
+    m_scheduler = new SonosRequestScheduler(m_networkManager, this);
+
     if(!m_tokenRefreshTimer) {
         m_tokenRefreshTimer = new QTimer(this);
         m_tokenRefreshTimer->setSingleShot(true);
@@ -90,9 +92,9 @@ void Sonos::getHouseholds()
     request.setRawHeader("Authorization", "Bearer " + m_accessToken);
     request.setRawHeader("X-Sonos-Api-Key", m_clientKey);
     request.setUrl(QUrl(m_baseControlUrl + "/households"));
-    QNetworkReply *reply = m_networkManager->get(request);
+    SonosReply *reply = m_scheduler->get(QString(), request);
     qDebug(dcSonos()) << "Sending request" << request.url() << request.rawHeaderList() << request.rawHeader("Authorization");
-    connect(reply, &QNetworkReply::finished, this, [reply, this] {
+    connect(reply, &SonosReply::finished, this, [reply, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -142,8 +144,8 @@ QUuid Sonos::loadFavorite(const QString &groupId, const QString &favouriteId)
     QJsonDocument doc(object);
     qDebug(dcSonos()) << "Sending request" << doc.toJson();
 
-    QNetworkReply *reply = m_networkManager->post(request, doc.toJson(QJsonDocument::Compact));
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, this] {
+    SonosReply *reply = m_scheduler->postFor(groupId, request, doc.toJson(QJsonDocument::Compact));
+    connect(reply, &SonosReply::finished, this, [reply, actionId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -175,8 +177,8 @@ QUuid Sonos::getFavorites(const QString &householdId)
     request.setUrl(QUrl(m_baseControlUrl + "/households/" + householdId + "/favorites"));
     QUuid requestId = QUuid::createUuid();
 
-    QNetworkReply *reply = m_networkManager->get(request);
-    connect(reply, &QNetworkReply::finished, this, [reply, requestId, householdId, this] {
+    SonosReply *reply = m_scheduler->get(householdId, request, SonosRequestScheduler::PriorityUser);
+    connect(reply, &SonosReply::finished, this, [reply, requestId, householdId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -230,8 +232,8 @@ void Sonos::getGroups(const QString &householdId)
     request.setRawHeader("Authorization", "Bearer " + m_accessToken);
     request.setRawHeader("X-Sonos-Api-Key", m_clientKey);
     request.setUrl(QUrl(m_baseControlUrl + "/households/" + householdId + "/groups"));
-    QNetworkReply *reply = m_networkManager->get(request);
-    connect(reply, &QNetworkReply::finished, this, [reply, householdId, this] {
+    SonosReply *reply = m_scheduler->get(householdId, request);
+    connect(reply, &SonosReply::finished, this, [reply, householdId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -271,22 +273,24 @@ void Sonos::getGroups(const QString &householdId)
             QVariantList players = obj.value("playerIds").toList();
             foreach (const QVariant &value, players) {
               group.playerIds.append(value.toByteArray());
+              m_scheduler->setHouseholdId(value.toString(), householdId);
             }
+            m_scheduler->setHouseholdId(group.groupId, householdId);
             groupObjects.append(group);
         }
         emit groupsReceived(householdId, groupObjects);
     });
 }
 
-void Sonos::getGroupVolume(const QString &groupId)
+void Sonos::getGroupVolume(const QString &groupId, SonosRequestScheduler::Priority priority)
 {
     QNetworkRequest request;
     request.setHeader(QNetworkRequest::KnownHeaders::ContentTypeHeader, "application/json");
     request.setRawHeader("Authorization", "Bearer " + m_accessToken);
     request.setRawHeader("X-Sonos-Api-Key", m_clientKey);
     request.setUrl(QUrl(m_baseControlUrl + "/groups/" + groupId + "/groupVolume"));
-    QNetworkReply *reply = m_networkManager->get(request);
-    connect(reply, &QNetworkReply::finished, this, [reply, groupId, this] {
+    SonosReply *reply = m_scheduler->getFor(groupId, request, priority);
+    connect(reply, &SonosReply::finished, this, [reply, groupId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -337,8 +341,8 @@ QUuid Sonos::setGroupVolume(const QString &groupId, int volume)
     QJsonDocument doc(object);
     qDebug(dcSonos()) << "Set volume:" << groupId << doc.toJson(QJsonDocument::Compact);
 
-    QNetworkReply *reply = m_networkManager->post(request, doc.toJson(QJsonDocument::Compact));
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, groupId, this] {
+    SonosReply *reply = m_scheduler->postFor(groupId, request, doc.toJson(QJsonDocument::Compact));
+    connect(reply, &SonosReply::finished, this, [reply, actionId, groupId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -357,7 +361,7 @@ QUuid Sonos::setGroupVolume(const QString &groupId, int volume)
         emit connectionChanged(true);
         emit authenticationStatusChanged(true);
         emit actionExecuted(actionId, true);
-        getGroupVolume(groupId);
+        getGroupVolume(groupId, SonosRequestScheduler::PriorityUser);
     });
     return actionId;
 }
@@ -377,8 +381,8 @@ QUuid Sonos::setGroupMute(const QString &groupId, bool mute)
 
     qDebug(dcSonos()) << "Set mute:" << groupId << doc.toJson(QJsonDocument::Compact);
 
-    QNetworkReply *reply = m_networkManager->post(request, doc.toJson(QJsonDocument::Compact));
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, groupId, this] {
+    SonosReply *reply = m_scheduler->postFor(groupId, request, doc.toJson(QJsonDocument::Compact));
+    connect(reply, &SonosReply::finished, this, [reply, actionId, groupId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -397,7 +401,7 @@ QUuid Sonos::setGroupMute(const QString &groupId, bool mute)
         emit connectionChanged(true);
         emit authenticationStatusChanged(true);
         emit actionExecuted(actionId, true);
-        getGroupVolume(groupId);
+        getGroupVolume(groupId, SonosRequestScheduler::PriorityUser);
     });
     return actionId;
 }
@@ -417,8 +421,8 @@ QUuid Sonos::setGroupRelativeVolume(const QString &groupId, int volumeDelta)
 
     qDebug(dcSonos()) << "Relative volume:" << groupId << volumeDelta;
 
-    QNetworkReply *reply = m_networkManager->post(request, doc.toJson(QJsonDocument::Compact));
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, groupId, this] {
+    SonosReply *reply = m_scheduler->postFor(groupId, request, doc.toJson(QJsonDocument::Compact));
+    connect(reply, &SonosReply::finished, this, [reply, actionId, groupId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -437,20 +441,20 @@ QUuid Sonos::setGroupRelativeVolume(const QString &groupId, int volumeDelta)
         emit connectionChanged(true);
         emit authenticationStatusChanged(true);
         emit actionExecuted(actionId, true);
-        getGroupVolume(groupId);
+        getGroupVolume(groupId, SonosRequestScheduler::PriorityUser);
     });
     return actionId;
 }
 
-void Sonos::getGroupPlaybackStatus(const QString &groupId)
+void Sonos::getGroupPlaybackStatus(const QString &groupId, SonosRequestScheduler::Priority priority)
 {
     QNetworkRequest request;
     request.setHeader(QNetworkRequest::KnownHeaders::ContentTypeHeader, "application/json");
     request.setRawHeader("Authorization", "Bearer " + m_accessToken);
     request.setRawHeader("X-Sonos-Api-Key", m_clientKey);
     request.setUrl(QUrl(m_baseControlUrl + "/groups/" + groupId + "/playback"));
-    QNetworkReply *reply = m_networkManager->get(request);
-    connect(reply, &QNetworkReply::finished, this, [reply, this, groupId] {
+    SonosReply *reply = m_scheduler->getFor(groupId, request, priority);
+    connect(reply, &SonosReply::finished, this, [reply, this, groupId] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -513,8 +517,8 @@ QUuid Sonos::groupLoadLineIn(const QString &groupId)
     request.setUrl(QUrl(m_baseControlUrl + "/groups/" + groupId + "/playback/lineIn"));
     QUuid actionId = QUuid::createUuid();
 
-    QNetworkReply *reply = m_networkManager->post(request, "");
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, groupId, this] {
+    SonosReply *reply = m_scheduler->postFor(groupId, request, "");
+    connect(reply, &SonosReply::finished, this, [reply, actionId, groupId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -533,7 +537,7 @@ QUuid Sonos::groupLoadLineIn(const QString &groupId)
         emit connectionChanged(true);
         emit authenticationStatusChanged(true);
         emit actionExecuted(actionId, true);
-        getGroupVolume(groupId);
+        getGroupVolume(groupId, SonosRequestScheduler::PriorityUser);
     });
     return actionId;
 }
@@ -549,8 +553,8 @@ QUuid Sonos::groupPlay(const QString &groupId)
 
     qDebug(dcSonos()) << "Play:" << groupId;
 
-    QNetworkReply *reply = m_networkManager->post(request, "");
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, groupId, this] {
+    SonosReply *reply = m_scheduler->postFor(groupId, request, "");
+    connect(reply, &SonosReply::finished, this, [reply, actionId, groupId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -569,7 +573,7 @@ QUuid Sonos::groupPlay(const QString &groupId)
         emit connectionChanged(true);
         emit authenticationStatusChanged(true);
         emit actionExecuted(actionId, true);
-        getGroupPlaybackStatus(groupId);
+        getGroupPlaybackStatus(groupId, SonosRequestScheduler::PriorityUser);
     });
     return actionId;
 }
@@ -585,8 +589,8 @@ QUuid Sonos::groupPause(const QString &groupId)
 
     qDebug(dcSonos()) << "Pause:" << groupId;
 
-    QNetworkReply *reply = m_networkManager->post(request, "");
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, groupId, this] {
+    SonosReply *reply = m_scheduler->postFor(groupId, request, "");
+    connect(reply, &SonosReply::finished, this, [reply, actionId, groupId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -605,7 +609,7 @@ QUuid Sonos::groupPause(const QString &groupId)
         emit connectionChanged(true);
         emit authenticationStatusChanged(true);
         emit actionExecuted(actionId, true);
-        getGroupPlaybackStatus(groupId);
+        getGroupPlaybackStatus(groupId, SonosRequestScheduler::PriorityUser);
     });
     return actionId;
 }
@@ -624,8 +628,8 @@ QUuid Sonos::groupSeek(const QString &groupId, int possitionMillis)
     object.insert("positionMillis", QJsonValue::fromVariant(possitionMillis));
     QJsonDocument doc(object);
 
-    QNetworkReply *reply = m_networkManager->post(request, doc.toJson(QJsonDocument::Compact));
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, this] {
+    SonosReply *reply = m_scheduler->postFor(groupId, request, doc.toJson(QJsonDocument::Compact));
+    connect(reply, &SonosReply::finished, this, [reply, actionId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -661,8 +665,8 @@ QUuid Sonos::groupSeekRelative(const QString &groupId, int deltaMillis)
     object.insert("deltaMillis", QJsonValue::fromVariant(deltaMillis));
     QJsonDocument doc(object);
 
-    QNetworkReply *reply = m_networkManager->post(request, doc.toJson(QJsonDocument::Compact));
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, this] {
+    SonosReply *reply = m_scheduler->postFor(groupId, request, doc.toJson(QJsonDocument::Compact));
+    connect(reply, &SonosReply::finished, this, [reply, actionId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -703,8 +707,8 @@ QUuid Sonos::groupSetPlayModes(const QString &groupId, PlayMode playMode)
     object.insert("playModes", playModesObject);
     QJsonDocument doc(object);
 
-    QNetworkReply *reply = m_networkManager->post(request, doc.toJson(QJsonDocument::Compact));
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, groupId, this] {
+    SonosReply *reply = m_scheduler->postFor(groupId, request, doc.toJson(QJsonDocument::Compact));
+    connect(reply, &SonosReply::finished, this, [reply, actionId, groupId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -723,7 +727,7 @@ QUuid Sonos::groupSetPlayModes(const QString &groupId, PlayMode playMode)
         emit connectionChanged(true);
         emit authenticationStatusChanged(true);
         emit actionExecuted(actionId, true);
-        getGroupPlaybackStatus(groupId);
+        getGroupPlaybackStatus(groupId, SonosRequestScheduler::PriorityUser);
     });
     return actionId;
 }
@@ -743,8 +747,8 @@ QUuid Sonos::groupSetShuffle(const QString &groupId, bool shuffle)
     object.insert("playModes", playModesObject);
     QJsonDocument doc(object);
 
-    QNetworkReply *reply = m_networkManager->post(request, doc.toJson(QJsonDocument::Compact));
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, groupId, this] {
+    SonosReply *reply = m_scheduler->postFor(groupId, request, doc.toJson(QJsonDocument::Compact));
+    connect(reply, &SonosReply::finished, this, [reply, actionId, groupId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -763,7 +767,7 @@ QUuid Sonos::groupSetShuffle(const QString &groupId, bool shuffle)
         emit connectionChanged(true);
         emit authenticationStatusChanged(true);
         emit actionExecuted(actionId, true);
-        getGroupPlaybackStatus(groupId);
+        getGroupPlaybackStatus(groupId, SonosRequestScheduler::PriorityUser);
     });
     return actionId;
 }
@@ -795,8 +799,8 @@ QUuid Sonos::groupSetRepeat(const QString &groupId, RepeatMode repeatMode)
     object.insert("playModes", playModesObject);
     QJsonDocument doc(object);
 
-    QNetworkReply *reply = m_networkManager->post(request, doc.toJson(QJsonDocument::Compact));
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, groupId, this] {
+    SonosReply *reply = m_scheduler->postFor(groupId, request, doc.toJson(QJsonDocument::Compact));
+    connect(reply, &SonosReply::finished, this, [reply, actionId, groupId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -815,7 +819,7 @@ QUuid Sonos::groupSetRepeat(const QString &groupId, RepeatMode repeatMode)
         emit connectionChanged(true);
         emit authenticationStatusChanged(true);
         emit actionExecuted(actionId, true);
-        getGroupPlaybackStatus(groupId);
+        getGroupPlaybackStatus(groupId, SonosRequestScheduler::PriorityUser);
     });
     return actionId;
 }
@@ -835,8 +839,8 @@ QUuid Sonos::groupSetCrossfade(const QString &groupId, bool crossfade)
     object.insert("playModes", playModesObject);
     QJsonDocument doc(object);
 
-    QNetworkReply *reply = m_networkManager->post(request, doc.toJson(QJsonDocument::Compact));
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, groupId, this] {
+    SonosReply *reply = m_scheduler->postFor(groupId, request, doc.toJson(QJsonDocument::Compact));
+    connect(reply, &SonosReply::finished, this, [reply, actionId, groupId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -855,7 +859,7 @@ QUuid Sonos::groupSetCrossfade(const QString &groupId, bool crossfade)
         emit connectionChanged(true);
         emit authenticationStatusChanged(true);
         emit actionExecuted(actionId, true);
-        getGroupPlaybackStatus(groupId);
+        getGroupPlaybackStatus(groupId, SonosRequestScheduler::PriorityUser);
     });
     return actionId;
 }
@@ -869,8 +873,8 @@ QUuid Sonos::groupSkipToNextTrack(const QString &groupId)
     request.setUrl(QUrl(m_baseControlUrl + "/groups/" + groupId + "/playback/skipToNextTrack"));
     QUuid actionId = QUuid::createUuid();
 
-    QNetworkReply *reply = m_networkManager->post(request, "");
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, groupId, this] {
+    SonosReply *reply = m_scheduler->postFor(groupId, request, "");
+    connect(reply, &SonosReply::finished, this, [reply, actionId, groupId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -889,7 +893,7 @@ QUuid Sonos::groupSkipToNextTrack(const QString &groupId)
         emit connectionChanged(true);
         emit authenticationStatusChanged(true);
         emit actionExecuted(actionId, true);
-        getGroupMetadataStatus(groupId);
+        getGroupMetadataStatus(groupId, SonosRequestScheduler::PriorityUser);
     });
     return actionId;
 }
@@ -903,8 +907,8 @@ QUuid Sonos::groupSkipToPreviousTrack(const QString &groupId)
     request.setUrl(QUrl(m_baseControlUrl + "/groups/" + groupId + "/playback/skipToPreviousTrack"));
     QUuid actionId = QUuid::createUuid();
 
-    QNetworkReply *reply = m_networkManager->post(request, "");
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, groupId, this] {
+    SonosReply *reply = m_scheduler->postFor(groupId, request, "");
+    connect(reply, &SonosReply::finished, this, [reply, actionId, groupId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -923,7 +927,7 @@ QUuid Sonos::groupSkipToPreviousTrack(const QString &groupId)
         emit connectionChanged(true);
         emit authenticationStatusChanged(true);
         emit actionExecuted(actionId, true);
-        getGroupMetadataStatus(groupId);
+        getGroupMetadataStatus(groupId, SonosRequestScheduler::PriorityUser);
     });
     return actionId;
 }
@@ -937,8 +941,8 @@ QUuid Sonos::groupTogglePlayPause(const QString &groupId)
     request.setUrl(QUrl(m_baseControlUrl + "/groups/" + groupId + "/playback/togglePlayPause"));
     QUuid actionId = QUuid::createUuid();
 
-    QNetworkReply *reply = m_networkManager->post(request, "");
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, groupId, this] {
+    SonosReply *reply = m_scheduler->postFor(groupId, request, "");
+    connect(reply, &SonosReply::finished, this, [reply, actionId, groupId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -957,20 +961,20 @@ QUuid Sonos::groupTogglePlayPause(const QString &groupId)
         emit connectionChanged(true);
         emit authenticationStatusChanged(true);
         emit actionExecuted(actionId, true);
-        getGroupPlaybackStatus(groupId);
+        getGroupPlaybackStatus(groupId, SonosRequestScheduler::PriorityUser);
     });
     return actionId;
 }
 
-void Sonos::getGroupMetadataStatus(const QString &groupId)
+void Sonos::getGroupMetadataStatus(const QString &groupId, SonosRequestScheduler::Priority priority)
 {
     QNetworkRequest request;
     request.setHeader(QNetworkRequest::KnownHeaders::ContentTypeHeader, "application/json");
     request.setRawHeader("Authorization", "Bearer " + m_accessToken);
     request.setRawHeader("X-Sonos-Api-Key", m_clientKey);
     request.setUrl(QUrl(m_baseControlUrl + "/groups/" + groupId + "/playbackMetadata"));
-    QNetworkReply *reply = m_networkManager->get(request);
-    connect(reply, &QNetworkReply::finished, this, [reply, groupId, this] {
+    SonosReply *reply = m_scheduler->getFor(groupId, request, priority);
+    connect(reply, &SonosReply::finished, this, [reply, groupId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -1101,15 +1105,15 @@ void Sonos::getGroupMetadataStatus(const QString &groupId)
     });
 }
 
-void Sonos::getPlayerVolume(const QByteArray &playerId)
+void Sonos::getPlayerVolume(const QByteArray &playerId, SonosRequestScheduler::Priority priority)
 {
     QNetworkRequest request;
     request.setHeader(QNetworkRequest::KnownHeaders::ContentTypeHeader, "application/json");
     request.setRawHeader("Authorization", "Bearer " + m_accessToken);
     request.setRawHeader("X-Sonos-Api-Key", m_clientKey);
     request.setUrl(QUrl(m_baseControlUrl + "/players/" + playerId + "/playerVolume"));
-    QNetworkReply *reply = m_networkManager->get(request);
-    connect(reply, &QNetworkReply::finished, this, [reply, playerId, this] {
+    SonosReply *reply = m_scheduler->getFor(playerId, request, priority);
+    connect(reply, &SonosReply::finished, this, [reply, playerId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -1159,8 +1163,8 @@ QUuid Sonos::setPlayerVolume(const QByteArray &playerId, int volume)
     object.insert("volume", QJsonValue::fromVariant(volume));
     QJsonDocument doc(object);
 
-    QNetworkReply *reply = m_networkManager->post(request, doc.toJson(QJsonDocument::Compact));
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, playerId, this] {
+    SonosReply *reply = m_scheduler->postFor(playerId, request, doc.toJson(QJsonDocument::Compact));
+    connect(reply, &SonosReply::finished, this, [reply, actionId, playerId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -1179,7 +1183,7 @@ QUuid Sonos::setPlayerVolume(const QByteArray &playerId, int volume)
         emit connectionChanged(true);
         emit authenticationStatusChanged(true);
         emit actionExecuted(actionId, true);
-        getPlayerVolume(playerId);
+        getPlayerVolume(playerId, SonosRequestScheduler::PriorityUser);
     });
     return actionId;
 }
@@ -1197,8 +1201,8 @@ QUuid Sonos::setPlayerRelativeVolume(const QByteArray &playerId, int volumeDelta
     object.insert("volumeDelta", QJsonValue::fromVariant(volumeDelta));
     QJsonDocument doc(object);
 
-    QNetworkReply *reply = m_networkManager->post(request, doc.toJson(QJsonDocument::Compact));
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, playerId, this] {
+    SonosReply *reply = m_scheduler->postFor(playerId, request, doc.toJson(QJsonDocument::Compact));
+    connect(reply, &SonosReply::finished, this, [reply, actionId, playerId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -1217,7 +1221,7 @@ QUuid Sonos::setPlayerRelativeVolume(const QByteArray &playerId, int volumeDelta
         emit connectionChanged(true);
         emit authenticationStatusChanged(true);
         emit actionExecuted(actionId, true);
-        getPlayerVolume(playerId);
+        getPlayerVolume(playerId, SonosRequestScheduler::PriorityUser);
     });
     return actionId;
 }
@@ -1235,8 +1239,8 @@ QUuid Sonos::setPlayerMute(const QByteArray &playerId, bool mute)
     object.insert("muted", QJsonValue::fromVariant(mute));
     QJsonDocument doc(object);
 
-    QNetworkReply *reply = m_networkManager->post(request, doc.toJson(QJsonDocument::Compact));
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, playerId, this] {
+    SonosReply *reply = m_scheduler->postFor(playerId, request, doc.toJson(QJsonDocument::Compact));
+    connect(reply, &SonosReply::finished, this, [reply, actionId, playerId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -1255,7 +1259,7 @@ QUuid Sonos::setPlayerMute(const QByteArray &playerId, bool mute)
         emit connectionChanged(true);
         emit authenticationStatusChanged(true);
         emit actionExecuted(actionId, true);
-        getPlayerVolume(playerId);
+        getPlayerVolume(playerId, SonosRequestScheduler::PriorityUser);
     });
     return actionId;
 }
@@ -1273,8 +1277,8 @@ void Sonos::getPlaylist(const QString &householdId, const QString &playlistId)
     object["playlistId"] = playlistId;
     QJsonDocument doc(object);
 
-    QNetworkReply *reply = m_networkManager->post(request, doc.toJson(QJsonDocument::Compact));
-    connect(reply, &QNetworkReply::finished, this, [reply, householdId, this] {
+    SonosReply *reply = m_scheduler->post(householdId, request, doc.toJson(QJsonDocument::Compact));
+    connect(reply, &SonosReply::finished, this, [reply, householdId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -1326,8 +1330,8 @@ void Sonos::getPlaylists(const QString &householdId)
     request.setRawHeader("Authorization", "Bearer " + m_accessToken);
     request.setRawHeader("X-Sonos-Api-Key", m_clientKey);
     request.setUrl(QUrl(m_baseControlUrl + "/households/" + householdId + "/playlists"));
-    QNetworkReply *reply = m_networkManager->get(request);
-    connect(reply, &QNetworkReply::finished, this, [reply, householdId, this] {
+    SonosReply *reply = m_scheduler->get(householdId, request, SonosRequestScheduler::PriorityUser);
+    connect(reply, &SonosReply::finished, this, [reply, householdId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -1386,8 +1390,8 @@ QUuid Sonos::loadPlaylist(const QString &groupId, const QString &playlistId)
     object.insert("playOnCompletion", true);
     QJsonDocument doc(object);
 
-    QNetworkReply *reply = m_networkManager->post(request, doc.toJson(QJsonDocument::Compact));
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, this] {
+    SonosReply *reply = m_scheduler->postFor(groupId, request, doc.toJson(QJsonDocument::Compact));
+    connect(reply, &SonosReply::finished, this, [reply, actionId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -1410,15 +1414,15 @@ QUuid Sonos::loadPlaylist(const QString &groupId, const QString &playlistId)
     return actionId;
 }
 
-void Sonos::getPlayerSettings(const QString &playerId)
+void Sonos::getPlayerSettings(const QString &playerId, SonosRequestScheduler::Priority priority)
 {
     QNetworkRequest request;
     request.setHeader(QNetworkRequest::KnownHeaders::ContentTypeHeader, "application/json");
     request.setRawHeader("Authorization", "Bearer " + m_accessToken);
     request.setRawHeader("X-Sonos-Api-Key", m_clientKey);
     request.setUrl(QUrl(m_baseControlUrl + "/players/" + playerId + "/settings/player"));
-    QNetworkReply *reply = m_networkManager->get(request);
-    connect(reply, &QNetworkReply::finished, this, [reply, playerId, this] {
+    SonosReply *reply = m_scheduler->getFor(playerId, request, priority);
+    connect(reply, &SonosReply::finished, this, [reply, playerId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -1469,8 +1473,8 @@ QUuid Sonos::setPlayerSettings(const QString &playerId, PlayerSettingsObject set
     object["wifiDisable"] = settings.wifiDisabled;
     QJsonDocument doc(object);
 
-    QNetworkReply *reply = m_networkManager->post(request, doc.toJson(QJsonDocument::Compact));
-    connect(reply, &QNetworkReply::finished, this, [reply, actionId, playerId, this] {
+    SonosReply *reply = m_scheduler->postFor(playerId, request, doc.toJson(QJsonDocument::Compact));
+    connect(reply, &SonosReply::finished, this, [reply, actionId, playerId, this] {
         reply->deleteLater();
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
@@ -1489,7 +1493,7 @@ QUuid Sonos::setPlayerSettings(const QString &playerId, PlayerSettingsObject set
         emit connectionChanged(true);
         emit authenticationStatusChanged(true);
         emit actionExecuted(actionId, true);
-        getPlayerSettings(playerId);
+        getPlayerSettings(playerId, SonosRequestScheduler::PriorityUser);
     });
     return actionId;
 }
@@ -1540,6 +1544,7 @@ void Sonos::getAccessTokenFromRefreshToken(const QByteArray &refreshToken)
             return;
         }
         m_accessToken = jsonDoc.toVariant().toMap().value("access_token").toByteArray();
+        m_scheduler->setAuthorization("Bearer " + m_accessToken);
 
         if (jsonDoc.toVariant().toMap().contains("expires_in")) {
             int expireTime = jsonDoc.toVariant().toMap().value("expires_in").toInt();
@@ -1614,6 +1619,7 @@ void Sonos::getAccessTokenFromAuthorizationCode(const QByteArray &authorizationC
         }
         qCDebug(dcSonos()) << "Access token:" << jsonDoc.toVariant().toMap().value("access_token").toString();
         m_accessToken = jsonDoc.toVariant().toMap().value("access_token").toByteArray();
+        m_scheduler->setAuthorization("Bearer " + m_accessToken);
 
         qCDebug(dcSonos()) << "Refresh token:" << jsonDoc.toVariant().toMap().value("refresh_token").toString();
         m_refreshToken = jsonDoc.toVariant().toMap().value("refresh_token").toByteArray();
@@ -36,6 +36,7 @@
 
 #include "network/networkaccessmanager.h"
 #include "integrations/thing.h"
+#include "sonosrequestscheduler.h"
 
 class Sonos : public QObject
 {
@@ -230,14 +231,14 @@ public:
     QUuid loadFavorite(const QString &groupId, const QString &faveriteId);
 
     //Group volume
-    void getGroupVolume(const QString &groupId);                             //Get the volume and mute state of a group.
+    void getGroupVolume(const QString &groupId, SonosRequestScheduler::Priority priority = SonosRequestScheduler::PriorityPoll); //Get the volume and mute state of a group.
     //Group volume actions
     QUuid setGroupVolume(const QString &groupId, int volume);                //Set group volume to a specific level and unmute the group if muted.
     QUuid setGroupMute(const QString &groupId, bool mute);                   //Mute and unmute the group.
     QUuid setGroupRelativeVolume(const QString &groupId, int volumeDelta); 	//Increase or decrease group volume.
 
     //group playback
-    void getGroupPlaybackStatus(const QString &groupId);
+    void getGroupPlaybackStatus(const QString &groupId, SonosRequestScheduler::Priority priority = SonosRequestScheduler::PriorityPoll);
 
     //Group playback actions
     QUuid groupLoadLineIn(const QString &groupId);
@@ -254,10 +255,10 @@ public:
     QUuid groupTogglePlayPause(const QString &groupId);
 
     //playbackMetadata
-    void getGroupMetadataStatus(const QString &groupId);
+    void getGroupMetadataStatus(const QString &groupId, SonosRequestScheduler::Priority priority = SonosRequestScheduler::PriorityPoll);
 
     // playerVolume
-    void getPlayerVolume(const QByteArray &playerId);
+    void getPlayerVolume(const QByteArray &playerId, SonosRequestScheduler::Priority priority = SonosRequestScheduler::PriorityPoll);
     QUuid setPlayerVolume(const QByteArray &playerId, int volume);
     QUuid setPlayerRelativeVolume(const QByteArray &playerId, int volumeDelta);
     QUuid setPlayerMute(const QByteArray &playerId, bool mute);
@@ -268,7 +269,7 @@ public:
     QUuid loadPlaylist(const QString &groupId, const QString &playlistId);
 
     //Settings
-    void getPlayerSettings(const QString &playerId);
+    void getPlayerSettings(const QString &playerId, SonosRequestScheduler::Priority priority = SonosRequestScheduler::PriorityPoll);
     QUuid setPlayerSettings(const QString &playerId, PlayerSettingsObject settings);
 
 private:
@@ -283,6 +284,7 @@ private:
 
     NetworkAccessManager *m_networkManager = nullptr;
     QTimer *m_tokenRefreshTimer = nullptr;
+    SonosRequestScheduler *m_scheduler = nullptr;
 private slots:
     void onRefreshTimeout();
 
@@ -1,4 +1,5 @@
 include(../plugins.pri)
+include(../common/http/http.pri)
 
 QT += network
 
@@ -7,7 +8,13 @@ TARGET = $$qtLibraryTarget(nymea_integrationpluginsonos)
 SOURCES += \
     integrationpluginsonos.cpp \
     sonos.cpp \
+    sonoseventserver.cpp \
+    sonosgroupevents.cpp \
+    sonosrequestscheduler.cpp \
 
 HEADERS += \
     integrationpluginsonos.h \
     sonos.h \
+    sonoseventserver.h \
+    sonosgroupevents.h \
+    sonosrequestscheduler.h \
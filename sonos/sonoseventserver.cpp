@@ -0,0 +1,167 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "sonoseventserver.h"
+#include "extern-plugininfo.h"
+
+#include <QUdpSocket>
+
+SonosEventServer::SonosEventServer(QObject *parent) :
+    QTcpServer(parent)
+{
+
+}
+
+bool SonosEventServer::startServer()
+{
+    if (isListening()) {
+        return true;
+    }
+
+    // Any free port, the speakers learn it from the CALLBACK header of every subscription
+    if (!listen(QHostAddress::AnyIPv4, 0)) {
+        qCWarning(dcSonos()) << "Event server: Could not listen for UPnP events:" << errorString();
+        return false;
+    }
+    qCDebug(dcSonos()) << "Event server: Listening for UPnP events on port" << serverPort();
+    return true;
+}
+
+QUrl SonosEventServer::callbackUrl(const QHostAddress &speakerAddress, const QString &path) const
+{
+    // Connecting a UDP socket sends nothing, it only selects the interface the speaker is reachable on
+    QUdpSocket socket;
+    socket.connectToHost(speakerAddress, 1400);
+    QHostAddress localAddress = socket.localAddress();
+    socket.close();
+    if (localAddress.isNull()) {
+        return QUrl();
+    }
+
+    QUrl url;
+    url.setScheme("http");
+    url.setHost(localAddress.toString());
+    url.setPort(serverPort());
+    url.setPath(path);
+    return url;
+}
+
+void SonosEventServer::addSpeaker(const QHostAddress &speakerAddress)
+{
+    m_speakers[speakerAddress]++;
+}
+
+void SonosEventServer::removeSpeaker(const QHostAddress &speakerAddress)
+{
+    if (--m_speakers[speakerAddress] <= 0) {
+        m_speakers.remove(speakerAddress);
+    }
+}
+
+void SonosEventServer::incomingConnection(qintptr socketDescriptor)
+{
+    QTcpSocket *socket = new QTcpSocket(this);
+    socket->setSocketDescriptor(socketDescriptor);
+
+    // Events are only expected from the speakers we subscribed on
+    if (!m_speakers.contains(socket->peerAddress())) {
+        qCDebug(dcSonos()) << "Event server: Rejecting connection from unknown address" << socket->peerAddress().toString();
+        socket->abort();
+        socket->deleteLater();
+        return;
+    }
+
+    Client client;
+    client.parser = HttpRequestParser(m_maxHeaderSize, m_maxBodySize);
+    m_clients.insert(socket, client);
+    connect(socket, &QTcpSocket::readyRead, this, &SonosEventServer::readClient);
+    // Queued, the parser still holds a reference to the client when a response closes the socket
+    connect(socket, &QTcpSocket::disconnected, this, &SonosEventServer::onDisconnected, Qt::QueuedConnection);
+}
+
+void SonosEventServer::readClient()
+{
+    QTcpSocket *socket = static_cast<QTcpSocket *>(sender());
+    if (!m_clients.contains(socket)) {
+        return;
+    }
+
+    Client &client = m_clients[socket];
+    if (client.closing) {
+        socket->readAll();
+        return;
+    }
+    client.parser.addData(socket->readAll());
+
+    // Requests may arrive in several segments and a connection may carry several requests
+    HttpRequestParser::Request request;
+    while (!client.closing && client.parser.takeRequest(&request)) {
+        processRequest(socket, request);
+    }
+    if (!client.closing && client.parser.error() != HttpRequestParser::ErrorNone) {
+        qCWarning(dcSonos()) << "Event server: Invalid request from" << socket->peerAddress().toString() << client.parser.errorStatus();
+        sendResponse(socket, client.parser.errorStatus(), false);
+    }
+}
+
+void SonosEventServer::processRequest(QTcpSocket *socket, const HttpRequestParser::Request &request)
+{
+    QByteArray sid = request.headers.value("sid");
+    if (request.method != "NOTIFY" || sid.isEmpty()) {
+        qCDebug(dcSonos()) << "Event server: Rejecting request from" << socket->peerAddress().toString() << request.method << request.path;
+        sendResponse(socket, "412 Precondition Failed", request.keepAlive());
+        return;
+    }
+
+    sendResponse(socket, "200 OK", request.keepAlive());
+    emit notificationReceived(sid, request.body);
+}
+
+void SonosEventServer::sendResponse(QTcpSocket *socket, const QByteArray &status, bool keepAlive)
+{
+    QByteArray response = "HTTP/1.1 " + status + "\r\n";
+    response.append("Content-Length: 0\r\n");
+    response.append(keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
+    response.append("\r\n");
+    socket->write(response);
+
+    if (!keepAlive) {
+        m_clients[socket].closing = true;
+        m_clients[socket].parser.clear();
+        socket->disconnectFromHost();
+    }
+}
+
+void SonosEventServer::onDisconnected()
+{
+    QTcpSocket *socket = static_cast<QTcpSocket *>(sender());
+    m_clients.remove(socket);
+    socket->deleteLater();
+}
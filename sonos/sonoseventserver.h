@@ -0,0 +1,84 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef SONOSEVENTSERVER_H
+#define SONOSEVENTSERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QHash>
+#include <QUrl>
+
+#include "httprequestparser.h"
+
+// Receives the UPnP GENA NOTIFY requests the speakers send for subscribed services.
+// Only speakers registered with addSpeaker() may connect.
+class SonosEventServer : public QTcpServer
+{
+    Q_OBJECT
+public:
+    explicit SonosEventServer(QObject *parent = nullptr);
+
+    bool startServer();
+    QUrl callbackUrl(const QHostAddress &speakerAddress, const QString &path) const;
+
+    // Registrations are counted, a speaker stays known until every addSpeaker() has been undone
+    void addSpeaker(const QHostAddress &speakerAddress);
+    void removeSpeaker(const QHostAddress &speakerAddress);
+
+signals:
+    void notificationReceived(const QByteArray &sid, const QByteArray &body);
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override;
+
+private:
+    // Request parser and keep-alive state of one speaker connection
+    struct Client {
+        HttpRequestParser parser;
+        bool closing = false;
+    };
+
+    QHash<QHostAddress, int> m_speakers;
+    QHash<QTcpSocket *, Client> m_clients;
+    int m_maxHeaderSize = 8192;
+    int m_maxBodySize = 512 * 1024;
+
+    void processRequest(QTcpSocket *socket, const HttpRequestParser::Request &request);
+    void sendResponse(QTcpSocket *socket, const QByteArray &status, bool keepAlive);
+
+private slots:
+    void readClient();
+    void onDisconnected();
+};
+
+#endif // SONOSEVENTSERVER_H
@@ -0,0 +1,363 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "sonosgroupevents.h"
+#include "extern-plugininfo.h"
+
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QXmlStreamReader>
+
+static const QString avTransportEventPath = "/MediaRenderer/AVTransport/Event";
+static const QString groupRenderingControlEventPath = "/MediaRenderer/GroupRenderingControl/Event";
+static const QString zoneGroupTopologyEventPath = "/ZoneGroupTopology/Event";
+
+SonosGroupEvents::SonosGroupEvents(NetworkAccessManager *networkManager, SonosEventServer *eventServer, const QString &groupId, const QHostAddress &address, QObject *parent) :
+    QObject(parent),
+    m_networkManager(networkManager),
+    m_eventServer(eventServer),
+    m_groupId(groupId),
+    m_address(address)
+{
+    m_playBack = Sonos::PlayBackObject();
+    m_playBack.playbackState = Sonos::PlayBackStateIdle;
+    m_volume = Sonos::VolumeObject();
+
+    m_eventServer->addSpeaker(m_address);
+    connect(m_eventServer, &SonosEventServer::notificationReceived, this, &SonosGroupEvents::onNotificationReceived);
+
+    foreach (const QString &eventPath, QStringList() << avTransportEventPath << groupRenderingControlEventPath << zoneGroupTopologyEventPath) {
+        Subscription subscription;
+        subscription.renewTimer = new QTimer(this);
+        subscription.renewTimer->setSingleShot(true);
+        connect(subscription.renewTimer, &QTimer::timeout, this, [this, eventPath](){
+            sendSubscribe(eventPath);
+        });
+        m_subscriptions.insert(eventPath, subscription);
+    }
+}
+
+SonosGroupEvents::~SonosGroupEvents()
+{
+    foreach (const QString &eventPath, m_subscriptions.keys()) {
+        sendUnsubscribe(eventPath);
+    }
+    if (m_eventServer) {
+        m_eventServer->removeSpeaker(m_address);
+    }
+}
+
+QString SonosGroupEvents::groupId() const
+{
+    return m_groupId;
+}
+
+QHostAddress SonosGroupEvents::address() const
+{
+    return m_address;
+}
+
+bool SonosGroupEvents::subscribed() const
+{
+    return m_subscribed;
+}
+
+void SonosGroupEvents::subscribe()
+{
+    foreach (const QString &eventPath, m_subscriptions.keys()) {
+        sendSubscribe(eventPath);
+    }
+}
+
+void SonosGroupEvents::sendSubscribe(const QString &eventPath)
+{
+    Subscription &subscription = m_subscriptions[eventPath];
+    subscription.renewTimer->stop();
+
+    QNetworkRequest request(QUrl(QString("http://%1:1400%2").arg(m_address.toString()).arg(eventPath)));
+    request.setRawHeader("TIMEOUT", "Second-" + QByteArray::number(m_subscriptionTimeout));
+    bool renewal = !subscription.sid.isEmpty();
+    if (renewal) {
+        request.setRawHeader("SID", subscription.sid);
+    } else {
+        QUrl callbackUrl = m_eventServer->callbackUrl(m_address, "/" + m_groupId + eventPath);
+        if (callbackUrl.isEmpty()) {
+            qCWarning(dcSonos()) << "Group events: No route to" << m_address.toString() << "retrying in" << m_retryInterval << "seconds";
+            setSubscriptionActive(eventPath, false);
+            subscription.renewTimer->start(m_retryInterval * 1000);
+            return;
+        }
+        request.setRawHeader("CALLBACK", "<" + callbackUrl.toEncoded() + ">");
+        request.setRawHeader("NT", "upnp:event");
+    }
+
+    QNetworkReply *reply = m_networkManager->sendCustomRequest(request, "SUBSCRIBE");
+    connect(reply, &QNetworkReply::finished, reply, &QNetworkReply::deleteLater);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, eventPath, renewal](){
+        Subscription &subscription = m_subscriptions[eventPath];
+        int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (status != 200 || reply->error() != QNetworkReply::NoError) {
+            subscription.sid.clear();
+            if (renewal) {
+                // The speaker forgot the subscription (reboot, expiry), start a fresh one right away
+                qCDebug(dcSonos()) << "Group events: Renewing" << eventPath << "on" << m_address.toString() << "failed, subscribing again";
+                sendSubscribe(eventPath);
+                return;
+            }
+            qCWarning(dcSonos()) << "Group events: Subscribing" << eventPath << "on" << m_address.toString() << "failed:" << status << reply->errorString();
+            setSubscriptionActive(eventPath, false);
+            subscription.renewTimer->start(m_retryInterval * 1000);
+            return;
+        }
+
+        subscription.sid = reply->rawHeader("SID");
+        int timeout = m_subscriptionTimeout;
+        QByteArray timeoutHeader = reply->rawHeader("TIMEOUT");
+        if (timeoutHeader.toLower().startsWith("second-")) {
+            timeout = qMax(60, timeoutHeader.mid(7).toInt());
+        }
+        // Renew well ahead of the expiry so a slow round trip doesn't let the subscription lapse
+        subscription.renewTimer->start(timeout * 800);
+        setSubscriptionActive(eventPath, true);
+
+        for (int i = 0; i < m_unmatchedNotifications.count(); i++) {
+            if (m_unmatchedNotifications.at(i).first == subscription.sid) {
+                processNotification(eventPath, m_unmatchedNotifications.takeAt(i).second);
+                i--;
+            }
+        }
+    });
+}
+
+void SonosGroupEvents::sendUnsubscribe(const QString &eventPath)
+{
+    Subscription subscription = m_subscriptions.value(eventPath);
+    if (subscription.sid.isEmpty()) {
+        return;
+    }
+
+    QNetworkRequest request(QUrl(QString("http://%1:1400%2").arg(m_address.toString()).arg(eventPath)));
+    request.setRawHeader("SID", subscription.sid);
+    QNetworkReply *reply = m_networkManager->sendCustomRequest(request, "UNSUBSCRIBE");
+    connect(reply, &QNetworkReply::finished, reply, &QNetworkReply::deleteLater);
+}
+
+void SonosGroupEvents::setSubscriptionActive(const QString &eventPath, bool active)
+{
+    m_subscriptions[eventPath].active = active;
+
+    bool subscribed = true;
+    foreach (const Subscription &subscription, m_subscriptions) {
+        subscribed &= subscription.active;
+    }
+
+    if (m_subscribed != subscribed) {
+        m_subscribed = subscribed;
+        qCDebug(dcSonos()) << "Group events:" << m_groupId << (subscribed ? "receiving local events" : "lost local events");
+        emit subscribedChanged(m_groupId, subscribed);
+    }
+}
+
+void SonosGroupEvents::onNotificationReceived(const QByteArray &sid, const QByteArray &body)
+{
+    foreach (const QString &eventPath, m_subscriptions.keys()) {
+        if (m_subscriptions.value(eventPath).sid == sid) {
+            processNotification(eventPath, body);
+            return;
+        }
+    }
+
+    // Might belong to a subscription whose response is still on its way, or to another group
+    m_unmatchedNotifications.append(qMakePair(sid, body));
+    while (m_unmatchedNotifications.count() > m_maxUnmatchedNotifications) {
+        m_unmatchedNotifications.removeFirst();
+    }
+}
+
+void SonosGroupEvents::processNotification(const QString &eventPath, const QByteArray &body)
+{
+    QHash<QString, QString> properties = parsePropertySet(body);
+
+    if (eventPath == avTransportEventPath) {
+        if (properties.contains("LastChange")) {
+            processAvTransportChange(properties.value("LastChange"));
+        }
+    } else if (eventPath == groupRenderingControlEventPath) {
+        processGroupRenderingControlChange(properties);
+    } else if (eventPath == zoneGroupTopologyEventPath) {
+        // The initial event only reflects the current topology, which is known already
+        if (properties.contains("ZoneGroupState") && m_topologyReceived) {
+            emit topologyChanged(m_groupId);
+        }
+        m_topologyReceived = true;
+    }
+}
+
+QHash<QString, QString> SonosGroupEvents::parsePropertySet(const QByteArray &body) const
+{
+    // <e:propertyset><e:property><Name>value</Name></e:property>...</e:propertyset>
+    QHash<QString, QString> properties;
+    QXmlStreamReader reader(body);
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (reader.isStartElement() && reader.name() == QLatin1String("property")) {
+            if (reader.readNextStartElement()) {
+                QString name = reader.name().toString();
+                properties.insert(name, reader.readElementText(QXmlStreamReader::IncludeChildElements));
+            }
+        }
+    }
+    if (reader.hasError()) {
+        qCWarning(dcSonos()) << "Group events: Invalid property set:" << reader.errorString();
+    }
+    return properties;
+}
+
+void SonosGroupEvents::processAvTransportChange(const QString &lastChange)
+{
+    // <Event><InstanceID val="0"><TransportState val="PLAYING"/>...</InstanceID></Event>
+    // Only changed variables are contained, keep the previous values for the rest
+    bool playBackChanged = false;
+    QString trackMetadata;
+    bool metadataChanged = false;
+
+    QXmlStreamReader reader(lastChange);
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (!reader.isStartElement() || !reader.attributes().hasAttribute("val")) {
+            continue;
+        }
+
+        QStringRef name = reader.name();
+        QString value = reader.attributes().value("val").toString();
+        if (name == QLatin1String("TransportState")) {
+            if (value == "PLAYING") {
+                m_playBack.playbackState = Sonos::PlayBackStatePlaying;
+            } else if (value == "PAUSED_PLAYBACK") {
+                m_playBack.playbackState = Sonos::PlayBackStatePause;
+            } else if (value == "TRANSITIONING") {
+                m_playBack.playbackState = Sonos::PlayBackStateBuffering;
+            } else {
+                m_playBack.playbackState = Sonos::PlayBackStateIdle;
+            }
+            playBackChanged = true;
+        } else if (name == QLatin1String("CurrentPlayMode")) {
+            m_playBack.playMode.shuffle = value.startsWith("SHUFFLE");
+            m_playBack.playMode.repeatOne = value.endsWith("REPEAT_ONE");
+            m_playBack.playMode.repeat = (value == "REPEAT_ALL" || value == "SHUFFLE");
+            playBackChanged = true;
+        } else if (name == QLatin1String("CurrentCrossfadeMode")) {
+            m_playBack.playMode.crossfade = (value == "1");
+            playBackChanged = true;
+        } else if (name == QLatin1String("CurrentTrackMetaData")) {
+            trackMetadata = value;
+            metadataChanged = true;
+        } else if (name == QLatin1String("EnqueuedTransportURIMetaData")) {
+            m_enqueuedMetadata = value;
+        }
+    }
+
+    if (reader.hasError()) {
+        qCWarning(dcSonos()) << "Group events: Invalid AVTransport LastChange:" << reader.errorString();
+        return;
+    }
+
+    if (playBackChanged) {
+        emit playBackStatusReceived(m_groupId, m_playBack);
+    }
+    if (metadataChanged) {
+        emit metadataStatusReceived(m_groupId, parseTrackMetadata(trackMetadata, m_enqueuedMetadata));
+    }
+}
+
+void SonosGroupEvents::processGroupRenderingControlChange(const QHash<QString, QString> &properties)
+{
+    if (!properties.contains("GroupVolume") && !properties.contains("GroupMute")) {
+        return;
+    }
+
+    if (properties.contains("GroupVolume")) {
+        m_volume.volume = properties.value("GroupVolume").toInt();
+    }
+    if (properties.contains("GroupMute")) {
+        m_volume.muted = (properties.value("GroupMute") == "1");
+    }
+    if (properties.contains("GroupVolumeChangeable")) {
+        m_volume.fixed = (properties.value("GroupVolumeChangeable") == "0");
+    }
+    emit volumeReceived(m_groupId, m_volume);
+}
+
+Sonos::MetadataStatus SonosGroupEvents::parseTrackMetadata(const QString &didl, const QString &enqueuedDidl) const
+{
+    Sonos::MetadataStatus metadata = Sonos::MetadataStatus();
+    QString streamContent;
+
+    // <DIDL-Lite><item><dc:title/><dc:creator/><upnp:album/><upnp:albumArtURI/><r:streamContent/></item></DIDL-Lite>
+    QXmlStreamReader reader(didl);
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (!reader.isStartElement()) {
+            continue;
+        }
+        QStringRef name = reader.name();
+        if (name == QLatin1String("title")) {
+            metadata.currentItem.track.name = reader.readElementText();
+        } else if (name == QLatin1String("creator")) {
+            metadata.currentItem.track.artist.name = reader.readElementText();
+        } else if (name == QLatin1String("album")) {
+            metadata.currentItem.track.album.name = reader.readElementText();
+        } else if (name == QLatin1String("albumArtURI")) {
+            QString artUri = reader.readElementText();
+            // Sonos hands out art relative to the speaker
+            if (artUri.startsWith("/")) {
+                artUri = QString("http://%1:1400%2").arg(m_address.toString()).arg(artUri);
+            }
+            metadata.currentItem.track.imageUrl = artUri;
+        } else if (name == QLatin1String("streamContent")) {
+            streamContent = reader.readElementText();
+        }
+    }
+
+    // Radio streams carry the current song in streamContent and the station in the enqueued metadata
+    if (!streamContent.isEmpty()) {
+        QXmlStreamReader enqueuedReader(enqueuedDidl);
+        while (!enqueuedReader.atEnd()) {
+            enqueuedReader.readNext();
+            if (enqueuedReader.isStartElement() && enqueuedReader.name() == QLatin1String("title")) {
+                metadata.container.name = enqueuedReader.readElementText();
+                break;
+            }
+        }
+        metadata.currentItem.track.album.name = metadata.container.name;
+        metadata.currentItem.track.name = streamContent;
+    }
+    return metadata;
+}
@@ -0,0 +1,107 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef SONOSGROUPEVENTS_H
+#define SONOSGROUPEVENTS_H
+
+#include <QObject>
+#include <QTimer>
+#include <QHostAddress>
+#include <QHash>
+#include <QPointer>
+
+#include "network/networkaccessmanager.h"
+#include "sonos.h"
+#include "sonoseventserver.h"
+
+// UPnP GENA subscriptions on the coordinator of a group, delivers the same objects as the cloud API
+class SonosGroupEvents : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SonosGroupEvents(NetworkAccessManager *networkManager, SonosEventServer *eventServer, const QString &groupId, const QHostAddress &address, QObject *parent = nullptr);
+    ~SonosGroupEvents();
+
+    QString groupId() const;
+    QHostAddress address() const;
+    bool subscribed() const;
+
+    void subscribe();
+
+signals:
+    void subscribedChanged(const QString &groupId, bool subscribed);
+    void topologyChanged(const QString &groupId);
+
+    void playBackStatusReceived(const QString &groupId, Sonos::PlayBackObject playBack);
+    void metadataStatusReceived(const QString &groupId, Sonos::MetadataStatus metaDataStatus);
+    void volumeReceived(const QString &groupId, Sonos::VolumeObject groupVolume);
+
+private:
+    struct Subscription {
+        QByteArray sid;
+        bool active = false;
+        QTimer *renewTimer = nullptr;
+    };
+
+    NetworkAccessManager *m_networkManager = nullptr;
+    // Note: the plugin may delete the server before the group events
+    QPointer<SonosEventServer> m_eventServer;
+    QString m_groupId;
+    QHostAddress m_address;
+
+    int m_subscriptionTimeout = 1800;
+    int m_retryInterval = 30;
+    QHash<QString, Subscription> m_subscriptions;
+    bool m_subscribed = false;
+    bool m_topologyReceived = false;
+
+    // NOTIFY requests may overtake the SUBSCRIBE response carrying the SID
+    QList<QPair<QByteArray, QByteArray> > m_unmatchedNotifications;
+    int m_maxUnmatchedNotifications = 16;
+
+    Sonos::PlayBackObject m_playBack;
+    Sonos::VolumeObject m_volume;
+    QString m_enqueuedMetadata;
+
+    void sendSubscribe(const QString &eventPath);
+    void sendUnsubscribe(const QString &eventPath);
+    void setSubscriptionActive(const QString &eventPath, bool active);
+    void processNotification(const QString &eventPath, const QByteArray &body);
+
+    QHash<QString, QString> parsePropertySet(const QByteArray &body) const;
+    void processAvTransportChange(const QString &lastChange);
+    void processGroupRenderingControlChange(const QHash<QString, QString> &properties);
+    Sonos::MetadataStatus parseTrackMetadata(const QString &didl, const QString &enqueuedDidl) const;
+
+private slots:
+    void onNotificationReceived(const QByteArray &sid, const QByteArray &body);
+};
+
+#endif // SONOSGROUPEVENTS_H
@@ -0,0 +1,408 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "sonosrequestscheduler.h"
+#include "extern-plugininfo.h"
+
+SonosReply::SonosReply(QObject *parent) :
+    QObject(parent)
+{
+
+}
+
+QVariant SonosReply::attribute(QNetworkRequest::Attribute code) const
+{
+    if (code == QNetworkRequest::HttpStatusCodeAttribute && m_status != 0)
+        return m_status;
+
+    return QVariant();
+}
+
+QNetworkReply::NetworkError SonosReply::error() const
+{
+    return m_error;
+}
+
+QString SonosReply::errorString() const
+{
+    return m_errorString;
+}
+
+QByteArray SonosReply::readAll() const
+{
+    return m_data;
+}
+
+SonosRequestScheduler::SonosRequestScheduler(NetworkAccessManager *networkManager, QObject *parent) :
+    QObject(parent),
+    m_networkManager(networkManager)
+{
+    m_resumeTimer = new QTimer(this);
+    m_resumeTimer->setSingleShot(true);
+    connect(m_resumeTimer, &QTimer::timeout, this, &SonosRequestScheduler::onResumeTimeout);
+
+    m_deferTimer = new QTimer(this);
+    m_deferTimer->setSingleShot(true);
+    connect(m_deferTimer, &QTimer::timeout, this, &SonosRequestScheduler::onDeferTimeout);
+
+    m_statisticsTimer = new QTimer(this);
+    m_statisticsTimer->setInterval(60000);
+    connect(m_statisticsTimer, &QTimer::timeout, this, &SonosRequestScheduler::onStatisticsTimeout);
+    m_statisticsTimer->start();
+}
+
+SonosRequestScheduler::~SonosRequestScheduler()
+{
+    foreach (const Household &household, m_households) {
+        qDeleteAll(household.inFlight);
+        qDeleteAll(household.userQueue);
+        qDeleteAll(household.pollQueue);
+    }
+    qDeleteAll(m_deferred);
+}
+
+void SonosRequestScheduler::setAuthorization(const QByteArray &authorization)
+{
+    m_authorization = authorization;
+}
+
+SonosReply *SonosRequestScheduler::get(const QString &householdId, const QNetworkRequest &request, Priority priority)
+{
+    Request *pending = m_pendingGets.value(request.url());
+    if (pending)
+        return join(pending, priority);
+
+    Request *newRequest = createRequest("GET", request, QByteArray(), priority);
+    newRequest->householdId = householdId;
+    SonosReply *reply = newRequest->replies.first();
+    enqueue(newRequest);
+    return reply;
+}
+
+SonosReply *SonosRequestScheduler::post(const QString &householdId, const QNetworkRequest &request, const QByteArray &data, Priority priority)
+{
+    Request *newRequest = createRequest("POST", request, data, priority);
+    newRequest->householdId = householdId;
+    SonosReply *reply = newRequest->replies.first();
+    enqueue(newRequest);
+    return reply;
+}
+
+void SonosRequestScheduler::setHouseholdId(const QString &id, const QString &householdId)
+{
+    m_householdIds.insert(id, householdId);
+
+    QList<Request *> resumed;
+    foreach (Request *request, m_deferred) {
+        if (request->id == id)
+            resumed.append(request);
+    }
+    foreach (Request *request, resumed) {
+        m_deferred.removeOne(request);
+        request->householdId = householdId;
+        enqueue(request);
+    }
+}
+
+SonosReply *SonosRequestScheduler::getFor(const QString &id, const QNetworkRequest &request, Priority priority)
+{
+    Request *pending = m_pendingGets.value(request.url());
+    if (pending)
+        return join(pending, priority);
+
+    Request *newRequest = createRequest("GET", request, QByteArray(), priority);
+    newRequest->id = id;
+    SonosReply *reply = newRequest->replies.first();
+    defer(newRequest);
+    return reply;
+}
+
+SonosReply *SonosRequestScheduler::postFor(const QString &id, const QNetworkRequest &request, const QByteArray &data, Priority priority)
+{
+    Request *newRequest = createRequest("POST", request, data, priority);
+    newRequest->id = id;
+    SonosReply *reply = newRequest->replies.first();
+    defer(newRequest);
+    return reply;
+}
+
+SonosRequestScheduler::Statistics SonosRequestScheduler::statistics() const
+{
+    Statistics statistics = m_statistics;
+    foreach (const Household &household, m_households) {
+        statistics.requestsQueued += household.userQueue.count() + household.pollQueue.count();
+        statistics.requestsInFlight += household.inFlight.count();
+    }
+    statistics.requestsQueued += m_deferred.count();
+    return statistics;
+}
+
+SonosRequestScheduler::Request *SonosRequestScheduler::createRequest(const QByteArray &verb, const QNetworkRequest &request, const QByteArray &data, Priority priority)
+{
+    Request *newRequest = new Request();
+    newRequest->verb = verb;
+    newRequest->request = request;
+    newRequest->data = data;
+    newRequest->priority = priority;
+    newRequest->replies.append(new SonosReply(this));
+    if (verb == "GET")
+        m_pendingGets.insert(request.url(), newRequest);
+
+    return newRequest;
+}
+
+SonosReply *SonosRequestScheduler::join(Request *pending, Priority priority)
+{
+    m_statistics.requestsDeduplicated++;
+    qCDebug(dcSonos()) << "Joining pending request" << pending->request.url().path();
+    // A user request waiting behind polls takes its place in the user queue
+    if (priority == PriorityUser && pending->priority == PriorityPoll) {
+        QHash<QString, Household>::iterator household = m_households.find(pending->householdId);
+        if (household != m_households.end() && household->pollQueue.removeOne(pending)) {
+            household->userQueue.append(pending);
+        }
+        pending->priority = PriorityUser;
+    }
+    SonosReply *reply = new SonosReply(this);
+    pending->replies.append(reply);
+    return reply;
+}
+
+void SonosRequestScheduler::enqueue(Request *request)
+{
+    Household &household = m_households[request->householdId];
+    if (request->priority == PriorityUser) {
+        household.userQueue.append(request);
+    } else {
+        household.pollQueue.append(request);
+    }
+    dispatch(request->householdId);
+}
+
+void SonosRequestScheduler::defer(Request *request)
+{
+    request->householdId = m_householdIds.value(request->id);
+    if (!request->householdId.isEmpty()) {
+        enqueue(request);
+        return;
+    }
+
+    qCDebug(dcSonos()) << "Deferring request" << request->request.url().path() << "until the household of" << request->id << "is known";
+    request->deferredSince = QDateTime::currentDateTimeUtc();
+    m_deferred.append(request);
+    if (!m_deferTimer->isActive())
+        m_deferTimer->start(m_maxDeferTime * 1000);
+}
+
+void SonosRequestScheduler::dispatch(const QString &householdId)
+{
+    Household &household = m_households[householdId];
+    if (household.blockedUntil.isValid()) {
+        if (household.blockedUntil > QDateTime::currentDateTimeUtc()) {
+            scheduleResume();
+            return;
+        }
+        household.blockedUntil = QDateTime();
+    }
+
+    while (household.inFlight.count() < m_maxInFlight) {
+        Request *request = nullptr;
+        if (!household.userQueue.isEmpty()) {
+            request = household.userQueue.takeFirst();
+        } else if (!household.pollQueue.isEmpty()) {
+            request = household.pollQueue.takeFirst();
+        } else {
+            break;
+        }
+        household.inFlight.append(request);
+        send(request);
+    }
+}
+
+void SonosRequestScheduler::send(Request *request)
+{
+    QNetworkRequest networkRequest = request->request;
+    // The access token may have been refreshed while the request was queued
+    if (!m_authorization.isEmpty())
+        networkRequest.setRawHeader("Authorization", m_authorization);
+
+    QNetworkReply *reply;
+    if (request->verb == "GET") {
+        reply = m_networkManager->get(networkRequest);
+    } else {
+        reply = m_networkManager->post(networkRequest, request->data);
+    }
+    request->attempts++;
+    m_statistics.requestsSent++;
+    connect(reply, &QNetworkReply::finished, this, [this, request, reply] {
+        finishRequest(request, reply);
+    });
+}
+
+void SonosRequestScheduler::finishRequest(Request *request, QNetworkReply *reply)
+{
+    reply->deleteLater();
+    QString householdId = request->householdId;
+    Household &household = m_households[householdId];
+    household.inFlight.removeOne(request);
+
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status == 429) {
+        m_statistics.requestsThrottled++;
+        int delay = retryAfter(reply);
+        if (delay <= 0) {
+            household.backoff = qBound(1, household.backoff * 2, m_maxBackoff);
+            delay = household.backoff;
+        }
+        household.blockedUntil = QDateTime::currentDateTimeUtc().addSecs(delay);
+        qCWarning(dcSonos()) << "Household" << householdId << "is rate limited, pausing requests for" << delay << "seconds";
+
+        if (request->attempts < m_maxAttempts) {
+            // Retry first once the household is released again
+            if (request->priority == PriorityUser) {
+                household.userQueue.prepend(request);
+            } else {
+                household.pollQueue.prepend(request);
+            }
+            scheduleResume();
+            return;
+        }
+    } else {
+        household.backoff = 0;
+    }
+
+    if (request->verb == "GET")
+        m_pendingGets.remove(request->request.url());
+
+    QByteArray data = reply->readAll();
+    foreach (QPointer<SonosReply> sonosReply, request->replies) {
+        if (sonosReply.isNull())
+            continue;
+
+        sonosReply->m_status = status;
+        sonosReply->m_error = reply->error();
+        sonosReply->m_errorString = reply->errorString();
+        sonosReply->m_data = data;
+        emit sonosReply->finished();
+    }
+    delete request;
+
+    dispatch(householdId);
+}
+
+void SonosRequestScheduler::scheduleResume()
+{
+    QDateTime now = QDateTime::currentDateTimeUtc();
+    qint64 next = -1;
+    foreach (const Household &household, m_households) {
+        if (!household.blockedUntil.isValid())
+            continue;
+
+        qint64 remaining = qMax<qint64>(0, now.msecsTo(household.blockedUntil));
+        if (next < 0 || remaining < next)
+            next = remaining;
+    }
+    if (next < 0)
+        return;
+
+    if (!m_resumeTimer->isActive() || m_resumeTimer->remainingTime() > next)
+        m_resumeTimer->start(static_cast<int>(next));
+}
+
+int SonosRequestScheduler::retryAfter(QNetworkReply *reply) const
+{
+    // Retry-After is either delta seconds or an HTTP date
+    QByteArray value = reply->rawHeader("Retry-After").trimmed();
+    if (value.isEmpty())
+        return 0;
+
+    bool ok;
+    int seconds = value.toInt(&ok);
+    if (ok)
+        return qMin(seconds, m_maxBackoff * 5);
+
+    QDateTime date = QDateTime::fromString(QString::fromLatin1(value), Qt::RFC2822Date);
+    if (!date.isValid())
+        return 0;
+
+    return static_cast<int>(qBound<qint64>(0, QDateTime::currentDateTimeUtc().secsTo(date), m_maxBackoff * 5));
+}
+
+void SonosRequestScheduler::onResumeTimeout()
+{
+    foreach (const QString &householdId, m_households.keys()) {
+        dispatch(householdId);
+    }
+}
+
+void SonosRequestScheduler::onDeferTimeout()
+{
+    QDateTime now = QDateTime::currentDateTimeUtc();
+    QList<Request *> expired;
+    foreach (Request *request, m_deferred) {
+        if (request->deferredSince.addSecs(m_maxDeferTime) <= now)
+            expired.append(request);
+    }
+
+    foreach (Request *request, expired) {
+        m_deferred.removeOne(request);
+        if (request->verb == "GET")
+            m_pendingGets.remove(request->request.url());
+
+        qCWarning(dcSonos()) << "Household of" << request->id << "is unknown, dropping request" << request->request.url().path();
+        foreach (QPointer<SonosReply> sonosReply, request->replies) {
+            if (sonosReply.isNull())
+                continue;
+
+            sonosReply->m_error = QNetworkReply::OperationCanceledError;
+            sonosReply->m_errorString = "Household of " + request->id + " is unknown";
+            emit sonosReply->finished();
+        }
+        delete request;
+    }
+
+    if (!m_deferred.isEmpty()) {
+        qint64 remaining = now.msecsTo(m_deferred.first()->deferredSince.addSecs(m_maxDeferTime));
+        m_deferTimer->start(static_cast<int>(qMax<qint64>(0, remaining)));
+    }
+}
+
+void SonosRequestScheduler::onStatisticsTimeout()
+{
+    Statistics statistics = this->statistics();
+    // Nothing to report while the scheduler is idle
+    if (statistics.requestsSent == m_loggedRequestsSent && statistics.requestsQueued == 0 && statistics.requestsInFlight == 0)
+        return;
+
+    m_loggedRequestsSent = statistics.requestsSent;
+    qCDebug(dcSonos()) << "Cloud requests sent:" << statistics.requestsSent << "deduplicated:" << statistics.requestsDeduplicated
+                       << "throttled:" << statistics.requestsThrottled << "queued:" << statistics.requestsQueued
+                       << "in flight:" << statistics.requestsInFlight;
+}
@@ -0,0 +1,158 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef SONOSREQUESTSCHEDULER_H
+#define SONOSREQUESTSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QHash>
+#include <QPointer>
+#include <QDateTime>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+
+#include "network/networkaccessmanager.h"
+
+// Result of a scheduled request, several replies can share one network request
+class SonosReply : public QObject
+{
+    Q_OBJECT
+    friend class SonosRequestScheduler;
+public:
+    explicit SonosReply(QObject *parent = nullptr);
+
+    QVariant attribute(QNetworkRequest::Attribute code) const;
+    QNetworkReply::NetworkError error() const;
+    QString errorString() const;
+    QByteArray readAll() const;
+
+signals:
+    void finished();
+
+private:
+    int m_status = 0;
+    QNetworkReply::NetworkError m_error = QNetworkReply::NoError;
+    QString m_errorString;
+    QByteArray m_data;
+};
+
+// Queues Control API requests per household, user actions are sent before background polls
+class SonosRequestScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum Priority {
+        PriorityUser,
+        PriorityPoll
+    };
+
+    struct Statistics {
+        int requestsSent = 0;
+        int requestsDeduplicated = 0;
+        int requestsThrottled = 0;
+        int requestsQueued = 0;
+        int requestsInFlight = 0;
+    };
+
+    explicit SonosRequestScheduler(NetworkAccessManager *networkManager, QObject *parent = nullptr);
+    ~SonosRequestScheduler();
+
+    void setAuthorization(const QByteArray &authorization);
+
+    SonosReply *get(const QString &householdId, const QNetworkRequest &request, Priority priority = PriorityPoll);
+    SonosReply *post(const QString &householdId, const QNetworkRequest &request, const QByteArray &data, Priority priority = PriorityUser);
+
+    // Requests for a group or player wait until the household of the id is known from the groups
+    void setHouseholdId(const QString &id, const QString &householdId);
+    SonosReply *getFor(const QString &id, const QNetworkRequest &request, Priority priority = PriorityPoll);
+    SonosReply *postFor(const QString &id, const QNetworkRequest &request, const QByteArray &data, Priority priority = PriorityUser);
+
+    Statistics statistics() const;
+
+private:
+    struct Request {
+        QString householdId;
+        QString id;
+        QDateTime deferredSince;
+        QByteArray verb;
+        QNetworkRequest request;
+        QByteArray data;
+        Priority priority = PriorityPoll;
+        int attempts = 0;
+        QList<QPointer<SonosReply> > replies;
+    };
+
+    struct Household {
+        QList<Request *> userQueue;
+        QList<Request *> pollQueue;
+        QList<Request *> inFlight;
+        int backoff = 0;
+        QDateTime blockedUntil;
+    };
+
+    NetworkAccessManager *m_networkManager = nullptr;
+    QTimer *m_resumeTimer = nullptr;
+    QTimer *m_deferTimer = nullptr;
+    QTimer *m_statisticsTimer = nullptr;
+    QByteArray m_authorization;
+
+    int m_maxInFlight = 2;
+    int m_maxAttempts = 3;
+    int m_maxBackoff = 60;
+    int m_maxDeferTime = 30;
+
+    QHash<QString, Household> m_households;
+    // Household of each group and player id
+    QHash<QString, QString> m_householdIds;
+    // Requests waiting for the household of their group or player id
+    QList<Request *> m_deferred;
+    // Identical GETs which are queued or in flight, keyed by url
+    QHash<QUrl, Request *> m_pendingGets;
+    Statistics m_statistics;
+    int m_loggedRequestsSent = 0;
+
+    Request *createRequest(const QByteArray &verb, const QNetworkRequest &request, const QByteArray &data, Priority priority);
+    SonosReply *join(Request *pending, Priority priority);
+    void enqueue(Request *request);
+    void defer(Request *request);
+    void dispatch(const QString &householdId);
+    void send(Request *request);
+    void finishRequest(Request *request, QNetworkReply *reply);
+    void scheduleResume();
+    int retryAfter(QNetworkReply *reply) const;
+
+private slots:
+    void onResumeTimeout();
+    void onDeferTimeout();
+    void onStatisticsTimeout();
+};
+
+#endif // SONOSREQUESTSCHEDULER_H
@@ -35,6 +35,7 @@
 #include <QNetworkReply>
 #include <QHostAddress>
 #include <QJsonDocument>
+#include <QTimer>
 
 #include "hardwaremanager.h"
 #include "network/networkaccessmanager.h"
@@ -70,6 +71,16 @@ static QHash<ThingClassId, QHash<QString, StateTypeId>> stateMaps = {
     {sonoff_dimmerThingClassId, sonoff_dimmerPowerStateTypeIds}
 };
 
+// Tasmota executes up to 30 commands per Backlog
+static const int maxBacklogCommands = 30;
+
+static QString normalizedChannelName(const QString &channelName)
+{
+    // Single relay devices publish POWER instead of POWER1
+    QString name = channelName.toUpper();
+    return name == "POWER" ? QString("POWER1") : name;
+}
+
 IntegrationPluginTasmota::IntegrationPluginTasmota()
 {
     // Helper maps for parent devices (aka sonoff_*)
@@ -191,6 +202,7 @@ void IntegrationPluginTasmota::setupThing(ThingSetupInfo *info)
             connect(channel, &MqttChannel::clientConnected, this, &IntegrationPluginTasmota::onClientConnected);
             connect(channel, &MqttChannel::clientDisconnected, this, &IntegrationPluginTasmota::onClientDisconnected);
             connect(channel, &MqttChannel::publishReceived, this, &IntegrationPluginTasmota::onPublishReceived);
+            setupTopicRoutes(info->thing(), channel);
 
             qCDebug(dcTasmota) << "Sonoff setup complete";
             info->finish(Thing::ThingErrorNoError);
@@ -284,6 +296,12 @@ void IntegrationPluginTasmota::thingRemoved(Thing *thing)
         MqttChannel* channel = m_mqttChannels.take(thing);
         hardwareManager()->mqttProvider()->releaseChannel(channel);
     }
+    m_pendingCommands.remove(thing);
+    foreach (const QString &topic, m_topicRoutes.keys()) {
+        if (m_topicRoutes.value(topic).thing == thing) {
+            m_topicRoutes.remove(topic);
+        }
+    }
 }
 
 void IntegrationPluginTasmota::executeAction(ThingActionInfo *info)
@@ -296,31 +314,24 @@ void IntegrationPluginTasmota::executeAction(ThingActionInfo *info)
             || thing->thingClassId() == sonoff_triThingClassId
             || thing->thingClassId() == sonoff_quadThingClassId
             || action.actionTypeId() == sonoff_dimmerPowerActionTypeId) {
-        MqttChannel *channel = m_mqttChannels.value(thing);
-        if (!channel) {
+        if (!m_mqttChannels.contains(thing)) {
             qCWarning(dcTasmota()) << "No MQTT channel for this thing.";
             info->finish(Thing::ThingErrorHardwareNotAvailable);
             return;
         }
         QString channelName = stateMaps.value(thing->thingClassId()).key(action.actionTypeId());
-        QByteArray payload = action.paramValue(action.actionTypeId()).toBool() ? "ON" : "OFF";
-        qCDebug(dcTasmota) << "Publishing:" << channel->topicPrefixList().first() + "/sonoff/cmnd/" + channelName << payload;
-        channel->publish(channel->topicPrefixList().first() + "/sonoff/cmnd/" + channelName, payload);
+        queueCommand(thing, channelName, action.paramValue(action.actionTypeId()).toBool() ? "ON" : "OFF");
         thing->setStateValue(action.actionTypeId(), action.paramValue(action.actionTypeId()));
         info->finish(Thing::ThingErrorNoError);
         return;
     }
     if (action.actionTypeId() == sonoff_dimmerBrightnessActionTypeId) {
-        MqttChannel *channel = m_mqttChannels.value(thing);
-        if (!channel) {
+        if (!m_mqttChannels.contains(thing)) {
             qCWarning(dcTasmota()) << "No MQTT channel for this thing:" << thing->name();
             info->finish(Thing::ThingErrorHardwareNotAvailable);
             return;
         }
-        QString channelName = stateMaps.value(thing->thingClassId()).key(action.actionTypeId());
-        QByteArray payload = QByteArray::number(action.paramValue(action.actionTypeId()).toInt());
-        qCDebug(dcTasmota) << "Publishing:" << channel->topicPrefixList().first() + "/sonoff/cmnd/DIMMER1" + channelName << payload;
-        channel->publish(channel->topicPrefixList().first() + "/sonoff/cmnd/DIMMER1" + channelName, payload);
+        queueCommand(thing, "DIMMER1", QByteArray::number(action.paramValue(action.actionTypeId()).toInt()));
         thing->setStateValue(action.actionTypeId(), action.paramValue(action.actionTypeId()));
         info->finish(Thing::ThingErrorNoError);
         return;
@@ -329,42 +340,34 @@ void IntegrationPluginTasmota::executeAction(ThingActionInfo *info)
     // Legacy (deprecated) connected devices
     if (m_powerStateTypeMap.contains(thing->thingClassId())) {
         Thing *parentDev = myThings().findById(thing->parentId());
-        MqttChannel *channel = m_mqttChannels.value(parentDev);
-        if (!channel) {
+        if (!m_mqttChannels.contains(parentDev)) {
             qCWarning(dcTasmota()) << "No mqtt channel for this thing.";
             return info->finish(Thing::ThingErrorHardwareNotAvailable);
         }
         ParamTypeId channelParamTypeId = m_channelParamTypeMap.value(thing->thingClassId());
         ParamTypeId powerActionParamTypeId = ParamTypeId(m_powerStateTypeMap.value(thing->thingClassId()).toString());
-        qCDebug(dcTasmota) << "Publishing:" << channel->topicPrefixList().first() + "/sonoff/cmnd/" + thing->paramValue(channelParamTypeId).toString() << (action.param(powerActionParamTypeId).value().toBool() ? "ON" : "OFF");
-        channel->publish(channel->topicPrefixList().first() + "/sonoff/cmnd/" + thing->paramValue(channelParamTypeId).toString().toLower(), action.param(powerActionParamTypeId).value().toBool() ? "ON" : "OFF");
+        queueCommand(parentDev, thing->paramValue(channelParamTypeId).toString().toLower(), action.param(powerActionParamTypeId).value().toBool() ? "ON" : "OFF");
         thing->setStateValue(m_powerStateTypeMap.value(thing->thingClassId()), action.param(powerActionParamTypeId).value().toBool());
         return info->finish(Thing::ThingErrorNoError);
     }
     if (m_closableStopActionTypeMap.contains(thing->thingClassId())) {
         Thing *parentDev = myThings().findById(thing->parentId());
-        MqttChannel *channel = m_mqttChannels.value(parentDev);
-        if (!channel) {
+        if (!m_mqttChannels.contains(parentDev)) {
             qCWarning(dcTasmota()) << "No mqtt channel for this thing.";
             return info->finish(Thing::ThingErrorHardwareNotAvailable);
         }
-        ParamTypeId openingChannelParamTypeId = m_openingChannelParamTypeMap.value(thing->thingClassId());
-        ParamTypeId closingChannelParamTypeId = m_closingChannelParamTypeMap.value(thing->thingClassId());
+        QString openingChannel = thing->paramValue(m_openingChannelParamTypeMap.value(thing->thingClassId())).toString().toLower();
+        QString closingChannel = thing->paramValue(m_closingChannelParamTypeMap.value(thing->thingClassId())).toString().toLower();
+        // The Backlog keeps the order, so the opposite relay is always released first
         if (action.actionTypeId() == m_closableOpenActionTypeMap.value(thing->thingClassId())) {
-            qCDebug(dcTasmota) << "Publishing:" << channel->topicPrefixList().first() + "/sonoff/cmnd/" + thing->paramValue(closingChannelParamTypeId).toString() << "OFF";
-            channel->publish(channel->topicPrefixList().first() + "/sonoff/cmnd/" + thing->paramValue(closingChannelParamTypeId).toString().toLower(), "OFF");
-            qCDebug(dcTasmota) << "Publishing:" << channel->topicPrefixList().first() + "/sonoff/cmnd/" + thing->paramValue(openingChannelParamTypeId).toString() << "ON";
-            channel->publish(channel->topicPrefixList().first() + "/sonoff/cmnd/" + thing->paramValue(openingChannelParamTypeId).toString().toLower(), "ON");
+            queueCommand(parentDev, closingChannel, "OFF");
+            queueCommand(parentDev, openingChannel, "ON");
         } else if (action.actionTypeId() == m_closableCloseActionTypeMap.value(thing->thingClassId())) {
-            qCDebug(dcTasmota) << "Publishing:" << channel->topicPrefixList().first() + "/sonoff/cmnd/" + thing->paramValue(openingChannelParamTypeId).toString() << "OFF";
-            channel->publish(channel->topicPrefixList().first() + "/sonoff/cmnd/" + thing->paramValue(openingChannelParamTypeId).toString().toLower(), "OFF");
-            qCDebug(dcTasmota) << "Publishing:" << channel->topicPrefixList().first() + "/sonoff/cmnd/" + thing->paramValue(closingChannelParamTypeId).toString() << "ON";
-            channel->publish(channel->topicPrefixList().first() + "/sonoff/cmnd/" + thing->paramValue(closingChannelParamTypeId).toString().toLower(), "ON");
+            queueCommand(parentDev, openingChannel, "OFF");
+            queueCommand(parentDev, closingChannel, "ON");
         } else { // Stop
-            qCDebug(dcTasmota) << "Publishing:" << channel->topicPrefixList().first() + "/sonoff/cmnd/" + thing->paramValue(openingChannelParamTypeId).toString() << "OFF";
-            channel->publish(channel->topicPrefixList().first() + "/sonoff/cmnd/" + thing->paramValue(openingChannelParamTypeId).toString().toLower(), "OFF");
-            qCDebug(dcTasmota) << "Publishing:" << channel->topicPrefixList().first() + "/sonoff/cmnd/" + thing->paramValue(closingChannelParamTypeId).toString() << "OFF";
-            channel->publish(channel->topicPrefixList().first() + "/sonoff/cmnd/" + thing->paramValue(closingChannelParamTypeId).toString().toLower(), "OFF");
+            queueCommand(parentDev, openingChannel, "OFF");
+            queueCommand(parentDev, closingChannel, "OFF");
         }
         return info->finish(Thing::ThingErrorNoError);
     }
@@ -399,50 +402,177 @@ void IntegrationPluginTasmota::onClientDisconnected(MqttChannel *channel)
 
 void IntegrationPluginTasmota::onPublishReceived(MqttChannel *channel, const QString &topic, const QByteArray &payload)
 {
+    Q_UNUSED(channel)
     qCDebug(dcTasmota) << "Publish received from Sonoff thing:" << topic << qUtf8Printable(payload);
-    Thing *thing = m_mqttChannels.key(channel);
-    if (topic.startsWith(channel->topicPrefixList().first() + "/sonoff/POWER")) {
-        QString channelName = topic.split("/").last();
 
-        thing->setStateValue(stateMaps.value(thing->thingClassId()).value(channelName), payload == "ON");
+    QHash<QString, TopicRoute>::const_iterator route = m_topicRoutes.constFind(topic);
+    if (route == m_topicRoutes.constEnd())
+        return;
 
-        // Legacy (deprecated) connected things via params
-        foreach (Thing *child, myThings().filterByParentId(thing->id())) {
-            if (child->paramValue(m_channelParamTypeMap.value(child->thingClassId())).toString() != channelName) {
-                continue;
-            }
-            if (m_powerStateTypeMap.contains(child->thingClassId())) {
-                child->setStateValue(m_powerStateTypeMap.value(child->thingClassId()), payload == "ON");
-            }
-            if (child->thingClassId() == tasmotaSwitchThingClassId) {
-                Event event(tasmotaSwitchPressedEventTypeId, child->id());
-                emit emitEvent(event);
+    switch (route->handler) {
+    case TopicHandlerPower:
+        setPowerState(route->thing, route->channelName, payload == "ON", true);
+        break;
+    case TopicHandlerState:
+        handleState(route->thing, payload);
+        break;
+    case TopicHandlerResult:
+        handleResult(route->thing, payload);
+        break;
+    }
+}
+
+void IntegrationPluginTasmota::setupTopicRoutes(Thing *thing, MqttChannel *channel)
+{
+    QString baseTopic = channel->topicPrefixList().first() + "/sonoff/";
+
+    // Single relay devices publish POWER instead of POWER1, the handlers map both to the same relay
+    QStringList channelNames = stateMaps.value(thing->thingClassId()).keys();
+    channelNames.append("POWER");
+    foreach (const QString &channelName, channelNames) {
+        TopicRoute route;
+        route.handler = TopicHandlerPower;
+        route.thing = thing;
+        route.channelName = channelName;
+        m_topicRoutes.insert(baseTopic + "stat/" + channelName, route);
+        m_topicRoutes.insert(baseTopic + channelName, route);
+    }
+
+    TopicRoute route;
+    route.thing = thing;
+    route.handler = TopicHandlerState;
+    m_topicRoutes.insert(baseTopic + "tele/STATE", route);
+    m_topicRoutes.insert(baseTopic + "STATE", route);
+    route.handler = TopicHandlerResult;
+    m_topicRoutes.insert(baseTopic + "stat/RESULT", route);
+}
+
+void IntegrationPluginTasmota::setPowerState(Thing *thing, const QString &channelName, bool on, bool emitPressed)
+{
+    QString relayName = normalizedChannelName(channelName);
+    if (stateMaps.value(thing->thingClassId()).contains(relayName)) {
+        thing->setStateValue(stateMaps.value(thing->thingClassId()).value(relayName), on);
+    }
+
+    // Legacy (deprecated) connected things via params
+    foreach (Thing *child, myThings().filterByParentId(thing->id())) {
+        if (normalizedChannelName(child->paramValue(m_channelParamTypeMap.value(child->thingClassId())).toString()) != relayName) {
+            continue;
+        }
+        if (m_powerStateTypeMap.contains(child->thingClassId())) {
+            child->setStateValue(m_powerStateTypeMap.value(child->thingClassId()), on);
+        }
+        if (emitPressed && child->thingClassId() == tasmotaSwitchThingClassId) {
+            Event event(tasmotaSwitchPressedEventTypeId, child->id());
+            emit emitEvent(event);
+        }
+    }
+}
+
+void IntegrationPluginTasmota::handleState(Thing *thing, const QByteArray &payload)
+{
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(dcTasmota) << "Cannot parse JSON from Tasmota device" << error.errorString();
+        return;
+    }
+    QVariantMap dataMap = jsonDoc.toVariant().toMap();
+    int signalStrength = dataMap.value("Wifi").toMap().value("RSSI").toInt();
+    thing->setStateValue(m_signalStrengthStateTypeMap.value(thing->thingClassId()), signalStrength);
+
+    if (m_brightnessStateTypeMap.contains(thing->thingClassId())) {
+        thing->setStateValue(m_brightnessStateTypeMap.value(thing->thingClassId()), dataMap.value("Dimmer").toInt());
+    }
+
+    // The state contains all relays at once
+    QHash<QString, bool> relayStates;
+    foreach (const QString &key, dataMap.keys()) {
+        if (key.startsWith("POWER")) {
+            relayStates.insert(normalizedChannelName(key), dataMap.value(key).toString() == "ON");
+        }
+    }
+    QHash<QString, StateTypeId> powerStateTypeIds = stateMaps.value(thing->thingClassId());
+    foreach (const QString &relayName, relayStates.keys()) {
+        if (powerStateTypeIds.contains(relayName)) {
+            thing->setStateValue(powerStateTypeIds.value(relayName), relayStates.value(relayName));
+        }
+    }
+
+    // Legacy (deprecated) connected things by params
+    foreach (Thing *child, myThings().filterByParentId(thing->id())) {
+        if (m_powerStateTypeMap.contains(child->thingClassId())) {
+            QString childChannel = normalizedChannelName(child->paramValue(m_channelParamTypeMap.value(child->thingClassId())).toString());
+            if (relayStates.contains(childChannel)) {
+                child->setStateValue(m_powerStateTypeMap.value(child->thingClassId()), relayStates.value(childChannel));
             }
         }
+        child->setStateValue(m_signalStrengthStateTypeMap.value(child->thingClassId()), signalStrength);
     }
-    if (topic.startsWith(channel->topicPrefixList().first() + "/sonoff/STATE")) {
-        QJsonParseError error;
-        QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
-        if (error.error != QJsonParseError::NoError) {
-            qCWarning(dcTasmota) << "Cannot parse JSON from Tasmota device" << error.errorString();
-            return;
+}
+
+void IntegrationPluginTasmota::handleResult(Thing *thing, const QByteArray &payload)
+{
+    // Command results, e.g. {"POWER2":"OFF"} or {"POWER":"ON","Dimmer":40}
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(dcTasmota) << "Cannot parse JSON from Tasmota device" << error.errorString();
+        return;
+    }
+    QVariantMap dataMap = jsonDoc.toVariant().toMap();
+    foreach (const QString &key, dataMap.keys()) {
+        if (key.startsWith("POWER")) {
+            setPowerState(thing, key, dataMap.value(key).toString() == "ON", false);
+        }
+    }
+    if (dataMap.contains("Dimmer") && m_brightnessStateTypeMap.contains(thing->thingClassId())) {
+        thing->setStateValue(m_brightnessStateTypeMap.value(thing->thingClassId()), dataMap.value("Dimmer").toInt());
+    }
+}
+
+void IntegrationPluginTasmota::queueCommand(Thing *thing, const QString &command, const QByteArray &payload)
+{
+    // A later command for the same relay replaces the earlier one
+    QList<QPair<QString, QByteArray> > &commands = m_pendingCommands[thing];
+    for (int i = 0; i < commands.count(); i++) {
+        if (commands.at(i).first.compare(command, Qt::CaseInsensitive) == 0) {
+            commands.removeAt(i);
+            break;
         }
-        QVariantMap dataMap = jsonDoc.toVariant().toMap();
-        thing->setStateValue(m_signalStrengthStateTypeMap.value(thing->thingClassId()), dataMap.value("Wifi").toMap().value("RSSI").toInt());
+    }
+    commands.append(qMakePair(command, payload));
+
+    if (!m_flushScheduled) {
+        m_flushScheduled = true;
+        QTimer::singleShot(0, this, &IntegrationPluginTasmota::flushCommands);
+    }
+}
 
-        if (m_brightnessStateTypeMap.contains(thing->thingClassId())) {
-            thing->setStateValue(m_brightnessStateTypeMap.value(thing->thingClassId()), dataMap.value("Dimmer").toInt());
+void IntegrationPluginTasmota::flushCommands()
+{
+    m_flushScheduled = false;
+
+    foreach (Thing *thing, m_pendingCommands.keys()) {
+        QList<QPair<QString, QByteArray> > commands = m_pendingCommands.take(thing);
+        MqttChannel *channel = m_mqttChannels.value(thing);
+        if (!channel)
+            continue;
+
+        QString commandTopic = channel->topicPrefixList().first() + "/sonoff/cmnd/";
+        if (commands.count() == 1) {
+            qCDebug(dcTasmota) << "Publishing:" << commandTopic + commands.first().first << commands.first().second;
+            channel->publish(commandTopic + commands.first().first, commands.first().second);
+            continue;
         }
 
-        // Legacy (deprecated) connected things by params
-        foreach (Thing *child, myThings().filterByParentId(thing->id())) {
-            if (m_powerStateTypeMap.contains(child->thingClassId())) {
-                QString childChannel = child->paramValue(m_channelParamTypeMap.value(child->thingClassId())).toString();
-                QString valueString = jsonDoc.toVariant().toMap().value(childChannel).toString();
-                child->setStateValue(m_powerStateTypeMap.value(child->thingClassId()), valueString == "ON");
+        for (int i = 0; i < commands.count(); i += maxBacklogCommands) {
+            QStringList backlog;
+            for (int j = i; j < qMin(i + maxBacklogCommands, commands.count()); j++) {
+                backlog.append(commands.at(j).first + ' ' + QString::fromUtf8(commands.at(j).second));
             }
-            child->setStateValue(m_signalStrengthStateTypeMap.value(child->thingClassId()), dataMap.value("Wifi").toMap().value("RSSI").toInt());
+            qCDebug(dcTasmota) << "Publishing:" << commandTopic + "Backlog" << backlog.join(';');
+            channel->publish(commandTopic + "Backlog", backlog.join(';').toUtf8());
         }
     }
 }
-
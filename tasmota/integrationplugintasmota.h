@@ -58,7 +58,30 @@ private slots:
     void onPublishReceived(MqttChannel *channel, const QString &topic, const QByteArray &payload);
 
 private:
+    enum TopicHandler {
+        TopicHandlerPower,
+        TopicHandlerState,
+        TopicHandlerResult
+    };
+    struct TopicRoute {
+        TopicHandler handler = TopicHandlerPower;
+        Thing *thing = nullptr;
+        QString channelName;
+    };
+
+    void setupTopicRoutes(Thing *thing, MqttChannel *channel);
+    void setPowerState(Thing *thing, const QString &channelName, bool on, bool emitPressed);
+    void handleState(Thing *thing, const QByteArray &payload);
+    void handleResult(Thing *thing, const QByteArray &payload);
+
+    // Commands issued in the same event loop turn are sent as one Backlog per device
+    void queueCommand(Thing *thing, const QString &command, const QByteArray &payload);
+    void flushCommands();
+
     QHash<Thing*, MqttChannel*> m_mqttChannels;
+    QHash<QString, TopicRoute> m_topicRoutes;
+    QHash<Thing*, QList<QPair<QString, QByteArray> > > m_pendingCommands;
+    bool m_flushScheduled = false;
 
     // Helpers for parent devices (the ones starting with sonoff)
     QHash<ThingClassId, ParamTypeId> m_ipAddressParamTypeMap;
@@ -54,10 +54,33 @@ void IntegrationPluginTcpCommander::setupThing(ThingSetupInfo *info)
             // In case of a reconfigure, make sure we reconnect
             tcpSocket->disconnectFromHost();
         }
+        StreamFramer *framer = m_tcpFramers.value(thing);
+        if (!framer) {
+            framer = new StreamFramer(framingSettings(thing), tcpSocket);
+            m_tcpFramers.insert(thing, framer);
+            connect(framer, &StreamFramer::frameReceived, thing, [=](const QByteArray &frame){
+                ParamList params;
+                params << Param(tcpClientTriggeredEventDataParamTypeId, frame);
+                Event event(tcpClientTriggeredEventTypeId, thing->id(), params);
+                emitEvent(event);
+            });
+            connect(framer, &StreamFramer::framingError, tcpSocket, [=](const QString &error){
+                qCWarning(dcTCPCommander()) << "Closing connection to" << address.toString() << error;
+                tcpSocket->abort();
+            });
+            connect(thing, &Thing::settingChanged, framer, [=](){
+                framer->setSettings(framingSettings(thing));
+            });
+        } else {
+            framer->setSettings(framingSettings(thing));
+        }
+
         connect(tcpSocket, &QTcpSocket::stateChanged, thing, [=](QAbstractSocket::SocketState state){
             thing->setStateValue(tcpClientConnectedStateTypeId, state == QAbstractSocket::ConnectedState);
 
             if (state == QAbstractSocket::UnconnectedState) {
+                // Don't glue a partial message to the data of the next connection
+                framer->clear();
                 QTimer::singleShot(10000, tcpSocket, [=](){
                     qCDebug(dcTCPCommander()) << "Reconnecting to server" << address << port;
                     tcpSocket->connectToHost(address, port);
@@ -65,11 +88,7 @@ void IntegrationPluginTcpCommander::setupThing(ThingSetupInfo *info)
             }
         });
         connect(tcpSocket, &QTcpSocket::readyRead, thing, [=](){
-            QByteArray data = tcpSocket->readAll();
-            ParamList params;
-            params << Param(tcpClientTriggeredEventDataParamTypeId, data);
-            Event event(tcpClientTriggeredEventTypeId, thing->id(), params);
-            emitEvent(event);
+            framer->addData(tcpSocket->readAll());
         });
 
         tcpSocket->connectToHost(address, port);
@@ -86,11 +105,15 @@ void IntegrationPluginTcpCommander::setupThing(ThingSetupInfo *info)
             delete tcpServer;
         }
         tcpServer = new TcpServer(port, this);
+        tcpServer->setFramingSettings(framingSettings(thing));
 
         if (tcpServer->isValid()) {
             m_tcpServers.insert(thing, tcpServer);
             connect(tcpServer, &TcpServer::connectionCountChanged, this, &IntegrationPluginTcpCommander::onTcpServerConnectionCountChanged);
             connect(tcpServer, &TcpServer::commandReceived, this, &IntegrationPluginTcpCommander::onTcpServerCommandReceived);
+            connect(thing, &Thing::settingChanged, tcpServer, [=](){
+                tcpServer->setFramingSettings(framingSettings(thing));
+            });
             return info->finish(Thing::ThingErrorNoError);
         } else {
             tcpServer->deleteLater();
@@ -108,7 +131,12 @@ void IntegrationPluginTcpCommander::executeAction(ThingActionInfo *info)
 
     if (action.actionTypeId() == tcpClientTriggerActionTypeId) {
         QTcpSocket *tcpSocket = m_tcpSockets.value(thing);
-        QByteArray data = action.param(tcpClientTriggerActionDataParamTypeId).value().toByteArray();
+        QByteArray data = m_tcpFramers.value(thing)->frame(action.param(tcpClientTriggerActionDataParamTypeId).value().toByteArray());
+        if (tcpSocket->bytesToWrite() + data.length() > m_maxPendingOutput) {
+            qCWarning(dcTCPCommander()) << "Server" << tcpSocket->peerAddress().toString() << "is not reading its data, dropping the message";
+            info->finish(Thing::ThingErrorHardwareFailure, QT_TR_NOOP("The server is not receiving the data."));
+            return;
+        }
         qint64 len = tcpSocket->write(data);
         if (len == data.length()) {
             info->finish(Thing::ThingErrorNoError);
@@ -128,6 +156,27 @@ void IntegrationPluginTcpCommander::executeAction(ThingActionInfo *info)
             info->finish(Thing::ThingErrorHardwareFailure, QT_TR_NOOP("Failed to send the command to the specified client(s)."));
         }
     }
+
+    else if (action.actionTypeId() == tcpServerBroadcastActionTypeId) {
+        TcpServer *server = m_tcpServers.value(thing);
+        QByteArray data = action.param(tcpServerBroadcastActionDataParamTypeId).value().toByteArray();
+        quint32 broadcastId = server->broadcast(data);
+        if (broadcastId == 0) {
+            info->finish(Thing::ThingErrorHardwareNotAvailable, QT_TR_NOOP("No client is connected."));
+            return;
+        }
+        // Finish once every client has flushed the data to the network
+        connect(server, &TcpServer::broadcastFinished, info, [info, broadcastId](quint32 finishedId, bool success){
+            if (finishedId != broadcastId)
+                return;
+
+            if (success) {
+                info->finish(Thing::ThingErrorNoError);
+            } else {
+                info->finish(Thing::ThingErrorHardwareFailure, QT_TR_NOOP("Failed to send the data to all clients."));
+            }
+        });
+    }
 }
 
 
@@ -135,6 +184,7 @@ void IntegrationPluginTcpCommander::thingRemoved(Thing *thing)
 {
     if(thing->thingClassId() == tcpClientThingClassId){
         QTcpSocket *tcpSocket = m_tcpSockets.take(thing);
+        m_tcpFramers.remove(thing);
         tcpSocket->deleteLater();
 
     } else if(thing->thingClassId() == tcpServerThingClassId){
@@ -144,6 +194,29 @@ void IntegrationPluginTcpCommander::thingRemoved(Thing *thing)
 }
 
 
+StreamFramer::Settings IntegrationPluginTcpCommander::framingSettings(Thing *thing) const
+{
+    StreamFramer::Settings settings;
+    // "Length prefixed" is a 4 byte big endian length in front of the message
+    settings.lengthFieldSize = 4;
+    settings.stripLengthField = true;
+    if (thing->thingClassId() == tcpClientThingClassId) {
+        settings.mode = StreamFramer::modeFromString(thing->setting(tcpClientSettingsFramingParamTypeId).toString());
+        settings.delimiter = StreamFramer::unescape(thing->setting(tcpClientSettingsDelimiterParamTypeId).toString());
+        settings.frameLength = thing->setting(tcpClientSettingsFrameSizeParamTypeId).toInt();
+        settings.idleTimeout = thing->setting(tcpClientSettingsIdleTimeoutParamTypeId).toInt();
+        settings.maxFrameSize = thing->setting(tcpClientSettingsMaxFrameSizeParamTypeId).toInt();
+    } else {
+        settings.mode = StreamFramer::modeFromString(thing->setting(tcpServerSettingsFramingParamTypeId).toString());
+        settings.delimiter = StreamFramer::unescape(thing->setting(tcpServerSettingsDelimiterParamTypeId).toString());
+        settings.frameLength = thing->setting(tcpServerSettingsFrameSizeParamTypeId).toInt();
+        settings.idleTimeout = thing->setting(tcpServerSettingsIdleTimeoutParamTypeId).toInt();
+        settings.maxFrameSize = thing->setting(tcpServerSettingsMaxFrameSizeParamTypeId).toInt();
+    }
+    return settings;
+}
+
+
 void IntegrationPluginTcpCommander::onTcpSocketConnectionChanged(bool connected)
 {
     QTcpSocket *tcpSocket = static_cast<QTcpSocket *>(sender());
@@ -33,6 +33,7 @@
 
 #include "integrations/integrationplugin.h"
 #include "tcpserver.h"
+#include "streamframer.h"
 
 class IntegrationPluginTcpCommander : public IntegrationPlugin
 {
@@ -53,6 +54,11 @@ public:
 private:
     QHash<Thing*, QTcpSocket*> m_tcpSockets;
     QHash<Thing*, TcpServer*> m_tcpServers;
+    QHash<Thing*, StreamFramer*> m_tcpFramers;
+
+    qint64 m_maxPendingOutput = 1024 * 1024;
+
+    StreamFramer::Settings framingSettings(Thing *thing) const;
 
 private slots:
     void onTcpSocketConnectionChanged(bool connected);
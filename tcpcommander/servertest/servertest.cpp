@@ -0,0 +1,235 @@
+#include <QCoreApplication>
+
+#include <QDebug>
+#include <QTimer>
+#include <QEventLoop>
+#include <QTcpSocket>
+
+#include "tcpserver.h"
+
+// Connects clients to the TCP server of the TCP commander and checks the message framing in both
+// directions, single client commands and that broadcasts only finish once every client has the data.
+// Usage: servertest
+
+Q_LOGGING_CATEGORY(dcTCPCommander, "TCPCommander")
+
+static int failures = 0;
+
+static void check(bool condition, const QString &what)
+{
+    if (!condition) {
+        qWarning().noquote() << "FAILED:" << what;
+        failures++;
+    }
+}
+
+static void wait(int milliseconds)
+{
+    QEventLoop loop;
+    QTimer::singleShot(milliseconds, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+static QTcpSocket *connectClient(TcpServer *server)
+{
+    QTcpSocket *socket = new QTcpSocket();
+    socket->connectToHost(QHostAddress::LocalHost, static_cast<quint16>(server->serverPort()));
+    socket->waitForConnected(2000);
+    // Let the server accept the connection
+    wait(20);
+    return socket;
+}
+
+static void writeSegments(QTcpSocket *socket, const QByteArray &data, int segmentSize)
+{
+    for (int i = 0; i < data.size(); i += segmentSize) {
+        socket->write(data.mid(i, segmentSize));
+        socket->flush();
+        wait(2);
+    }
+    wait(100);
+}
+
+static QByteArray lengthPrefixed(const QByteArray &message)
+{
+    QByteArray frame;
+    quint32 length = static_cast<quint32>(message.length());
+    for (int i = 3; i >= 0; i--) {
+        frame.append(static_cast<char>((length >> (8 * i)) & 0xff));
+    }
+    return frame + message;
+}
+
+// The settings the plugin uses for the "Length prefixed" framing
+static StreamFramer::Settings lengthFieldSettings()
+{
+    StreamFramer::Settings settings;
+    settings.mode = StreamFramer::ModeLengthField;
+    settings.lengthFieldSize = 4;
+    settings.stripLengthField = true;
+    settings.maxFrameSize = 1024;
+    return settings;
+}
+
+static void testLengthField(TcpServer *server)
+{
+    server->setFramingSettings(lengthFieldSettings());
+    QList<QByteArray> received;
+    QMetaObject::Connection connection = QObject::connect(server, &TcpServer::commandReceived, [&received](const QString &, const QByteArray &message){
+        received.append(message);
+    });
+
+    QTcpSocket *socket = connectClient(server);
+    QList<QByteArray> messages = {"Light 1 ON", QByteArray(), QByteArray("\x00\x01\x02\n\r", 5), QByteArray(1024, 'x')};
+    QByteArray stream;
+    foreach (const QByteArray &message, messages) {
+        stream.append(lengthPrefixed(message));
+    }
+
+    writeSegments(socket, stream, 1);
+    check(received == messages, "length prefixed messages split into single bytes are received");
+    received.clear();
+
+    writeSegments(socket, stream, stream.size());
+    check(received == messages, "length prefixed messages in one segment are received");
+
+    QByteArray expected;
+    for (int i = 0; i < 2 * messages.count(); i++) {
+        expected.append(lengthPrefixed("OK\n"));
+    }
+    check(socket->readAll() == expected, "every message is answered with a length prefixed OK");
+    received.clear();
+
+    writeSegments(socket, lengthPrefixed(QByteArray(1025, 'x')) + lengthPrefixed("after"), 512);
+    check(received.isEmpty(), "message larger than the maximum is not received");
+    check(socket->state() == QAbstractSocket::UnconnectedState, "connection sending a message larger than the maximum is closed");
+
+    QObject::disconnect(connection);
+    delete socket;
+    wait(20);
+}
+
+static void testDelimiter(TcpServer *server)
+{
+    StreamFramer::Settings settings;
+    settings.mode = StreamFramer::ModeDelimiter;
+    settings.delimiter = "\r\n";
+    server->setFramingSettings(settings);
+    QList<QByteArray> received;
+    QMetaObject::Connection connection = QObject::connect(server, &TcpServer::commandReceived, [&received](const QString &, const QByteArray &message){
+        received.append(message);
+    });
+
+    QTcpSocket *socket = connectClient(server);
+    writeSegments(socket, "first\r\nsec\rond\r\n\r\nthird\r", 3);
+    check(received == QList<QByteArray>({"first", "sec\rond", ""}), "delimited messages are received");
+    writeSegments(socket, "\n", 1);
+    check(received.count() == 4 && received.last() == "third", "delimiter split across segments is found");
+    check(socket->readAll() == QByteArray("OK\n\r\n").repeated(4), "every message is answered with a delimited OK");
+
+    QObject::disconnect(connection);
+    delete socket;
+    wait(20);
+}
+
+static void testSendCommand(TcpServer *server)
+{
+    server->setFramingSettings(lengthFieldSettings());
+    QTcpSocket *first = connectClient(server);
+    QTcpSocket *second = connectClient(server);
+
+    check(server->sendCommand(QString("127.0.0.1:%1").arg(second->localPort()), "single"), "command to a single connection is sent");
+    wait(50);
+    check(first->readAll().isEmpty() && second->readAll() == lengthPrefixed("single"), "command to a single connection only reaches that connection");
+
+    check(server->sendCommand("127.0.0.1", "host"), "command to a host is sent");
+    wait(50);
+    check(first->readAll() == lengthPrefixed("host") && second->readAll() == lengthPrefixed("host"), "command to a host reaches all its connections");
+
+    check(!server->sendCommand("127.0.0.1:1", "nobody"), "command to an unknown connection fails");
+
+    delete first;
+    delete second;
+    wait(20);
+}
+
+static void testBroadcast(TcpServer *server)
+{
+    server->setFramingSettings(lengthFieldSettings());
+    QList<QPair<quint32, bool> > finished;
+    QMetaObject::Connection connection = QObject::connect(server, &TcpServer::broadcastFinished, [&finished](quint32 broadcastId, bool success){
+        finished.append(qMakePair(broadcastId, success));
+    });
+
+    check(server->broadcast("nobody") == 0, "broadcast without clients is rejected");
+
+    QList<QTcpSocket *> sockets;
+    for (int i = 0; i < 3; i++) {
+        sockets.append(connectClient(server));
+    }
+    check(server->connectionCount() == 3, "all clients are connected");
+
+    QByteArray data(200 * 1024, 'b');
+    quint32 broadcastId = server->broadcast(data);
+    check(finished.isEmpty(), "broadcast does not finish before the data is written");
+    wait(200);
+    check(finished == QList<QPair<quint32, bool> >({qMakePair(broadcastId, true)}), "broadcast finishes once every client has the data");
+    foreach (QTcpSocket *socket, sockets) {
+        check(socket->readAll() == lengthPrefixed(data), "broadcast data is received complete");
+    }
+    finished.clear();
+
+    // A client which stops reading is closed once too much data is pending for it
+    QTcpSocket *stalled = sockets.takeLast();
+    stalled->setReadBufferSize(1);
+    wait(20);
+    QList<quint32> broadcastIds;
+    for (int i = 0; i < 256 && server->connectionCount() == 3; i++) {
+        broadcastIds.append(server->broadcast(QByteArray(256 * 1024, 's')));
+        foreach (QTcpSocket *socket, sockets) {
+            socket->readAll();
+        }
+        wait(10);
+    }
+    wait(200);
+    // The stalled client doesn't read, so it might not notice being closed, the server side tells
+    check(server->connectionCount() == 2, "client not reading its data is closed and the reading clients stay connected");
+    check(finished.count() == broadcastIds.count(), "every broadcast finishes");
+    int failed = 0;
+    for (int i = 0; i < finished.count(); i++) {
+        if (!finished.at(i).second)
+            failed++;
+    }
+    check(failed > 0, "broadcasts pending for the closed client fail");
+    check(!finished.isEmpty() && finished.first().second, "broadcast flushed before the client stalled succeeds");
+
+    QObject::disconnect(connection);
+    delete stalled;
+    qDeleteAll(sockets);
+    wait(20);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+    QLoggingCategory::setFilterRules("TCPCommander.debug=false\nTCPCommander.warning=false");
+
+    TcpServer server(QHostAddress::LocalHost, 0);
+    if (!server.isValid()) {
+        qWarning() << "Could not start the TCP server";
+        return 1;
+    }
+
+    testLengthField(&server);
+    testDelimiter(&server);
+    testSendCommand(&server);
+    testBroadcast(&server);
+
+    if (failures > 0) {
+        qWarning() << failures << "checks failed";
+        return 1;
+    }
+
+    qInfo() << "All checks passed";
+    return 0;
+}
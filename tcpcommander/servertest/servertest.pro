@@ -0,0 +1,14 @@
+CONFIG += c++11
+
+QT += network
+
+include(../../common/framing/framing.pri)
+
+# Picks up the logging category stub in this directory before the generated plugin info
+INCLUDEPATH += . ..
+
+SOURCES += servertest.cpp \
+    ../tcpserver.cpp
+
+HEADERS += extern-plugininfo.h \
+    ../tcpserver.h
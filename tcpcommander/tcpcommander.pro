@@ -1,4 +1,5 @@
 include(../plugins.pri)
+include(../common/framing/framing.pri)
 
 QT += network
 
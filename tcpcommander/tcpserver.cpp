@@ -59,6 +59,7 @@ TcpServer::TcpServer(const quint16 &port, QObject *parent) :
 
 TcpServer::~TcpServer()
 {
+    qDeleteAll(m_clients);
 }
 
 bool TcpServer::isValid()
@@ -81,52 +82,239 @@ int TcpServer::connectionCount()
     return m_clients.count();
 }
 
+void TcpServer::setFramingSettings(const StreamFramer::Settings &settings)
+{
+    m_framingSettings = settings;
+    foreach (Client *client, m_clients) {
+        client->framer->setSettings(settings);
+    }
+}
+
 bool TcpServer::sendCommand(const QString &clientIp, const QByteArray &data)
 {
-    bool success = false;
-    QHostAddress address(clientIp);
+    QList<Client*> clients = findClients(clientIp);
+    if (clients.isEmpty()) {
+        qCWarning(dcTCPCommander()) << "No client matching the destination" << clientIp;
+        return false;
+    }
 
-    foreach (QTcpSocket *client, m_clients) {
-        if (address == QHostAddress(QHostAddress::AnyIPv4) || client->peerAddress() == address) {
-            qint64 len = client->write(data);
-            if (len == data.length()) {
-                success = true;
-            }
+    // All clients share the same framing, so the message is only framed once
+    QByteArray message = clients.first()->framer->frame(data);
+    bool success = false;
+    foreach (Client *client, clients) {
+        if (writeToClient(client, message)) {
+            success = true;
         }
     }
-    qCWarning(dcTCPCommander()) << "No client matching the destination IP" << address.toString();
     return success;
 }
 
+quint32 TcpServer::broadcast(const QByteArray &data)
+{
+    if (m_clients.isEmpty())
+        return 0;
+
+    quint32 broadcastId = m_nextBroadcastId++;
+    if (m_nextBroadcastId == 0)
+        m_nextBroadcastId = 1;
+
+    QByteArray message = m_clients.begin().value()->framer->frame(data);
+    int pending = 0;
+    bool success = true;
+    foreach (Client *client, m_clients) {
+        if (!writeToClient(client, message)) {
+            success = false;
+            continue;
+        }
+        client->pendingBroadcasts.enqueue(qMakePair(client->bytesEnqueued, broadcastId));
+        pending++;
+    }
+
+    qCDebug(dcTCPCommander()) << "Broadcasting" << message.length() << "bytes to" << pending << "clients";
+    if (pending == 0) {
+        // Emit after the caller had the chance to store the id
+        QMetaObject::invokeMethod(this, "broadcastFinished", Qt::QueuedConnection, Q_ARG(quint32, broadcastId), Q_ARG(bool, false));
+        return broadcastId;
+    }
+    m_pendingBroadcasts.insert(broadcastId, pending);
+    if (!success)
+        m_failedBroadcasts.insert(broadcastId, true);
+
+    return broadcastId;
+}
+
+QList<TcpServer::ClientStatistics> TcpServer::statistics() const
+{
+    QList<ClientStatistics> statistics;
+    foreach (Client *client, m_clients) {
+        ClientStatistics clientStatistics = client->statistics;
+        clientStatistics.bytesQueued = client->socket->bytesToWrite();
+        statistics.append(clientStatistics);
+    }
+    return statistics;
+}
+
 void TcpServer::newConnection()
 {
     qDebug(dcTCPCommander()) << "TCP Server new Connection request";
     QTcpSocket *socket = m_tcpServer->nextPendingConnection();
     socket->flush();
 
-    m_clients.append(socket);
+    Client *client = new Client();
+    client->socket = socket;
+    client->peer = Peer(normalizedAddress(socket->peerAddress()), socket->peerPort());
+    client->statistics.address = client->peer.first;
+    client->statistics.port = client->peer.second;
+    client->framer = new StreamFramer(m_framingSettings, socket);
+    m_clients.insert(socket, client);
+    m_clientsByPeer.insert(client->peer, client);
+    m_clientsByAddress.insert(client->peer.first, client);
+
     emit connectionCountChanged(m_clients.count());
-    connect(socket, &QTcpSocket::disconnected, this, &TcpServer::onDisconnected);
+    // Queued, a write failing while a message is being processed must not delete the client underneath
+    connect(socket, &QTcpSocket::disconnected, this, &TcpServer::onDisconnected, Qt::QueuedConnection);
     connect(socket, &QTcpSocket::readyRead, this, &TcpServer::readData);
+    connect(socket, &QTcpSocket::bytesWritten, this, &TcpServer::onBytesWritten);
+
+    QString clientIp = client->peer.first.toString();
+    connect(client->framer, &StreamFramer::frameReceived, this, [this, client, clientIp](const QByteArray &frame){
+        qDebug(dcTCPCommander()) << "TCP Server message received: " << frame;
+        client->statistics.messagesReceived++;
+        if (!client->closing) {
+            writeToClient(client, client->framer->frame("OK\n"));
+        }
+        emit commandReceived(clientIp, frame);
+    });
+    connect(client->framer, &StreamFramer::framingError, socket, [client, clientIp](const QString &error){
+        qWarning(dcTCPCommander()) << "Closing connection to" << clientIp << error;
+        client->closing = true;
+        client->socket->abort();
+    });
     // Note: error signal will be interpreted as function, not as signal in C++11
     connect(socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(onError(QAbstractSocket::SocketError)));
 }
 
 void TcpServer::onDisconnected()
 {
-    QTcpSocket *client = qobject_cast<QTcpSocket*>(sender());
-    qDebug(dcTCPCommander()) << "TCP client disconnected";
-    m_clients.removeAll(client);
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    Client *client = m_clients.take(socket);
+    if (!client)
+        return;
+
+    qDebug(dcTCPCommander()) << "TCP client disconnected" << client->peer.first.toString() << client->peer.second
+                             << "sent" << client->statistics.messagesSent << "messages," << client->statistics.bytesWritten << "bytes";
+    m_clientsByPeer.remove(client->peer);
+    m_clientsByAddress.remove(client->peer.first, client);
+    client->framer->clear();
+
+    while (!client->pendingBroadcasts.isEmpty()) {
+        quint32 broadcastId = client->pendingBroadcasts.dequeue().second;
+        m_failedBroadcasts.insert(broadcastId, true);
+        finishBroadcast(broadcastId, false);
+    }
+
+    delete client;
+    socket->deleteLater();
     emit connectionCountChanged(m_clients.count());
 }
 
 void TcpServer::readData()
 {
     QTcpSocket *socket = static_cast<QTcpSocket *>(sender());
-    QByteArray data = socket->readAll();
-    qDebug(dcTCPCommander()) << "TCP Server data received: " << data;
-    socket->write("OK\n");
-    emit commandReceived(socket->peerAddress().toString(), data);
+    Client *client = m_clients.value(socket);
+    if (!client || client->closing)
+        return;
+
+    client->framer->addData(socket->readAll());
+}
+
+void TcpServer::onBytesWritten(qint64 bytes)
+{
+    QTcpSocket *socket = static_cast<QTcpSocket *>(sender());
+    Client *client = m_clients.value(socket);
+    if (!client)
+        return;
+
+    client->statistics.bytesWritten += bytes;
+    while (!client->pendingBroadcasts.isEmpty() && client->pendingBroadcasts.head().first <= client->statistics.bytesWritten) {
+        finishBroadcast(client->pendingBroadcasts.dequeue().second, true);
+    }
+}
+
+QHostAddress TcpServer::normalizedAddress(const QHostAddress &address)
+{
+    // Connections to a dual stack server show up as IPv4 mapped IPv6 addresses
+    bool isIPv4 = false;
+    quint32 ipv4 = address.toIPv4Address(&isIPv4);
+    if (isIPv4)
+        return QHostAddress(ipv4);
+
+    return address;
+}
+
+QList<TcpServer::Client*> TcpServer::findClients(const QString &clientIp) const
+{
+    QHostAddress address(clientIp);
+    if (address == QHostAddress(QHostAddress::AnyIPv4))
+        return m_clients.values();
+
+    if (!address.isNull())
+        return m_clientsByAddress.values(normalizedAddress(address));
+
+    // "address:port" or "[address]:port"
+    int separator = clientIp.lastIndexOf(':');
+    if (separator < 0)
+        return QList<Client*>();
+
+    QString host = clientIp.left(separator);
+    if (host.startsWith('[') && host.endsWith(']'))
+        host = host.mid(1, host.length() - 2);
+
+    bool ok = false;
+    quint16 port = clientIp.mid(separator + 1).toUShort(&ok);
+    address = QHostAddress(host);
+    if (!ok || address.isNull())
+        return QList<Client*>();
+
+    Client *client = m_clientsByPeer.value(Peer(normalizedAddress(address), port));
+    if (!client)
+        return QList<Client*>();
+
+    return QList<Client*>() << client;
+}
+
+bool TcpServer::writeToClient(Client *client, const QByteArray &data)
+{
+    if (client->closing)
+        return false;
+
+    if (client->socket->bytesToWrite() + data.length() > m_maxPendingOutput) {
+        qWarning(dcTCPCommander()) << "Client" << client->peer.first.toString() << client->peer.second << "is not reading its data, closing the connection";
+        client->closing = true;
+        client->socket->abort();
+        return false;
+    }
+
+    qint64 written = client->socket->write(data);
+    if (written != data.length())
+        return false;
+
+    client->bytesEnqueued += written;
+    client->statistics.messagesSent++;
+    return true;
+}
+
+void TcpServer::finishBroadcast(quint32 broadcastId, bool success)
+{
+    if (!m_pendingBroadcasts.contains(broadcastId))
+        return;
+
+    if (--m_pendingBroadcasts[broadcastId] > 0)
+        return;
+
+    m_pendingBroadcasts.remove(broadcastId);
+    success = success && !m_failedBroadcasts.take(broadcastId);
+    emit broadcastFinished(broadcastId, success);
 }
 
 void TcpServer::onError(QAbstractSocket::SocketError error)
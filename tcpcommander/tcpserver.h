@@ -34,11 +34,25 @@
 #include <QObject>
 #include <QTcpSocket>
 #include <QTcpServer>
+#include <QHash>
+#include <QPair>
+#include <QQueue>
+
+#include "streamframer.h"
 
 class TcpServer : public QObject
 {
     Q_OBJECT
 public:
+    struct ClientStatistics {
+        QHostAddress address;
+        quint16 port = 0;
+        qint64 bytesQueued = 0;     // Currently waiting in the socket's write buffer
+        quint64 bytesWritten = 0;
+        quint64 messagesSent = 0;
+        quint64 messagesReceived = 0;
+    };
+
     explicit TcpServer(const QHostAddress address, const quint16 &port, QObject *parent = nullptr);
     explicit TcpServer(const quint16 &port, QObject *parent = nullptr);
     ~TcpServer();
@@ -50,24 +64,63 @@ public:
 
     int connectionCount();
 
+    void setFramingSettings(const StreamFramer::Settings &settings);
+
+    // clientIp is an address, "address:port" for a single connection or 0.0.0.0 for all clients
     bool sendCommand(const QString &clientIp, const QByteArray &data);
 
+    // Sends to all clients, broadcastFinished() is emitted once every client has flushed the data.
+    // Returns 0 if no client is connected.
+    quint32 broadcast(const QByteArray &data);
+
+    QList<ClientStatistics> statistics() const;
+
 signals:
     void newPendingConnection();
     void commandReceived(const QString &clientIp, const QByteArray &message);
     void connectionCountChanged(int connections);
+    void broadcastFinished(quint32 broadcastId, bool success);
 
 private slots:
     void newConnection();
     void onDisconnected();
     void readData();
+    void onBytesWritten(qint64 bytes);
     void onError(QAbstractSocket::SocketError error);
 
 private:
+    typedef QPair<QHostAddress, quint16> Peer;
+
+    struct Client {
+        QTcpSocket *socket = nullptr;
+        StreamFramer *framer = nullptr;
+        Peer peer;
+        bool closing = false;
+        quint64 bytesEnqueued = 0;
+        ClientStatistics statistics;
+        // Broadcasts waiting for this client, with the write offset completing them
+        QQueue<QPair<quint64, quint32> > pendingBroadcasts;
+    };
+
     QTcpServer *m_tcpServer = nullptr;
 
-    QList<QTcpSocket*> m_clients;
+    QHash<QTcpSocket*, Client*> m_clients;
+    QHash<Peer, Client*> m_clientsByPeer;
+    QMultiHash<QHostAddress, Client*> m_clientsByAddress;
+    StreamFramer::Settings m_framingSettings;
+
+    // Broadcast id -> number of clients which haven't flushed it yet
+    QHash<quint32, int> m_pendingBroadcasts;
+    QHash<quint32, bool> m_failedBroadcasts;
+    quint32 m_nextBroadcastId = 1;
+
+    // Clients not reading their data are disconnected instead of buffering without limit
+    qint64 m_maxPendingOutput = 1024 * 1024;
 
+    static QHostAddress normalizedAddress(const QHostAddress &address);
+    QList<Client*> findClients(const QString &clientIp) const;
+    bool writeToClient(Client *client, const QByteArray &data);
+    void finishBroadcast(quint32 broadcastId, bool success);
 };
 
 #endif // TCPSERVER_H
@@ -47,6 +47,17 @@ IntegrationPluginTexasInstruments::~IntegrationPluginTexasInstruments()
 
 }
 
+void IntegrationPluginTexasInstruments::init()
+{
+    // Note: the connection limit is shared by all bluetooth plugins, show the current global value
+    setConfigValue(texasInstrumentsPluginMaxConnectionsParamTypeId, BluetoothConnectionLease::maximumConnections(hardwareManager()->bluetoothLowEnergyManager()));
+    connect(this, &IntegrationPluginTexasInstruments::configValueChanged, this, [this](const ParamTypeId &paramTypeId, const QVariant &value){
+        if (paramTypeId == texasInstrumentsPluginMaxConnectionsParamTypeId) {
+            BluetoothConnectionLease::setMaximumConnections(hardwareManager()->bluetoothLowEnergyManager(), value.toInt());
+        }
+    });
+}
+
 void IntegrationPluginTexasInstruments::discoverThings(ThingDiscoveryInfo *info)
 {
     Q_ASSERT_X(info->thingClassId() == sensorTagThingClassId, "DevicePluginTexasInstruments", "Unhandled ThingClassId!");
@@ -106,13 +117,17 @@ void IntegrationPluginTexasInstruments::setupThing(ThingSetupInfo *info)
 
     SensorTag *sensorTag = new SensorTag(thing, bluetoothDevice, this);
     m_sensorTags.insert(thing, sensorTag);
+    // The sensor values and buttons are reported by notifications, keep the SensorTag connected
+    BluetoothConnectionLease *connectionLease = new BluetoothConnectionLease(hardwareManager()->bluetoothLowEnergyManager(), bluetoothDevice, sensorTag);
+    connectionLease->setRotatable(false);
+    m_connectionLeases.insert(thing, connectionLease);
 
     if (!m_reconnectTimer) {
         m_reconnectTimer = hardwareManager()->pluginTimerManager()->registerTimer(10);
         connect(m_reconnectTimer, &PluginTimer::timeout, this, [this](){
-            foreach (SensorTag *sensorTag, m_sensorTags) {
-                if (!sensorTag->bluetoothDevice()->connected()) {
-                    sensorTag->bluetoothDevice()->connectDevice();
+            foreach (Thing *thing, m_sensorTags.keys()) {
+                if (!m_sensorTags.value(thing)->bluetoothDevice()->connected()) {
+                    m_connectionLeases.value(thing)->request(BluetoothConnectionLease::PriorityPersistent);
                 }
             }
         });
@@ -137,8 +152,8 @@ void IntegrationPluginTexasInstruments::postSetupThing(Thing *thing)
     sensorTag->setMeasurementPeriod(thing->stateValue(sensorTagMeasurementPeriodStateTypeId).toInt());
     sensorTag->setMeasurementPeriodMovement(thing->stateValue(sensorTagMeasurementPeriodMovementStateTypeId).toInt());
 
-    // Connect to the sensor
-    sensorTag->bluetoothDevice()->connectDevice();
+    // Connect to the sensor as soon as a connection slot is available
+    m_connectionLeases.value(thing)->request(BluetoothConnectionLease::PriorityPersistent);
 }
 
 void IntegrationPluginTexasInstruments::thingRemoved(Thing *thing)
@@ -148,6 +163,7 @@ void IntegrationPluginTexasInstruments::thingRemoved(Thing *thing)
     }
 
     SensorTag *sensorTag = m_sensorTags.take(thing);
+    m_connectionLeases.take(thing)->release();
     hardwareManager()->bluetoothLowEnergyManager()->unregisterDevice(sensorTag->bluetoothDevice());
     sensorTag->deleteLater();
 
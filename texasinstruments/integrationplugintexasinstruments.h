@@ -34,6 +34,7 @@
 #include <QObject>
 
 #include "integrations/integrationplugin.h"
+#include "bluetoothconnectionlease.h"
 
 class SensorTag;
 
@@ -49,6 +50,7 @@ public:
     explicit IntegrationPluginTexasInstruments(QObject *parent = nullptr);
     ~IntegrationPluginTexasInstruments() override;
 
+    void init() override;
     void discoverThings(ThingDiscoveryInfo *info) override;
     void setupThing(ThingSetupInfo *info) override;
     void postSetupThing(Thing *thing) override;
@@ -57,6 +59,7 @@ public:
 
 private:
     QHash<Thing*, SensorTag*> m_sensorTags;
+    QHash<Thing*, BluetoothConnectionLease*> m_connectionLeases;
 
     PluginTimer *m_reconnectTimer = nullptr;
 };
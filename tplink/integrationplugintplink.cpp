@@ -37,7 +37,10 @@
 #include <QNetworkReply>
 #include <QJsonDocument>
 #include <QTimer>
-#include <QDataStream>
+#include <QtEndian>
+
+// Replies of the devices are a few KiB, longer length prefixes are garbage
+static const quint32 maxMessageSize = 64 * 1024;
 
 // Related projects:
 
@@ -103,80 +106,31 @@ IntegrationPluginTPLink::~IntegrationPluginTPLink()
 
 void IntegrationPluginTPLink::init()
 {
+    // Listens for discovery replies all the time, also to broadcasts sent for other things
     m_broadcastSocket = new QUdpSocket(this);
-
+    if (!m_broadcastSocket->bind(QHostAddress::AnyIPv4, 0)) {
+        qCWarning(dcTplink()) << "Error opening the discovery socket:" << m_broadcastSocket->errorString();
+    }
+    connect(m_broadcastSocket, &QUdpSocket::readyRead, this, &IntegrationPluginTPLink::onBroadcastReadyRead);
 }
 
 void IntegrationPluginTPLink::discoverThings(ThingDiscoveryInfo *info)
 {
-    QVariantMap map;
-    QVariantMap getSysInfo;
-    getSysInfo.insert("get_sysinfo", QVariant());
-    map.insert("system", getSysInfo);
-    QByteArray payload = QJsonDocument::fromVariant(map).toJson(QJsonDocument::Compact);
-    QByteArray datagram = encryptPayload(payload);
-
-    qint64 len = m_broadcastSocket->writeDatagram(datagram, QHostAddress::Broadcast, 9999);
-    if (len != datagram.length()) {
+    if (!broadcastDiscovery()) {
         info->finish(Thing::ThingErrorHardwareFailure, QT_TR_NOOP("An error happened sending the discovery to the network."));
         return;
     }
 
+    // Always collect for the full window, known devices answering quickly says nothing about new ones.
+    // Setups and reconnects look for a single device and finish as soon as it answers.
+    m_pendingDiscoveries.append(info);
+    connect(info, &ThingDiscoveryInfo::destroyed, this, [this, info](){
+        m_pendingDiscoveries.removeAll(info);
+    });
     QTimer::singleShot(2000, info, [this, info](){
-        while(m_broadcastSocket->hasPendingDatagrams()) {
-            char buffer[4096];
-            QHostAddress senderAddress;
-            qint64 len = m_broadcastSocket->readDatagram(buffer, 4096, &senderAddress);
-            QByteArray data = decryptPayload(QByteArray::fromRawData(buffer, len));
-            QJsonParseError error;
-            QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
-            if (error.error != QJsonParseError::NoError) {
-                qCWarning(dcTplink()) << "Error parsing JSON from thing:" << data;
-                continue;
-            }
-            QVariantMap properties = jsonDoc.toVariant().toMap();
-            QVariantMap sysInfo = properties.value("system").toMap().value("get_sysinfo").toMap();
-
-            qCWarning(dcTplink()) << qUtf8Printable(jsonDoc.toJson(QJsonDocument::Indented));
-
-            QRegExp modelFilter;
-            if (info->thingClassId() == kasaPlug100ThingClassId) {
-                modelFilter = QRegExp("(HS100|HS103|HS105|KP100|KP105).*");
-            } else if (info->thingClassId() == kasaPlug110ThingClassId) {
-                modelFilter = QRegExp("(HS110|KP115).*");
-            } else if (info->thingClassId() == kasaSwitch200ThingClassId) {
-                modelFilter = QRegExp("HS200.*");
-            } else if (info->thingClassId() == kasaPowerStrip300ThingClassId) {
-                modelFilter = QRegExp("HS300.*");
-            }
-            QString model = sysInfo.value("model").toString();
-
-            if (modelFilter.exactMatch(model)) {
-                ThingDescriptor descriptor(info->thingClassId(), sysInfo.value("alias").toString(), sysInfo.value("dev_name").toString());
-                Param idParam = Param(idParamTypesMap.value(info->thingClassId()), sysInfo.value("deviceId").toString());
-                descriptor.setParams(ParamList() << idParam);
-                Thing *existingThing = myThings().findByParams(ParamList() << idParam);
-                if (existingThing) {
-                    descriptor.setThingId(existingThing->id());
-                }
-
-                // Sometimes kasa devices reply multiple times on the discovery call. Prevent duplicates in the search results.
-                bool found = false;
-                foreach (const ThingDescriptor &existingDescriptor, info->thingDescriptors()) {
-                    if (existingDescriptor.params().paramValue(idParamTypesMap.value(info->thingClassId())) == idParam.value()) {
-                        found = true;
-                        break;
-                    }
-                }
-                if (!found) {
-                    info->addThingDescriptor(descriptor);
-                }
-            } else {
-                qCWarning(dcTplink()) << "Ignoring not matching device type:\n" << qUtf8Printable(jsonDoc.toJson(QJsonDocument::Indented));
-            }
-
+        if (m_pendingDiscoveries.removeAll(info) > 0) {
+            info->finish(Thing::ThingErrorNoError);
         }
-        info->finish(Thing::ThingErrorNoError);
     });
 }
 
@@ -188,77 +142,177 @@ void IntegrationPluginTPLink::setupThing(ThingSetupInfo *info)
         return;
     }
 
+    QString deviceId = info->thing()->paramValue(idParamTypesMap.value(info->thing()->thingClassId())).toString();
+    if (m_deviceAddresses.contains(deviceId)) {
+        qCDebug(dcTplink()) << "Device already known at" << m_deviceAddresses.value(deviceId);
+        finishSetup(info, m_deviceAddresses.value(deviceId), m_deviceSysInfos.value(deviceId));
+        return;
+    }
+
+    if (!broadcastDiscovery()) {
+        info->finish(Thing::ThingErrorHardwareFailure, QT_TR_NOOP("An error happened finding the device in the network."));
+        return;
+    }
+
+    m_pendingSetups.insert(deviceId, info);
+    connect(info, &ThingSetupInfo::destroyed, this, [this, info, deviceId](){
+        if (m_pendingSetups.value(deviceId) == info) {
+            m_pendingSetups.remove(deviceId);
+        }
+        m_setupRetries.remove(info);
+    });
+
+    QTimer::singleShot(2000, info, [this, info, deviceId](){
+        if (m_pendingSetups.value(deviceId) != info) {
+            // Already found
+            return;
+        }
+        m_pendingSetups.remove(deviceId);
+
+        if (!m_setupRetries.contains(info) || m_setupRetries.value(info) < 5) {
+            qCDebug(dcTplink()) << "Device not found in network. Retrying... (" << m_setupRetries[info] << ")";
+            m_setupRetries[info]++;
+            setupThing(info);
+            return;
+        }
+        m_setupRetries.remove(info);
+        info->finish(Thing::ThingErrorThingNotFound, QT_TR_NOOP("The device could not be found on the network."));
+    });
+}
+
+void IntegrationPluginTPLink::finishSetup(ThingSetupInfo *info, const QHostAddress &address, const QVariantMap &sysInfo)
+{
+    qCDebug(dcTplink()) << "Found thing at" << address;
+
+    // We need to finish the setup before we can generate childs for this thing
+    info->finish(Thing::ThingErrorNoError);
+    m_setupRetries.remove(info);
+
+    // Set up child sockets if needed (currently only the HS300)
+    QVariantList children = sysInfo.value("children").toList();
+    if (children.count() > 0 && myThings().filterByParentId(info->thing()->id()).isEmpty()) {
+        ThingDescriptors descriptors;
+        foreach (const QVariant &childVariant, children) {
+            QVariantMap childMap = childVariant.toMap();
+            ThingDescriptor descriptor(kasaSocketThingClassId, childMap.value("alias").toString(), QString(), info->thing()->id());
+
+            QString devId = QString("%1%2")
+                    .arg(info->thing()->paramValue(idParamTypesMap.value(info->thing()->thingClassId())).toString())
+                    .arg(childMap.value("id").toString());
+            descriptor.setParams(ParamList() << Param(kasaSocketThingIdParamTypeId, devId));
+            qCDebug(dcTplink()) << "Creating child socket for" << info->thing()->name() << "with ID" << devId;
+            descriptors.append(descriptor);
+        }
+        emit autoThingsAppeared(descriptors);
+    }
+
+    connectToDevice(info->thing(), address);
+}
+
+bool IntegrationPluginTPLink::broadcastDiscovery()
+{
     QVariantMap map;
     QVariantMap getSysInfo;
     getSysInfo.insert("get_sysinfo", QVariant());
     map.insert("system", getSysInfo);
-    QVariantMap getRealTime;
-    getRealTime.insert("get_realtime", QVariant());
-    map.insert("emeter", getRealTime);
     QByteArray payload = QJsonDocument::fromVariant(map).toJson(QJsonDocument::Compact);
     QByteArray datagram = encryptPayload(payload);
 
+    m_lastBroadcast.start();
     qint64 len = m_broadcastSocket->writeDatagram(datagram, QHostAddress::Broadcast, 9999);
     if (len != datagram.length()) {
-        info->finish(Thing::ThingErrorHardwareFailure, QT_TR_NOOP("An error happened finding the device in the network."));
-        return;
+        qCWarning(dcTplink()) << "Error sending discovery broadcast:" << m_broadcastSocket->errorString();
+        return false;
     }
+    return true;
+}
 
-    QTimer::singleShot(2000, info, [this, info](){
+void IntegrationPluginTPLink::onBroadcastReadyRead()
+{
+    while (m_broadcastSocket->hasPendingDatagrams()) {
+        char buffer[4096];
+        QHostAddress senderAddress;
+        qint64 len = m_broadcastSocket->readDatagram(buffer, 4096, &senderAddress);
+        if (len <= 0)
+            continue;
+
+        decryptInPlace(buffer, static_cast<int>(len));
+        QByteArray data = QByteArray::fromRawData(buffer, static_cast<int>(len));
+        QJsonParseError error;
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
+        if (error.error != QJsonParseError::NoError) {
+            qCWarning(dcTplink()) << "Error parsing JSON from thing:" << data;
+            continue;
+        }
+        QVariantMap properties = jsonDoc.toVariant().toMap();
+        QVariantMap sysInfo = properties.value("system").toMap().value("get_sysinfo").toMap();
+        QString deviceId = sysInfo.value("deviceId").toString();
+        if (deviceId.isEmpty())
+            continue;
+
+        QHostAddress previousAddress = m_deviceAddresses.value(deviceId);
+        m_deviceAddresses.insert(deviceId, senderAddress);
+        m_deviceSysInfos.insert(deviceId, sysInfo);
+
+        foreach (ThingDiscoveryInfo *info, m_pendingDiscoveries) {
+            addDiscoveryResult(info, sysInfo);
+        }
 
-        while(m_broadcastSocket->hasPendingDatagrams()) {
-            char buffer[4096];
-            QHostAddress senderAddress;
-            qint64 len = m_broadcastSocket->readDatagram(buffer, 4096, &senderAddress);
-            QByteArray data = decryptPayload(QByteArray::fromRawData(buffer, len));
-            QJsonParseError error;
-            QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &error);
-            if (error.error != QJsonParseError::NoError) {
-                qCWarning(dcTplink()) << "Error parsing JSON from thing:" << data;
-                continue;
-            }
-            QVariantMap properties = jsonDoc.toVariant().toMap();
-            QVariantMap sysInfo = properties.value("system").toMap().value("get_sysinfo").toMap();
-            if (info->thing()->paramValue(idParamTypesMap.value(info->thing()->thingClassId())).toString() == sysInfo.value("deviceId").toString()) {
-                qCDebug(dcTplink()) << "Found thing at" << senderAddress;
-
-                // We need to finish the setup before we can generate childs for this thing
-                info->finish(Thing::ThingErrorNoError);
-                m_setupRetries.remove(info);
-
-                // Set up child sockets if needed (currently only the HS300)
-                QVariantList children = sysInfo.value("children").toList();
-                if (children.count() > 0 && myThings().filterByParentId(info->thing()->id()).isEmpty()) {
-                    ThingDescriptors descriptors;
-                    foreach (const QVariant &childVariant, children) {
-                        QVariantMap childMap = childVariant.toMap();
-                        ThingDescriptor descriptor(kasaSocketThingClassId, childMap.value("alias").toString(), QString(), info->thing()->id());
-
-                        QString devId = QString("%1%2")
-                                .arg(info->thing()->paramValue(idParamTypesMap.value(info->thing()->thingClassId())).toString())
-                                .arg(childMap.value("id").toString());
-                        descriptor.setParams(ParamList() << Param(kasaSocketThingIdParamTypeId, devId));
-                        qCDebug(dcTplink()) << "Creating child socket for" << info->thing()->name() << "with ID" << devId;
-                        descriptors.append(descriptor);
-                    }
-                    emit autoThingsAppeared(descriptors);
-                }
+        ThingSetupInfo *setupInfo = m_pendingSetups.take(deviceId);
+        if (setupInfo) {
+            finishSetup(setupInfo, senderAddress, sysInfo);
+        }
 
-                connectToDevice(info->thing(), senderAddress);
+        if (!previousAddress.isNull() && previousAddress != senderAddress) {
+            foreach (Thing *thing, myThings()) {
+                if (!thing->parentId().isNull() || thing->paramValue(idParamTypesMap.value(thing->thingClassId())).toString() != deviceId)
+                    continue;
 
-                return;
+                qCDebug(dcTplink()) << thing->name() << "moved from" << previousAddress.toString() << "to" << senderAddress.toString();
+                QTcpSocket *socket = m_sockets.value(thing);
+                if (socket) {
+                    // Reconnects to the new address from the address table
+                    socket->abort();
+                }
             }
         }
+    }
+}
 
-        if (!m_setupRetries.contains(info) || m_setupRetries.value(info) < 5) {
-            qCDebug(dcTplink()) << "Device not found in network. Retrying... (" << m_setupRetries[info] << ")";
-            m_setupRetries[info]++;
-            setupThing(info);
+void IntegrationPluginTPLink::addDiscoveryResult(ThingDiscoveryInfo *info, const QVariantMap &sysInfo)
+{
+    QRegExp modelFilter;
+    if (info->thingClassId() == kasaPlug100ThingClassId) {
+        modelFilter = QRegExp("(HS100|HS103|HS105|KP100|KP105).*");
+    } else if (info->thingClassId() == kasaPlug110ThingClassId) {
+        modelFilter = QRegExp("(HS110|KP115).*");
+    } else if (info->thingClassId() == kasaSwitch200ThingClassId) {
+        modelFilter = QRegExp("HS200.*");
+    } else if (info->thingClassId() == kasaPowerStrip300ThingClassId) {
+        modelFilter = QRegExp("HS300.*");
+    }
+    QString model = sysInfo.value("model").toString();
+
+    if (!modelFilter.exactMatch(model)) {
+        qCDebug(dcTplink()) << "Ignoring not matching device type" << model;
+        return;
+    }
+
+    ThingDescriptor descriptor(info->thingClassId(), sysInfo.value("alias").toString(), sysInfo.value("dev_name").toString());
+    Param idParam = Param(idParamTypesMap.value(info->thingClassId()), sysInfo.value("deviceId").toString());
+    descriptor.setParams(ParamList() << idParam);
+    Thing *existingThing = myThings().findByParams(ParamList() << idParam);
+    if (existingThing) {
+        descriptor.setThingId(existingThing->id());
+    }
+
+    // Sometimes kasa devices reply multiple times on the discovery call. Prevent duplicates in the search results.
+    foreach (const ThingDescriptor &existingDescriptor, info->thingDescriptors()) {
+        if (existingDescriptor.params().paramValue(idParamTypesMap.value(info->thingClassId())) == idParam.value()) {
             return;
         }
-        m_setupRetries.remove(info);
-        info->finish(Thing::ThingErrorThingNotFound, QT_TR_NOOP("The device could not be found on the network."));
-    });
+    }
+    info->addThingDescriptor(descriptor);
 }
 
 void IntegrationPluginTPLink::postSetupThing(Thing *thing)
@@ -273,19 +327,22 @@ void IntegrationPluginTPLink::postSetupThing(Thing *thing)
         map.insert("system", systemMap);
         QByteArray payload = QJsonDocument::fromVariant(map).toJson(QJsonDocument::Compact);
         qCDebug(dcTplink) << "Setting thing name:" << payload;
-        payload = encryptPayload(payload);
-        QByteArray data;
-        QDataStream stream(&data, QIODevice::ReadWrite);
-        stream << static_cast<quint32>(payload.length());
-        data.append(payload);
 
         Job job;
         job.id = m_jobIdx++;
-        job.data = data;
+        job.data = buildMessage(payload);
         m_jobQueue[thing].append(job);
         processQueue(thing);
     });
 
+    if (!m_discoveryTimer) {
+        // Keeps the address table current, e.g. after a DHCP lease changed
+        m_discoveryTimer = hardwareManager()->pluginTimerManager()->registerTimer(60);
+        connect(m_discoveryTimer, &PluginTimer::timeout, this, [this](){
+            broadcastDiscovery();
+        });
+    }
+
     if (!m_timer) {
         m_timer = hardwareManager()->pluginTimerManager()->registerTimer(1);
         connect(m_timer, &PluginTimer::timeout, this, [this](){
@@ -308,6 +365,7 @@ void IntegrationPluginTPLink::thingRemoved(Thing *thing)
 {
     qCDebug(dcTplink()) << "Device removed" << thing->name();
     m_sockets.remove(thing);
+    m_inputBuffers.remove(thing);
     m_pendingJobs.remove(thing);
     m_jobQueue.remove(thing);
 
@@ -315,6 +373,10 @@ void IntegrationPluginTPLink::thingRemoved(Thing *thing)
         hardwareManager()->pluginTimerManager()->unregisterTimer(m_timer);
         m_timer = nullptr;
     }
+    if (myThings().isEmpty() && m_discoveryTimer) {
+        hardwareManager()->pluginTimerManager()->unregisterTimer(m_discoveryTimer);
+        m_discoveryTimer = nullptr;
+    }
 }
 
 void IntegrationPluginTPLink::executeAction(ThingActionInfo *info)
@@ -322,67 +384,100 @@ void IntegrationPluginTPLink::executeAction(ThingActionInfo *info)
     // The actual thing to send the command to (either directly a physical thing or in case of a virtual socket the parent thing)
     Thing *targetThing = info->thing()->parentId().isNull() ? info->thing() : myThings().findById(info->thing()->parentId());
 
-    QVariantMap powerMap;
-    powerMap.insert("state", info->action().param(info->action().actionTypeId()).value().toBool() ? 1 : 0);
-    QVariantMap systemMap;
-    systemMap.insert("set_relay_state", powerMap);
-    QVariantMap map;
-    map.insert("system", systemMap);
+    int state = info->action().param(info->action().actionTypeId()).value().toBool() ? 1 : 0;
+    QByteArray payload;
 
     // If we're switching a virtual child, we need to add a context map for the child_ids
-    if (info->thing()->thingClassId() == kasaSocketThingClassId) {
+    bool isChild = info->thing()->thingClassId() == kasaSocketThingClassId;
+    if (isChild) {
+        QVariantMap powerMap;
+        powerMap.insert("state", state);
+        QVariantMap systemMap;
+        systemMap.insert("set_relay_state", powerMap);
         QVariantMap contextMap;
         contextMap.insert("child_ids", QVariantList() << info->thing()->paramValue(kasaSocketThingIdParamTypeId).toString());
+        QVariantMap map;
+        map.insert("system", systemMap);
         map.insert("context", contextMap);
+        payload = QJsonDocument::fromVariant(map).toJson(QJsonDocument::Compact);
+    } else {
+        // Read back the new state in the same round trip. Written by hand as the device processes
+        // the commands in order and QVariantMap would sort get_sysinfo before set_relay_state.
+        payload = "{\"system\":{\"set_relay_state\":{\"state\":" + QByteArray::number(state) + "},\"get_sysinfo\":null}";
+        if (currentPowerStatetTypesMap.contains(targetThing->thingClassId())) {
+            payload += ",\"emeter\":{\"get_realtime\":null}";
+        }
+        payload += "}";
     }
-
-    qCDebug(dcTplink()) << "Executing action" << qUtf8Printable(QJsonDocument::fromVariant(map).toJson(QJsonDocument::Compact));
-
-    QByteArray payload = encryptPayload(QJsonDocument::fromVariant(map).toJson(QJsonDocument::Compact));
-    QByteArray data;
-    QDataStream stream(&data, QIODevice::ReadWrite);
-    stream << static_cast<quint32>(payload.length());
-    data.append(payload);
+    qCDebug(dcTplink()) << "Executing action" << qUtf8Printable(payload);
 
     Job job;
     job.id = m_jobIdx++;
-    job.data = data;
+    job.data = buildMessage(payload);
     job.actionInfo = info;
     m_jobQueue[targetThing].append(job);
     connect(info, &ThingActionInfo::aborted, this, [=](){
         m_jobQueue[targetThing].removeAll(job);
     });
 
-    // Directly queue up fetchState
-    fetchState(targetThing);
+    if (isChild) {
+        fetchState(targetThing);
+    }
 
     processQueue(targetThing);
 }
 
-QByteArray IntegrationPluginTPLink::encryptPayload(const QByteArray &payload)
+void IntegrationPluginTPLink::encryptInPlace(char *data, int length)
 {
-    QByteArray result;
-    int k = 171;
-    for (int i = 0; i < payload.length(); i++){
-        char t = payload.at(i) xor k;
-        k = t;
-        result.append(t);
+    char k = static_cast<char>(171);
+    for (int i = 0; i < length; i++) {
+        data[i] = data[i] ^ k;
+        k = data[i];
     }
-    return result;
 }
 
-QByteArray IntegrationPluginTPLink::decryptPayload(const QByteArray &payload)
+void IntegrationPluginTPLink::decryptInPlace(char *data, int length)
 {
-    QByteArray result;
-    int k = 171;
-    for (int i = 0; i < payload.length(); i++){
-        char t = payload.at(i);
-        result.append(t xor k);
+    char k = static_cast<char>(171);
+    for (int i = 0; i < length; i++) {
+        char t = data[i];
+        data[i] = t ^ k;
         k = t;
     }
+}
+
+QByteArray IntegrationPluginTPLink::encryptPayload(const QByteArray &payload)
+{
+    QByteArray result = payload;
+    encryptInPlace(result.data(), result.length());
     return result;
 }
 
+QByteArray IntegrationPluginTPLink::buildMessage(const QByteArray &payload)
+{
+    // 4 byte big endian length followed by the encrypted payload, in one allocation
+    QByteArray message(4 + payload.length(), Qt::Uninitialized);
+    qToBigEndian<quint32>(static_cast<quint32>(payload.length()), reinterpret_cast<uchar *>(message.data()));
+    memcpy(message.data() + 4, payload.constData(), static_cast<size_t>(payload.length()));
+    encryptInPlace(message.data() + 4, payload.length());
+    return message;
+}
+
+QVariantMap IntegrationPluginTPLink::stateRequest(Thing *thing)
+{
+    QVariantMap map;
+    QVariantMap getSysInfo;
+    getSysInfo.insert("get_sysinfo", QVariant());
+    map.insert("system", getSysInfo);
+    // Only ask devices with an energy meter for it, the others answer with an error for the module
+    if (currentPowerStatetTypesMap.contains(thing->thingClassId())) {
+        QVariantMap getRealTime;
+        getRealTime.insert("get_realtime", QVariant());
+        map.insert("emeter", getRealTime);
+    }
+    return map;
+}
+
 void IntegrationPluginTPLink::connectToDevice(Thing *thing, const QHostAddress &address)
 {
     if (m_sockets.contains(thing)) {
@@ -415,33 +510,41 @@ void IntegrationPluginTPLink::connectToDevice(Thing *thing, const QHostAddress &
 
     connect(socket, &QTcpSocket::readyRead, thing, [this, socket, thing](){
         m_inputBuffers[thing].append(socket->readAll());
-        while (m_inputBuffers[thing].length() > 4) {
-            QByteArray data = m_inputBuffers[thing];
-            QDataStream stream(data);
-            qint32 len;
-            stream >> len;
-            data.remove(0, 4);
-            if (data.length() < len) {
-                // Buffer not complete... wait for more...
+
+        // Walk all complete frames and drop them from the buffer once at the end
+        int offset = 0;
+        while (m_inputBuffers.value(thing).length() - offset >= 4) {
+            const QByteArray &buffer = m_inputBuffers[thing];
+            quint32 len = qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(buffer.constData() + offset));
+            if (len > maxMessageSize) {
+                // Out of sync or not a Kasa device, don't buffer up to 4 GiB waiting for the rest
+                qCWarning(dcTplink()) << "Message of" << len << "bytes exceeds the maximum of" << maxMessageSize << "bytes, closing the connection";
+                m_inputBuffers.remove(thing);
+                socket->abort();
                 return;
             }
-            QByteArray payload = data.left(len);
-            data.remove(0, len);
-            m_inputBuffers[thing] = data;
+            if (static_cast<quint32>(buffer.length() - offset - 4) < len) {
+                // Buffer not complete... wait for more...
+                break;
+            }
+            QByteArray payload = buffer.mid(offset + 4, static_cast<int>(len));
+            offset += 4 + static_cast<int>(len);
+            decryptInPlace(payload.data(), payload.length());
 
             if (!m_pendingJobs.contains(thing)) {
                 qCWarning(dcTplink()) << "Received packet from thing but don't have a job waiting for it. Did it time out?";
                 processQueue(thing);
-                return;
+                continue;
             }
 
             Job job = m_pendingJobs.take(thing);
 
             QJsonParseError error;
-            QJsonDocument jsonDoc = QJsonDocument::fromJson(decryptPayload(payload), &error);
+            QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
             if (error.error != QJsonParseError::NoError) {
-                qCWarning(dcTplink()) << "Cannot parse json from device:" << decryptPayload(payload);
+                qCWarning(dcTplink()) << "Cannot parse json from device:" << payload;
                 m_jobQueue[thing].prepend(job);
+                m_inputBuffers.remove(thing);
                 socket->disconnectFromHost();
                 return;
             }
@@ -456,7 +559,11 @@ void IntegrationPluginTPLink::connectToDevice(Thing *thing, const QHostAddress &
                         qCWarning(dcTplink()) << "Set relay state failed:" << qUtf8Printable(jsonDoc.toJson());
                         if (job.actionInfo) {
                             job.actionInfo->finish(Thing::ThingErrorHardwareFailure);
+                            job.actionInfo = nullptr;
                         }
+                    } else if (job.actionInfo && !systemMap.contains("get_sysinfo")) {
+                        job.actionInfo->finish(Thing::ThingErrorNoError);
+                        job.actionInfo = nullptr;
                     }
                 }
                 if (systemMap.contains("get_sysinfo")) {
@@ -523,12 +630,17 @@ void IntegrationPluginTPLink::connectToDevice(Thing *thing, const QHostAddress &
 
             processQueue(thing);
         }
+
+        if (offset > 0 && m_inputBuffers.contains(thing)) {
+            m_inputBuffers[thing].remove(0, offset);
+        }
     });
 
     connect(socket, &QTcpSocket::stateChanged, thing, [this, thing, address](QAbstractSocket::SocketState newState){
         if (newState == QAbstractSocket::UnconnectedState) {
             qCDebug(dcTplink()) << "Device disconnected";
             m_sockets.take(thing)->deleteLater();
+            m_inputBuffers.remove(thing);
             if (m_pendingJobs.contains(thing)) {
                 // Putting active job back to queue
                 m_jobQueue[thing].prepend(m_pendingJobs.take(thing));
@@ -540,7 +652,15 @@ void IntegrationPluginTPLink::connectToDevice(Thing *thing, const QHostAddress &
                 child->setStateValue(kasaSocketConnectedStateTypeId, false);
             }
 
-            QTimer::singleShot(500, thing, [this, thing, address]() {connectToDevice(thing, address);});
+            // The device might have a new address, ask for it but not more often than every 10 seconds
+            if (!m_lastBroadcast.isValid() || m_lastBroadcast.elapsed() > 10000) {
+                broadcastDiscovery();
+            }
+
+            QTimer::singleShot(500, thing, [this, thing, address]() {
+                QString deviceId = thing->paramValue(idParamTypesMap.value(thing->thingClassId())).toString();
+                connectToDevice(thing, m_deviceAddresses.value(deviceId, address));
+            });
         }
     });
 
@@ -549,24 +669,13 @@ void IntegrationPluginTPLink::connectToDevice(Thing *thing, const QHostAddress &
 
 void IntegrationPluginTPLink::fetchState(Thing *thing, ThingActionInfo *info)
 {
-    QVariantMap map;
-    QVariantMap getSysInfo;
-    getSysInfo.insert("get_sysinfo", QVariant());
-    map.insert("system", getSysInfo);
-    QVariantMap getRealTime;
-    getRealTime.insert("get_realtime", QVariant());
-    map.insert("emeter", getRealTime);
-    QByteArray plaintext = QJsonDocument::fromVariant(map).toJson(QJsonDocument::Compact);
+    // System info and energy meter in one round trip
+    QByteArray plaintext = QJsonDocument::fromVariant(stateRequest(thing)).toJson(QJsonDocument::Compact);
     qCDebug(dcTplink()) << "Fetching device state";
-    QByteArray payload = encryptPayload(plaintext);
-    QByteArray data;
-    QDataStream stream(&data, QIODevice::ReadWrite);
-    stream << static_cast<quint32>(payload.length());
-    data.append(payload);
 
     Job job;
     job.id = m_jobIdx++;
-    job.data = data;
+    job.data = buildMessage(plaintext);
     job.actionInfo = info;
     m_jobQueue[thing].append(job);
 
@@ -34,6 +34,7 @@
 #include "integrations/integrationplugin.h"
 
 #include <QUdpSocket>
+#include <QElapsedTimer>
 
 #include <QNetworkAccessManager>
 
@@ -58,8 +59,15 @@ public:
     void executeAction(ThingActionInfo *info) override;
 
 private:
+    void encryptInPlace(char *data, int length);
+    void decryptInPlace(char *data, int length);
     QByteArray encryptPayload(const QByteArray &payload);
-    QByteArray decryptPayload(const QByteArray &payload);
+    QByteArray buildMessage(const QByteArray &payload);
+    QVariantMap stateRequest(Thing *thing);
+
+    bool broadcastDiscovery();
+    void addDiscoveryResult(ThingDiscoveryInfo *info, const QVariantMap &sysInfo);
+    void finishSetup(ThingSetupInfo *info, const QHostAddress &address, const QVariantMap &sysInfo);
 
     void connectToDevice(Thing *thing, const QHostAddress &address);
     void fetchState(Thing *thing, ThingActionInfo *info = nullptr);
@@ -79,12 +87,25 @@ private:
     int m_jobIdx = 0;
 
     QUdpSocket *m_broadcastSocket = nullptr;
+    QElapsedTimer m_lastBroadcast;
+    PluginTimer *m_discoveryTimer = nullptr;
+
+    // Filled from all discovery replies, keyed by deviceId
+    QHash<QString, QHostAddress> m_deviceAddresses;
+    QHash<QString, QVariantMap> m_deviceSysInfos;
+
+    // Discoveries collecting replies, setups waiting for their device
+    QList<ThingDiscoveryInfo*> m_pendingDiscoveries;
+    QHash<QString, ThingSetupInfo*> m_pendingSetups;
     QHash<Thing*, QTcpSocket*> m_sockets;
     QHash<ThingSetupInfo*, int> m_setupRetries;
 
     QHash<Thing*, QByteArray> m_inputBuffers;
 
     PluginTimer *m_timer = nullptr;
+
+private slots:
+    void onBroadcastReadyRead();
 };
 
 #endif // INTEGRATIONPLUGINANEL_H
@@ -41,6 +41,9 @@
 
 #include "plugintimer.h"
 
+#include "tuyalocaldevice.h"
+#include "tuyaprotocol.h"
+
 // API info:
 // Python project: https://github.com/PaulAnnekov/tuyaha
 // JS project: https://github.com/unparagoned/cloudtuya
@@ -66,6 +69,22 @@ QHash<ActionTypeId, ThingClassId> powerStateTypeIdsMap = {
     {tuyaLightThingClassId, tuyaLightPowerStateTypeId}
 };
 
+QHash<QString, ThingClassId> devTypeThingClassIds = {
+    {"cover", tuyaClosableThingClassId},
+    {"switch", tuyaSwitchThingClassId},
+    {"light", tuyaLightThingClassId}
+};
+
+QHash<ThingClassId, ParamTypeId> localKeyParamTypeIdsMap = {
+    {tuyaClosableThingClassId, tuyaClosableSettingsLocalKeyParamTypeId},
+    {tuyaSwitchThingClassId, tuyaSwitchSettingsLocalKeyParamTypeId},
+    {tuyaLightThingClassId, tuyaLightSettingsLocalKeyParamTypeId}
+};
+
+// Devices announce themselves on UDP 6666 (plain, older firmwares) and 6667 (encrypted)
+const quint16 discoveryPort = 6666;
+const quint16 encryptedDiscoveryPort = 6667;
+
 IntegrationPluginTuya::IntegrationPluginTuya(QObject *parent): IntegrationPlugin(parent)
 {
 }
@@ -128,19 +147,42 @@ void IntegrationPluginTuya::postSetupThing(Thing *thing)
     if (thing->thingClassId() == tuyaCloudThingClassId) {
         updateChildDevices(thing);        
     } else {
-        queryDevice(thing);
+        // Restore the last known state, the discovery of the parent refreshes it
+        pluginStorage()->beginGroup(thing->parentId().toString());
+        QByteArray discoveryCache = pluginStorage()->value("DiscoveryCache").toByteArray();
+        pluginStorage()->endGroup();
+        QString devId = thing->paramValue(idParamTypeIdsMap.value(thing->thingClassId())).toString();
+        foreach (const QVariant &deviceVariant, QJsonDocument::fromJson(discoveryCache).toVariant().toMap().value("payload").toMap().value("devices").toList()) {
+            if (deviceVariant.toMap().value("id").toString() == devId) {
+                applyCloudState(thing, deviceVariant.toMap().value("data").toMap());
+                break;
+            }
+        }
+
+        takeLocalKeySetting(thing);
+        setupLocalDevice(thing);
+        connect(thing, &Thing::settingChanged, this, [this, thing](const ParamTypeId &paramTypeId, const QVariant &value){
+            // Emptying the setting after taking the key over changes it again
+            if (paramTypeId == localKeyParamTypeIdsMap.value(thing->thingClassId()) && !value.toString().isEmpty()) {
+                takeLocalKeySetting(thing);
+                setupLocalDevice(thing);
+            }
+        });
     }
 
 
     if (!m_pluginTimerQuery) {
         m_pluginTimerQuery = hardwareManager()->pluginTimerManager()->registerTimer(queryInterval);
         connect(m_pluginTimerQuery, &PluginTimer::timeout, this, [this](){
+            // Only devices which just received an action are queried, the discovery refreshes all others
             foreach (Thing *d, myThings().filterByThingClassId(tuyaCloudThingClassId)) {
-                if (m_pollQueue.value(d).isEmpty()) {
-                    m_pollQueue[d] = myThings().filterByParentId(d->id());
-                }
-                if (m_pollQueue[d].count() > 0) {
-                    queryDevice(m_pollQueue[d].takeFirst());
+                while (!m_queryQueue.value(d).isEmpty()) {
+                    Thing *child = m_queryQueue[d].takeFirst();
+                    // Locally connected devices push their state
+                    if (!m_localDevices.contains(child) || !m_localDevices.value(child)->connected()) {
+                        queryDevice(child);
+                        break;
+                    }
                 }
             }
         });
@@ -159,11 +201,24 @@ void IntegrationPluginTuya::postSetupThing(Thing *thing)
 void IntegrationPluginTuya::thingRemoved(Thing *thing)
 {
     if (thing->thingClassId() == tuyaCloudThingClassId) {
-        m_pollQueue.remove(thing);
+        m_queryQueue.remove(thing);
         m_tokenExpiryTimers.take(thing->id())->deleteLater();
+    } else {
+        foreach (Thing *parent, m_queryQueue.keys()) {
+            m_queryQueue[parent].removeAll(thing);
+        }
+        if (m_localDevices.contains(thing)) {
+            m_localDevices.take(thing)->deleteLater();
+        }
+        pluginStorage()->remove(thing->id().toString());
     }
 
     if (myThings().isEmpty()) {
+        delete m_discoverySocket;
+        m_discoverySocket = nullptr;
+        delete m_encryptedDiscoverySocket;
+        m_encryptedDiscoverySocket = nullptr;
+
         hardwareManager()->pluginTimerManager()->unregisterTimer(m_pluginTimerDiscovery);
         m_pluginTimerDiscovery = nullptr;
         hardwareManager()->pluginTimerManager()->unregisterTimer(m_pluginTimerQuery);
@@ -245,6 +300,14 @@ void IntegrationPluginTuya::confirmPairing(ThingPairingInfo *info, const QString
 }
 
 void IntegrationPluginTuya::executeAction(ThingActionInfo *info)
+{
+    if (executeLocalAction(info))
+        return;
+
+    executeCloudAction(info);
+}
+
+void IntegrationPluginTuya::executeCloudAction(ThingActionInfo *info)
 {
     QString devId = info->thing()->paramValue(idParamTypeIdsMap.value(info->thing()->thingClassId())).toString();
 
@@ -448,62 +511,54 @@ void IntegrationPluginTuya::updateChildDevices(Thing *thing)
 
         QList<ThingDescriptor> unknownDevices;
 
+        // All states are refreshed in one pass from the discovery result
+        QHash<QString, Thing*> knownDevices;
+        foreach (Thing *child, myThings()) {
+            if (idParamTypeIdsMap.contains(child->thingClassId())) {
+                knownDevices.insert(child->paramValue(idParamTypeIdsMap.value(child->thingClassId())).toString(), child);
+            }
+        }
+
         foreach (const QVariant &deviceVariant, devices) {
             QVariantMap deviceMap = deviceVariant.toMap();
             QString devType = deviceMap.value("dev_type").toString();
             QString id = deviceMap.value("id").toString();
             QString name = deviceMap.value("name").toString();
 
-            if (devType == "switch") {
-                Thing *d = myThings().findByParams(ParamList() << Param(tuyaSwitchThingIdParamTypeId, id));
-                if (!d) {
-                    qCDebug(dcTuya()) << "Found new Tuya switch" << id << name;
-                    ThingDescriptor descriptor(tuyaSwitchThingClassId, name, QString(), thing->id());
-                    descriptor.setParams(ParamList() << Param(tuyaSwitchThingIdParamTypeId, id));
-                    unknownDevices.append(descriptor);
-                } else {
-                    bool online = deviceMap.value("data").toMap().value("online").toBool();
-                    bool state = deviceMap.value("data").toMap().value("state").toBool();
-                    qCDebug(dcTuya()) << "Found existing Tuya switch" << d->name() << id << name << (online ? "online:" : "offline") << (state ? "on": "off");
-                    d->setStateValue(tuyaSwitchConnectedStateTypeId, online);
-                    d->setStateValue(tuyaSwitchPowerStateTypeId, state);
-                }
+            if (!devTypeThingClassIds.contains(devType)) {
+                qCWarning(dcTuya()) << "Skipping unsupported thing type:" << devType;
+                qCWarning(dcTuya()) << "Please report this including the following data:\n" << qUtf8Printable(QJsonDocument::fromVariant(deviceVariant).toJson());
+                continue;
+            }
 
-            } else if (devType == "cover") {
-                Thing *d = myThings().findByParams(ParamList() << Param(tuyaClosableThingIdParamTypeId, id));
-                if (!d) {
-                    qCDebug(dcTuya()) << "Found new Tuya cover" << id << name;
-                    ThingDescriptor descriptor(tuyaClosableThingClassId, name, QString(), thing->id());
-                    descriptor.setParams(ParamList() << Param(tuyaClosableThingIdParamTypeId, id));
-                    unknownDevices.append(descriptor);
-                } else {
-                    bool online = deviceMap.value("data").toMap().value("online").toBool();
-                    qCDebug(dcTuya()) << "Found existing Tuya cover" << d->name() << id << name << (online ? "online" : "offline");
-                    d->setStateValue(tuyaClosableConnectedStateTypeId, online);
-                }
+            Thing *d = knownDevices.value(id);
+            if (!d) {
+                ThingClassId thingClassId = devTypeThingClassIds.value(devType);
+                qCDebug(dcTuya()) << "Found new Tuya" << devType << id << name;
+                ThingDescriptor descriptor(thingClassId, name, QString(), thing->id());
+                descriptor.setParams(ParamList() << Param(idParamTypeIdsMap.value(thingClassId), id));
+                unknownDevices.append(descriptor);
+                continue;
+            }
 
-            } else if (devType == "light") {
-                Thing *d = myThings().findByParams(ParamList() << Param(tuyaLightThingIdParamTypeId, id));
-                if (!d) {
-                    qCDebug(dcTuya()) << "Found new color Tuya light" << id << name;
-                    ThingDescriptor descriptor(tuyaLightThingClassId, name, QString(), thing->id());
-                    descriptor.setParams(ParamList() << Param(tuyaLightThingIdParamTypeId, id));
-                    unknownDevices.append(descriptor);
-                } else {
-                    bool online = deviceMap.value("data").toMap().value("online").toBool();
-                    bool state = deviceMap.value("data").toMap().value("state").toBool();
-                    qCDebug(dcTuya()) << "Found existing Tuya color light" << d->name() << id << name << (online ? "online" : "offline");
-                    int brightness = deviceMap.value("data").toMap().value("brightness").toInt() / 10; // Apparently the value in the tuya cloud is 10 - 1000
-                    d->setStateValue(tuyaLightConnectedStateTypeId, online);
-                    d->setStateValue(tuyaLightPowerStateTypeId, state);
-                    d->setStateValue(tuyaLightBrightnessStateTypeId, brightness);
-                }
+            // Take over the local key once if the cloud provides it
+            QString localKey = deviceMap.value("local_key").toString();
+            if (!localKey.isEmpty() && loadLocalKey(d).isEmpty()) {
+                qCDebug(dcTuya()) << "Received local key for" << d->name();
+                storeLocalKey(d, localKey.toUtf8());
+                setupLocalDevice(d);
+            }
 
-            } else {
-                qCWarning(dcTuya()) << "Skipping unsupported thing type:" << devType;
-                qCWarning(dcTuya()) << "Please report this including the following data:\n" << qUtf8Printable(QJsonDocument::fromVariant(deviceVariant).toJson());
+            // This state is newer than a pending query could deliver
+            m_queryQueue[thing].removeAll(d);
+
+            if (m_localDevices.contains(d) && m_localDevices.value(d)->connected()) {
+                qCDebug(dcTuya()) << "Tuya" << devType << d->name() << "is controlled locally";
                 continue;
             }
+
+            qCDebug(dcTuya()) << "Found existing Tuya" << devType << d->name() << id << name;
+            applyCloudState(d, deviceMap.value("data").toMap());
         }
 
         if (!unknownDevices.isEmpty()) {
@@ -572,16 +627,31 @@ void IntegrationPluginTuya::queryDevice(Thing *thing)
             // Fall through to mark thing as offline on any other error.
         }
 
-        bool connected = result.value("payload").toMap().value("data").toMap().value("online").toBool();
-        bool state = result.value("payload").toMap().value("data").toMap().value("state").toBool();
-        qCDebug(dcTuya()) << "Device" << thing->name() << "is online:" << connected << "on:" << state;
+        applyCloudState(thing, result.value("payload").toMap().value("data").toMap());
+    });
+}
+
+void IntegrationPluginTuya::applyCloudState(Thing *thing, const QVariantMap &data)
+{
+    bool online = data.value("online").toBool();
+    qCDebug(dcTuya()) << "Device" << thing->name() << "is online:" << online << "state:" << data.value("state");
+    thing->setStateValue(connectedStateTypeIdsMap.value(thing->thingClassId()), online);
 
-        thing->setStateValue(connectedStateTypeIdsMap.value(thing->thingClassId()), connected);
+    if (powerStateTypeIdsMap.contains(thing->thingClassId()) && data.contains("state")) {
+        thing->setStateValue(powerStateTypeIdsMap.value(thing->thingClassId()), data.value("state").toBool());
+    }
+    if (thing->thingClassId() == tuyaLightThingClassId && data.contains("brightness")) {
+        // Apparently the value in the tuya cloud is 10 - 1000
+        thing->setStateValue(tuyaLightBrightnessStateTypeId, data.value("brightness").toInt() / 10);
+    }
+}
 
-        if (powerStateTypeIdsMap.contains(thing->thingClassId())) {
-            thing->setStateValue(powerStateTypeIdsMap.value(thing->thingClassId()), state);
-        }
-    });
+void IntegrationPluginTuya::scheduleQuery(Thing *thing)
+{
+    Thing *parentDevice = myThings().findById(thing->parentId());
+    if (parentDevice && !m_queryQueue.value(parentDevice).contains(thing)) {
+        m_queryQueue[parentDevice].append(thing);
+    }
 }
 
 void IntegrationPluginTuya::controlTuyaSwitch(const QString &devId, const QString &command, const QVariant &value, ThingActionInfo *info)
@@ -620,7 +690,7 @@ void IntegrationPluginTuya::controlTuyaSwitch(const QString &devId, const QStrin
 
     QNetworkReply *reply = hardwareManager()->networkManager()->post(request, jsonDoc.toJson(QJsonDocument::Compact));
     connect(reply, &QNetworkReply::finished, [reply](){reply->deleteLater();});
-    connect(reply, &QNetworkReply::finished, info, [info, reply](){
+    connect(reply, &QNetworkReply::finished, info, [this, info, reply](){
         if (reply->error() !=  QNetworkReply::NoError) {
             qCWarning(dcTuya()) << "Error setting switch state" << reply->error();
             info->finish(Thing::ThingErrorHardwareFailure, QT_TR_NOOP("Error connecting to Tuya switch."));
@@ -645,7 +715,194 @@ void IntegrationPluginTuya::controlTuyaSwitch(const QString &devId, const QStrin
         }
 
         qCDebug(dcTuya())  << "Device controlled";
+        // Confirm the new state with the next query
+        scheduleQuery(info->thing());
         info->finish(Thing::ThingErrorNoError);
     });
 }
 
+void IntegrationPluginTuya::setupLocalDevice(Thing *thing)
+{
+    if (m_localDevices.contains(thing)) {
+        m_localDevices.take(thing)->deleteLater();
+        scheduleQuery(thing);
+    }
+
+    QByteArray localKey = loadLocalKey(thing);
+    if (localKey.isEmpty())
+        return;
+
+    if (localKey.length() != 16) {
+        qCWarning(dcTuya()) << "Invalid local key for" << thing->name() << ", the key needs to have 16 characters.";
+        return;
+    }
+
+    if (!m_discoverySocket) {
+        m_discoverySocket = new QUdpSocket(this);
+        if (!m_discoverySocket->bind(QHostAddress::AnyIPv4, discoveryPort, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)) {
+            qCWarning(dcTuya()) << "Cannot listen for Tuya devices on port" << discoveryPort << m_discoverySocket->errorString();
+        }
+        connect(m_discoverySocket, &QUdpSocket::readyRead, this, &IntegrationPluginTuya::onDiscoveryReadyRead);
+
+        m_encryptedDiscoverySocket = new QUdpSocket(this);
+        if (!m_encryptedDiscoverySocket->bind(QHostAddress::AnyIPv4, encryptedDiscoveryPort, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)) {
+            qCWarning(dcTuya()) << "Cannot listen for Tuya devices on port" << encryptedDiscoveryPort << m_encryptedDiscoverySocket->errorString();
+        }
+        connect(m_encryptedDiscoverySocket, &QUdpSocket::readyRead, this, &IntegrationPluginTuya::onDiscoveryReadyRead);
+    }
+
+    QString devId = thing->paramValue(idParamTypeIdsMap.value(thing->thingClassId())).toString();
+    TuyaLocalDevice *localDevice = new TuyaLocalDevice(devId, localKey, this);
+    m_localDevices.insert(thing, localDevice);
+
+    connect(localDevice, &TuyaLocalDevice::connectedChanged, thing, [this, thing](bool connected){
+        if (connected) {
+            thing->setStateValue(connectedStateTypeIdsMap.value(thing->thingClassId()), true);
+        } else {
+            // Let the cloud tell whether the device is still online
+            scheduleQuery(thing);
+        }
+    });
+    connect(localDevice, &TuyaLocalDevice::dpsChanged, thing, [this, thing](const QVariantMap &dps){
+        onLocalDpsChanged(thing, dps);
+    });
+
+    // The address is known as soon as the device broadcasts the next time (every ~5 seconds)
+    if (m_deviceAddresses.contains(devId)) {
+        localDevice->setAddress(m_deviceAddresses.value(devId));
+    }
+}
+
+QByteArray IntegrationPluginTuya::loadLocalKey(Thing *thing)
+{
+    pluginStorage()->beginGroup(thing->id().toString());
+    QByteArray localKey = pluginStorage()->value("localKey").toByteArray();
+    pluginStorage()->endGroup();
+    return localKey;
+}
+
+void IntegrationPluginTuya::storeLocalKey(Thing *thing, const QByteArray &localKey)
+{
+    pluginStorage()->beginGroup(thing->id().toString());
+    pluginStorage()->setValue("localKey", localKey);
+    pluginStorage()->endGroup();
+}
+
+void IntegrationPluginTuya::takeLocalKeySetting(Thing *thing)
+{
+    // The setting is only the input field, the key is kept in the plugin storage like other credentials
+    ParamTypeId localKeyParamTypeId = localKeyParamTypeIdsMap.value(thing->thingClassId());
+    QString localKey = thing->setting(localKeyParamTypeId).toString();
+    if (localKey.isEmpty())
+        return;
+
+    storeLocalKey(thing, localKey.toUtf8());
+    thing->setSettingValue(localKeyParamTypeId, QString());
+}
+
+bool IntegrationPluginTuya::executeLocalAction(ThingActionInfo *info)
+{
+    Thing *thing = info->thing();
+    TuyaLocalDevice *localDevice = m_localDevices.value(thing);
+    if (!localDevice || !localDevice->connected())
+        return false;
+
+    // Switches use data point 1, lights either 1/3 (older) or 20/22 and covers 1 with "open", "close" and "stop"
+    QVariantMap dps;
+    ActionTypeId actionTypeId = info->action().actionTypeId();
+    if (powerStateTypeIdsMap.values().contains(actionTypeId)) {
+        QString dp = localDevice->dps().contains("20") ? "20" : "1";
+        dps.insert(dp, info->action().paramValue(actionTypeId).toBool());
+    } else if (actionTypeId == tuyaLightBrightnessActionTypeId) {
+        int brightness = info->action().paramValue(tuyaLightBrightnessActionBrightnessParamTypeId).toInt();
+        if (localDevice->dps().contains("22")) {
+            dps.insert("22", qMax(10, brightness * 10));
+        } else if (localDevice->dps().contains("3")) {
+            dps.insert("3", 25 + brightness * 230 / 100);
+        }
+    } else if (actionTypeId == tuyaClosableOpenActionTypeId) {
+        dps.insert("1", "open");
+    } else if (actionTypeId == tuyaClosableCloseActionTypeId) {
+        dps.insert("1", "close");
+    } else if (actionTypeId == tuyaClosableStopActionTypeId) {
+        dps.insert("1", "stop");
+    }
+
+    // Colors aren't mapped to data points yet
+    if (dps.isEmpty())
+        return false;
+
+    int requestId = localDevice->setDps(dps);
+    if (requestId < 0)
+        return false;
+
+    qCDebug(dcTuya()) << "Controlling" << thing->name() << "locally:" << dps;
+    connect(localDevice, &TuyaLocalDevice::commandFinished, info, [this, info, requestId](int id, bool success){
+        if (id != requestId)
+            return;
+
+        if (!success) {
+            qCWarning(dcTuya()) << "Local control of" << info->thing()->name() << "failed, using the cloud";
+            executeCloudAction(info);
+            return;
+        }
+        // The device pushes its new state right after the acknowledge
+        info->finish(Thing::ThingErrorNoError);
+    });
+    return true;
+}
+
+void IntegrationPluginTuya::onLocalDpsChanged(Thing *thing, const QVariantMap &dps)
+{
+    if (thing->thingClassId() == tuyaSwitchThingClassId) {
+        if (dps.contains("1")) {
+            thing->setStateValue(tuyaSwitchPowerStateTypeId, dps.value("1").toBool());
+        }
+    } else if (thing->thingClassId() == tuyaLightThingClassId) {
+        if (dps.contains("20")) {
+            thing->setStateValue(tuyaLightPowerStateTypeId, dps.value("20").toBool());
+        } else if (dps.contains("1")) {
+            thing->setStateValue(tuyaLightPowerStateTypeId, dps.value("1").toBool());
+        }
+        if (dps.contains("22")) {
+            thing->setStateValue(tuyaLightBrightnessStateTypeId, dps.value("22").toInt() / 10);
+        } else if (dps.contains("3")) {
+            thing->setStateValue(tuyaLightBrightnessStateTypeId, qMax(0, (dps.value("3").toInt() - 25) * 100 / 230));
+        }
+    }
+}
+
+void IntegrationPluginTuya::onDiscoveryReadyRead()
+{
+    QUdpSocket *socket = qobject_cast<QUdpSocket*>(sender());
+    while (socket->hasPendingDatagrams()) {
+        QByteArray datagram;
+        datagram.resize(static_cast<int>(socket->pendingDatagramSize()));
+        QHostAddress senderAddress;
+        socket->readDatagram(datagram.data(), datagram.size(), &senderAddress);
+
+        TuyaProtocol::Message message;
+        if (TuyaProtocol::parseMessage(TuyaProtocol::udpKey(), datagram, 0, &message) <= 0)
+            continue;
+
+        QVariantMap announcement = QJsonDocument::fromJson(message.payload).toVariant().toMap();
+        QString devId = announcement.value("gwId").toString();
+        if (devId.isEmpty())
+            continue;
+
+        QHostAddress address(announcement.value("ip").toString());
+        if (address.isNull()) {
+            address = senderAddress;
+        }
+        if (m_deviceAddresses.value(devId) == address)
+            continue;
+
+        qCDebug(dcTuya()) << "Tuya device" << devId << "announced at" << address.toString() << "version" << announcement.value("version").toString();
+        m_deviceAddresses.insert(devId, address);
+        foreach (TuyaLocalDevice *localDevice, m_localDevices) {
+            if (localDevice->devId() == devId) {
+                localDevice->setAddress(address);
+            }
+        }
+    }
+}
@@ -32,10 +32,12 @@
 #define INTEGRATIONPLUGINTUYA_H
 
 #include <QTimer>
+#include <QUdpSocket>
 
 #include "integrations/integrationplugin.h"
 
 class PluginTimer;
+class TuyaLocalDevice;
 
 class IntegrationPluginTuya: public IntegrationPlugin
 {
@@ -63,14 +65,32 @@ private:
     void refreshAccessToken(Thing *thing);
     void updateChildDevices(Thing *thing);
     void queryDevice(Thing *thing);
+    void applyCloudState(Thing *thing, const QVariantMap &data);
+    void scheduleQuery(Thing *thing);
 
     void controlTuyaSwitch(const QString &devId, const QString &command, const QVariant &value, ThingActionInfo *info);
+    void executeCloudAction(ThingActionInfo *info);
+
+    // Local control on port 6668, the cloud is used while a device isn't reachable locally
+    void setupLocalDevice(Thing *thing);
+    QByteArray loadLocalKey(Thing *thing);
+    void storeLocalKey(Thing *thing, const QByteArray &localKey);
+    void takeLocalKeySetting(Thing *thing);
+    bool executeLocalAction(ThingActionInfo *info);
+    void onLocalDpsChanged(Thing *thing, const QVariantMap &dps);
+    void onDiscoveryReadyRead();
 
     QHash<ThingId, QTimer*> m_tokenExpiryTimers;
     PluginTimer *m_pluginTimerQuery = nullptr;
     PluginTimer *m_pluginTimerDiscovery = nullptr;
 
-    QHash<Thing*, QList<Thing*>> m_pollQueue;
+    // Devices to query after an action, one per cloud account and query interval
+    QHash<Thing*, QList<Thing*>> m_queryQueue;
+
+    QHash<Thing*, TuyaLocalDevice*> m_localDevices;
+    QHash<QString, QHostAddress> m_deviceAddresses;
+    QUdpSocket *m_discoverySocket = nullptr;
+    QUdpSocket *m_encryptedDiscoverySocket = nullptr;
 };
 
 #endif // INTEGRATIONPLUGINTUYA_H
@@ -0,0 +1,291 @@
+#include <QCoreApplication>
+
+#include <QDebug>
+#include <QTimer>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include <QNetworkInterface>
+#include <QCryptographicHash>
+
+#include <openssl/evp.h>
+
+// Simulates a Tuya switch with LAN protocol 3.3
+// Usage: simulator [devId] [localKey]   runs the device, the local key needs to match the one of the thing in nymea
+//        simulator --check              checks the framing against reference frames and exits with an error on a mismatch
+// The framing is implemented here on its own instead of using the plugin's TuyaProtocol, so talking to
+// the plugin checks one implementation against the other.
+
+#define DEVICE_ID "bf0123456789abcdef01"
+#define LOCAL_KEY "0123456789abcdef"
+
+static const quint32 messagePrefix = 0x000055AA;
+static const quint32 messageSuffix = 0x0000AA55;
+static const quint32 commandControl = 0x07;
+static const quint32 commandStatus = 0x08;
+static const quint32 commandHeartbeat = 0x09;
+static const quint32 commandDpQuery = 0x0a;
+static const quint32 commandAnnouncement = 0x13;
+static const QByteArray versionHeader = QByteArray("3.3") + QByteArray(12, '\0');
+
+struct Frame {
+    quint32 sequence = 0;
+    quint32 command = 0;
+    QByteArray payload;
+};
+
+static void appendUInt32(QByteArray &data, quint32 value)
+{
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        data.append(static_cast<char>((value >> shift) & 0xff));
+    }
+}
+
+static quint32 readUInt32(const QByteArray &data, int offset)
+{
+    quint32 value = 0;
+    for (int i = 0; i < 4; i++) {
+        value = (value << 8) | static_cast<quint8>(data.at(offset + i));
+    }
+    return value;
+}
+
+// Bitwise CRC-32 like zlib computes it
+static quint32 crc32(const QByteArray &data)
+{
+    quint32 crc = 0xFFFFFFFF;
+    foreach (char byte, data) {
+        crc ^= static_cast<quint8>(byte);
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+    }
+    return ~crc;
+}
+
+static QByteArray aes(bool encrypt, const QByteArray &key, const QByteArray &input)
+{
+    EVP_CIPHER_CTX *context = EVP_CIPHER_CTX_new();
+    QByteArray output(input.length() + 16, Qt::Uninitialized);
+    int length = 0;
+    int finalLength = 0;
+    bool ok = EVP_CipherInit_ex(context, EVP_aes_128_ecb(), nullptr, reinterpret_cast<const uchar *>(key.constData()), nullptr, encrypt ? 1 : 0)
+            && EVP_CipherUpdate(context, reinterpret_cast<uchar *>(output.data()), &length,
+                                reinterpret_cast<const uchar *>(input.constData()), input.length())
+            && EVP_CipherFinal_ex(context, reinterpret_cast<uchar *>(output.data()) + length, &finalLength);
+    EVP_CIPHER_CTX_free(context);
+    if (!ok)
+        return QByteArray();
+
+    output.resize(length + finalLength);
+    return output;
+}
+
+// Messages of the device carry a return code, status pushes additionally the version header
+static QByteArray buildFrame(const QByteArray &key, quint32 sequence, quint32 command, const QByteArray &payload)
+{
+    QByteArray body(4, '\0');
+    if (command == commandStatus)
+        body.append(versionHeader);
+    if (!payload.isEmpty())
+        body.append(aes(true, key, payload));
+
+    QByteArray frame;
+    appendUInt32(frame, messagePrefix);
+    appendUInt32(frame, sequence);
+    appendUInt32(frame, command);
+    appendUInt32(frame, static_cast<quint32>(body.length() + 8));
+    frame.append(body);
+    appendUInt32(frame, crc32(frame));
+    appendUInt32(frame, messageSuffix);
+    return frame;
+}
+
+// Parses a message of the client at the start of data. Returns the number of bytes consumed,
+// 0 if the message is not complete yet and -1 if it is invalid.
+static int parseFrame(const QByteArray &key, const QByteArray &data, Frame *frame)
+{
+    if (data.length() < 16)
+        return 0;
+
+    quint32 length = readUInt32(data, 12);
+    if (readUInt32(data, 0) != messagePrefix || length < 8 || length > 65536)
+        return -1;
+
+    int size = 16 + static_cast<int>(length);
+    if (data.length() < size)
+        return 0;
+
+    if (readUInt32(data, size - 4) != messageSuffix || readUInt32(data, size - 8) != crc32(data.left(size - 8)))
+        return -1;
+
+    frame->sequence = readUInt32(data, 4);
+    frame->command = readUInt32(data, 8);
+    QByteArray body = data.mid(16, static_cast<int>(length) - 8);
+    if (body.startsWith(versionHeader))
+        body = body.mid(versionHeader.length());
+    frame->payload = body.isEmpty() ? QByteArray() : aes(false, key, body);
+    return size;
+}
+
+static int check()
+{
+    // Computed with "openssl enc -aes-128-ecb" and zlib's crc32 for the default device ID and local key
+    const QByteArray key = LOCAL_KEY;
+    int failures = 0;
+    auto checkFrame = [&failures](const QString &name, const QByteArray &frame, const QByteArray &expectedHex) {
+        if (frame.toHex() != expectedHex) {
+            qWarning().noquote() << "FAILED:" << name << "frame" << frame.toHex() << "expected" << expectedHex;
+            failures++;
+        }
+    };
+
+    checkFrame("heartbeat", buildFrame(key, 1, commandHeartbeat, QByteArray()),
+               "000055aa00000001000000090000000c000000006dc772860000aa55");
+    checkFrame("query response", buildFrame(key, 2, commandDpQuery, "{\"devId\":\"bf0123456789abcdef01\",\"dps\":{\"1\":false}}"),
+               "000055aa000000020000000a0000004c00000000cf86245f80a43fd581e9f874f8bade17e0b4d3f9e7b218c96a2c6c50"
+               "7dd240c020732d3448c1530434b02aa5e450ca5064215f365b0dad6b2ac8fab15b1d40bd893828770000aa55");
+    checkFrame("status", buildFrame(key, 0, commandStatus, "{\"devId\":\"bf0123456789abcdef01\",\"dps\":{\"1\":true},\"t\":1600000000}"),
+               "000055aa00000000000000080000006b00000000332e33000000000000000000000000cf86245f80a43fd581e9f874f8"
+               "bade17e0b4d3f9e7b218c96a2c6c507dd240c041fb8ef70a70a27b93a7e74ffe754263e83091c08674ba4d3a25d0b371"
+               "4609b6377222e061a924c591cd9c27ea163ed4496e8c580000aa55");
+
+    QByteArray control = QByteArray::fromHex("000055aa000000030000000700000077332e33000000000000000000000000cf86245f80a43fd581e9f874f8bade17e0"
+                                             "b4d3f9e7b218c96a2c6c507dd240c041fb8ef70a70a27b93a7e74ffe7542630e5039e3e6f789ec3471ddf0f204364ee6"
+                                             "abde0238b0d61fa0fb89beb937e43144baa569ef4dcc222a3f62327609ede15e9abbb50000aa55");
+    Frame frame;
+    int consumed = parseFrame(key, control + "trailing", &frame);
+    if (consumed != control.length() || frame.sequence != 3 || frame.command != commandControl
+            || frame.payload != "{\"devId\":\"bf0123456789abcdef01\",\"dps\":{\"1\":true},\"t\":\"1600000000\",\"uid\":\"bf0123456789abcdef01\"}") {
+        qWarning() << "FAILED: control frame parsed to" << consumed << frame.sequence << frame.command << frame.payload;
+        failures++;
+    }
+    if (parseFrame(key, control.left(control.length() - 1), &frame) != 0) {
+        qWarning() << "FAILED: incomplete control frame is not waited for";
+        failures++;
+    }
+    QByteArray corrupted = control;
+    corrupted[20] = static_cast<char>(corrupted.at(20) ^ 0x01);
+    if (parseFrame(key, corrupted, &frame) != -1) {
+        qWarning() << "FAILED: control frame with a wrong checksum is accepted";
+        failures++;
+    }
+
+    if (failures > 0) {
+        qWarning() << failures << "checks failed";
+        return 1;
+    }
+    qInfo() << "All checks passed";
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    if (app.arguments().value(1) == "--check")
+        return check();
+
+    QString devId = argc > 1 ? QString(argv[1]) : QString(DEVICE_ID);
+    QByteArray localKey = argc > 2 ? QByteArray(argv[2]) : QByteArray(LOCAL_KEY);
+    if (localKey.length() != 16) {
+        qWarning() << "The local key needs to have 16 characters";
+        return 1;
+    }
+    QVariantMap dps;
+    dps.insert("1", false);
+    QHash<QTcpSocket *, QByteArray> buffers;
+
+    qDebug() << "Simulating Tuya switch" << devId;
+
+    QString ip;
+    foreach (const QHostAddress &address, QNetworkInterface::allAddresses()) {
+        if (address.protocol() == QAbstractSocket::IPv4Protocol && !address.isLoopback()) {
+            ip = address.toString();
+            break;
+        }
+    }
+
+    // Announce the device like the real ones do every 5 seconds
+    QUdpSocket udp;
+    QTimer announceTimer;
+    QObject::connect(&announceTimer, &QTimer::timeout, &app, [&udp, ip, devId](){
+        QVariantMap announcement;
+        announcement.insert("ip", ip);
+        announcement.insert("gwId", devId);
+        announcement.insert("active", 2);
+        announcement.insert("ability", 0);
+        announcement.insert("mode", 0);
+        announcement.insert("encrypt", true);
+        announcement.insert("productKey", "simulator");
+        announcement.insert("version", "3.3");
+        QByteArray payload = QJsonDocument::fromVariant(announcement).toJson(QJsonDocument::Compact);
+        QByteArray udpKey = QCryptographicHash::hash("yGAdlopoPVldABfn", QCryptographicHash::Md5);
+        udp.writeDatagram(buildFrame(udpKey, 0, commandAnnouncement, payload), QHostAddress::Broadcast, 6667);
+    });
+    announceTimer.start(5000);
+
+    QTcpServer tcp;
+    bool success = tcp.listen(QHostAddress("0.0.0.0"), 6668);
+    qDebug() << "Listening on tcp" << success;
+    QObject::connect(&tcp, &QTcpServer::newConnection, &app, [&](){
+        QTcpSocket *client = tcp.nextPendingConnection();
+        qDebug() << "New connection from" << client->peerAddress().toString();
+        QObject::connect(client, &QTcpSocket::disconnected, &app, [&buffers, client](){
+            qDebug() << "Client disconnected";
+            buffers.remove(client);
+            client->deleteLater();
+        });
+        QObject::connect(client, &QTcpSocket::readyRead, &app, [&, client](){
+            QByteArray &buffer = buffers[client];
+            buffer.append(client->readAll());
+            int offset = 0;
+            while (offset < buffer.length()) {
+                Frame message;
+                int consumed = parseFrame(localKey, buffer.mid(offset), &message);
+                if (consumed == 0)
+                    break;
+
+                if (consumed < 0) {
+                    qWarning() << "Invalid message, closing connection";
+                    client->abort();
+                    return;
+                }
+                offset += consumed;
+                qDebug() << "Incoming command" << message.command << message.payload;
+
+                QVariantMap response;
+                response.insert("devId", devId);
+                switch (message.command) {
+                case commandHeartbeat:
+                    client->write(buildFrame(localKey, message.sequence, message.command, QByteArray()));
+                    break;
+                case commandDpQuery:
+                    response.insert("dps", dps);
+                    client->write(buildFrame(localKey, message.sequence, message.command, QJsonDocument::fromVariant(response).toJson(QJsonDocument::Compact)));
+                    break;
+                case commandControl: {
+                    QVariantMap changes = QJsonDocument::fromJson(message.payload).toVariant().toMap().value("dps").toMap();
+                    foreach (const QString &dp, changes.keys()) {
+                        dps.insert(dp, changes.value(dp));
+                    }
+                    qDebug() << "Data points:" << dps;
+                    client->write(buildFrame(localKey, message.sequence, message.command, QByteArray()));
+                    // Push the changed data points like the devices do
+                    response.insert("dps", changes);
+                    response.insert("t", QDateTime::currentMSecsSinceEpoch() / 1000);
+                    client->write(buildFrame(localKey, 0, commandStatus, QJsonDocument::fromVariant(response).toJson(QJsonDocument::Compact)));
+                    break;
+                }
+                default:
+                    qWarning() << "Unhandled command" << message.command;
+                }
+            }
+            buffer.remove(0, offset);
+        });
+    });
+
+    return app.exec();
+}
@@ -0,0 +1,7 @@
+CONFIG += c++11
+
+QT += network
+
+LIBS += -lcrypto
+
+SOURCES += simulator.cpp
@@ -2,12 +2,16 @@ include(../plugins.pri)
 
 QT += network
 
-PKGCONFIG += nymea-mqtt
+PKGCONFIG += nymea-mqtt libcrypto
 
 TARGET = $$qtLibraryTarget(nymea_integrationplugintuya)
 
 SOURCES += \
     integrationplugintuya.cpp \
+    tuyalocaldevice.cpp \
+    tuyaprotocol.cpp \
 
 HEADERS += \
     integrationplugintuya.h \
+    tuyalocaldevice.h \
+    tuyaprotocol.h \
@@ -0,0 +1,240 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "tuyalocaldevice.h"
+#include "tuyaprotocol.h"
+#include "extern-plugininfo.h"
+
+#include <QDateTime>
+#include <QJsonDocument>
+
+static const quint16 devicePort = 6668;
+// Devices close connections which are quiet for about 30 seconds
+static const int heartbeatInterval = 10000;
+static const int receiveTimeout = 30000;
+static const int commandTimeout = 5000;
+
+TuyaLocalDevice::TuyaLocalDevice(const QString &devId, const QByteArray &localKey, QObject *parent) :
+    QObject(parent),
+    m_devId(devId),
+    m_localKey(localKey)
+{
+    m_socket = new QTcpSocket(this);
+    connect(m_socket, &QTcpSocket::readyRead, this, &TuyaLocalDevice::onReadyRead);
+    connect(m_socket, &QTcpSocket::stateChanged, this, &TuyaLocalDevice::onStateChanged);
+
+    m_heartbeatTimer = new QTimer(this);
+    m_heartbeatTimer->setInterval(heartbeatInterval);
+    connect(m_heartbeatTimer, &QTimer::timeout, this, &TuyaLocalDevice::onHeartbeatTimer);
+
+    m_reconnectTimer = new QTimer(this);
+    m_reconnectTimer->setSingleShot(true);
+    connect(m_reconnectTimer, &QTimer::timeout, this, &TuyaLocalDevice::connectToDevice);
+}
+
+QString TuyaLocalDevice::devId() const
+{
+    return m_devId;
+}
+
+QHostAddress TuyaLocalDevice::address() const
+{
+    return m_address;
+}
+
+void TuyaLocalDevice::setAddress(const QHostAddress &address)
+{
+    if (m_address == address)
+        return;
+
+    qCDebug(dcTuya()) << "Local device" << m_devId << "is at" << address.toString();
+    m_address = address;
+    m_reconnectDelay = 5;
+    if (m_socket->state() != QAbstractSocket::UnconnectedState) {
+        // Reconnects to the new address from onStateChanged
+        m_socket->abort();
+    } else {
+        connectToDevice();
+    }
+}
+
+bool TuyaLocalDevice::connected() const
+{
+    return m_socket->state() == QAbstractSocket::ConnectedState;
+}
+
+QVariantMap TuyaLocalDevice::dps() const
+{
+    return m_dps;
+}
+
+int TuyaLocalDevice::setDps(const QVariantMap &dps)
+{
+    if (!connected())
+        return -1;
+
+    QVariantMap payload;
+    payload.insert("devId", m_devId);
+    payload.insert("uid", m_devId);
+    payload.insert("t", QString::number(QDateTime::currentMSecsSinceEpoch() / 1000));
+    payload.insert("dps", dps);
+
+    quint32 sequence = m_sequence;
+    int requestId = static_cast<int>(sequence & 0x7fffffff);
+    m_pendingCommands.insert(sequence, requestId);
+    send(TuyaProtocol::CommandControl, QJsonDocument::fromVariant(payload).toJson(QJsonDocument::Compact));
+
+    QTimer::singleShot(commandTimeout, this, [this, sequence, requestId](){
+        if (m_pendingCommands.remove(sequence) > 0) {
+            qCWarning(dcTuya()) << "Local device" << m_devId << "did not acknowledge the command";
+            emit commandFinished(requestId, false);
+        }
+    });
+    return requestId;
+}
+
+void TuyaLocalDevice::connectToDevice()
+{
+    if (m_address.isNull() || m_socket->state() != QAbstractSocket::UnconnectedState)
+        return;
+
+    qCDebug(dcTuya()) << "Connecting to local device" << m_devId << m_address.toString();
+    m_socket->connectToHost(m_address, devicePort);
+}
+
+void TuyaLocalDevice::send(quint32 command, const QByteArray &payload)
+{
+    m_socket->write(TuyaProtocol::buildMessage(m_localKey, m_sequence++, command, payload));
+}
+
+void TuyaLocalDevice::processMessage(quint32 sequence, quint32 command, quint32 returnCode, const QByteArray &payload)
+{
+    if (command == TuyaProtocol::CommandControl) {
+        if (m_pendingCommands.contains(sequence)) {
+            emit commandFinished(m_pendingCommands.take(sequence), returnCode == 0);
+        }
+        // The new state follows as status message
+        return;
+    }
+
+    if (command == TuyaProtocol::CommandHeartbeat || payload.isEmpty())
+        return;
+
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(payload, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qCWarning(dcTuya()) << "Cannot parse message from local device" << m_devId << payload;
+        return;
+    }
+
+    QVariantMap dps = jsonDoc.toVariant().toMap().value("dps").toMap();
+    if (dps.isEmpty())
+        return;
+
+    // Status pushes only contain the changed data points
+    for (QVariantMap::const_iterator it = dps.constBegin(); it != dps.constEnd(); ++it) {
+        m_dps.insert(it.key(), it.value());
+    }
+    qCDebug(dcTuya()) << "Local device" << m_devId << "data points:" << dps;
+    emit dpsChanged(m_dps);
+}
+
+void TuyaLocalDevice::onReadyRead()
+{
+    m_lastReceived.start();
+    m_buffer.append(m_socket->readAll());
+
+    int offset = 0;
+    while (offset < m_buffer.length()) {
+        TuyaProtocol::Message message;
+        int consumed = TuyaProtocol::parseMessage(m_localKey, m_buffer, offset, &message);
+        if (consumed == 0)
+            break;
+
+        if (consumed < 0) {
+            qCWarning(dcTuya()) << "Invalid data from local device" << m_devId << ", wrong local key?";
+            m_buffer.clear();
+            m_socket->abort();
+            return;
+        }
+        offset += consumed;
+        processMessage(message.sequence, message.command, message.returnCode, message.payload);
+    }
+    m_buffer.remove(0, offset);
+}
+
+void TuyaLocalDevice::onStateChanged(QAbstractSocket::SocketState state)
+{
+    if (state == QAbstractSocket::ConnectedState) {
+        qCDebug(dcTuya()) << "Connected to local device" << m_devId;
+        m_reconnectDelay = 5;
+        m_lastReceived.start();
+        m_heartbeatTimer->start();
+
+        // Ask for all data points once, changes are pushed by the device afterwards
+        QVariantMap query;
+        query.insert("gwId", m_devId);
+        query.insert("devId", m_devId);
+        query.insert("uid", m_devId);
+        query.insert("t", QString::number(QDateTime::currentMSecsSinceEpoch() / 1000));
+        send(TuyaProtocol::CommandDpQuery, QJsonDocument::fromVariant(query).toJson(QJsonDocument::Compact));
+
+        emit connectedChanged(true);
+        return;
+    }
+
+    if (state == QAbstractSocket::UnconnectedState) {
+        bool wasConnected = m_heartbeatTimer->isActive();
+        m_heartbeatTimer->stop();
+        m_buffer.clear();
+        QList<int> failed = m_pendingCommands.values();
+        m_pendingCommands.clear();
+        foreach (int requestId, failed) {
+            emit commandFinished(requestId, false);
+        }
+        if (wasConnected) {
+            qCDebug(dcTuya()) << "Local device" << m_devId << "disconnected";
+            emit connectedChanged(false);
+        }
+
+        m_reconnectTimer->start(m_reconnectDelay * 1000);
+        m_reconnectDelay = qMin(m_reconnectDelay * 2, 60);
+    }
+}
+
+void TuyaLocalDevice::onHeartbeatTimer()
+{
+    if (m_lastReceived.elapsed() > receiveTimeout) {
+        qCWarning(dcTuya()) << "Local device" << m_devId << "stopped answering";
+        m_socket->abort();
+        return;
+    }
+    send(TuyaProtocol::CommandHeartbeat, QByteArray("{}"));
+}
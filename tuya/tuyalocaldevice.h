@@ -0,0 +1,88 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef TUYALOCALDEVICE_H
+#define TUYALOCALDEVICE_H
+
+#include <QObject>
+#include <QTimer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QVariantMap>
+#include <QHash>
+#include <QElapsedTimer>
+
+// Persistent connection to a Tuya device on TCP port 6668 using the LAN protocol 3.3
+class TuyaLocalDevice : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TuyaLocalDevice(const QString &devId, const QByteArray &localKey, QObject *parent = nullptr);
+
+    QString devId() const;
+    QHostAddress address() const;
+    // (Re)connects if the address changed
+    void setAddress(const QHostAddress &address);
+
+    bool connected() const;
+    QVariantMap dps() const;
+
+    // Returns a request id for commandFinished() or -1 if the device isn't connected
+    int setDps(const QVariantMap &dps);
+
+signals:
+    void connectedChanged(bool connected);
+    void dpsChanged(const QVariantMap &dps);
+    void commandFinished(int requestId, bool success);
+
+private:
+    QString m_devId;
+    QByteArray m_localKey;
+    QHostAddress m_address;
+    QTcpSocket *m_socket = nullptr;
+    QByteArray m_buffer;
+    quint32 m_sequence = 1;
+    QVariantMap m_dps;
+
+    QTimer *m_heartbeatTimer = nullptr;
+    QTimer *m_reconnectTimer = nullptr;
+    int m_reconnectDelay = 5;
+    QElapsedTimer m_lastReceived;
+    QHash<quint32, int> m_pendingCommands;
+
+    void connectToDevice();
+    void send(quint32 command, const QByteArray &payload);
+    void processMessage(quint32 sequence, quint32 command, quint32 returnCode, const QByteArray &payload);
+    void onReadyRead();
+    void onStateChanged(QAbstractSocket::SocketState state);
+    void onHeartbeatTimer();
+};
+
+#endif // TUYALOCALDEVICE_H
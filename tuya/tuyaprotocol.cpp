@@ -0,0 +1,182 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "tuyaprotocol.h"
+
+#include <QtEndian>
+#include <QCryptographicHash>
+
+#include <openssl/evp.h>
+
+static const quint32 messagePrefix = 0x000055AA;
+static const quint32 messageSuffix = 0x0000AA55;
+static const int headerSize = 16;
+static const int trailerSize = 8;
+static const int maxMessageSize = 64 * 1024;
+static const QByteArray versionHeader = QByteArray("3.3") + QByteArray(12, '\0');
+
+QByteArray TuyaProtocol::udpKey()
+{
+    return QCryptographicHash::hash("yGAdlopoPVldABfn", QCryptographicHash::Md5);
+}
+
+QByteArray TuyaProtocol::encrypt(const QByteArray &key, const QByteArray &plaintext)
+{
+    if (key.length() != 16)
+        return QByteArray();
+
+    EVP_CIPHER_CTX *context = EVP_CIPHER_CTX_new();
+    QByteArray ciphertext(plaintext.length() + 16, Qt::Uninitialized);
+    int length = 0;
+    int finalLength = 0;
+    bool ok = EVP_EncryptInit_ex(context, EVP_aes_128_ecb(), nullptr, reinterpret_cast<const uchar *>(key.constData()), nullptr)
+            && EVP_EncryptUpdate(context, reinterpret_cast<uchar *>(ciphertext.data()), &length,
+                                 reinterpret_cast<const uchar *>(plaintext.constData()), plaintext.length())
+            && EVP_EncryptFinal_ex(context, reinterpret_cast<uchar *>(ciphertext.data()) + length, &finalLength);
+    EVP_CIPHER_CTX_free(context);
+    if (!ok)
+        return QByteArray();
+
+    ciphertext.resize(length + finalLength);
+    return ciphertext;
+}
+
+QByteArray TuyaProtocol::decrypt(const QByteArray &key, const QByteArray &ciphertext)
+{
+    if (key.length() != 16 || ciphertext.isEmpty() || ciphertext.length() % 16 != 0)
+        return QByteArray();
+
+    EVP_CIPHER_CTX *context = EVP_CIPHER_CTX_new();
+    QByteArray plaintext(ciphertext.length() + 16, Qt::Uninitialized);
+    int length = 0;
+    int finalLength = 0;
+    bool ok = EVP_DecryptInit_ex(context, EVP_aes_128_ecb(), nullptr, reinterpret_cast<const uchar *>(key.constData()), nullptr)
+            && EVP_DecryptUpdate(context, reinterpret_cast<uchar *>(plaintext.data()), &length,
+                                 reinterpret_cast<const uchar *>(ciphertext.constData()), ciphertext.length())
+            && EVP_DecryptFinal_ex(context, reinterpret_cast<uchar *>(plaintext.data()) + length, &finalLength);
+    EVP_CIPHER_CTX_free(context);
+    if (!ok)
+        return QByteArray();
+
+    plaintext.resize(length + finalLength);
+    return plaintext;
+}
+
+QByteArray TuyaProtocol::buildMessage(const QByteArray &key, quint32 sequence, quint32 command, const QByteArray &payload, bool withReturnCode)
+{
+    QByteArray body;
+    if (withReturnCode)
+        body.append(QByteArray(4, '\0'));
+    if (command == CommandControl || (withReturnCode && command == CommandStatus))
+        body.append(versionHeader);
+    if (!payload.isEmpty())
+        body.append(encrypt(key, payload));
+
+    QByteArray message(headerSize + body.length() + trailerSize, Qt::Uninitialized);
+    uchar *data = reinterpret_cast<uchar *>(message.data());
+    qToBigEndian<quint32>(messagePrefix, data);
+    qToBigEndian<quint32>(sequence, data + 4);
+    qToBigEndian<quint32>(command, data + 8);
+    qToBigEndian<quint32>(static_cast<quint32>(body.length() + trailerSize), data + 12);
+    memcpy(data + headerSize, body.constData(), static_cast<size_t>(body.length()));
+    int crcOffset = headerSize + body.length();
+    qToBigEndian<quint32>(crc32(message.constData(), crcOffset), data + crcOffset);
+    qToBigEndian<quint32>(messageSuffix, data + crcOffset + 4);
+    return message;
+}
+
+int TuyaProtocol::parseMessage(const QByteArray &key, const QByteArray &buffer, int offset, Message *message)
+{
+    int available = buffer.length() - offset;
+    if (available < headerSize)
+        return 0;
+
+    const uchar *data = reinterpret_cast<const uchar *>(buffer.constData() + offset);
+    if (qFromBigEndian<quint32>(data) != messagePrefix)
+        return -1;
+
+    quint32 length = qFromBigEndian<quint32>(data + 12);
+    if (length < static_cast<quint32>(trailerSize) || length > static_cast<quint32>(maxMessageSize))
+        return -1;
+
+    int messageSize = headerSize + static_cast<int>(length);
+    if (available < messageSize)
+        return 0;
+
+    if (qFromBigEndian<quint32>(data + messageSize - 4) != messageSuffix)
+        return -1;
+
+    int crcOffset = messageSize - trailerSize;
+    if (qFromBigEndian<quint32>(data + crcOffset) != crc32(buffer.constData() + offset, crcOffset))
+        return -1;
+
+    message->sequence = qFromBigEndian<quint32>(data + 4);
+    message->command = qFromBigEndian<quint32>(data + 8);
+    message->returnCode = 0;
+
+    // Messages from devices carry a return code, the encrypted part is always a multiple of 16 bytes
+    QByteArray body = buffer.mid(offset + headerSize, static_cast<int>(length) - trailerSize);
+    if (body.length() >= 4 && !body.startsWith("3.3") && (body.length() % 16 != 0 || body.at(4) == '{')) {
+        message->returnCode = qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(body.constData()));
+        body = body.mid(4);
+    }
+    if (body.startsWith("3.3"))
+        body = body.mid(versionHeader.length());
+
+    if (body.isEmpty() || body.startsWith('{')) {
+        // Empty acknowledges and unencrypted status of older firmwares
+        message->payload = body;
+    } else {
+        message->payload = decrypt(key, body);
+    }
+    return messageSize;
+}
+
+quint32 TuyaProtocol::crc32(const char *data, int length)
+{
+    static quint32 table[256];
+    static bool tableReady = false;
+    if (!tableReady) {
+        for (quint32 i = 0; i < 256; i++) {
+            quint32 value = i;
+            for (int bit = 0; bit < 8; bit++) {
+                value = (value & 1) ? (0xEDB88320 ^ (value >> 1)) : (value >> 1);
+            }
+            table[i] = value;
+        }
+        tableReady = true;
+    }
+
+    quint32 crc = 0xFFFFFFFF;
+    for (int i = 0; i < length; i++) {
+        crc = table[(crc ^ static_cast<quint8>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFF;
+}
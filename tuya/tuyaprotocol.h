@@ -0,0 +1,75 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef TUYAPROTOCOL_H
+#define TUYAPROTOCOL_H
+
+#include <QByteArray>
+
+// Framing and encryption of the Tuya LAN protocol version 3.3
+//
+// Every message is framed as
+//   0x000055AA | sequence | command | length | [return code] payload | CRC32 | 0x0000AA55
+// with big endian integers. The payload is AES-128-ECB encrypted with the device's local key,
+// control messages additionally start with an unencrypted "3.3" version header.
+class TuyaProtocol
+{
+public:
+    enum Command {
+        CommandControl = 0x07,
+        CommandStatus = 0x08,
+        CommandHeartbeat = 0x09,
+        CommandDpQuery = 0x0a
+    };
+
+    struct Message {
+        quint32 sequence = 0;
+        quint32 command = 0;
+        quint32 returnCode = 0;
+        QByteArray payload; // Decrypted
+    };
+
+    // Devices broadcast their presence on UDP 6667 encrypted with this key
+    static QByteArray udpKey();
+
+    static QByteArray encrypt(const QByteArray &key, const QByteArray &plaintext);
+    static QByteArray decrypt(const QByteArray &key, const QByteArray &ciphertext);
+
+    static QByteArray buildMessage(const QByteArray &key, quint32 sequence, quint32 command, const QByteArray &payload, bool withReturnCode = false);
+
+    // Parses the message starting at offset. Returns the number of bytes consumed, 0 if the
+    // message is not complete yet and -1 if the data is not a valid message.
+    static int parseMessage(const QByteArray &key, const QByteArray &buffer, int offset, Message *message);
+
+private:
+    static quint32 crc32(const char *data, int length);
+};
+
+#endif // TUYAPROTOCOL_H
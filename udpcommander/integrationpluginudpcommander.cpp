@@ -44,17 +44,21 @@ void IntegrationPluginUdpCommander::setupThing(ThingSetupInfo *info)
     qCDebug(dcUdpCommander()) << "Setup thing" << thing->name() << thing->params();
 
     if (thing->thingClassId() == udpReceiverThingClassId) {
-        QUdpSocket *udpSocket = new QUdpSocket(this);
+        UdpReceiver *receiver = new UdpReceiver(this);
         int port = thing->paramValue(udpReceiverThingPortParamTypeId).toInt();
-        if (!udpSocket->bind(QHostAddress::Any, port, QUdpSocket::ShareAddress)) {
+        if (!receiver->bind(port)) {
             qCWarning(dcUdpCommander()) << thing->name() << "cannot bind to port" << port;
-            delete udpSocket;
+            delete receiver;
             return info->finish(Thing::ThingErrorHardwareNotAvailable, QT_TR_NOOP("Error opening UDP port."));
         }
         qCDebug(dcUdpCommander()) << "Listening on port" << port;
 
-        connect(udpSocket, SIGNAL(readyRead()), this, SLOT(readPendingDatagrams()));
-        m_receiverList.insert(udpSocket, thing);
+        applyReceiverSettings(thing, receiver);
+        connect(thing, &Thing::settingChanged, receiver, [this, thing, receiver](){
+            applyReceiverSettings(thing, receiver);
+        });
+        connect(receiver, &UdpReceiver::datagramReceived, this, &IntegrationPluginUdpCommander::onDatagramReceived);
+        m_receiverList.insert(receiver, thing);
 
         return info->finish(Thing::ThingErrorNoError);
     } else if (thing->thingClassId() == udpCommanderThingClassId) {
@@ -85,10 +89,9 @@ void IntegrationPluginUdpCommander::executeAction(ThingActionInfo *info)
 void IntegrationPluginUdpCommander::thingRemoved(Thing *thing)
 {
     if (thing->thingClassId() == udpReceiverThingClassId) {
-        QUdpSocket *socket = m_receiverList.key(thing);
-        m_receiverList.remove(socket);
-        socket->close();
-        socket->deleteLater();
+        UdpReceiver *receiver = m_receiverList.key(thing);
+        m_receiverList.remove(receiver);
+        receiver->deleteLater();
 
     } else if (thing->thingClassId() == udpCommanderThingClassId) {
         QUdpSocket *socket = m_commanderList.key(thing);
@@ -98,34 +101,28 @@ void IntegrationPluginUdpCommander::thingRemoved(Thing *thing)
     }
 }
 
-void IntegrationPluginUdpCommander::readPendingDatagrams()
+void IntegrationPluginUdpCommander::applyReceiverSettings(Thing *thing, UdpReceiver *receiver)
+{
+    receiver->setAcknowledge(thing->setting(udpReceiverSettingsAcknowledgeParamTypeId).toBool());
+    receiver->setDedupeWindow(thing->setting(udpReceiverSettingsDedupeWindowParamTypeId).toInt());
+    receiver->setMaxRate(thing->setting(udpReceiverSettingsMaxEventRateParamTypeId).toInt());
+}
+
+void IntegrationPluginUdpCommander::onDatagramReceived(const QByteArray &data, const QHostAddress &senderAddress, quint16 senderPort)
 {
-    qCDebug(dcUdpCommander()) << "UDP datagram received";
-    QUdpSocket *socket= static_cast<QUdpSocket *>(sender());
-    Thing *thing = m_receiverList.value(socket);
+    UdpReceiver *receiver = static_cast<UdpReceiver *>(sender());
+    Thing *thing = m_receiverList.value(receiver);
 
     if (!thing) {
         qCWarning(dcUdpCommander()) << "Received a datagram from a socket we don't know";
         return;
     }
 
-    QByteArray datagram;
-    QHostAddress sender;
-    quint16 senderPort = 0;
-
-    while (socket->hasPendingDatagrams()) {
-        datagram.resize(socket->pendingDatagramSize());
-        socket->readDatagram(datagram.data(), datagram.size(), &sender, &senderPort);
-        qCDebug(dcUdpCommander()) << "Incoming datatram" << datagram << "on" << thing->name() << "from" << sender.toString() << senderPort;
-
-        Event ev = Event(udpReceiverTriggeredEventTypeId, thing->id());
-        ParamList params;
-        params.append(Param(udpReceiverTriggeredEventDataParamTypeId, datagram));
-        ev.setParams(params);
-        emit emitEvent(ev);
-
-        // Send response for verification
-        socket->writeDatagram("OK\n", sender, senderPort);
-    }
+    qCDebug(dcUdpCommander()) << "Incoming datagram" << data << "on" << thing->name() << "from" << senderAddress.toString() << senderPort;
 
+    Event ev = Event(udpReceiverTriggeredEventTypeId, thing->id());
+    ParamList params;
+    params.append(Param(udpReceiverTriggeredEventDataParamTypeId, data));
+    ev.setParams(params);
+    emit emitEvent(ev);
 }
@@ -32,6 +32,7 @@
 #define INTEGRATIONPLUGINUDPCOMMANDER_H
 
 #include "integrations/integrationplugin.h"
+#include "udpreceiver.h"
 
 #include <QHash>
 #include <QDebug>
@@ -52,11 +53,13 @@ public:
     void executeAction(ThingActionInfo *info) override;
 
 private:
-    QHash<QUdpSocket *, Thing *> m_receiverList;
+    QHash<UdpReceiver *, Thing *> m_receiverList;
     QHash<QUdpSocket *, Thing *> m_commanderList;
 
+    void applyReceiverSettings(Thing *thing, UdpReceiver *receiver);
+
 private slots:
-    void readPendingDatagrams();
+    void onDatagramReceived(const QByteArray &data, const QHostAddress &senderAddress, quint16 senderPort);
 
 };
 
@@ -0,0 +1,9 @@
+#ifndef EXTERNPLUGININFO_H
+#define EXTERNPLUGININFO_H
+
+#include <QLoggingCategory>
+
+// Stands in for the file generated by the plugin build
+Q_DECLARE_LOGGING_CATEGORY(dcUdpCommander)
+
+#endif // EXTERNPLUGININFO_H
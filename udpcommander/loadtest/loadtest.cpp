@@ -0,0 +1,99 @@
+#include <QCoreApplication>
+
+#include <QDebug>
+#include <QTimer>
+#include <QEventLoop>
+#include <QUdpSocket>
+#include <QElapsedTimer>
+
+#include "udpreceiver.h"
+
+// Load test for the UDP receiver of the UDP commander
+// Usage: loadtest [datagrams] [senders] [port] [max rate]
+// Sends [datagrams] distinct datagrams from [senders] sockets as fast as possible to a receiver
+// bound to [port] and reports the datagrams per second passed on and how many got lost. With a
+// [max rate] the rate limit of the receiver is enabled, the datagrams above it are coalesced.
+
+Q_LOGGING_CATEGORY(dcUdpCommander, "UdpCommander")
+
+// Datagrams sent before the receiver gets the chance to read
+static const int burstSize = 64;
+
+static void wait(int milliseconds)
+{
+    QEventLoop loop;
+    QTimer::singleShot(milliseconds, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+    QLoggingCategory::setFilterRules("UdpCommander.debug=false");
+
+    int datagrams = argc > 1 ? QString(argv[1]).toInt() : 100000;
+    int senders = argc > 2 ? QString(argv[2]).toInt() : 16;
+    quint16 port = argc > 3 ? static_cast<quint16>(QString(argv[3]).toUInt()) : 52323;
+    int maxRate = argc > 4 ? QString(argv[4]).toInt() : 0;
+    if (datagrams <= 0 || senders <= 0 || port == 0 || maxRate < 0) {
+        qWarning() << "Usage: loadtest [datagrams] [senders] [port] [max rate]";
+        return 1;
+    }
+
+    UdpReceiver receiver;
+    if (!receiver.bind(port)) {
+        qWarning() << "Could not bind the receiver to port" << port;
+        return 1;
+    }
+    receiver.setAcknowledge(false);
+    receiver.setMaxRate(maxRate);
+
+    int received = 0;
+    QElapsedTimer clock;
+    qint64 lastReceived = 0;
+    QObject::connect(&receiver, &UdpReceiver::datagramReceived, [&received, &lastReceived, &clock](){
+        received++;
+        lastReceived = clock.nsecsElapsed();
+    });
+
+    QList<QUdpSocket *> sockets;
+    for (int i = 0; i < senders; i++) {
+        QUdpSocket *socket = new QUdpSocket();
+        socket->bind(QHostAddress::LocalHost, 0);
+        sockets.append(socket);
+    }
+
+    qInfo() << "Sending" << datagrams << "datagrams from" << senders << "senders to port" << port << (maxRate > 0 ? QString("with a rate limit of %1/s").arg(maxRate) : QString());
+
+    clock.start();
+    int sent = 0;
+    int failed = 0;
+    while (sent < datagrams) {
+        for (int i = 0; i < burstSize && sent < datagrams; i++) {
+            QByteArray data = "datagram " + QByteArray::number(sent);
+            if (sockets.at(sent % senders)->writeDatagram(data, QHostAddress::LocalHost, port) < 0) {
+                failed++;
+            }
+            sent++;
+        }
+        QCoreApplication::processEvents();
+    }
+    qint64 sendTime = clock.nsecsElapsed();
+
+    // Until the receiver has been quiet for a while
+    int previous = -1;
+    while (previous != received) {
+        previous = received;
+        wait(maxRate > 0 ? 1500 : 200);
+    }
+
+    qint64 receiveTime = qMax<qint64>(lastReceived, 1);
+    qInfo() << "Sent" << sent - failed << "datagrams in" << sendTime / 1000000 << "ms," << failed << "could not be sent";
+    qInfo() << "Received" << received << "datagrams in" << receiveTime / 1000000 << "ms," << (received * 1000000000.0 / receiveTime) << "datagrams/s";
+    if (sent - failed > 0) {
+        qInfo() << "Drop rate" << (100.0 * (sent - failed - received) / (sent - failed)) << "%";
+    }
+
+    qDeleteAll(sockets);
+    return received > 0 ? 0 : 1;
+}
@@ -0,0 +1,12 @@
+CONFIG += c++11
+
+QT += network
+
+# Picks up the logging category stub in this directory before the generated plugin info
+INCLUDEPATH += . ..
+
+SOURCES += loadtest.cpp \
+    ../udpreceiver.cpp
+
+HEADERS += extern-plugininfo.h \
+    ../udpreceiver.h
@@ -5,9 +5,11 @@ QT += network
 TARGET = $$qtLibraryTarget(nymea_integrationpluginudpcommander)
 
 SOURCES += \
-    integrationpluginudpcommander.cpp
+    integrationpluginudpcommander.cpp \
+    udpreceiver.cpp
 
 HEADERS += \
-    integrationpluginudpcommander.h
+    integrationpluginudpcommander.h \
+    udpreceiver.h
 
 
@@ -0,0 +1,328 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "udpreceiver.h"
+#include "extern-plugininfo.h"
+
+#include <QNetworkInterface>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+// Datagrams read with one recvmmsg call and the maximum size of each of them,
+// the largest UDP payload fits so datagrams are never truncated
+static const int batchSize = 32;
+static const int maxDatagramSize = 65535;
+// Batches read per socket notification, the rest is read on the next event loop run
+static const int maxBatches = 8;
+// Senders tracked for the dedupe and the rate limit, datagrams of further senders pass the
+// dedupe unchecked and are dropped while the rate limit is exceeded
+static const int maxSenders = 1024;
+
+UdpReceiver::UdpReceiver(QObject *parent) :
+    QObject(parent)
+{
+    m_clock.start();
+
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    connect(m_flushTimer, &QTimer::timeout, this, &UdpReceiver::flushCoalesced);
+
+    m_pruneTimer = new QTimer(this);
+    connect(m_pruneTimer, &QTimer::timeout, this, &UdpReceiver::pruneLastDatagrams);
+}
+
+UdpReceiver::~UdpReceiver()
+{
+    if (m_socket >= 0) {
+        ::close(m_socket);
+    }
+}
+
+bool UdpReceiver::bind(quint16 port)
+{
+    // Dual stack if possible, IPv4 only otherwise
+    m_socket = ::socket(AF_INET6, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_socket >= 0) {
+        int v6only = 0;
+        setsockopt(m_socket, IPPROTO_IPV6, IPV6_V6ONLY, &v6only, sizeof(v6only));
+    } else {
+        m_ipv6 = false;
+        m_socket = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    }
+    if (m_socket < 0) {
+        qCWarning(dcUdpCommander()) << "Could not create UDP socket:" << strerror(errno);
+        return false;
+    }
+
+    // Same as QUdpSocket::ShareAddress
+    int reuse = 1;
+    setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    int result;
+    if (m_ipv6) {
+        sockaddr_in6 address;
+        memset(&address, 0, sizeof(address));
+        address.sin6_family = AF_INET6;
+        address.sin6_addr = in6addr_any;
+        address.sin6_port = htons(port);
+        result = ::bind(m_socket, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+    } else {
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(port);
+        result = ::bind(m_socket, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+    }
+    if (result < 0) {
+        qCWarning(dcUdpCommander()) << "Could not bind UDP socket to port" << port << strerror(errno);
+        ::close(m_socket);
+        m_socket = -1;
+        return false;
+    }
+
+    m_notifier = new QSocketNotifier(m_socket, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &UdpReceiver::readDatagrams);
+    return true;
+}
+
+void UdpReceiver::setAcknowledge(bool acknowledge)
+{
+    m_acknowledge = acknowledge;
+}
+
+void UdpReceiver::setDedupeWindow(int milliseconds)
+{
+    m_dedupeWindow = milliseconds;
+    m_lastDatagrams.clear();
+    if (m_dedupeWindow > 0) {
+        m_pruneTimer->start(qMax(1000, m_dedupeWindow));
+    } else {
+        m_pruneTimer->stop();
+    }
+}
+
+void UdpReceiver::setMaxRate(int datagramsPerSecond)
+{
+    m_maxRate = datagramsPerSecond;
+    m_tokens = m_maxRate;
+    m_lastRefill = m_clock.elapsed();
+    if (m_maxRate == 0) {
+        flushCoalesced();
+    }
+}
+
+void UdpReceiver::readDatagrams()
+{
+    // Allocated once, the datagrams are copied out before the next batch is read
+    if (m_buffer.isEmpty())
+        m_buffer.resize(batchSize * maxDatagramSize);
+
+    sockaddr_storage addresses[batchSize];
+    iovec iovecs[batchSize];
+    mmsghdr messages[batchSize];
+
+    for (int batch = 0; batch < maxBatches; batch++) {
+        memset(messages, 0, sizeof(messages));
+        for (int i = 0; i < batchSize; i++) {
+            iovecs[i].iov_base = m_buffer.data() + i * maxDatagramSize;
+            iovecs[i].iov_len = maxDatagramSize;
+            messages[i].msg_hdr.msg_iov = &iovecs[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            messages[i].msg_hdr.msg_name = &addresses[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(addresses[i]);
+        }
+
+        int count = recvmmsg(m_socket, messages, batchSize, MSG_DONTWAIT, nullptr);
+        if (count < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                qCWarning(dcUdpCommander()) << "Error reading datagrams:" << strerror(errno);
+            }
+            return;
+        }
+
+        qCDebug(dcUdpCommander()) << "Received" << count << "datagrams";
+        for (int i = 0; i < count; i++) {
+            // Never pass on a partial payload
+            if (messages[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                qCWarning(dcUdpCommander()) << "Dropping datagram larger than" << maxDatagramSize << "bytes";
+                m_truncated++;
+                reportDrops();
+                continue;
+            }
+
+            Datagram datagram;
+            datagram.data = QByteArray(m_buffer.constData() + i * maxDatagramSize, static_cast<int>(messages[i].msg_len));
+            datagram.sender = QHostAddress(reinterpret_cast<sockaddr *>(&addresses[i]));
+            bool isIPv4 = false;
+            quint32 ipv4 = datagram.sender.toIPv4Address(&isIPv4);
+            if (isIPv4)
+                datagram.sender = QHostAddress(ipv4);
+            if (addresses[i].ss_family == AF_INET6) {
+                datagram.senderPort = ntohs(reinterpret_cast<sockaddr_in6 *>(&addresses[i])->sin6_port);
+            } else {
+                datagram.senderPort = ntohs(reinterpret_cast<sockaddr_in *>(&addresses[i])->sin_port);
+            }
+
+            if (m_acknowledge)
+                sendAcknowledge(datagram.sender, datagram.senderPort);
+
+            handleDatagram(datagram);
+        }
+
+        if (count < batchSize)
+            return;
+    }
+}
+
+void UdpReceiver::handleDatagram(const Datagram &datagram)
+{
+    QString senderKey = datagram.sender.toString() + ':' + QString::number(datagram.senderPort);
+    qint64 now = m_clock.elapsed();
+
+    if (m_dedupeWindow > 0) {
+        QHash<QString, LastDatagram>::iterator last = m_lastDatagrams.find(senderKey);
+        if (last != m_lastDatagrams.end() && last->data == datagram.data && now - last->timestamp < m_dedupeWindow) {
+            m_duplicates++;
+            reportDrops();
+            return;
+        }
+        if (last == m_lastDatagrams.end() && m_lastDatagrams.count() < maxSenders) {
+            last = m_lastDatagrams.insert(senderKey, LastDatagram());
+        }
+        if (last != m_lastDatagrams.end()) {
+            last->data = datagram.data;
+            last->timestamp = now;
+        }
+    }
+
+    if (m_maxRate > 0) {
+        // Something older of this sender is still waiting, it is replaced by the newer one
+        if (m_coalesced.contains(senderKey) || !takeToken()) {
+            if (m_coalesced.contains(senderKey)) {
+                m_coalescedCount++;
+                reportDrops();
+            } else if (m_coalesced.count() >= maxSenders) {
+                m_overflowed++;
+                reportDrops();
+                return;
+            }
+            m_coalesced.insert(senderKey, datagram);
+            if (!m_flushTimer->isActive()) {
+                m_flushTimer->start(qMax(1, 1000 / m_maxRate));
+            }
+            return;
+        }
+    }
+
+    emit datagramReceived(datagram.data, datagram.sender, datagram.senderPort);
+}
+
+void UdpReceiver::sendAcknowledge(const QHostAddress &address, quint16 port)
+{
+    static const char acknowledge[] = "OK\n";
+    if (m_ipv6) {
+        sockaddr_in6 destination;
+        memset(&destination, 0, sizeof(destination));
+        destination.sin6_family = AF_INET6;
+        destination.sin6_port = htons(port);
+        if (address.protocol() == QAbstractSocket::IPv4Protocol) {
+            // IPv4 mapped address ::ffff:a.b.c.d
+            destination.sin6_addr.s6_addr[10] = 0xff;
+            destination.sin6_addr.s6_addr[11] = 0xff;
+            quint32 ipv4 = htonl(address.toIPv4Address());
+            memcpy(&destination.sin6_addr.s6_addr[12], &ipv4, sizeof(ipv4));
+        } else {
+            Q_IPV6ADDR ipv6 = address.toIPv6Address();
+            memcpy(&destination.sin6_addr, &ipv6, sizeof(ipv6));
+            destination.sin6_scope_id = QNetworkInterface::interfaceIndexFromName(address.scopeId());
+        }
+        ::sendto(m_socket, acknowledge, 3, MSG_DONTWAIT, reinterpret_cast<sockaddr *>(&destination), sizeof(destination));
+    } else {
+        sockaddr_in destination;
+        memset(&destination, 0, sizeof(destination));
+        destination.sin_family = AF_INET;
+        destination.sin_port = htons(port);
+        destination.sin_addr.s_addr = htonl(address.toIPv4Address());
+        ::sendto(m_socket, acknowledge, 3, MSG_DONTWAIT, reinterpret_cast<sockaddr *>(&destination), sizeof(destination));
+    }
+}
+
+bool UdpReceiver::takeToken()
+{
+    qint64 now = m_clock.elapsed();
+    m_tokens = qMin<double>(m_maxRate, m_tokens + (now - m_lastRefill) * m_maxRate / 1000.0);
+    m_lastRefill = now;
+    if (m_tokens < 1)
+        return false;
+
+    m_tokens -= 1;
+    return true;
+}
+
+void UdpReceiver::flushCoalesced()
+{
+    while (!m_coalesced.isEmpty()) {
+        if (m_maxRate > 0 && !takeToken()) {
+            m_flushTimer->start(qMax(1, 1000 / m_maxRate));
+            return;
+        }
+        Datagram datagram = m_coalesced.take(m_coalesced.firstKey());
+        emit datagramReceived(datagram.data, datagram.sender, datagram.senderPort);
+    }
+}
+
+void UdpReceiver::pruneLastDatagrams()
+{
+    // Forget senders which went quiet
+    qint64 now = m_clock.elapsed();
+    QMutableHashIterator<QString, LastDatagram> it(m_lastDatagrams);
+    while (it.hasNext()) {
+        if (now - it.next().value().timestamp >= m_dedupeWindow) {
+            it.remove();
+        }
+    }
+}
+
+void UdpReceiver::reportDrops()
+{
+    qint64 now = m_clock.elapsed();
+    if (m_lastDropReport != 0 && now - m_lastDropReport < 10000)
+        return;
+
+    m_lastDropReport = now;
+    qCDebug(dcUdpCommander()) << "Dropped" << m_duplicates << "duplicate," << m_coalescedCount << "coalesced," << m_overflowed << "rate limited and"
+                               << m_truncated << "truncated datagrams so far";
+}
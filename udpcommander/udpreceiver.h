@@ -0,0 +1,109 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+*
+* Copyright 2013 - 2020, nymea GmbH
+* Contact: contact@nymea.io
+*
+* This file is part of nymea.
+* This project including source code and documentation is protected by
+* copyright law, and remains the property of nymea GmbH. All rights, including
+* reproduction, publication, editing and translation, are reserved. The use of
+* this project is subject to the terms of a license agreement to be concluded
+* with nymea GmbH in accordance with the terms of use of nymea GmbH, available
+* under https://nymea.io/license
+*
+* GNU Lesser General Public License Usage
+* Alternatively, this project may be redistributed and/or modified under the
+* terms of the GNU Lesser General Public License as published by the Free
+* Software Foundation; version 3. This project is distributed in the hope that
+* it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+* warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this project. If not, see <https://www.gnu.org/licenses/>.
+*
+* For any further details and any questions please contact us under
+* contact@nymea.io or see our FAQ/Licensing Information on
+* https://nymea.io/license/faq
+*
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef UDPRECEIVER_H
+#define UDPRECEIVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QMap>
+#include <QTimer>
+#include <QHostAddress>
+#include <QElapsedTimer>
+#include <QSocketNotifier>
+
+// Receives datagrams in batches with recvmmsg and limits the rate they are passed on
+class UdpReceiver : public QObject
+{
+    Q_OBJECT
+public:
+    explicit UdpReceiver(QObject *parent = nullptr);
+    ~UdpReceiver();
+
+    bool bind(quint16 port);
+
+    // Reply "OK\n" to every received datagram
+    void setAcknowledge(bool acknowledge);
+    // Drop datagrams repeating the last payload of the same sender within this time, 0 disables it
+    void setDedupeWindow(int milliseconds);
+    // Limit of datagramReceived() per second, 0 means unlimited.
+    // When exceeded only the latest datagram of each sender is kept until the limit allows it.
+    void setMaxRate(int datagramsPerSecond);
+
+signals:
+    void datagramReceived(const QByteArray &data, const QHostAddress &sender, quint16 senderPort);
+
+private:
+    struct Datagram {
+        QByteArray data;
+        QHostAddress sender;
+        quint16 senderPort = 0;
+    };
+
+    struct LastDatagram {
+        QByteArray data;
+        qint64 timestamp = 0;
+    };
+
+    int m_socket = -1;
+    bool m_ipv6 = true;
+    QSocketNotifier *m_notifier = nullptr;
+    QByteArray m_buffer;
+
+    bool m_acknowledge = true;
+    int m_dedupeWindow = 0;
+    int m_maxRate = 0;
+
+    QElapsedTimer m_clock;
+    QHash<QString, LastDatagram> m_lastDatagrams;
+    QTimer *m_pruneTimer = nullptr;
+
+    // Token bucket for the rate limit
+    double m_tokens = 0;
+    qint64 m_lastRefill = 0;
+    QMap<QString, Datagram> m_coalesced;
+    QTimer *m_flushTimer = nullptr;
+
+    quint64 m_duplicates = 0;
+    quint64 m_coalescedCount = 0;
+    quint64 m_truncated = 0;
+    quint64 m_overflowed = 0;
+    qint64 m_lastDropReport = 0;
+
+    void readDatagrams();
+    void handleDatagram(const Datagram &datagram);
+    void sendAcknowledge(const QHostAddress &address, quint16 port);
+    bool takeToken();
+    void flushCoalesced();
+    void pruneLastDatagrams();
+    void reportDrops();
+};
+
+#endif // UDPRECEIVER_H